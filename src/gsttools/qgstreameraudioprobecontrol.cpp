@@ -33,6 +33,7 @@
 
 #include "qgstreameraudioprobecontrol_p.h"
 #include <private/qgstutils_p.h>
+#include <private/qmediaaudioprobecontrol_p.h>
 
 QGstreamerAudioProbeControl::QGstreamerAudioProbeControl(QObject *parent)
     : QMediaAudioProbeControl(parent)
@@ -41,6 +42,8 @@ QGstreamerAudioProbeControl::QGstreamerAudioProbeControl(QObject *parent)
 
 QGstreamerAudioProbeControl::~QGstreamerAudioProbeControl()
 {
+    // Release a streaming thread waiting for room in the queue
+    QMediaAudioProbeControlPrivate::get(this)->queue.setFlushing(true);
 }
 
 void QGstreamerAudioProbeControl::probeCaps(GstCaps *caps)
@@ -71,11 +74,16 @@ bool QGstreamerAudioProbeControl::probeBuffer(GstBuffer *buffer)
     data = QByteArray(reinterpret_cast<const char *>(buffer->data), buffer->size);
 #endif
 
-    QMutexLocker locker(&m_bufferMutex);
-    if (m_format.isValid()) {
-        if (!m_pendingBuffer.isValid())
-            QMetaObject::invokeMethod(this, "bufferProbed", Qt::QueuedConnection);
-        m_pendingBuffer = QAudioBuffer(data, m_format, position);
+    QAudioFormat format;
+    {
+        QMutexLocker locker(&m_bufferMutex);
+        format = m_format;
+    }
+
+    // Not holding the mutex, the queue may wait for the probes to catch up
+    if (format.isValid()
+            && QMediaAudioProbeControlPrivate::get(this)->queue.enqueue(QAudioBuffer(data, format, position))) {
+        QMetaObject::invokeMethod(this, "bufferProbed", Qt::QueuedConnection);
     }
 
     return true;
@@ -84,12 +92,13 @@ bool QGstreamerAudioProbeControl::probeBuffer(GstBuffer *buffer)
 void QGstreamerAudioProbeControl::bufferProbed()
 {
     QAudioBuffer audioBuffer;
-    {
-        QMutexLocker locker(&m_bufferMutex);
-        if (!m_pendingBuffer.isValid())
-            return;
-        audioBuffer = m_pendingBuffer;
-        m_pendingBuffer = QAudioBuffer();
-    }
+    bool more = false;
+    if (!QMediaAudioProbeControlPrivate::get(this)->queue.dequeue(&audioBuffer, &more))
+        return;
+
+    // Deliver one buffer per event so that a full queue does not starve the event loop
+    if (more)
+        QMetaObject::invokeMethod(this, "bufferProbed", Qt::QueuedConnection);
+
     emit audioBufferProbed(audioBuffer);
 }
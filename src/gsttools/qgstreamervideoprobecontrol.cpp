@@ -35,6 +35,7 @@
 
 #include "qgstutils_p.h"
 #include <private/qgstvideobuffer_p.h>
+#include <private/qmediavideoprobecontrol_p.h>
 
 QGstreamerVideoProbeControl::QGstreamerVideoProbeControl(QObject *parent)
     : QMediaVideoProbeControl(parent)
@@ -45,16 +46,15 @@ QGstreamerVideoProbeControl::QGstreamerVideoProbeControl(QObject *parent)
 
 QGstreamerVideoProbeControl::~QGstreamerVideoProbeControl()
 {
+    // Release a streaming thread waiting for room in the queue
+    QMediaVideoProbeControlPrivate::get(this)->queue.setFlushing(true);
 }
 
 void QGstreamerVideoProbeControl::startFlushing()
 {
     m_flushing = true;
 
-    {
-        QMutexLocker locker(&m_frameMutex);
-        m_pendingFrame = QVideoFrame();
-    }
+    QMediaVideoProbeControlPrivate::get(this)->queue.setFlushing(true);
 
     // only emit flush if at least one frame was probed
     if (m_frameProbed)
@@ -63,6 +63,8 @@ void QGstreamerVideoProbeControl::startFlushing()
 
 void QGstreamerVideoProbeControl::stopFlushing()
 {
+    QMediaVideoProbeControlPrivate::get(this)->queue.setFlushing(false);
+
     m_flushing = false;
 }
 
@@ -86,27 +88,44 @@ void QGstreamerVideoProbeControl::probeCaps(GstCaps *caps)
 
 bool QGstreamerVideoProbeControl::probeBuffer(GstBuffer *buffer)
 {
-    QMutexLocker locker(&m_frameMutex);
+    QVideoFrame frame;
+    {
+        QMutexLocker locker(&m_frameMutex);
 
-    if (m_flushing || !m_format.isValid())
-        return true;
+        if (m_flushing || !m_format.isValid())
+            return true;
 
-    QVideoFrame frame(
+        frame = QVideoFrame(
 #if GST_CHECK_VERSION(1,0,0)
-                new QGstVideoBuffer(buffer, m_videoInfo),
+                    new QGstVideoBuffer(buffer, m_videoInfo),
 #else
-                new QGstVideoBuffer(buffer, m_bytesPerLine),
+                    new QGstVideoBuffer(buffer, m_bytesPerLine),
 #endif
-                m_format.frameSize(),
-                m_format.pixelFormat());
+                    m_format.frameSize(),
+                    m_format.pixelFormat());
+    }
 
     QGstUtils::setFrameTimeStamps(&frame, buffer);
 
-    m_frameProbed = true;
+    // Skip, scale and convert in the streaming thread, only what the probes
+    // asked for is handed over to them
+    QMediaVideoProbeControlPrivate *probeControl = QMediaVideoProbeControlPrivate::get(this);
+    if (!probeControl->acceptFrame(frame))
+        return true;
 
-    if (!m_pendingFrame.isValid())
+    frame = probeControl->reduceFrame(frame);
+    if (!frame.isValid())
+        return true;
+
+    {
+        QMutexLocker locker(&m_frameMutex);
+        m_frameProbed = true;
+    }
+
+    // Depending on the delivery policy this replaces the pending frame, drops
+    // the oldest queued one or waits for the probes to catch up
+    if (probeControl->queue.enqueue(frame))
         QMetaObject::invokeMethod(this, "frameProbed", Qt::QueuedConnection);
-    m_pendingFrame = frame;
 
     return true;
 }
@@ -114,12 +133,13 @@ bool QGstreamerVideoProbeControl::probeBuffer(GstBuffer *buffer)
 void QGstreamerVideoProbeControl::frameProbed()
 {
     QVideoFrame frame;
-    {
-        QMutexLocker locker(&m_frameMutex);
-        if (!m_pendingFrame.isValid())
-            return;
-        frame = m_pendingFrame;
-        m_pendingFrame = QVideoFrame();
-    }
+    bool more = false;
+    if (!QMediaVideoProbeControlPrivate::get(this)->queue.dequeue(&frame, &more))
+        return;
+
+    // Deliver one frame per event so that a full queue does not starve the event loop
+    if (more)
+        QMetaObject::invokeMethod(this, "frameProbed", Qt::QueuedConnection);
+
     emit videoFrameProbed(frame);
 }
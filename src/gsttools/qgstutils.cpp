@@ -45,6 +45,8 @@
 #include <QtCore/qelapsedtimer.h>
 #include <QtMultimedia/qvideosurfaceformat.h>
 #include <private/qmultimediautils_p.h>
+#include <private/qvideoframe_p.h>
+#include <private/qvideoframeconversionhelper_p.h>
 
 #include <gst/audio/audio.h>
 #include <gst/video/video.h>
@@ -57,6 +59,7 @@ template<typename T, int N> static int lengthOf(const T (&)[N]) { return N; }
 #endif
 
 #include "qgstreamervideoinputdevicecontrol_p.h"
+#include "qgstvideobuffer_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -790,6 +793,34 @@ static const ColorFormat qt_colorLookup[] =
 }
 #endif
 
+#if GST_CHECK_VERSION(1,0,0)
+static const QYCbCrCoefficients &yCbCrCoefficients(const GstVideoColorimetry &colorimetry)
+{
+    const QYCbCrCoefficients::Range range = colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255
+            ? QYCbCrCoefficients::FullRange
+            : QYCbCrCoefficients::LimitedRange;
+
+    switch (colorimetry.matrix) {
+    case GST_VIDEO_COLOR_MATRIX_BT709:
+        return qt_yCbCrCoefficients(QYCbCrCoefficients::BT709, range);
+#if GST_CHECK_VERSION(1,6,0)
+    case GST_VIDEO_COLOR_MATRIX_BT2020:
+        return qt_yCbCrCoefficients(QYCbCrCoefficients::BT2020, range);
+#endif
+    default:
+        return qt_yCbCrCoefficients(QYCbCrCoefficients::BT601, range);
+    }
+}
+#else
+static const QYCbCrCoefficients &yCbCrCoefficients(const GstStructure *structure)
+{
+    // 0.10 caps only tell standard and high definition matrices apart
+    const bool hdtv = qstrcmp(gst_structure_get_string(structure, "color-matrix"), "hdtv") == 0;
+    return qt_yCbCrCoefficients(hdtv ? QYCbCrCoefficients::BT709 : QYCbCrCoefficients::BT601,
+                                QYCbCrCoefficients::LimitedRange);
+}
+#endif
+
 #if GST_CHECK_VERSION(1,0,0)
 QImage QGstUtils::bufferToImage(GstBuffer *buffer, const GstVideoInfo &videoInfo)
 #else
@@ -799,10 +830,38 @@ QImage QGstUtils::bufferToImage(GstBuffer *buffer)
     QImage img;
 
 #if GST_CHECK_VERSION(1,0,0)
+    if (videoInfo.finfo->format == GST_VIDEO_FORMAT_I420) {
+        // Half size preview, downscaled and converted in the YUV domain
+        const QVideoFrame frame(new QGstVideoBuffer(buffer, videoInfo),
+                                QSize(videoInfo.width, videoInfo.height),
+                                QVideoFrame::Format_YUV420P);
+        return qt_scaledImageFromVideoFrame(frame, QSize(videoInfo.width / 2, videoInfo.height / 2),
+                                            Qt::IgnoreAspectRatio,
+                                            yCbCrCoefficients(videoInfo.colorimetry));
+    }
+
     GstVideoInfo info = videoInfo;
     GstVideoFrame frame;
     if (!gst_video_frame_map(&frame, &info, buffer, GST_MAP_READ))
         return img;
+
+    for (int i = 0; i < lengthOf(qt_colorLookup); ++i) {
+        if (qt_colorLookup[i].gstFormat != videoInfo.finfo->format)
+            continue;
+
+        const QImage image(
+                    static_cast<const uchar *>(frame.data[0]),
+                    videoInfo.width,
+                    videoInfo.height,
+                    frame.info.stride[0],
+                    qt_colorLookup[i].imageFormat);
+        img = image;
+        img.detach();
+
+        break;
+    }
+
+    gst_video_frame_unmap(&frame);
 #else
     GstCaps *caps = gst_buffer_get_caps(buffer);
     if (!caps)
@@ -821,66 +880,15 @@ QImage QGstUtils::bufferToImage(GstBuffer *buffer)
         return img;
     }
     gst_caps_unref(caps);
-#endif
 
-#if GST_CHECK_VERSION(1,0,0)
-    if (videoInfo.finfo->format == GST_VIDEO_FORMAT_I420) {
-        const int width = videoInfo.width;
-        const int height = videoInfo.height;
-
-        const int stride[] = { frame.info.stride[0], frame.info.stride[1], frame.info.stride[2] };
-        const uchar *data[] = {
-            static_cast<const uchar *>(frame.data[0]),
-            static_cast<const uchar *>(frame.data[1]),
-            static_cast<const uchar *>(frame.data[2])
-        };
-#else
     if (qstrcmp(gst_structure_get_name(structure), "video/x-raw-yuv") == 0) {
-        const int stride[] = { width, width / 2, width / 2 };
-        const uchar *data[] = {
-            (const uchar *)buffer->data,
-            (const uchar *)buffer->data + width * height,
-            (const uchar *)buffer->data + width * height * 5 / 4
-        };
-#endif
-        img = QImage(width/2, height/2, QImage::Format_RGB32);
-
-        for (int y=0; y<height; y+=2) {
-            const uchar *yLine = data[0] + (y * stride[0]);
-            const uchar *uLine = data[1] + (y * stride[1] / 2);
-            const uchar *vLine = data[2] + (y * stride[2] / 2);
-
-            for (int x=0; x<width; x+=2) {
-                const qreal Y = 1.164*(yLine[x]-16);
-                const int U = uLine[x/2]-128;
-                const int V = vLine[x/2]-128;
-
-                int b = qBound(0, int(Y + 2.018*U), 255);
-                int g = qBound(0, int(Y - 0.813*V - 0.391*U), 255);
-                int r = qBound(0, int(Y + 1.596*V), 255);
-
-                img.setPixel(x/2,y/2,qRgb(r,g,b));
-            }
-        }
-#if GST_CHECK_VERSION(1,0,0)
-    } else for (int i = 0; i < lengthOf(qt_colorLookup); ++i) {
-        if (qt_colorLookup[i].gstFormat != videoInfo.finfo->format)
-            continue;
-
-        const QImage image(
-                    static_cast<const uchar *>(frame.data[0]),
-                    videoInfo.width,
-                    videoInfo.height,
-                    frame.info.stride[0],
-                    qt_colorLookup[i].imageFormat);
-        img = image;
-        img.detach();
-
-        break;
-    }
-
-    gst_video_frame_unmap(&frame);
-#else
+        // Half size preview, downscaled and converted in the YUV domain
+        const QVideoFrame frame(new QGstVideoBuffer(buffer, width),
+                                QSize(width, height),
+                                QVideoFrame::Format_YUV420P);
+        img = qt_scaledImageFromVideoFrame(frame, QSize(width / 2, height / 2),
+                                           Qt::IgnoreAspectRatio,
+                                           yCbCrCoefficients(structure));
     } else if (qstrcmp(gst_structure_get_name(structure), "video/x-raw-rgb") == 0) {
         QImage::Format format = QImage::Format_Invalid;
         int bpp = 0;
@@ -86,13 +86,28 @@ QSoundBuffer::State StaticSoundBufferAL::state() const
 
 void StaticSoundBufferAL::load()
 {
-    if (m_state == Loading || m_state == Ready)
+    load(QSampleCache::HighPriority);
+}
+
+void StaticSoundBufferAL::preload()
+{
+    load(QSampleCache::LowPriority);
+}
+
+void StaticSoundBufferAL::load(QSampleCache::Priority priority)
+{
+    if (m_state == Loading) {
+        // A preloading sample that is needed now moves ahead in the queue
+        m_sampleLoader->raisePriority(m_sample, priority);
+        return;
+    }
+    if (m_state == Ready)
         return;
 
     m_state = Loading;
     emit stateChanged(m_state);
 
-    m_sample = m_sampleLoader->requestSample(m_url);
+    m_sample = m_sampleLoader->requestSample(m_url, priority);
     connect(m_sample, SIGNAL(error()), this, SLOT(decoderError()));
     connect(m_sample, SIGNAL(ready()), this, SLOT(sampleReady()));
     switch (m_sample->state()) {
@@ -61,11 +61,11 @@
 
 #include "qsoundsource_p.h"
 #include "qsoundbuffer_p.h"
+#include "qsamplecache_p.h"
 
 QT_BEGIN_NAMESPACE
 
 class QSample;
-class QSampleCache;
 
 class QSoundBufferPrivateAL : public QSoundBuffer
 {
@@ -88,6 +88,7 @@ public:
     State state() const Q_DECL_OVERRIDE;
 
     void load() Q_DECL_OVERRIDE;
+    void preload() Q_DECL_OVERRIDE;
 
     void bindToSource(ALuint alSource) Q_DECL_OVERRIDE;
     void unbindFromSource(ALuint alSource) Q_DECL_OVERRIDE;
@@ -101,6 +102,8 @@ public Q_SLOTS:
     void decoderError();
 
 private:
+    void load(QSampleCache::Priority priority);
+
     long m_ref;
     QUrl m_url;
     ALuint m_alBuffer;
@@ -153,7 +153,7 @@ void QDeclarativeAudioSample::load()
         return;
     }
     if (m_soundBuffer->state() != QSoundBuffer::Loading && m_soundBuffer->state() != QSoundBuffer::Ready)
-        m_soundBuffer->load();
+        m_soundBuffer->preload();
 }
 
 void QDeclarativeAudioSample::setPreloaded(bool preloaded)
@@ -218,7 +218,7 @@ void QDeclarativeAudioSample::init()
             connect(m_soundBuffer, SIGNAL(ready()), this, SIGNAL(loadedChanged()));
         }
         if (m_preloaded) {
-            m_soundBuffer->load();
+            m_soundBuffer->preload();
         }
     }
 }
@@ -64,7 +64,9 @@ public:
 
     virtual State state() const = 0;
 
+    // Loads the buffer ahead of the ones being preloaded, it is needed now
     virtual void load() = 0;
+    virtual void preload() = 0;
 
 Q_SIGNALS:
     void stateChanged(State state);
@@ -19,7 +19,9 @@ PRIVATE_HEADERS += \
            audio/qaudiodevicefactory_p.h \
            audio/qwavedecoder_p.h \
            audio/qsamplecache_p.h \
-           audio/qaudiohelpers_p.h
+           audio/qaudiohelpers_p.h \
+           audio/qaudioconverter_p.h \
+           audio/qaudioresampler_p.h
 
 SOURCES += \
            audio/qaudio.cpp \
@@ -37,7 +39,15 @@ SOURCES += \
            audio/qaudiobuffer.cpp \
            audio/qaudioprobe.cpp \
            audio/qaudiodecoder.cpp \
-           audio/qaudiohelpers.cpp
+           audio/qaudiohelpers.cpp \
+           audio/qaudioconverter.cpp \
+           audio/qaudioresampler.cpp
+
+SSE2_SOURCES += audio/qaudiohelpers_sse2.cpp \
+                audio/qaudioconverter_sse2.cpp \
+                audio/qaudioresampler_sse2.cpp
+AVX2_SOURCES += audio/qaudiohelpers_avx2.cpp \
+                audio/qaudioresampler_avx2.cpp
 
 unix:!mac {
     config_pulseaudio {
@@ -33,6 +33,8 @@
 
 #include "qaudiobuffer.h"
 #include "qaudiobuffer_p.h"
+#include "qaudioconverter_p.h"
+#include "qaudioresampler_p.h"
 
 #include <QObject>
 #include <QDebug>
@@ -94,10 +96,12 @@ public:
 // Private class to go in .cpp file
 class QMemoryAudioBufferProvider : public QAbstractAudioBuffer {
 public:
-    QMemoryAudioBufferProvider(const void *data, int frameCount, const QAudioFormat &format, qint64 startTime)
+    QMemoryAudioBufferProvider(const void *data, int frameCount, const QAudioFormat &format, qint64 startTime,
+                               QAudioBuffer::ChannelLayout layout = QAudioBuffer::InterleavedLayout)
         : mStartTime(startTime)
         , mFrameCount(frameCount)
         , mFormat(format)
+        , mLayout(layout)
     {
         int numBytes = format.bytesForFrames(frameCount);
         if (numBytes > 0) {
@@ -138,21 +142,108 @@ public:
     QAudioFormat format() const {return mFormat;}
     qint64 startTime() const {return mStartTime;}
     int frameCount() const {return mFrameCount;}
+    QAudioBuffer::ChannelLayout channelLayout() const {return mLayout;}
 
     void *constData() const {return mBuffer;}
 
     void *writableData() {return mBuffer;}
     QAbstractAudioBuffer *clone() const
     {
-        return new QMemoryAudioBufferProvider(mBuffer, mFrameCount, mFormat, mStartTime);
+        return new QMemoryAudioBufferProvider(mBuffer, mFrameCount, mFormat, mStartTime, mLayout);
     }
 
     void *mBuffer;
     qint64 mStartTime;
     int mFrameCount;
     QAudioFormat mFormat;
+    QAudioBuffer::ChannelLayout mLayout;
 };
 
+// Wraps memory owned by the application, which is handed back through the
+// cleanup function once the last buffer referring to it goes away
+class QExternalAudioBufferProvider : public QAbstractAudioBuffer {
+public:
+    QExternalAudioBufferProvider(void *data, bool writable, int frameCount, const QAudioFormat &format,
+                                 qint64 startTime, QAudioBuffer::ChannelLayout layout,
+                                 QAudioBuffer::CleanupFunction cleanupFunction, void *cleanupInfo)
+        : mData(data)
+        , mWritable(writable)
+        , mStartTime(startTime)
+        , mFrameCount(frameCount)
+        , mFormat(format)
+        , mLayout(layout)
+        , mCleanupFunction(cleanupFunction)
+        , mCleanupInfo(cleanupInfo)
+    {
+    }
+
+    ~QExternalAudioBufferProvider()
+    {
+        if (mCleanupFunction)
+            mCleanupFunction(mCleanupInfo);
+    }
+
+    void release() {delete this;}
+    QAudioFormat format() const {return mFormat;}
+    qint64 startTime() const {return mStartTime;}
+    int frameCount() const {return mFrameCount;}
+    QAudioBuffer::ChannelLayout channelLayout() const {return mLayout;}
+
+    void *constData() const {return mData;}
+
+    void *writableData() {return mWritable ? mData : 0;}
+    // Sharing the memory is only safe while it is read, so copy it instead
+    QAbstractAudioBuffer *clone() const {return 0;}
+
+    void *mData;
+    bool mWritable;
+    qint64 mStartTime;
+    int mFrameCount;
+    QAudioFormat mFormat;
+    QAudioBuffer::ChannelLayout mLayout;
+    QAudioBuffer::CleanupFunction mCleanupFunction;
+    void *mCleanupInfo;
+};
+
+static QAbstractAudioBuffer *qt_createExternalAudioBuffer(void *data, bool writable, int numFrames,
+                                                          const QAudioFormat &format,
+                                                          QAudioBuffer::ChannelLayout layout,
+                                                          qint64 startTime,
+                                                          QAudioBuffer::CleanupFunction cleanupFunction,
+                                                          void *cleanupInfo)
+{
+    if (!data || numFrames < 0 || !format.isValid()) {
+        // The memory is not used, so hand it straight back
+        if (cleanupFunction)
+            cleanupFunction(cleanupInfo);
+        return 0;
+    }
+
+    return new QExternalAudioBufferProvider(data, writable, numFrames, format, startTime, layout,
+                                            cleanupFunction, cleanupInfo);
+}
+
+// Offset of the first sample of a channel, in bytes
+static int qt_channelOffset(const QAudioFormat &format, QAudioBuffer::ChannelLayout layout,
+                            int frameCount, int channel)
+{
+    const int sampleBytes = format.sampleSize() / 8;
+    if (layout == QAudioBuffer::PlanarLayout)
+        return channel * frameCount * sampleBytes;
+    return channel * sampleBytes;
+}
+
+template <typename T>
+static void qt_copyChannel(const char *in, int inStride, char *out, int outStride, int frames)
+{
+    for (int i = 0; i < frames; ++i) {
+        // External memory need not be aligned to the sample size
+        memcpy(out, in, sizeof(T));
+        in += inStride;
+        out += outStride;
+    }
+}
+
 QAudioBufferPrivate *QAudioBufferPrivate::clone()
 {
     // We want to create a single bufferprivate with a
@@ -164,7 +255,7 @@ QAudioBufferPrivate *QAudioBufferPrivate::clone()
         QAbstractAudioBuffer *abuf = mProvider->clone();
 
         if (!abuf) {
-            abuf = new QMemoryAudioBufferProvider(mProvider->constData(), mProvider->frameCount(), mProvider->format(), mProvider->startTime());
+            abuf = new QMemoryAudioBufferProvider(mProvider->constData(), mProvider->frameCount(), mProvider->format(), mProvider->startTime(), mProvider->channelLayout());
         }
 
         if (abuf) {
@@ -186,6 +277,42 @@ QAudioBufferPrivate *QAudioBufferPrivate::clone()
     \ingroup multimedia
     \ingroup multimedia_audio
     \brief The QAudioBuffer class represents a collection of audio samples with a specific format and sample rate.
+
+    An audio buffer normally owns a copy of its samples. Memory that already
+    holds samples, such as the output of a decoder or a DSP library, can be
+    wrapped without copying by passing it to one of the constructors taking a
+    data pointer, along with a function to release it once the buffer and all
+    its copies have been destroyed.
+
+    The samples of the channels are usually interleaved, one frame after the
+    other. A buffer with the \l PlanarLayout instead stores all the samples of
+    the first channel, followed by all the samples of the second channel and so
+    on, which lets each channel be processed as one contiguous array. The
+    samples of a channel can be reached in either layout with
+    \l constChannelData() and \l sampleStride().
+*/
+
+/*!
+    \enum QAudioBuffer::ChannelLayout
+    \since 5.7
+
+    Describes how the samples of the channels are arranged in memory.
+
+    \value InterleavedLayout   Each frame holds one sample of every channel, and the
+                               frames follow one another. This is the layout used by
+                               QAudioOutput, QAudioInput and QAudioDecoder.
+    \value PlanarLayout        All the samples of each channel are stored together, one
+                               channel after the other.
+*/
+
+/*!
+    \typedef QAudioBuffer::CleanupFunction
+    \since 5.7
+
+    A function with the signature \c{void cleanup(void *cleanupInfo)}, called
+    to release memory wrapped by an audio buffer.
+
+    \sa QAudioBuffer(const void *, int, const QAudioFormat &, ChannelLayout, qint64, CleanupFunction, void *)
 */
 // ^ Mostly useful with probe or decoder
 
@@ -258,6 +385,79 @@ QAudioBuffer::QAudioBuffer(int numFrames, const QAudioFormat &format, qint64 sta
         d = 0;
 }
 
+/*!
+    \since 5.7
+
+    Creates a new audio buffer with space for \a numFrames frames of
+    the given \a format, with the samples arranged in the channel
+    \a layout.  The individual samples will be initialized to the
+    default for the format.
+
+    \a startTime (in microseconds) indicates when this buffer
+    starts in the stream.
+    If this buffer is not part of a stream, set it to -1.
+ */
+QAudioBuffer::QAudioBuffer(int numFrames, const QAudioFormat &format, ChannelLayout layout, qint64 startTime)
+{
+    if (format.isValid())
+        d = new QAudioBufferPrivate(new QMemoryAudioBufferProvider(0, numFrames, format, startTime, layout));
+    else
+        d = 0;
+}
+
+/*!
+    \since 5.7
+
+    Creates a new audio buffer over the \a numFrames frames of the given
+    \a format at \a data, with the samples arranged in the channel \a layout.
+    The samples are not copied, and may be modified through \l data() and
+    \l channelData() as long as this is the only copy of the buffer.
+
+    The memory must stay valid until \a cleanupFunction is called with
+    \a cleanupInfo, which happens when the last copy of this buffer is
+    destroyed or detached from it. This may be in another thread than the one
+    that created the buffer. If \a data is null, or the buffer is not valid,
+    \a cleanupFunction is called before the constructor returns.
+
+    \a startTime (in microseconds) indicates when this buffer
+    starts in the stream.
+    If this buffer is not part of a stream, set it to -1.
+ */
+QAudioBuffer::QAudioBuffer(void *data, int numFrames, const QAudioFormat &format, ChannelLayout layout,
+                           qint64 startTime, CleanupFunction cleanupFunction, void *cleanupInfo)
+{
+    QAbstractAudioBuffer *provider = qt_createExternalAudioBuffer(data, true, numFrames, format, layout, startTime,
+                                                                  cleanupFunction, cleanupInfo);
+    d = provider ? new QAudioBufferPrivate(provider) : 0;
+}
+
+/*!
+    \since 5.7
+
+    Creates a new read-only audio buffer over the \a numFrames frames of the
+    given \a format at \a data, with the samples arranged in the channel
+    \a layout. The samples are not copied, unless the buffer is modified
+    through \l data() or \l channelData(), which first makes a copy.
+
+    The memory must stay valid until \a cleanupFunction is called with
+    \a cleanupInfo, which happens when the last copy of this buffer is
+    destroyed or detached from it. This may be in another thread than the one
+    that created the buffer. If \a data is null, or the buffer is not valid,
+    \a cleanupFunction is called before the constructor returns.
+
+    \a startTime (in microseconds) indicates when this buffer
+    starts in the stream.
+    If this buffer is not part of a stream, set it to -1.
+ */
+QAudioBuffer::QAudioBuffer(const void *data, int numFrames, const QAudioFormat &format, ChannelLayout layout,
+                           qint64 startTime, CleanupFunction cleanupFunction, void *cleanupInfo)
+{
+    QAbstractAudioBuffer *provider = qt_createExternalAudioBuffer(const_cast<void *>(data), false, numFrames,
+                                                                  format, layout, startTime,
+                                                                  cleanupFunction, cleanupInfo);
+    d = provider ? new QAudioBufferPrivate(provider) : 0;
+}
+
 /*!
     Assigns the \a other buffer to this.
  */
@@ -308,8 +508,8 @@ QAudioFormat QAudioBuffer::format() const
 /*!
     Returns the number of complete audio frames in this buffer.
 
-    An audio frame is an interleaved set of one sample per channel
-    for the same instant in time.
+    An audio frame is a set of one sample per channel for the same
+    instant in time.
 */
 int QAudioBuffer::frameCount() const
 {
@@ -473,7 +673,7 @@ void *QAudioBuffer::data()
     }
 
     // Wasn't writable, so turn it into a memory provider
-    QAbstractAudioBuffer *memBuffer = new QMemoryAudioBufferProvider(constData(), frameCount(), format(), startTime());
+    QAbstractAudioBuffer *memBuffer = new QMemoryAudioBufferProvider(constData(), frameCount(), format(), startTime(), channelLayout());
 
     if (memBuffer) {
         d->mProvider->release();
@@ -486,6 +686,214 @@ void *QAudioBuffer::data()
     return 0;
 }
 
+/*!
+    \since 5.7
+
+    Returns a copy of this buffer converted to \a format.
+
+    The sample type, sample size, byte order and channel count can all be
+    changed, as long as both formats are linear PCM ("audio/pcm") with 8, 16 or
+    32 bit samples. Converting to mono averages all channels, converting from
+    mono copies the samples to every channel. Between other channel counts the
+    channels are kept in order, dropping the extra ones or adding silent ones.
+
+    A different sample rate is converted with a windowed sinc filter. As the
+    buffer is resampled on its own, the frames before and after it are taken
+    as silent; use consecutive buffers of a stream at the same rate where
+    possible. The start time of the buffer is preserved.
+
+    The samples of the result are always interleaved, so a planar buffer is
+    converted to the \l InterleavedLayout even if it already has \a format.
+
+    Returns this buffer if it already has \a format, or an invalid buffer if
+    the conversion is not supported.
+
+    \sa convertToLayout()
+*/
+QAudioBuffer QAudioBuffer::convertToFormat(const QAudioFormat &format) const
+{
+    if (!isValid() || !format.isValid())
+        return QAudioBuffer();
+
+    if (channelLayout() == PlanarLayout) {
+        const QAudioBuffer interleaved = convertToLayout(InterleavedLayout);
+        return interleaved.convertToFormat(format);
+    }
+
+    const QAudioFormat sourceFormat = this->format();
+    if (sourceFormat == format)
+        return *this;
+
+    if (!qt_isAudioConversionSupported(sourceFormat, format))
+        return QAudioBuffer();
+
+    const int frames = frameCount();
+    if (sourceFormat.sampleRate() == format.sampleRate()) {
+        QAudioBuffer result(frames, format, startTime());
+        if (!qt_convertAudioSamples(constData(), sourceFormat, result.data(), format, frames))
+            return QAudioBuffer();
+        return result;
+    }
+
+    // Resample float samples, in the channel layout of the result
+    QAudioFormat floatFormat = format;
+    floatFormat.setSampleSize(32);
+    floatFormat.setSampleType(QAudioFormat::Float);
+    floatFormat.setByteOrder(QAudioFormat::Endian(QSysInfo::ByteOrder));
+    QAudioFormat inputFormat = floatFormat;
+    inputFormat.setSampleRate(sourceFormat.sampleRate());
+
+    const int channels = format.channelCount();
+    QVector<float> input(frames * channels);
+    qt_convertAudioSamples(constData(), sourceFormat, input.data(), inputFormat, frames);
+
+    QAudioResampler resampler(sourceFormat.sampleRate(), format.sampleRate(), channels);
+    const int outputFrames = int(QAudioResampler::outputFrameCount(frames, sourceFormat.sampleRate(),
+                                                                    format.sampleRate()));
+    QVector<float> output(outputFrames * channels);
+    int written = resampler.process(input.constData(), frames, output.data(), outputFrames);
+    written += resampler.flush(output.data() + written * channels, outputFrames - written);
+
+    QAudioBuffer result(written, format, startTime());
+    if (!qt_convertAudioSamples(output.constData(), floatFormat, result.data(), format, written))
+        return QAudioBuffer();
+    return result;
+}
+
+/*!
+    \since 5.7
+
+    Returns a copy of this buffer with its samples arranged in the channel
+    \a layout, or this buffer if it already has \a layout.
+
+    \sa convertToFormat()
+*/
+QAudioBuffer QAudioBuffer::convertToLayout(ChannelLayout layout) const
+{
+    if (!isValid())
+        return QAudioBuffer();
+
+    const ChannelLayout sourceLayout = channelLayout();
+    if (sourceLayout == layout)
+        return *this;
+
+    const QAudioFormat format = this->format();
+    const int frames = frameCount();
+    QAudioBuffer result(frames, format, layout, startTime());
+    char *out = static_cast<char *>(result.data());
+    if (!out)
+        return QAudioBuffer();
+
+    const char *in = static_cast<const char *>(constData());
+    const int inStride = sampleStride();
+    const int outStride = result.sampleStride();
+    for (int channel = 0; channel < format.channelCount(); ++channel) {
+        const char *inChannel = in + qt_channelOffset(format, sourceLayout, frames, channel);
+        char *outChannel = out + qt_channelOffset(format, layout, frames, channel);
+        switch (format.sampleSize()) {
+        case 8:
+            qt_copyChannel<quint8>(inChannel, inStride, outChannel, outStride, frames);
+            break;
+        case 16:
+            qt_copyChannel<quint16>(inChannel, inStride, outChannel, outStride, frames);
+            break;
+        case 32:
+            qt_copyChannel<quint32>(inChannel, inStride, outChannel, outStride, frames);
+            break;
+        default:
+            for (int i = 0; i < frames; ++i)
+                memcpy(outChannel + i * outStride, inChannel + i * inStride, format.sampleSize() / 8);
+            break;
+        }
+    }
+
+    return result;
+}
+
+/*!
+    \since 5.7
+
+    Returns how the samples of the channels are arranged in this buffer.
+*/
+QAudioBuffer::ChannelLayout QAudioBuffer::channelLayout() const
+{
+    if (!isValid())
+        return InterleavedLayout;
+    return d->mProvider->channelLayout();
+}
+
+/*!
+    \since 5.7
+
+    Returns the distance in bytes from one sample of a channel to the next
+    sample of the same channel.
+
+    This is the size of a frame for an interleaved buffer, and the size of a
+    sample for a planar buffer.
+
+    \sa constChannelData()
+*/
+int QAudioBuffer::sampleStride() const
+{
+    if (!isValid())
+        return 0;
+
+    const QAudioFormat f = format();
+    if (channelLayout() == PlanarLayout)
+        return f.sampleSize() / 8;
+    return f.bytesPerFrame();
+}
+
+/*!
+    \since 5.7
+
+    Returns a pointer to the first sample of \a channel.  You can only read it.
+
+    The following samples of the channel are \l sampleStride() bytes apart.
+    Returns a null pointer if the buffer is not valid or has no such channel.
+
+    There is also a templatized version of this function that returns a
+    specific type of pointer, with no checking done on the format of the
+    buffer.
+
+    \code
+    // With a planar float buffer:
+    const float *right = buffer.constChannelData<float>(1);
+    \endcode
+
+    \sa channelData()
+*/
+const void *QAudioBuffer::constChannelData(int channel) const
+{
+    if (!isValid() || channel < 0 || channel >= format().channelCount())
+        return 0;
+
+    const char *base = static_cast<const char *>(d->mProvider->constData());
+    return base + qt_channelOffset(format(), channelLayout(), frameCount(), channel);
+}
+
+/*!
+    \since 5.7
+
+    Returns a pointer to the first sample of \a channel.  You can modify the
+    data through the returned pointer.
+
+    Like \l data(), this makes a deep copy of the samples if they are shared
+    with other buffers, or wrap read-only memory.
+
+    \sa constChannelData()
+*/
+void *QAudioBuffer::channelData(int channel)
+{
+    if (!isValid() || channel < 0 || channel >= format().channelCount())
+        return 0;
+
+    char *base = static_cast<char *>(data());
+    if (!base)
+        return 0;
+    return base + qt_channelOffset(format(), channelLayout(), frameCount(), channel);
+}
+
 // Template helper classes worth documenting
 
 /*!
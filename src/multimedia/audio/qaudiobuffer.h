@@ -49,11 +49,25 @@ class QAudioBufferPrivate;
 class Q_MULTIMEDIA_EXPORT QAudioBuffer
 {
 public:
+    enum ChannelLayout {
+        InterleavedLayout,
+        PlanarLayout
+    };
+
+    typedef void (*CleanupFunction)(void *cleanupInfo);
+
     QAudioBuffer();
     QAudioBuffer(QAbstractAudioBuffer *provider);
     QAudioBuffer(const QAudioBuffer &other);
     QAudioBuffer(const QByteArray &data, const QAudioFormat &format, qint64 startTime = -1);
     QAudioBuffer(int numFrames, const QAudioFormat &format, qint64 startTime = -1); // Initialized to empty
+    QAudioBuffer(int numFrames, const QAudioFormat &format, ChannelLayout layout, qint64 startTime = -1);
+    QAudioBuffer(void *data, int numFrames, const QAudioFormat &format,
+                 ChannelLayout layout = InterleavedLayout, qint64 startTime = -1,
+                 CleanupFunction cleanupFunction = Q_NULLPTR, void *cleanupInfo = Q_NULLPTR);
+    QAudioBuffer(const void *data, int numFrames, const QAudioFormat &format,
+                 ChannelLayout layout = InterleavedLayout, qint64 startTime = -1,
+                 CleanupFunction cleanupFunction = Q_NULLPTR, void *cleanupInfo = Q_NULLPTR);
 
     QAudioBuffer& operator=(const QAudioBuffer &other);
 
@@ -81,6 +95,15 @@ public:
     const void* data() const; // Does not detach
     void *data(); // detaches
 
+    // Per channel access, for both interleaved and planar buffers
+    ChannelLayout channelLayout() const;
+    int sampleStride() const;
+    const void *constChannelData(int channel) const; // Does not detach
+    void *channelData(int channel); // detaches
+
+    QAudioBuffer convertToFormat(const QAudioFormat &format) const;
+    QAudioBuffer convertToLayout(ChannelLayout layout) const;
+
     // Structures for easier access to stereo data
     template <typename T> struct StereoFrameDefault { enum { Default = 0 }; };
 
@@ -130,6 +153,12 @@ public:
     template <typename T> T* data() {
         return static_cast<T*>(data());
     }
+    template <typename T> const T* constChannelData(int channel) const {
+        return static_cast<const T*>(constChannelData(channel));
+    }
+    template <typename T> T* channelData(int channel) {
+        return static_cast<T*>(channelData(channel));
+    }
 private:
     QAudioBufferPrivate *d;
 };
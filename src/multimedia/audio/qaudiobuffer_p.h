@@ -49,6 +49,7 @@
 #include <qmultimedia.h>
 
 #include "qaudioformat.h"
+#include "qaudiobuffer.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -66,6 +67,7 @@ public:
     virtual QAudioFormat format() const = 0;
     virtual qint64 startTime() const = 0;
     virtual int frameCount() const = 0;
+    virtual QAudioBuffer::ChannelLayout channelLayout() const { return QAudioBuffer::InterleavedLayout; }
 
     // R/O Data
     virtual void *constData() const = 0;
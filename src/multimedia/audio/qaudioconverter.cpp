@@ -0,0 +1,602 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qaudioconverter_p.h"
+
+#include <QtCore/qendian.h>
+#include <QtCore/qvarlengtharray.h>
+#include <private/qsimd_p.h>
+
+#include <math.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Scalar kernels. Floats are quantized with rounding to nearest even, like the
+    SSE2 conversion instructions do, so that both give the same results. The
+    SIMD kernels also use these for leftover samples.
+*/
+
+static inline qint16 qt_floatToS16(float v)
+{
+    return qint16(qMin(lrintf(qBound(-1.0f, v, 1.0f) * 32768.0f), 32767L));
+}
+
+static inline qint32 qt_floatToS32(float v)
+{
+    // The largest float below 1 keeps the product within the range of qint32
+    return qint32(lrintf(qBound(-1.0f, v, 0.99999994f) * 2147483648.0f));
+}
+
+void QT_FASTCALL qt_convertAudio_S16ToF32(const void *src, void *dst, int count)
+{
+    const qint16 *in = static_cast<const qint16 *>(src);
+    float *out = static_cast<float *>(dst);
+    for (int i = 0; i < count; ++i)
+        out[i] = in[i] * (1.0f / 32768.0f);
+}
+
+void QT_FASTCALL qt_convertAudio_F32ToS16(const void *src, void *dst, int count)
+{
+    const float *in = static_cast<const float *>(src);
+    qint16 *out = static_cast<qint16 *>(dst);
+    for (int i = 0; i < count; ++i)
+        out[i] = qt_floatToS16(in[i]);
+}
+
+void QT_FASTCALL qt_convertAudio_U8ToS16(const void *src, void *dst, int count)
+{
+    const quint8 *in = static_cast<const quint8 *>(src);
+    qint16 *out = static_cast<qint16 *>(dst);
+    for (int i = 0; i < count; ++i)
+        out[i] = qint16((in[i] - 128) * 256);
+}
+
+void QT_FASTCALL qt_convertAudio_S16ToU8(const void *src, void *dst, int count)
+{
+    const qint16 *in = static_cast<const qint16 *>(src);
+    quint8 *out = static_cast<quint8 *>(dst);
+    for (int i = 0; i < count; ++i)
+        out[i] = quint8((in[i] >> 8) + 128);
+}
+
+void QT_FASTCALL qt_convertAudio_S32ToS16(const void *src, void *dst, int count)
+{
+    const qint32 *in = static_cast<const qint32 *>(src);
+    qint16 *out = static_cast<qint16 *>(dst);
+    for (int i = 0; i < count; ++i)
+        out[i] = qint16(in[i] >> 16);
+}
+
+void QT_FASTCALL qt_convertAudio_S16ToS32(const void *src, void *dst, int count)
+{
+    const qint16 *in = static_cast<const qint16 *>(src);
+    qint32 *out = static_cast<qint32 *>(dst);
+    for (int i = 0; i < count; ++i)
+        out[i] = qint32(in[i]) * 65536;
+}
+
+void QT_FASTCALL qt_convertAudio_S32ToF32(const void *src, void *dst, int count)
+{
+    const qint32 *in = static_cast<const qint32 *>(src);
+    float *out = static_cast<float *>(dst);
+    for (int i = 0; i < count; ++i)
+        out[i] = float(in[i]) * (1.0f / 2147483648.0f);
+}
+
+void QT_FASTCALL qt_convertAudio_F32ToS32(const void *src, void *dst, int count)
+{
+    const float *in = static_cast<const float *>(src);
+    qint32 *out = static_cast<qint32 *>(dst);
+    for (int i = 0; i < count; ++i)
+        out[i] = qt_floatToS32(in[i]);
+}
+
+void QT_FASTCALL qt_convertAudio_S16StereoToMono(const void *src, void *dst, int frames)
+{
+    const qint16 *in = static_cast<const qint16 *>(src);
+    qint16 *out = static_cast<qint16 *>(dst);
+    for (int i = 0; i < frames; ++i)
+        out[i] = qint16((in[2 * i] + in[2 * i + 1]) >> 1);
+}
+
+void QT_FASTCALL qt_convertAudio_F32StereoToMono(const void *src, void *dst, int frames)
+{
+    const float *in = static_cast<const float *>(src);
+    float *out = static_cast<float *>(dst);
+    for (int i = 0; i < frames; ++i)
+        out[i] = (in[2 * i] + in[2 * i + 1]) * 0.5f;
+}
+
+template <typename T>
+static void qt_duplicateChannel(const void *src, void *dst, int frames)
+{
+    const T *in = static_cast<const T *>(src);
+    T *out = static_cast<T *>(dst);
+    for (int i = 0; i < frames; ++i)
+        out[2 * i] = out[2 * i + 1] = in[i];
+}
+
+void QT_FASTCALL qt_convertAudio_8MonoToStereo(const void *src, void *dst, int frames)
+{
+    qt_duplicateChannel<quint8>(src, dst, frames);
+}
+
+void QT_FASTCALL qt_convertAudio_16MonoToStereo(const void *src, void *dst, int frames)
+{
+    qt_duplicateChannel<quint16>(src, dst, frames);
+}
+
+void QT_FASTCALL qt_convertAudio_32MonoToStereo(const void *src, void *dst, int frames)
+{
+    qt_duplicateChannel<quint32>(src, dst, frames);
+}
+
+static const AudioConvertFunc qScalarAudioConvertFuncs[QAudioConvertKernelCount] = {
+    qt_convertAudio_S16ToF32,
+    qt_convertAudio_F32ToS16,
+    qt_convertAudio_U8ToS16,
+    qt_convertAudio_S16ToU8,
+    qt_convertAudio_S32ToS16,
+    qt_convertAudio_S16ToS32,
+    qt_convertAudio_S32ToF32,
+    qt_convertAudio_F32ToS32,
+    qt_convertAudio_S16StereoToMono,
+    qt_convertAudio_F32StereoToMono,
+    qt_convertAudio_8MonoToStereo,
+    qt_convertAudio_16MonoToStereo,
+    qt_convertAudio_32MonoToStereo
+};
+
+/*
+    Overrides the entries of \a funcs with the kernels of every instruction set
+    up to \a maxLevel which were compiled in and are supported by the CPU, and
+    returns the highest level applied.
+*/
+static QAudioConvertLevel qInitAudioConvertFuncsAsm(AudioConvertFunc *funcs, QAudioConvertLevel maxLevel)
+{
+    QAudioConvertLevel level = QAudioConvertScalar;
+
+#ifdef QT_COMPILER_SUPPORTS_SSE2
+    extern void QT_FASTCALL qt_convertAudio_S16ToF32_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_F32ToS16_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_U8ToS16_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_S16ToU8_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_S32ToS16_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_S16ToS32_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_S32ToF32_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_F32ToS32_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_S16StereoToMono_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_F32StereoToMono_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_8MonoToStereo_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_16MonoToStereo_sse2(const void*, void*, int);
+    extern void QT_FASTCALL qt_convertAudio_32MonoToStereo_sse2(const void*, void*, int);
+    if (maxLevel >= QAudioConvertSSE2 && qCpuHasFeature(SSE2)) {
+        level = QAudioConvertSSE2;
+        funcs[QAudioConvertS16ToF32] = qt_convertAudio_S16ToF32_sse2;
+        funcs[QAudioConvertF32ToS16] = qt_convertAudio_F32ToS16_sse2;
+        funcs[QAudioConvertU8ToS16] = qt_convertAudio_U8ToS16_sse2;
+        funcs[QAudioConvertS16ToU8] = qt_convertAudio_S16ToU8_sse2;
+        funcs[QAudioConvertS32ToS16] = qt_convertAudio_S32ToS16_sse2;
+        funcs[QAudioConvertS16ToS32] = qt_convertAudio_S16ToS32_sse2;
+        funcs[QAudioConvertS32ToF32] = qt_convertAudio_S32ToF32_sse2;
+        funcs[QAudioConvertF32ToS32] = qt_convertAudio_F32ToS32_sse2;
+        funcs[QAudioConvertS16StereoToMono] = qt_convertAudio_S16StereoToMono_sse2;
+        funcs[QAudioConvertF32StereoToMono] = qt_convertAudio_F32StereoToMono_sse2;
+        funcs[QAudioConvert8MonoToStereo] = qt_convertAudio_8MonoToStereo_sse2;
+        funcs[QAudioConvert16MonoToStereo] = qt_convertAudio_16MonoToStereo_sse2;
+        funcs[QAudioConvert32MonoToStereo] = qt_convertAudio_32MonoToStereo_sse2;
+    }
+#endif
+    Q_UNUSED(maxLevel);
+    return level;
+}
+
+// The fastest kernels the CPU supports, set up once in whichever thread
+// converts samples first
+struct QAudioConvertFuncs
+{
+    QAudioConvertFuncs()
+    {
+        memcpy(convert, qScalarAudioConvertFuncs, sizeof(convert));
+        qInitAudioConvertFuncsAsm(convert, QAudioConvertSSE2);
+    }
+
+    AudioConvertFunc convert[QAudioConvertKernelCount];
+};
+
+Q_GLOBAL_STATIC(QAudioConvertFuncs, qAudioConvertFuncs)
+
+static AudioConvertFunc qAudioConvertFunc(QAudioConvertKernel kernel)
+{
+    // Null after the kernels were destroyed on exit
+    const QAudioConvertFuncs *funcs = qAudioConvertFuncs();
+    return funcs ? funcs->convert[kernel] : qScalarAudioConvertFuncs[kernel];
+}
+
+/*!
+    \internal
+
+    Returns the conversion \a kernel using instruction sets up to \a level
+    only, or null if \a level is not available on this CPU.
+
+    Conversions normally pick the fastest kernels available; this allows
+    benchmarks and tests to compare the scalar and each SIMD implementation.
+*/
+AudioConvertFunc qt_audioConvertFunc(QAudioConvertKernel kernel, QAudioConvertLevel level)
+{
+    if (kernel >= QAudioConvertKernelCount)
+        return Q_NULLPTR;
+
+    AudioConvertFunc funcs[QAudioConvertKernelCount];
+    memcpy(funcs, qScalarAudioConvertFuncs, sizeof(funcs));
+    if (qInitAudioConvertFuncsAsm(funcs, level) != level)
+        return Q_NULLPTR;
+
+    return funcs[kernel];
+}
+
+namespace {
+
+enum SampleKind {
+    InvalidSample,
+    UInt8Sample,
+    Int8Sample,
+    UInt16Sample,
+    Int16Sample,
+    UInt32Sample,
+    Int32Sample,
+    FloatSample
+};
+
+SampleKind sampleKind(const QAudioFormat &format)
+{
+    if (format.codec() != QLatin1String("audio/pcm") || format.channelCount() <= 0)
+        return InvalidSample;
+
+    switch (format.sampleSize()) {
+    case 8:
+        if (format.sampleType() == QAudioFormat::UnSignedInt)
+            return UInt8Sample;
+        if (format.sampleType() == QAudioFormat::SignedInt)
+            return Int8Sample;
+        break;
+    case 16:
+        if (format.sampleType() == QAudioFormat::UnSignedInt)
+            return UInt16Sample;
+        if (format.sampleType() == QAudioFormat::SignedInt)
+            return Int16Sample;
+        break;
+    case 32:
+        if (format.sampleType() == QAudioFormat::UnSignedInt)
+            return UInt32Sample;
+        if (format.sampleType() == QAudioFormat::SignedInt)
+            return Int32Sample;
+        if (format.sampleType() == QAudioFormat::Float)
+            return FloatSample;
+        break;
+    default:
+        break;
+    }
+    return InvalidSample;
+}
+
+bool isNativeByteOrder(const QAudioFormat &format)
+{
+    const QAudioFormat::Endian native = QSysInfo::ByteOrder == QSysInfo::LittleEndian
+            ? QAudioFormat::LittleEndian
+            : QAudioFormat::BigEndian;
+    return format.sampleSize() == 8 || format.byteOrder() == native;
+}
+
+// Returns the kernel converting native byte order samples, or -1 if there is none
+int directKernel(SampleKind from, int fromChannels, SampleKind to, int toChannels, int sampleBytes)
+{
+    if (fromChannels == toChannels) {
+        switch (from) {
+        case Int16Sample:
+            if (to == FloatSample)
+                return QAudioConvertS16ToF32;
+            if (to == UInt8Sample)
+                return QAudioConvertS16ToU8;
+            if (to == Int32Sample)
+                return QAudioConvertS16ToS32;
+            break;
+        case FloatSample:
+            if (to == Int16Sample)
+                return QAudioConvertF32ToS16;
+            if (to == Int32Sample)
+                return QAudioConvertF32ToS32;
+            break;
+        case UInt8Sample:
+            if (to == Int16Sample)
+                return QAudioConvertU8ToS16;
+            break;
+        case Int32Sample:
+            if (to == Int16Sample)
+                return QAudioConvertS32ToS16;
+            if (to == FloatSample)
+                return QAudioConvertS32ToF32;
+            break;
+        default:
+            break;
+        }
+    } else if (from == to) {
+        if (fromChannels == 2 && toChannels == 1) {
+            if (from == Int16Sample)
+                return QAudioConvertS16StereoToMono;
+            if (from == FloatSample)
+                return QAudioConvertF32StereoToMono;
+        } else if (fromChannels == 1 && toChannels == 2) {
+            // Duplicating samples does not depend on how they are interpreted
+            if (sampleBytes == 1)
+                return QAudioConvert8MonoToStereo;
+            if (sampleBytes == 2)
+                return QAudioConvert16MonoToStereo;
+            if (sampleBytes == 4)
+                return QAudioConvert32MonoToStereo;
+        }
+    }
+    return -1;
+}
+
+template <typename T>
+inline T readSample(const uchar *src, bool swap)
+{
+    T value;
+    memcpy(&value, src, sizeof(T));
+    return swap ? qbswap(value) : value;
+}
+
+template <typename T>
+inline void writeSample(uchar *dst, T value, bool swap)
+{
+    if (swap)
+        value = qbswap(value);
+    memcpy(dst, &value, sizeof(T));
+}
+
+void decodeSamples(SampleKind kind, bool swap, const uchar *src, float *dst, int count)
+{
+    switch (kind) {
+    case UInt8Sample:
+        for (int i = 0; i < count; ++i)
+            dst[i] = (src[i] - 128) * (1.0f / 128.0f);
+        break;
+    case Int8Sample:
+        for (int i = 0; i < count; ++i)
+            dst[i] = qint8(src[i]) * (1.0f / 128.0f);
+        break;
+    case UInt16Sample:
+        for (int i = 0; i < count; ++i)
+            dst[i] = (readSample<quint16>(src + 2 * i, swap) - 32768) * (1.0f / 32768.0f);
+        break;
+    case Int16Sample:
+        for (int i = 0; i < count; ++i)
+            dst[i] = qint16(readSample<quint16>(src + 2 * i, swap)) * (1.0f / 32768.0f);
+        break;
+    case UInt32Sample:
+        for (int i = 0; i < count; ++i)
+            dst[i] = float(qint32(readSample<quint32>(src + 4 * i, swap) ^ 0x80000000)) * (1.0f / 2147483648.0f);
+        break;
+    case Int32Sample:
+        for (int i = 0; i < count; ++i)
+            dst[i] = float(qint32(readSample<quint32>(src + 4 * i, swap))) * (1.0f / 2147483648.0f);
+        break;
+    case FloatSample:
+        for (int i = 0; i < count; ++i) {
+            const quint32 bits = readSample<quint32>(src + 4 * i, swap);
+            memcpy(dst + i, &bits, 4);
+        }
+        break;
+    case InvalidSample:
+        break;
+    }
+}
+
+inline qint32 quantize(float v, float scale, qint32 minimum, qint32 maximum)
+{
+    return qBound(long(minimum), lrintf(qBound(-1.0f, v, 1.0f) * scale), long(maximum));
+}
+
+void encodeSamples(SampleKind kind, bool swap, const float *src, uchar *dst, int count)
+{
+    switch (kind) {
+    case UInt8Sample:
+        for (int i = 0; i < count; ++i)
+            dst[i] = quint8(quantize(src[i], 128.0f, -128, 127) + 128);
+        break;
+    case Int8Sample:
+        for (int i = 0; i < count; ++i)
+            dst[i] = quint8(qint8(quantize(src[i], 128.0f, -128, 127)));
+        break;
+    case UInt16Sample:
+        for (int i = 0; i < count; ++i)
+            writeSample<quint16>(dst + 2 * i, quint16(qt_floatToS16(src[i]) + 32768), swap);
+        break;
+    case Int16Sample:
+        for (int i = 0; i < count; ++i)
+            writeSample<quint16>(dst + 2 * i, quint16(qt_floatToS16(src[i])), swap);
+        break;
+    case UInt32Sample:
+        for (int i = 0; i < count; ++i)
+            writeSample<quint32>(dst + 4 * i, quint32(qt_floatToS32(src[i])) ^ 0x80000000, swap);
+        break;
+    case Int32Sample:
+        for (int i = 0; i < count; ++i)
+            writeSample<quint32>(dst + 4 * i, quint32(qt_floatToS32(src[i])), swap);
+        break;
+    case FloatSample:
+        for (int i = 0; i < count; ++i) {
+            quint32 bits;
+            memcpy(&bits, src + i, 4);
+            writeSample<quint32>(dst + 4 * i, bits, swap);
+        }
+        break;
+    case InvalidSample:
+        break;
+    }
+}
+
+// Mono is the average of all channels and is copied to all channels,
+// otherwise channels are kept in order, dropping or adding silent ones
+void mixChannels(const float *src, int srcChannels, float *dst, int dstChannels, int frames)
+{
+    for (int frame = 0; frame < frames; ++frame) {
+        const float *in = src + frame * srcChannels;
+        float *out = dst + frame * dstChannels;
+        if (dstChannels == 1) {
+            float sum = 0;
+            for (int c = 0; c < srcChannels; ++c)
+                sum += in[c];
+            out[0] = sum / srcChannels;
+        } else if (srcChannels == 1) {
+            for (int c = 0; c < dstChannels; ++c)
+                out[c] = in[0];
+        } else {
+            const int common = qMin(srcChannels, dstChannels);
+            for (int c = 0; c < common; ++c)
+                out[c] = in[c];
+            for (int c = common; c < dstChannels; ++c)
+                out[c] = 0;
+        }
+    }
+}
+
+void swapSamples(int sampleBytes, const uchar *src, uchar *dst, int count)
+{
+    if (sampleBytes == 2) {
+        for (int i = 0; i < count; ++i)
+            writeSample<quint16>(dst + 2 * i, readSample<quint16>(src + 2 * i, false), true);
+    } else if (sampleBytes == 4) {
+        for (int i = 0; i < count; ++i)
+            writeSample<quint32>(dst + 4 * i, readSample<quint32>(src + 4 * i, false), true);
+    } else if (src != dst) {
+        memcpy(dst, src, count);
+    }
+}
+
+}
+
+/*!
+    \internal
+
+    Returns true if samples in format \a from can be converted to \a to by
+    qt_convertAudioSamples(). Both formats must be linear PCM with 8, 16 or 32
+    bit samples. The sample rates are not taken into account.
+*/
+bool qt_isAudioConversionSupported(const QAudioFormat &from, const QAudioFormat &to)
+{
+    return sampleKind(from) != InvalidSample && sampleKind(to) != InvalidSample;
+}
+
+/*!
+    \internal
+
+    Converts \a frames frames from \a src in format \a from to format \a to,
+    into \a dst. Sample type, sample size, byte order and channel count can all
+    differ, the sample rate is ignored. \a src and \a dst must not overlap,
+    unless both formats have the same sample size and channel count.
+
+    Common conversions between native byte order formats have dedicated,
+    vectorized kernels. The other ones go through blocks of float samples.
+
+    Downmixing to mono averages all channels, upmixing from mono copies the
+    sample to every channel. Between other channel counts, channels are kept
+    in order, with extra ones dropped or silent ones added.
+
+    Returns false if the conversion is not supported.
+*/
+bool qt_convertAudioSamples(const void *src, const QAudioFormat &from,
+                            void *dst, const QAudioFormat &to, int frames)
+{
+    const SampleKind fromKind = sampleKind(from);
+    const SampleKind toKind = sampleKind(to);
+    if (fromKind == InvalidSample || toKind == InvalidSample)
+        return false;
+
+    if (frames <= 0)
+        return true;
+
+    const int fromChannels = from.channelCount();
+    const int toChannels = to.channelCount();
+    const bool swapIn = !isNativeByteOrder(from);
+    const bool swapOut = !isNativeByteOrder(to);
+
+    if (fromKind == toKind && fromChannels == toChannels) {
+        if (swapIn == swapOut) {
+            if (src != dst)
+                memcpy(dst, src, from.bytesForFrames(frames));
+        } else {
+            swapSamples(from.sampleSize() / 8, static_cast<const uchar *>(src),
+                        static_cast<uchar *>(dst), frames * fromChannels);
+        }
+        return true;
+    }
+
+    if (!swapIn && !swapOut) {
+        const int kernel = directKernel(fromKind, fromChannels, toKind, toChannels, from.sampleSize() / 8);
+        if (kernel >= 0) {
+            qAudioConvertFunc(QAudioConvertKernel(kernel))(src, dst, fromChannels == toChannels ? frames * fromChannels : frames);
+            return true;
+        }
+    }
+
+    enum { BlockFrames = 256 };
+    QVarLengthArray<float, BlockFrames * 2> samples(BlockFrames * fromChannels);
+    QVarLengthArray<float, BlockFrames * 2> mixed(fromChannels != toChannels ? BlockFrames * toChannels : 0);
+
+    const uchar *in = static_cast<const uchar *>(src);
+    uchar *out = static_cast<uchar *>(dst);
+    const int inFrameBytes = from.bytesPerFrame();
+    const int outFrameBytes = to.bytesPerFrame();
+
+    for (int done = 0; done < frames; done += BlockFrames) {
+        const int block = qMin(int(BlockFrames), frames - done);
+
+        decodeSamples(fromKind, swapIn, in + done * inFrameBytes, samples.data(), block * fromChannels);
+
+        const float *result = samples.constData();
+        if (fromChannels != toChannels) {
+            mixChannels(samples.constData(), fromChannels, mixed.data(), toChannels, block);
+            result = mixed.constData();
+        }
+
+        encodeSamples(toKind, swapOut, result, out + done * outFrameBytes, block * toChannels);
+    }
+
+    return true;
+}
+
+QT_END_NAMESPACE
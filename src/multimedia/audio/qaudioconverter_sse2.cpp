@@ -0,0 +1,270 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qaudioconverter_p.h"
+
+#include <private/qsimd_p.h>
+
+#ifdef QT_COMPILER_SUPPORTS_SSE2
+
+QT_BEGIN_NAMESPACE
+
+void QT_FASTCALL qt_convertAudio_S16ToF32(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_F32ToS16(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_U8ToS16(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_S16ToU8(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_S32ToS16(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_S16ToS32(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_S32ToF32(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_F32ToS32(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_S16StereoToMono(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_F32StereoToMono(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_8MonoToStereo(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_16MonoToStereo(const void*, void*, int);
+void QT_FASTCALL qt_convertAudio_32MonoToStereo(const void*, void*, int);
+
+// Leftover samples which do not fill a whole vector go through the scalar kernels
+
+void QT_FASTCALL qt_convertAudio_S16ToF32_sse2(const void *src, void *dst, int count)
+{
+    const qint16 *in = static_cast<const qint16 *>(src);
+    float *out = static_cast<float *>(dst);
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    int i = 0;
+    for (; i <= count - 8; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    qt_convertAudio_S16ToF32(in + i, out + i, count - i);
+}
+
+void QT_FASTCALL qt_convertAudio_F32ToS16_sse2(const void *src, void *dst, int count)
+{
+    const float *in = static_cast<const float *>(src);
+    qint16 *out = static_cast<qint16 *>(dst);
+    const __m128 minimum = _mm_set1_ps(-1.0f);
+    const __m128 maximum = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32768.0f);
+
+    int i = 0;
+    for (; i <= count - 8; i += 8) {
+        __m128 lo = _mm_loadu_ps(in + i);
+        __m128 hi = _mm_loadu_ps(in + i + 4);
+        lo = _mm_mul_ps(_mm_min_ps(_mm_max_ps(lo, minimum), maximum), scale);
+        hi = _mm_mul_ps(_mm_min_ps(_mm_max_ps(hi, minimum), maximum), scale);
+        // Saturating pack clips 32768 to 32767
+        const __m128i v = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+    }
+    qt_convertAudio_F32ToS16(in + i, out + i, count - i);
+}
+
+void QT_FASTCALL qt_convertAudio_U8ToS16_sse2(const void *src, void *dst, int count)
+{
+    const quint8 *in = static_cast<const quint8 *>(src);
+    qint16 *out = static_cast<qint16 *>(dst);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(qint16(0x8000));
+
+    int i = 0;
+    for (; i <= count - 16; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        // (x << 8) ^ 0x8000 is (x - 128) << 8
+        const __m128i lo = _mm_xor_si128(_mm_unpacklo_epi8(zero, v), bias);
+        const __m128i hi = _mm_xor_si128(_mm_unpackhi_epi8(zero, v), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), hi);
+    }
+    qt_convertAudio_U8ToS16(in + i, out + i, count - i);
+}
+
+void QT_FASTCALL qt_convertAudio_S16ToU8_sse2(const void *src, void *dst, int count)
+{
+    const qint16 *in = static_cast<const qint16 *>(src);
+    quint8 *out = static_cast<quint8 *>(dst);
+    const __m128i bias = _mm_set1_epi8(char(0x80));
+
+    int i = 0;
+    for (; i <= count - 16; i += 16) {
+        const __m128i lo = _mm_srai_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), 8);
+        const __m128i hi = _mm_srai_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 8)), 8);
+        const __m128i v = _mm_xor_si128(_mm_packs_epi16(lo, hi), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+    }
+    qt_convertAudio_S16ToU8(in + i, out + i, count - i);
+}
+
+void QT_FASTCALL qt_convertAudio_S32ToS16_sse2(const void *src, void *dst, int count)
+{
+    const qint32 *in = static_cast<const qint32 *>(src);
+    qint16 *out = static_cast<qint16 *>(dst);
+
+    int i = 0;
+    for (; i <= count - 8; i += 8) {
+        const __m128i lo = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 4)), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(lo, hi));
+    }
+    qt_convertAudio_S32ToS16(in + i, out + i, count - i);
+}
+
+void QT_FASTCALL qt_convertAudio_S16ToS32_sse2(const void *src, void *dst, int count)
+{
+    const qint16 *in = static_cast<const qint16 *>(src);
+    qint32 *out = static_cast<qint32 *>(dst);
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i <= count - 8; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi16(zero, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 4), _mm_unpackhi_epi16(zero, v));
+    }
+    qt_convertAudio_S16ToS32(in + i, out + i, count - i);
+}
+
+void QT_FASTCALL qt_convertAudio_S32ToF32_sse2(const void *src, void *dst, int count)
+{
+    const qint32 *in = static_cast<const qint32 *>(src);
+    float *out = static_cast<float *>(dst);
+    const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+
+    int i = 0;
+    for (; i <= count - 4; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    qt_convertAudio_S32ToF32(in + i, out + i, count - i);
+}
+
+void QT_FASTCALL qt_convertAudio_F32ToS32_sse2(const void *src, void *dst, int count)
+{
+    const float *in = static_cast<const float *>(src);
+    qint32 *out = static_cast<qint32 *>(dst);
+    const __m128 minimum = _mm_set1_ps(-1.0f);
+    const __m128 maximum = _mm_set1_ps(0.99999994f);
+    const __m128 scale = _mm_set1_ps(2147483648.0f);
+
+    int i = 0;
+    for (; i <= count - 4; i += 4) {
+        const __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), minimum), maximum);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_cvtps_epi32(_mm_mul_ps(v, scale)));
+    }
+    qt_convertAudio_F32ToS32(in + i, out + i, count - i);
+}
+
+void QT_FASTCALL qt_convertAudio_S16StereoToMono_sse2(const void *src, void *dst, int frames)
+{
+    const qint16 *in = static_cast<const qint16 *>(src);
+    qint16 *out = static_cast<qint16 *>(dst);
+    const __m128i ones = _mm_set1_epi16(1);
+
+    int i = 0;
+    for (; i <= frames - 8; i += 8) {
+        // Adds the left and right samples of each frame into 32 bits
+        __m128i lo = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i)), ones);
+        __m128i hi = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i + 8)), ones);
+        lo = _mm_srai_epi32(lo, 1);
+        hi = _mm_srai_epi32(hi, 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(lo, hi));
+    }
+    qt_convertAudio_S16StereoToMono(in + 2 * i, out + i, frames - i);
+}
+
+void QT_FASTCALL qt_convertAudio_F32StereoToMono_sse2(const void *src, void *dst, int frames)
+{
+    const float *in = static_cast<const float *>(src);
+    float *out = static_cast<float *>(dst);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    int i = 0;
+    for (; i <= frames - 4; i += 4) {
+        const __m128 a = _mm_loadu_ps(in + 2 * i);
+        const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+    qt_convertAudio_F32StereoToMono(in + 2 * i, out + i, frames - i);
+}
+
+void QT_FASTCALL qt_convertAudio_8MonoToStereo_sse2(const void *src, void *dst, int frames)
+{
+    const quint8 *in = static_cast<const quint8 *>(src);
+    quint8 *out = static_cast<quint8 *>(dst);
+
+    int i = 0;
+    for (; i <= frames - 16; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(v, v));
+    }
+    qt_convertAudio_8MonoToStereo(in + i, out + 2 * i, frames - i);
+}
+
+void QT_FASTCALL qt_convertAudio_16MonoToStereo_sse2(const void *src, void *dst, int frames)
+{
+    const quint16 *in = static_cast<const quint16 *>(src);
+    quint16 *out = static_cast<quint16 *>(dst);
+
+    int i = 0;
+    for (; i <= frames - 8; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi16(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 8), _mm_unpackhi_epi16(v, v));
+    }
+    qt_convertAudio_16MonoToStereo(in + i, out + 2 * i, frames - i);
+}
+
+void QT_FASTCALL qt_convertAudio_32MonoToStereo_sse2(const void *src, void *dst, int frames)
+{
+    const quint32 *in = static_cast<const quint32 *>(src);
+    quint32 *out = static_cast<quint32 *>(dst);
+
+    int i = 0;
+    for (; i <= frames - 4; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi32(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 4), _mm_unpackhi_epi32(v, v));
+    }
+    qt_convertAudio_32MonoToStereo(in + i, out + 2 * i, frames - i);
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -34,18 +34,28 @@
 #include "qaudiohelpers_p.h"
 
 #include <QDebug>
+#include <private/qsimd_p.h>
 
 QT_BEGIN_NAMESPACE
 
 namespace QAudioHelperInternal
 {
 
-template<class T> void adjustSamples(qreal factor, const void *src, void *dst, int samples)
+template<class T> void adjustSamples(qreal factor, qreal step, int channels, const void *src, void *dst, int samples)
 {
     const T *pSrc = (const T *)src;
     T *pDst = (T*)dst;
-    for ( int i = 0; i < samples; i++ )
-        pDst[i] = pSrc[i] * factor;
+    if (step == 0) {
+        for ( int i = 0; i < samples; i++ )
+            pDst[i] = pSrc[i] * factor;
+        return;
+    }
+
+    for (int i = 0, frame = 0; i < samples; ++frame) {
+        const qreal gain = factor + step * frame;
+        for (int c = 0; c < channels && i < samples; ++c, ++i)
+            pDst[i] = pSrc[i] * gain;
+    }
 }
 
 // Unsigned samples are biased around 0x80/0x8000 :/
@@ -69,39 +79,173 @@ template<> struct signedVersion<quint32>
     enum {offset = 0x80000000};
 };
 
-template<class T> void adjustUnsignedSamples(qreal factor, const void *src, void *dst, int samples)
+template<class T> void adjustUnsignedSamples(qreal factor, qreal step, int channels, const void *src, void *dst, int samples)
 {
     const T *pSrc = (const T *)src;
     T *pDst = (T*)dst;
-    for ( int i = 0; i < samples; i++ ) {
-        pDst[i] = signedVersion<T>::offset + ((typename signedVersion<T>::TS)(pSrc[i] - signedVersion<T>::offset) * factor);
+    for (int i = 0, frame = 0; i < samples; ++frame) {
+        const qreal gain = factor + step * frame;
+        for (int c = 0; c < channels && i < samples; ++c, ++i)
+            pDst[i] = signedVersion<T>::offset + ((typename signedVersion<T>::TS)(pSrc[i] - signedVersion<T>::offset) * gain);
     }
 }
 
+// Scalar kernels, the SIMD ones also fall back to them for leftovers and for
+// ramps over channel counts which don't fit in their registers
+void QT_FASTCALL multiplySamples_int16(const void *src, void *dst, int samples, int channels,
+                                      qreal factor, qreal step)
+{
+    adjustSamples<qint16>(factor, step, channels, src, dst, samples);
+}
+
+void QT_FASTCALL multiplySamples_int32(const void *src, void *dst, int samples, int channels,
+                                      qreal factor, qreal step)
+{
+    adjustSamples<qint32>(factor, step, channels, src, dst, samples);
+}
+
+void QT_FASTCALL multiplySamples_float(const void *src, void *dst, int samples, int channels,
+                                      qreal factor, qreal step)
+{
+    adjustSamples<float>(factor, step, channels, src, dst, samples);
+}
+
+static const SampleGainFunc qScalarGainFuncs[NGainFormats] = {
+    multiplySamples_int16,
+    multiplySamples_int32,
+    multiplySamples_float
+};
+
+/*
+    Overrides the entries of \a funcs with the kernels of every instruction set
+    up to \a maxLevel which were compiled in and are supported by the CPU, and
+    returns the highest level applied.
+*/
+static SampleGainLevel qInitGainFuncsAsm(SampleGainFunc *funcs, SampleGainLevel maxLevel)
+{
+    SampleGainLevel level = GainScalar;
+
+#ifdef QT_COMPILER_SUPPORTS_SSE2
+    extern void QT_FASTCALL multiplySamples_int16_sse2(const void*, void*, int, int, qreal, qreal);
+    extern void QT_FASTCALL multiplySamples_int32_sse2(const void*, void*, int, int, qreal, qreal);
+    extern void QT_FASTCALL multiplySamples_float_sse2(const void*, void*, int, int, qreal, qreal);
+    if (maxLevel >= GainSSE2 && qCpuHasFeature(SSE2)) {
+        level = GainSSE2;
+        funcs[GainInt16] = multiplySamples_int16_sse2;
+        funcs[GainInt32] = multiplySamples_int32_sse2;
+        funcs[GainFloat] = multiplySamples_float_sse2;
+    }
+#endif
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    extern void QT_FASTCALL multiplySamples_int16_avx2(const void*, void*, int, int, qreal, qreal);
+    extern void QT_FASTCALL multiplySamples_int32_avx2(const void*, void*, int, int, qreal, qreal);
+    extern void QT_FASTCALL multiplySamples_float_avx2(const void*, void*, int, int, qreal, qreal);
+    if (maxLevel >= GainAVX2 && qCpuHasFeature(AVX2)) {
+        level = GainAVX2;
+        funcs[GainInt16] = multiplySamples_int16_avx2;
+        funcs[GainInt32] = multiplySamples_int32_avx2;
+        funcs[GainFloat] = multiplySamples_float_avx2;
+    }
+#endif
+    Q_UNUSED(maxLevel);
+    return level;
+}
+
+// The fastest kernels the CPU supports, set up once in whichever thread
+// multiplies samples first
+struct QSampleGainFuncs
+{
+    QSampleGainFuncs()
+    {
+        memcpy(gain, qScalarGainFuncs, sizeof(gain));
+        qInitGainFuncsAsm(gain, GainAVX2);
+    }
+
+    SampleGainFunc gain[NGainFormats];
+};
+
+Q_GLOBAL_STATIC(QSampleGainFuncs, qGainFuncs)
+
+/*
+    Returns the kernel multiplying samples in \a format using instruction sets
+    up to \a level only, or null if \a level is not available on this CPU.
+
+    Audio normally picks the fastest kernels available; this allows benchmarks
+    and tests to compare the scalar and each SIMD implementation.
+*/
+SampleGainFunc qSampleGainFunc(SampleGainFormat format, SampleGainLevel level)
+{
+    if (format >= NGainFormats)
+        return Q_NULLPTR;
+
+    SampleGainFunc funcs[NGainFormats];
+    memcpy(funcs, qScalarGainFuncs, sizeof(funcs));
+    if (qInitGainFuncsAsm(funcs, level) != level)
+        return Q_NULLPTR;
+
+    return funcs[format];
+}
+
 void qMultiplySamples(qreal factor, const QAudioFormat &format, const void* src, void* dest, int len)
 {
-    int samplesCount = len / (format.sampleSize()/8);
+    qMultiplySamples(factor, factor, format, src, dest, len);
+}
+
+/*
+    Multiplies the \a len bytes of samples in \a src by a gain ramping linearly
+    from \a startFactor on the first frame towards \a endFactor, which is
+    reached right after the last frame, and writes them to \a dest. Passing the
+    previous end factor as the start factor of the next buffer makes volume
+    changes smooth instead of clicking.
+
+    Signed 16 and 32 bit integer and float samples use SIMD kernels when
+    available. \a src and \a dest may be the same buffer.
+*/
+void qMultiplySamples(qreal startFactor, qreal endFactor, const QAudioFormat &format,
+                      const void *src, void *dest, int len)
+{
+    const int sampleBytes = format.sampleSize() / 8;
+    if (sampleBytes <= 0 || len <= 0)
+        return;
+
+    int samplesCount = len / sampleBytes;
+
+    // Unity gain leaves the samples as they are
+    if (startFactor == 1 && endFactor == 1) {
+        if (src != dest)
+            memcpy(dest, src, samplesCount * sampleBytes);
+        return;
+    }
+
+    const int channels = qMax(1, format.channelCount());
+    const int frames = samplesCount / channels;
+    const qreal step = frames > 0 ? (endFactor - startFactor) / frames : 0;
+    const qreal factor = startFactor;
+
+    // Null after the kernels were destroyed on exit
+    const QSampleGainFuncs *gainFuncs = qGainFuncs();
+    const SampleGainFunc *funcs = gainFuncs ? gainFuncs->gain : qScalarGainFuncs;
 
     switch ( format.sampleSize() ) {
     case 8:
         if (format.sampleType() == QAudioFormat::SignedInt)
-            QAudioHelperInternal::adjustSamples<qint8>(factor,src,dest,samplesCount);
+            QAudioHelperInternal::adjustSamples<qint8>(factor,step,channels,src,dest,samplesCount);
         else if (format.sampleType() == QAudioFormat::UnSignedInt)
-            QAudioHelperInternal::adjustUnsignedSamples<quint8>(factor,src,dest,samplesCount);
+            QAudioHelperInternal::adjustUnsignedSamples<quint8>(factor,step,channels,src,dest,samplesCount);
         break;
     case 16:
         if (format.sampleType() == QAudioFormat::SignedInt)
-            QAudioHelperInternal::adjustSamples<qint16>(factor,src,dest,samplesCount);
+            funcs[GainInt16](src,dest,samplesCount,channels,factor,step);
         else if (format.sampleType() == QAudioFormat::UnSignedInt)
-            QAudioHelperInternal::adjustUnsignedSamples<quint16>(factor,src,dest,samplesCount);
+            QAudioHelperInternal::adjustUnsignedSamples<quint16>(factor,step,channels,src,dest,samplesCount);
         break;
     default:
         if (format.sampleType() == QAudioFormat::SignedInt)
-            QAudioHelperInternal::adjustSamples<qint32>(factor,src,dest,samplesCount);
+            funcs[GainInt32](src,dest,samplesCount,channels,factor,step);
         else if (format.sampleType() == QAudioFormat::UnSignedInt)
-            QAudioHelperInternal::adjustUnsignedSamples<quint32>(factor,src,dest,samplesCount);
+            QAudioHelperInternal::adjustUnsignedSamples<quint32>(factor,step,channels,src,dest,samplesCount);
         else if (format.sampleType() == QAudioFormat::Float)
-            QAudioHelperInternal::adjustSamples<float>(factor,src,dest,samplesCount);
+            funcs[GainFloat](src,dest,samplesCount,channels,factor,step);
     }
 }
 }
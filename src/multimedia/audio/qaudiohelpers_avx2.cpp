@@ -0,0 +1,184 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qaudiohelpers_p.h"
+
+#include <private/qsimd_p.h>
+
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+
+QT_BEGIN_NAMESPACE
+
+namespace QAudioHelperInternal
+{
+
+void QT_FASTCALL multiplySamples_int16(const void*, void*, int, int, qreal, qreal);
+void QT_FASTCALL multiplySamples_int32(const void*, void*, int, int, qreal, qreal);
+void QT_FASTCALL multiplySamples_float(const void*, void*, int, int, qreal, qreal);
+
+// Each loop iteration handles a block of 16 samples, a ramp can only be applied
+// if the block holds whole frames
+enum { BlockSize = 16 };
+
+static inline bool blockHoldsFrames(int channels, qreal step)
+{
+    return step == 0 || (channels > 0 && BlockSize % channels == 0);
+}
+
+// Gain offsets of the samples first to first + 7 of a block from the first frame of the block
+static inline __m256 gainOffsets_ps(int first, int channels, qreal step)
+{
+    return _mm256_setr_ps(step * ((first + 0) / channels), step * ((first + 1) / channels),
+                          step * ((first + 2) / channels), step * ((first + 3) / channels),
+                          step * ((first + 4) / channels), step * ((first + 5) / channels),
+                          step * ((first + 6) / channels), step * ((first + 7) / channels));
+}
+
+void QT_FASTCALL multiplySamples_int16_avx2(const void *src, void *dst, int samples, int channels,
+                                           qreal factor, qreal step)
+{
+    if (!blockHoldsFrames(channels, step)) {
+        multiplySamples_int16(src, dst, samples, channels, factor, step);
+        return;
+    }
+    if (step == 0)
+        channels = 1;
+
+    const qint16 *pSrc = static_cast<const qint16 *>(src);
+    qint16 *pDst = static_cast<qint16 *>(dst);
+
+    const __m256 offsetLo = gainOffsets_ps(0, channels, step);
+    const __m256 offsetHi = gainOffsets_ps(8, channels, step);
+    const int blockFrames = BlockSize / channels;
+
+    int i = 0;
+    int frame = 0;
+    for (; i < samples - (BlockSize - 1); i += BlockSize, frame += blockFrames) {
+        const __m256 gain = _mm256_set1_ps(factor + step * frame);
+
+        const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc + i));
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(data));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(data, 1));
+
+        const __m256 scaledLo = _mm256_mul_ps(_mm256_cvtepi32_ps(lo), _mm256_add_ps(gain, offsetLo));
+        const __m256 scaledHi = _mm256_mul_ps(_mm256_cvtepi32_ps(hi), _mm256_add_ps(gain, offsetHi));
+
+        // Packing works within 128 bit lanes, put the 64 bit quarters back in order
+        __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(scaledLo), _mm256_cvttps_epi32(scaledHi));
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDst + i), packed);
+    }
+
+    // leftovers
+    if (i < samples)
+        multiplySamples_int16(pSrc + i, pDst + i, samples - i, channels, factor + step * frame, step);
+}
+
+void QT_FASTCALL multiplySamples_int32_avx2(const void *src, void *dst, int samples, int channels,
+                                           qreal factor, qreal step)
+{
+    if (!blockHoldsFrames(channels, step)) {
+        multiplySamples_int32(src, dst, samples, channels, factor, step);
+        return;
+    }
+    if (step == 0)
+        channels = 1;
+
+    const qint32 *pSrc = static_cast<const qint32 *>(src);
+    qint32 *pDst = static_cast<qint32 *>(dst);
+
+    // 32 bit samples don't fit in the mantissa of a float, they are scaled
+    // in double precision like the scalar code does
+    __m256d offsets[BlockSize / 4];
+    for (int k = 0; k < BlockSize / 4; ++k) {
+        offsets[k] = _mm256_setr_pd(step * ((4 * k) / channels), step * ((4 * k + 1) / channels),
+                                    step * ((4 * k + 2) / channels), step * ((4 * k + 3) / channels));
+    }
+    const int blockFrames = BlockSize / channels;
+
+    int i = 0;
+    int frame = 0;
+    for (; i < samples - (BlockSize - 1); i += BlockSize, frame += blockFrames) {
+        const __m256d gain = _mm256_set1_pd(factor + step * frame);
+
+        for (int k = 0; k < BlockSize / 4; ++k) {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + i + 4 * k));
+            const __m256d scaled = _mm256_mul_pd(_mm256_cvtepi32_pd(data), _mm256_add_pd(gain, offsets[k]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + i + 4 * k), _mm256_cvttpd_epi32(scaled));
+        }
+    }
+
+    // leftovers
+    if (i < samples)
+        multiplySamples_int32(pSrc + i, pDst + i, samples - i, channels, factor + step * frame, step);
+}
+
+void QT_FASTCALL multiplySamples_float_avx2(const void *src, void *dst, int samples, int channels,
+                                           qreal factor, qreal step)
+{
+    if (!blockHoldsFrames(channels, step)) {
+        multiplySamples_float(src, dst, samples, channels, factor, step);
+        return;
+    }
+    if (step == 0)
+        channels = 1;
+
+    const float *pSrc = static_cast<const float *>(src);
+    float *pDst = static_cast<float *>(dst);
+
+    const __m256 offsetLo = gainOffsets_ps(0, channels, step);
+    const __m256 offsetHi = gainOffsets_ps(8, channels, step);
+    const int blockFrames = BlockSize / channels;
+
+    int i = 0;
+    int frame = 0;
+    for (; i < samples - (BlockSize - 1); i += BlockSize, frame += blockFrames) {
+        const __m256 gain = _mm256_set1_ps(factor + step * frame);
+
+        const __m256 lo = _mm256_loadu_ps(pSrc + i);
+        const __m256 hi = _mm256_loadu_ps(pSrc + i + 8);
+        _mm256_storeu_ps(pDst + i, _mm256_mul_ps(lo, _mm256_add_ps(gain, offsetLo)));
+        _mm256_storeu_ps(pDst + i + 8, _mm256_mul_ps(hi, _mm256_add_ps(gain, offsetHi)));
+    }
+
+    // leftovers
+    if (i < samples)
+        multiplySamples_float(pSrc + i, pDst + i, samples - i, channels, factor + step * frame, step);
+}
+
+}
+
+QT_END_NAMESPACE
+
+#endif
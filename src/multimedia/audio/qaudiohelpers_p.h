@@ -52,6 +52,29 @@ QT_BEGIN_NAMESPACE
 namespace QAudioHelperInternal
 {
 Q_MULTIMEDIA_EXPORT void qMultiplySamples(qreal factor, const QAudioFormat& format, const void *src, void* dest, int len);
+Q_MULTIMEDIA_EXPORT void qMultiplySamples(qreal startFactor, qreal endFactor, const QAudioFormat &format,
+                                          const void *src, void *dest, int len);
+
+// Sample formats with vectorized gain kernels
+enum SampleGainFormat {
+    GainInt16,
+    GainInt32,
+    GainFloat,
+    NGainFormats
+};
+
+enum SampleGainLevel {
+    GainScalar,
+    GainSSE2,
+    GainAVX2
+};
+
+// Multiplies interleaved samples by a gain starting at factor for the first
+// frame and growing by step for each following frame
+typedef void (QT_FASTCALL *SampleGainFunc)(const void *src, void *dst, int samples, int channels,
+                                           qreal factor, qreal step);
+
+Q_MULTIMEDIA_EXPORT SampleGainFunc qSampleGainFunc(SampleGainFormat format, SampleGainLevel level);
 }
 
 QT_END_NAMESPACE
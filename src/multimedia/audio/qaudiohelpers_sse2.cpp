@@ -0,0 +1,177 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qaudiohelpers_p.h"
+
+#include <private/qsimd_p.h>
+
+#ifdef QT_COMPILER_SUPPORTS_SSE2
+
+QT_BEGIN_NAMESPACE
+
+namespace QAudioHelperInternal
+{
+
+void QT_FASTCALL multiplySamples_int16(const void*, void*, int, int, qreal, qreal);
+void QT_FASTCALL multiplySamples_int32(const void*, void*, int, int, qreal, qreal);
+void QT_FASTCALL multiplySamples_float(const void*, void*, int, int, qreal, qreal);
+
+// Each loop iteration handles a block of 8 samples, a ramp can only be applied
+// if the block holds whole frames
+enum { BlockSize = 8 };
+
+static inline bool blockHoldsFrames(int channels, qreal step)
+{
+    return step == 0 || (channels > 0 && BlockSize % channels == 0);
+}
+
+void QT_FASTCALL multiplySamples_int16_sse2(const void *src, void *dst, int samples, int channels,
+                                           qreal factor, qreal step)
+{
+    if (!blockHoldsFrames(channels, step)) {
+        multiplySamples_int16(src, dst, samples, channels, factor, step);
+        return;
+    }
+    if (step == 0)
+        channels = 1;
+
+    const qint16 *pSrc = static_cast<const qint16 *>(src);
+    qint16 *pDst = static_cast<qint16 *>(dst);
+
+    // Gain offsets of each sample of a block from the first frame of the block
+    const __m128 offsetLo = _mm_setr_ps(step * (0 / channels), step * (1 / channels),
+                                        step * (2 / channels), step * (3 / channels));
+    const __m128 offsetHi = _mm_setr_ps(step * (4 / channels), step * (5 / channels),
+                                        step * (6 / channels), step * (7 / channels));
+    const int blockFrames = BlockSize / channels;
+
+    int i = 0;
+    int frame = 0;
+    for (; i < samples - (BlockSize - 1); i += BlockSize, frame += blockFrames) {
+        const __m128 gain = _mm_set1_ps(factor + step * frame);
+
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + i));
+        // Sign extend to 32 bit
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(data, data), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(data, data), 16);
+
+        const __m128 scaledLo = _mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_add_ps(gain, offsetLo));
+        const __m128 scaledHi = _mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_add_ps(gain, offsetHi));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + i),
+                         _mm_packs_epi32(_mm_cvttps_epi32(scaledLo), _mm_cvttps_epi32(scaledHi)));
+    }
+
+    // leftovers
+    if (i < samples)
+        multiplySamples_int16(pSrc + i, pDst + i, samples - i, channels, factor + step * frame, step);
+}
+
+void QT_FASTCALL multiplySamples_int32_sse2(const void *src, void *dst, int samples, int channels,
+                                           qreal factor, qreal step)
+{
+    if (!blockHoldsFrames(channels, step)) {
+        multiplySamples_int32(src, dst, samples, channels, factor, step);
+        return;
+    }
+    if (step == 0)
+        channels = 1;
+
+    const qint32 *pSrc = static_cast<const qint32 *>(src);
+    qint32 *pDst = static_cast<qint32 *>(dst);
+
+    // 32 bit samples don't fit in the mantissa of a float, they are scaled
+    // in double precision like the scalar code does
+    __m128d offsets[BlockSize / 2];
+    for (int k = 0; k < BlockSize / 2; ++k)
+        offsets[k] = _mm_setr_pd(step * ((2 * k) / channels), step * ((2 * k + 1) / channels));
+    const int blockFrames = BlockSize / channels;
+
+    int i = 0;
+    int frame = 0;
+    for (; i < samples - (BlockSize - 1); i += BlockSize, frame += blockFrames) {
+        const __m128d gain = _mm_set1_pd(factor + step * frame);
+
+        for (int k = 0; k < BlockSize / 2; ++k) {
+            const __m128i data = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pSrc + i + 2 * k));
+            const __m128d scaled = _mm_mul_pd(_mm_cvtepi32_pd(data), _mm_add_pd(gain, offsets[k]));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(pDst + i + 2 * k), _mm_cvttpd_epi32(scaled));
+        }
+    }
+
+    // leftovers
+    if (i < samples)
+        multiplySamples_int32(pSrc + i, pDst + i, samples - i, channels, factor + step * frame, step);
+}
+
+void QT_FASTCALL multiplySamples_float_sse2(const void *src, void *dst, int samples, int channels,
+                                           qreal factor, qreal step)
+{
+    if (!blockHoldsFrames(channels, step)) {
+        multiplySamples_float(src, dst, samples, channels, factor, step);
+        return;
+    }
+    if (step == 0)
+        channels = 1;
+
+    const float *pSrc = static_cast<const float *>(src);
+    float *pDst = static_cast<float *>(dst);
+
+    const __m128 offsetLo = _mm_setr_ps(step * (0 / channels), step * (1 / channels),
+                                        step * (2 / channels), step * (3 / channels));
+    const __m128 offsetHi = _mm_setr_ps(step * (4 / channels), step * (5 / channels),
+                                        step * (6 / channels), step * (7 / channels));
+    const int blockFrames = BlockSize / channels;
+
+    int i = 0;
+    int frame = 0;
+    for (; i < samples - (BlockSize - 1); i += BlockSize, frame += blockFrames) {
+        const __m128 gain = _mm_set1_ps(factor + step * frame);
+
+        const __m128 lo = _mm_loadu_ps(pSrc + i);
+        const __m128 hi = _mm_loadu_ps(pSrc + i + 4);
+        _mm_storeu_ps(pDst + i, _mm_mul_ps(lo, _mm_add_ps(gain, offsetLo)));
+        _mm_storeu_ps(pDst + i + 4, _mm_mul_ps(hi, _mm_add_ps(gain, offsetHi)));
+    }
+
+    // leftovers
+    if (i < samples)
+        multiplySamples_float(pSrc + i, pDst + i, samples - i, channels, factor + step * frame, step);
+}
+
+}
+
+QT_END_NAMESPACE
+
+#endif
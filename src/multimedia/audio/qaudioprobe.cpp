@@ -58,6 +58,7 @@
 
 #include "qaudioprobe.h"
 #include "qmediaaudioprobecontrol.h"
+#include "qmediaaudioprobecontrol_p.h"
 #include "qmediaservice.h"
 #include "qmediarecorder.h"
 #include "qsharedpointer.h"
@@ -67,8 +68,21 @@ QT_BEGIN_NAMESPACE
 
 class QAudioProbePrivate {
 public:
+    void applySettings()
+    {
+        if (QMediaAudioProbeControlPrivate *control = QMediaAudioProbeControlPrivate::get(probee.data()))
+            control->setProbeSettings(this, settings);
+    }
+
+    void removeSettings()
+    {
+        if (QMediaAudioProbeControlPrivate *control = QMediaAudioProbeControlPrivate::get(probee.data()))
+            control->removeProbe(this);
+    }
+
     QPointer<QMediaObject> source;
     QPointer<QMediaAudioProbeControl> probee;
+    QAudioProbeSettings settings;
 };
 
 /*!
@@ -94,6 +108,7 @@ QAudioProbe::~QAudioProbe()
         if (d->probee) {
             disconnect(d->probee.data(), SIGNAL(audioBufferProbed(QAudioBuffer)), this, SIGNAL(audioBufferProbed(QAudioBuffer)));
             disconnect(d->probee.data(), SIGNAL(flush()), this, SIGNAL(flush()));
+            d->removeSettings();
         }
         d->source.data()->service()->releaseControl(d->probee.data());
     }
@@ -123,6 +138,7 @@ bool QAudioProbe::setSource(QMediaObject *source)
     if (!d->source && d->probee) {
         disconnect(d->probee.data(), SIGNAL(audioBufferProbed(QAudioBuffer)), this, SIGNAL(audioBufferProbed(QAudioBuffer)));
         disconnect(d->probee.data(), SIGNAL(flush()), this, SIGNAL(flush()));
+        d->removeSettings();
         d->probee.clear();
     }
 
@@ -131,6 +147,7 @@ bool QAudioProbe::setSource(QMediaObject *source)
             Q_ASSERT(d->probee);
             disconnect(d->probee.data(), SIGNAL(audioBufferProbed(QAudioBuffer)), this, SIGNAL(audioBufferProbed(QAudioBuffer)));
             disconnect(d->probee.data(), SIGNAL(flush()), this, SIGNAL(flush()));
+            d->removeSettings();
             d->source.data()->service()->releaseControl(d->probee.data());
             d->source.clear();
             d->probee.clear();
@@ -145,6 +162,7 @@ bool QAudioProbe::setSource(QMediaObject *source)
             if (d->probee) {
                 connect(d->probee.data(), SIGNAL(audioBufferProbed(QAudioBuffer)), this, SIGNAL(audioBufferProbed(QAudioBuffer)));
                 connect(d->probee.data(), SIGNAL(flush()), this, SIGNAL(flush()));
+                d->applySettings();
                 d->source = source;
             }
         }
@@ -192,6 +210,99 @@ bool QAudioProbe::isActive() const
     return d->probee != 0;
 }
 
+/*!
+    Returns the policy followed to deliver the probed buffers.
+
+    \since 5.7
+    \sa setDeliveryPolicy()
+*/
+QMultimedia::ProbeDeliveryPolicy QAudioProbe::deliveryPolicy() const
+{
+    return d->settings.deliveryPolicy;
+}
+
+/*!
+    Sets the \a policy followed when the probed buffers arrive faster than
+    they are handled.
+
+    The default QMultimedia::LatestOnlyDelivery policy suits previews, only the
+    most recent buffer is delivered. Analysis needing every buffer should
+    use QMultimedia::BlockingQueueDelivery, which makes the media wait while
+    the queue is full. The media is only ever held for a second, after which
+    the oldest buffer is dropped, so the queue must be drained from a thread
+    running an event loop.
+
+    \since 5.7
+    \sa setQueueCapacity(), droppedCount()
+*/
+void QAudioProbe::setDeliveryPolicy(QMultimedia::ProbeDeliveryPolicy policy)
+{
+    d->settings.deliveryPolicy = policy;
+    d->applySettings();
+}
+
+/*!
+    Returns the maximum number of buffers queued for delivery.
+
+    \since 5.7
+    \sa setQueueCapacity()
+*/
+int QAudioProbe::queueCapacity() const
+{
+    return d->settings.queueCapacity;
+}
+
+/*!
+    Sets the maximum number of buffers queued for delivery to \a capacity.
+    It has no effect with the QMultimedia::LatestOnlyDelivery policy.
+
+    \since 5.7
+*/
+void QAudioProbe::setQueueCapacity(int capacity)
+{
+    d->settings.queueCapacity = qMax(1, capacity);
+    d->applySettings();
+}
+
+/*!
+    Returns the number of buffers dropped, since the statistics were last
+    reset, because they could not be delivered in time.
+
+    The count covers all the probes monitoring the same media object.
+
+    \since 5.7
+    \sa resetStatistics()
+*/
+int QAudioProbe::droppedCount() const
+{
+    QMediaAudioProbeControlPrivate *control = QMediaAudioProbeControlPrivate::get(d->probee.data());
+    return control ? control->queue.droppedCount() : 0;
+}
+
+/*!
+    Returns the largest number of buffers that were waiting for delivery at
+    the same time, since the statistics were last reset.
+
+    \since 5.7
+    \sa resetStatistics()
+*/
+int QAudioProbe::queueHighWaterMark() const
+{
+    QMediaAudioProbeControlPrivate *control = QMediaAudioProbeControlPrivate::get(d->probee.data());
+    return control ? control->queue.highWaterMark() : 0;
+}
+
+/*!
+    Resets the dropped count and the queue high-water mark.
+
+    \since 5.7
+*/
+void QAudioProbe::resetStatistics()
+{
+    if (QMediaAudioProbeControlPrivate *control = QMediaAudioProbeControlPrivate::get(d->probee.data()))
+        control->queue.resetStatistics();
+}
+
 /*!
     \fn QAudioProbe::audioBufferProbed(const QAudioBuffer &buffer)
 
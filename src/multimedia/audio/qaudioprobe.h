@@ -36,6 +36,7 @@
 
 #include <QtCore/qobject.h>
 #include <QtMultimedia/qaudiobuffer.h>
+#include <QtMultimedia/qmultimedia.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -55,6 +56,16 @@ public:
 
     bool isActive() const;
 
+    QMultimedia::ProbeDeliveryPolicy deliveryPolicy() const;
+    void setDeliveryPolicy(QMultimedia::ProbeDeliveryPolicy policy);
+
+    int queueCapacity() const;
+    void setQueueCapacity(int capacity);
+
+    int droppedCount() const;
+    int queueHighWaterMark() const;
+    void resetStatistics();
+
 Q_SIGNALS:
     void audioBufferProbed(const QAudioBuffer &audioBuffer);
     void flush();
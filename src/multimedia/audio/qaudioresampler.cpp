@@ -0,0 +1,459 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qaudioresampler_p.h"
+
+#include <QtCore/qmath.h>
+#include <QtCore/qvarlengtharray.h>
+#include <private/qsimd_p.h>
+
+QT_BEGIN_NAMESPACE
+
+static float QT_FASTCALL qt_resampleDot(const float *samples, const float *coefficients, int count)
+{
+    float sum = 0;
+    for (int i = 0; i < count; ++i)
+        sum += samples[i] * coefficients[i];
+    return sum;
+}
+
+/*
+    Sets \a dot to the kernel of the highest instruction set up to \a maxLevel
+    which was compiled in and is supported by the CPU, and returns its level.
+*/
+static QAudioResampleLevel qInitResampleAsm(AudioResampleDotFunc *dot, QAudioResampleLevel maxLevel)
+{
+    QAudioResampleLevel level = QAudioResampleScalar;
+
+#ifdef QT_COMPILER_SUPPORTS_SSE2
+    extern float QT_FASTCALL qt_resampleDot_sse2(const float*, const float*, int);
+    if (maxLevel >= QAudioResampleSSE2 && qCpuHasFeature(SSE2)) {
+        level = QAudioResampleSSE2;
+        *dot = qt_resampleDot_sse2;
+    }
+#endif
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    extern float QT_FASTCALL qt_resampleDot_avx2(const float*, const float*, int);
+    if (maxLevel >= QAudioResampleAVX2 && qCpuHasFeature(AVX2)) {
+        level = QAudioResampleAVX2;
+        *dot = qt_resampleDot_avx2;
+    }
+#endif
+    Q_UNUSED(maxLevel);
+    return level;
+}
+
+// The fastest kernel the CPU supports, set up once in whichever thread
+// resamples first
+struct QAudioResampleFuncs
+{
+    QAudioResampleFuncs()
+        : dot(qt_resampleDot)
+    {
+        qInitResampleAsm(&dot, QAudioResampleAVX2);
+    }
+
+    AudioResampleDotFunc dot;
+};
+
+Q_GLOBAL_STATIC(QAudioResampleFuncs, qResampleFuncs)
+
+/*!
+    \internal
+
+    Returns the filter kernel of the resampler using instruction sets up to
+    \a level only, or null if \a level is not available on this CPU.
+*/
+AudioResampleDotFunc qt_audioResampleDotFunc(QAudioResampleLevel level)
+{
+    AudioResampleDotFunc dot = qt_resampleDot;
+    if (qInitResampleAsm(&dot, level) != level)
+        return Q_NULLPTR;
+    return dot;
+}
+
+namespace {
+
+struct QualityParameters
+{
+    int taps;       // filter length when upsampling
+    double rolloff; // cutoff relative to the lower Nyquist frequency
+    double beta;    // Kaiser window shape, higher attenuates more
+};
+
+const QualityParameters qualityParameters[] = {
+    { 16, 0.85, 5.0 },  // FastQuality
+    { 32, 0.91, 7.0 },  // MediumQuality
+    { 64, 0.95, 9.0 }   // HighQuality
+};
+
+enum {
+    MaximumTaps = 512,
+    MaximumPhases = 1024,
+    BlockFrames = 1024
+};
+
+double besselI0(double x)
+{
+    const double y = x * x / 4;
+    double sum = 1;
+    double term = 1;
+    for (int k = 1; k < 64 && term > sum * 1e-12; ++k) {
+        term *= y / (double(k) * k);
+        sum += term;
+    }
+    return sum;
+}
+
+int greatestCommonDivisor(int a, int b)
+{
+    while (b) {
+        const int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+}
+
+/*!
+    \class QAudioResampler
+    \internal
+
+    \brief The QAudioResampler class converts the sample rate of a stream of
+    interleaved float samples.
+
+    It is a polyphase windowed sinc filter: every output frame is the dot
+    product of the input frames around it with one of a bank of precomputed
+    filters, picked by the position of the output frame between two input
+    frames. The ratio of the rates is reduced to an exact fraction, so the
+    output does not drift however long the stream is.
+
+    The \l Quality sets the length of the filters and how close their cutoff is
+    to the Nyquist frequency, trading CPU time for less aliasing and a flatter
+    passband.
+
+    Output frames are aligned with the input: the first output frame is at the
+    time of the first input frame. Producing it needs latencyFrames() input
+    frames after it though, so these are held back until more input comes or
+    flush() is called. The latency only depends on the rates and quality and
+    never changes while streaming.
+*/
+
+QAudioResampler::QAudioResampler()
+{
+    setup(0, 0, 0);
+}
+
+QAudioResampler::QAudioResampler(int inputRate, int outputRate, int channels, Quality quality)
+{
+    setup(inputRate, outputRate, channels, quality);
+}
+
+/*!
+    Sets up the resampler to convert \a channels channels from \a inputRate to
+    \a outputRate Hz with \a quality, and resets it.
+*/
+void QAudioResampler::setup(int inputRate, int outputRate, int channels, Quality quality)
+{
+    m_inputRate = inputRate;
+    m_outputRate = outputRate;
+    m_channels = channels;
+    m_quality = quality;
+    m_interpolation = 1;
+    m_decimation = 1;
+    m_taps = 0;
+    m_phaseCount = 0;
+    m_coefficients.clear();
+    m_history.clear();
+    m_capacity = 0;
+    m_dot = Q_NULLPTR;
+
+    if (inputRate <= 0 || outputRate <= 0 || channels <= 0) {
+        reset();
+        return;
+    }
+
+    const int divisor = greatestCommonDivisor(inputRate, outputRate);
+    m_interpolation = outputRate / divisor;
+    m_decimation = inputRate / divisor;
+
+    // Downsampling lowers the cutoff below the input Nyquist frequency, which
+    // takes proportionally longer filters for the same transition band
+    const QualityParameters &parameters = qualityParameters[quality];
+    const double ratio = qMin(1.0, double(m_interpolation) / m_decimation);
+    m_taps = qMin(int(MaximumTaps), (int(ceil(parameters.taps / ratio)) + 7) & ~7);
+
+    // Exact fractions with very large terms share the closest filters
+    m_phaseCount = qMin(m_interpolation, int(MaximumPhases));
+
+    // Equal rates get a full band filter, which passes the input unchanged
+    const double rolloff = m_interpolation == m_decimation ? 1.0 : parameters.rolloff;
+    const double cutoff = 0.5 * rolloff * ratio;
+    const double windowScale = 1.0 / besselI0(parameters.beta);
+    const int half = m_taps / 2;
+
+    m_coefficients.resize(m_phaseCount * m_taps);
+    QVarLengthArray<double, 128> taps(m_taps);
+    for (int phase = 0; phase < m_phaseCount; ++phase) {
+        const double offset = double(phase) / m_phaseCount;
+        double sum = 0;
+        for (int i = 0; i < m_taps; ++i) {
+            // Distance from the output frame to the input frame of this tap
+            const double distance = offset + half - 1 - i;
+            const double x = distance / half;
+            const double window = qAbs(x) < 1 ? besselI0(parameters.beta * sqrt(1 - x * x)) * windowScale : 0;
+            const double arg = M_PI * 2 * cutoff * distance;
+            const double sinc = distance == 0 ? 1 : sin(arg) / arg;
+            taps[i] = sinc * window;
+            sum += taps[i];
+        }
+
+        // Unity gain at DC for every phase
+        float *coefficients = m_coefficients.data() + phase * m_taps;
+        for (int i = 0; i < m_taps; ++i)
+            coefficients[i] = float(taps[i] / sum);
+    }
+
+    // Null after the kernel was destroyed on exit
+    const QAudioResampleFuncs *funcs = qResampleFuncs();
+    m_dot = funcs ? funcs->dot : qt_resampleDot;
+
+    reset();
+}
+
+/*!
+    Returns true if the resampler has been set up with valid rates and channel
+    count.
+*/
+bool QAudioResampler::isValid() const
+{
+    return m_taps > 0;
+}
+
+/*!
+    Returns the number of input frames held back to compute the output.
+*/
+int QAudioResampler::latencyFrames() const
+{
+    return m_taps / 2;
+}
+
+/*!
+    Returns the duration in microseconds of the input held back to compute the
+    output.
+*/
+qint64 QAudioResampler::latency() const
+{
+    return m_inputRate > 0 ? qint64(latencyFrames()) * 1000000 / m_inputRate : 0;
+}
+
+/*!
+    Returns the number of output frames produced by \a inputFrames frames of
+    a whole stream at \a inputRate Hz, converted to \a outputRate Hz.
+*/
+qint64 QAudioResampler::outputFrameCount(qint64 inputFrames, int inputRate, int outputRate)
+{
+    if (inputFrames <= 0 || inputRate <= 0 || outputRate <= 0)
+        return 0;
+    return (inputFrames * outputRate + inputRate - 1) / inputRate;
+}
+
+/*!
+    Returns the largest number of frames process() can produce from
+    \a inputFrames more input frames, including any pending ones.
+*/
+int QAudioResampler::maximumOutputFrames(int inputFrames) const
+{
+    if (!isValid())
+        return 0;
+    const qint64 available = qint64(m_buffered) + qMax(0, inputFrames) - m_index;
+    return int(qMax(qint64(0), (available * m_interpolation - m_phase) / m_decimation + 1));
+}
+
+/*!
+    Resamples \a inputFrames frames of \a input and writes up to
+    \a maxOutputFrames frames to \a output, returning how many were written.
+
+    All of the input is consumed. Output that does not fit, or which needs
+    input that did not come yet, is produced by the next calls.
+*/
+int QAudioResampler::process(const float *input, int inputFrames, float *output, int maxOutputFrames)
+{
+    if (!isValid() || m_flushed)
+        return 0;
+
+    int written = 0;
+    int consumed = 0;
+    do {
+        const int frames = qMin(int(BlockFrames), inputFrames - consumed);
+        if (frames > 0) {
+            appendFrames(input + qint64(consumed) * m_channels, frames);
+            consumed += frames;
+            m_inputFrames += frames;
+        }
+        written += produce(output + qint64(written) * m_channels, maxOutputFrames - written, -1);
+        discardConsumedFrames();
+    } while (consumed < inputFrames);
+
+    return written;
+}
+
+/*!
+    Ends the stream: writes up to \a maxOutputFrames of the output frames held
+    back for the latency to \a output, returning how many were written. It can
+    be called again until it returns 0, if \a output is too small.
+
+    process() does nothing after this until reset() is called.
+*/
+int QAudioResampler::flush(float *output, int maxOutputFrames)
+{
+    if (!isValid())
+        return 0;
+
+    if (!m_flushed) {
+        // The frames after the end of the stream are silent
+        appendSilence(latencyFrames());
+        m_flushed = true;
+    }
+
+    const qint64 total = outputFrameCount(m_inputFrames, m_decimation, m_interpolation);
+    const int written = produce(output, maxOutputFrames, total);
+    discardConsumedFrames();
+    return written;
+}
+
+/*!
+    Drops any pending input and starts a new stream.
+*/
+void QAudioResampler::reset()
+{
+    m_buffered = 0;
+    m_index = 0;
+    m_phase = 0;
+    m_inputFrames = 0;
+    m_outputFrames = 0;
+    m_flushed = false;
+
+    if (!isValid())
+        return;
+
+    // The frames before the start of the stream are silent
+    appendSilence(latencyFrames() - 1);
+    m_index = m_buffered;
+}
+
+void QAudioResampler::reserveFrames(int frames)
+{
+    if (m_buffered + frames > m_capacity) {
+        const int capacity = qMax(m_buffered + frames, m_capacity * 2);
+        QVector<float> history(capacity * m_channels, 0.0f);
+        for (int c = 0; c < m_channels; ++c) {
+            memcpy(history.data() + c * capacity, m_history.constData() + c * m_capacity,
+                   m_buffered * sizeof(float));
+        }
+        m_history.swap(history);
+        m_capacity = capacity;
+    }
+}
+
+void QAudioResampler::appendFrames(const float *input, int frames)
+{
+    reserveFrames(frames);
+
+    // Each channel is kept contiguous for the filter kernel
+    float *history = m_history.data();
+    for (int c = 0; c < m_channels; ++c) {
+        float *channel = history + c * m_capacity + m_buffered;
+        for (int i = 0; i < frames; ++i)
+            channel[i] = input[i * m_channels + c];
+    }
+    m_buffered += frames;
+}
+
+void QAudioResampler::appendSilence(int frames)
+{
+    reserveFrames(frames);
+
+    float *history = m_history.data();
+    for (int c = 0; c < m_channels; ++c)
+        memset(history + c * m_capacity + m_buffered, 0, frames * sizeof(float));
+    m_buffered += frames;
+}
+
+int QAudioResampler::produce(float *output, int maxOutputFrames, qint64 limit)
+{
+    const int half = latencyFrames();
+    const float *history = m_history.constData();
+
+    int written = 0;
+    while (written < maxOutputFrames && m_index + half < m_buffered
+           && (limit < 0 || m_outputFrames < limit)) {
+        const int bank = m_phaseCount == m_interpolation
+                ? m_phase
+                : int(qint64(m_phase) * m_phaseCount / m_interpolation);
+        const float *coefficients = m_coefficients.constData() + bank * m_taps;
+        const int first = m_index - half + 1;
+
+        for (int c = 0; c < m_channels; ++c)
+            output[c] = m_dot(history + c * m_capacity + first, coefficients, m_taps);
+        output += m_channels;
+        ++written;
+        ++m_outputFrames;
+
+        m_phase += m_decimation;
+        m_index += m_phase / m_interpolation;
+        m_phase %= m_interpolation;
+    }
+    return written;
+}
+
+void QAudioResampler::discardConsumedFrames()
+{
+    // Keep the frames the next output frame needs
+    const int first = qMin(m_index - latencyFrames() + 1, m_buffered);
+    if (first <= 0)
+        return;
+
+    float *history = m_history.data();
+    for (int c = 0; c < m_channels; ++c) {
+        float *channel = history + c * m_capacity;
+        memmove(channel, channel + first, (m_buffered - first) * sizeof(float));
+    }
+    m_buffered -= first;
+    m_index -= first;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,131 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QAUDIORESAMPLER_P_H
+#define QAUDIORESAMPLER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qtmultimediadefs.h>
+#include <QtCore/qvector.h>
+
+QT_BEGIN_NAMESPACE
+
+enum QAudioResampleLevel {
+    QAudioResampleScalar,
+    QAudioResampleSSE2,
+    QAudioResampleAVX2
+};
+
+// Dot product of two float arrays, count is a multiple of 8
+typedef float (QT_FASTCALL *AudioResampleDotFunc)(const float *samples, const float *coefficients, int count);
+
+Q_MULTIMEDIA_EXPORT AudioResampleDotFunc qt_audioResampleDotFunc(QAudioResampleLevel level);
+
+class Q_MULTIMEDIA_EXPORT QAudioResampler
+{
+public:
+    enum Quality {
+        FastQuality,
+        MediumQuality,
+        HighQuality
+    };
+
+    QAudioResampler();
+    QAudioResampler(int inputRate, int outputRate, int channels, Quality quality = MediumQuality);
+
+    void setup(int inputRate, int outputRate, int channels, Quality quality = MediumQuality);
+    bool isValid() const;
+
+    int inputRate() const { return m_inputRate; }
+    int outputRate() const { return m_outputRate; }
+    int channelCount() const { return m_channels; }
+    Quality quality() const { return m_quality; }
+    int filterLength() const { return m_taps; }
+
+    int latencyFrames() const;
+    qint64 latency() const;
+
+    int maximumOutputFrames(int inputFrames) const;
+    static qint64 outputFrameCount(qint64 inputFrames, int inputRate, int outputRate);
+
+    int process(const float *input, int inputFrames, float *output, int maxOutputFrames);
+    int flush(float *output, int maxOutputFrames);
+    void reset();
+
+private:
+    void reserveFrames(int frames);
+    void appendFrames(const float *input, int frames);
+    void appendSilence(int frames);
+    int produce(float *output, int maxOutputFrames, qint64 limit);
+    void discardConsumedFrames();
+
+    int m_inputRate;
+    int m_outputRate;
+    int m_channels;
+    Quality m_quality;
+
+    // Output frames advance by m_decimation / m_interpolation input frames
+    int m_interpolation;
+    int m_decimation;
+    int m_taps;
+    int m_phaseCount;
+    QVector<float> m_coefficients;
+
+    // Planar input history, m_capacity frames per channel
+    QVector<float> m_history;
+    int m_capacity;
+    int m_buffered;
+    int m_index;
+    int m_phase;
+
+    qint64 m_inputFrames;
+    qint64 m_outputFrames;
+    bool m_flushed;
+
+    AudioResampleDotFunc m_dot;
+};
+
+QT_END_NAMESPACE
+
+#endif // QAUDIORESAMPLER_P_H
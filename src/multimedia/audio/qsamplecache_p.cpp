@@ -33,12 +33,22 @@
 
 #include "qsamplecache_p.h"
 #include "qwavedecoder_p.h"
+#include "qaudiodecoder.h"
 
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QNetworkRequest>
 
 #include <QtCore/QDebug>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/qendian.h>
+
+#include <limits>
 //#define QT_SAMPLECACHE_DEBUG
 
 QT_BEGIN_NAMESPACE
@@ -79,6 +89,31 @@ QT_BEGIN_NAMESPACE
         }
     \endcode
 
+    Uncompressed WAV samples from local files and resources are memory
+    mapped, the sample data then points into the file instead of a copy on
+    the heap. The cache accounts for mapped and heap data separately, both
+    count towards the capacity.
+
+    Samples load concurrently on a small pool of loading threads, at most
+    maximumConcurrentLoads() at a time. The others wait in a queue ordered
+    by the priority they were requested with, so that a sound needed right
+    away can be requested with HighPriority ahead of background preloads
+    requested with LowPriority. loadingCount() tells how many samples are
+    still queued or loading.
+
+    Local files and resources in other formats than WAV, like Ogg Vorbis or
+    Opus, are decoded with QAudioDecoder in the loading threads. The decoded
+    PCM data is kept as a WAV file in diskCacheDirectory(), named after the
+    URL and the modification time of the file, or the contents of a
+    resource. Later loads of the same file then map that WAV file instead of
+    decoding it again. The directory holds at most diskCacheCapacity() bytes,
+    the oldest decoded samples are removed to make room for new ones.
+
+    Samples that are no longer referenced stay in the cache as long as the
+    capacity allows, see setCapacity(). When loading a new sample exceeds it,
+    the least recently used of them are unloaded first. statistics() tells
+    how much memory the cache uses and how well it works.
+
     When you no longer need the sound sample data, you need to release it:
 
     \code
@@ -91,30 +126,42 @@ QT_BEGIN_NAMESPACE
 
 QSampleCache::QSampleCache(QObject *parent)
     : QObject(parent)
-    , m_networkAccessManager(0)
     , m_mutex(QMutex::Recursive)
     , m_capacity(0)
     , m_usage(0)
+    , m_mappedUsage(0)
+    , m_diskCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+    , m_diskCacheCapacity(64 * 1024 * 1024)
     , m_loadingRefCount(0)
+    , m_activeLoads(0)
+    , m_maximumLoads(qMax(1, QThread::idealThreadCount()))
+    , m_loadingThreadsExiting(false)
 {
-    m_loadingThread.setObjectName(QLatin1String("QSampleCache::LoadingThread"));
-    connect(&m_loadingThread, SIGNAL(finished()), this, SIGNAL(isLoadingChanged()));
-    connect(&m_loadingThread, SIGNAL(started()), this, SIGNAL(isLoadingChanged()));
+    if (!m_diskCacheDirectory.isEmpty())
+        m_diskCacheDirectory += QLatin1String("/qsamplecache");
 }
 
+// Called in loading threads, each one needs its own
 QNetworkAccessManager& QSampleCache::networkAccessManager()
 {
-    if (!m_networkAccessManager)
-        m_networkAccessManager = new QNetworkAccessManager();
-    return *m_networkAccessManager;
+    QMutexLocker locker(&m_mutex);
+    QNetworkAccessManager *&manager = m_networkAccessManagers[QThread::currentThread()];
+    if (!manager)
+        manager = new QNetworkAccessManager();
+    return *manager;
 }
 
 QSampleCache::~QSampleCache()
 {
     QMutexLocker m(&m_mutex);
 
-    m_loadingThread.quit();
-    m_loadingThread.wait();
+    // Samples deleted below still finish their loads, quietly
+    blockSignals(true);
+
+    foreach (QThread *thread, m_loadingThreads) {
+        thread->quit();
+        thread->wait();
+    }
 
     // Killing the loading thread means that no samples can be
     // deleted using deleteLater.  And some samples that had deleteLater
@@ -125,22 +172,253 @@ QSampleCache::~QSampleCache()
     foreach (QSample* sample, m_staleSamples)
         delete sample; // deleting a sample does affect the m_staleSamples list, but foreach copies it
 
-    m_networkAccessManager->deleteLater();
+    // Their threads are gone, so they can be deleted from here
+    qDeleteAll(m_networkAccessManagers);
 }
 
+// Called in both threads
 void QSampleCache::loadingRelease()
 {
     QMutexLocker locker(&m_loadingMutex);
     m_loadingRefCount--;
-    if (m_loadingRefCount == 0) {
-        if (m_loadingThread.isRunning())
-            m_loadingThread.exit();
+    if (m_loadingRefCount > 0)
+        return;
+
+    // Idle threads are stopped until the next load
+    foreach (QThread *thread, m_loadingThreads) {
+        if (thread->isRunning())
+            thread->exit();
     }
+    m_loadingThreadsExiting = true;
+    locker.unlock();
+
+    // Notified from the application thread, like the start of the loading
+    QMetaObject::invokeMethod(this, "isLoadingChanged", Qt::QueuedConnection);
 }
 
 bool QSampleCache::isLoading() const
 {
-    return m_loadingThread.isRunning();
+    QMutexLocker locker(&m_loadingMutex);
+    return m_loadingRefCount > 0;
+}
+
+/*
+    Returns the number of samples waiting to be loaded or loading.
+*/
+int QSampleCache::loadingCount() const
+{
+    QMutexLocker locker(&m_loadingMutex);
+    return m_pendingLoads.size() + m_activeLoads;
+}
+
+/*
+    Returns the directory holding the decoded compressed samples, empty when
+    they are not kept on disk.
+*/
+QString QSampleCache::diskCacheDirectory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_diskCacheDirectory;
+}
+
+void QSampleCache::setDiskCacheDirectory(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_diskCacheDirectory = directory;
+}
+
+/*
+    Returns how many bytes the decoded samples may take in
+    diskCacheDirectory(), 64 MB by default. Samples are not kept on disk
+    when it is 0.
+*/
+qint64 QSampleCache::diskCacheCapacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_diskCacheCapacity;
+}
+
+void QSampleCache::setDiskCacheCapacity(qint64 capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_diskCacheCapacity = qMax(qint64(0), capacity);
+}
+
+// Called in loading thread
+// Removes the oldest decoded samples until size more bytes fit in the disk
+// cache. Returns false if they can't fit at all.
+bool QSampleCache::reserveDiskCacheSpace(qint64 size) const
+{
+    QString path;
+    qint64 capacity;
+    {
+        QMutexLocker locker(&m_mutex);
+        path = m_diskCacheDirectory;
+        capacity = m_diskCacheCapacity;
+    }
+    if (path.isEmpty() || size > capacity)
+        return false;
+
+    // Newest first, those keep their place
+    const QFileInfoList files = QDir(path).entryInfoList(QStringList(QLatin1String("*.wav")),
+                                                          QDir::Files, QDir::Time);
+    qint64 used = size;
+    foreach (const QFileInfo &file, files) {
+        if (used + file.size() <= capacity)
+            used += file.size();
+        else
+            QFile::remove(file.absoluteFilePath());
+    }
+    return true;
+}
+
+// Called in loading thread
+// The name of the decoded copy of the file behind url, which changes along
+// with the file. Returns an empty string if decoded samples are not kept.
+QString QSampleCache::diskCacheFileName(const QUrl &url, const QString &fileName) const
+{
+    const QString directory = diskCacheDirectory();
+    if (directory.isEmpty())
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (fileName.startsWith(QLatin1Char(':'))) {
+        // Resources have no modification time, they are built in
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file))
+            return QString();
+    } else {
+        const QFileInfo info(fileName);
+        hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+        hash.addData(QByteArray::number(info.size()));
+    }
+
+    const QByteArray urlHash = QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex();
+    return directory + QLatin1Char('/') + QLatin1String(urlHash) + QLatin1Char('-')
+            + QLatin1String(hash.result().toHex()) + QLatin1String(".wav");
+}
+
+int QSampleCache::maximumConcurrentLoads() const
+{
+    QMutexLocker locker(&m_loadingMutex);
+    return m_maximumLoads;
+}
+
+// Called in application thread
+void QSampleCache::setMaximumConcurrentLoads(int loads)
+{
+    {
+        QMutexLocker locker(&m_loadingMutex);
+        m_maximumLoads = qMax(1, loads);
+    }
+    startPendingLoads();
+}
+
+// Called in application thread
+void QSampleCache::queueLoad(QSample *sample, int priority)
+{
+    {
+        QMutexLocker locker(&m_loadingMutex);
+        // Behind the samples of the same priority, they were requested first
+        int index = 0;
+        while (index < m_pendingLoads.size() && m_pendingLoads.at(index)->m_priority >= priority)
+            ++index;
+        sample->m_priority = priority;
+        m_pendingLoads.insert(index, sample);
+    }
+    emit loadingCountChanged();
+
+    startPendingLoads();
+}
+
+/*
+    Moves \a sample ahead of the samples of a lower priority than \a priority
+    if it is still waiting to be loaded.
+*/
+// Called in application thread
+void QSampleCache::raisePriority(QSample *sample, Priority priority)
+{
+    QMutexLocker locker(&m_loadingMutex);
+    if (sample->m_priority >= priority || !m_pendingLoads.removeOne(sample))
+        return;
+
+    int index = 0;
+    while (index < m_pendingLoads.size() && m_pendingLoads.at(index)->m_priority >= priority)
+        ++index;
+    sample->m_priority = priority;
+    m_pendingLoads.insert(index, sample);
+}
+
+// Called in application thread, loads are only handed out from there since
+// samples can only be moved to a loading thread from the application thread
+void QSampleCache::startPendingLoads()
+{
+    QMutexLocker locker(&m_loadingMutex);
+    if (m_pendingLoads.isEmpty() || m_activeLoads >= m_maximumLoads)
+        return;
+
+    if (m_loadingThreadsExiting) {
+        // Threads asked to exit while idle have to finish before restarting
+        m_loadingThreadsExiting = false;
+        locker.unlock();
+        foreach (QThread *thread, m_loadingThreads)
+            thread->wait();
+        locker.relock();
+    }
+
+    while (!m_pendingLoads.isEmpty() && m_activeLoads < m_maximumLoads) {
+        QSample *sample = m_pendingLoads.takeFirst();
+
+        // Samples loading again after an error stay in their thread
+        int index = m_loadingThreads.indexOf(sample->thread());
+        if (index < 0) {
+            index = 0;
+            for (int i = 1; i < m_loadingThreads.size(); ++i) {
+                if (m_threadLoads.at(i) < m_threadLoads.at(index))
+                    index = i;
+            }
+            if (m_loadingThreads.isEmpty()
+                    || (m_threadLoads.at(index) > 0 && m_loadingThreads.size() < m_maximumLoads)) {
+                QThread *thread = new QThread(this);
+                thread->setObjectName(QLatin1String("QSampleCache::LoadingThread"));
+                m_loadingThreads.append(thread);
+                m_threadLoads.append(0);
+                index = m_loadingThreads.size() - 1;
+            }
+            sample->moveToThread(m_loadingThreads.at(index));
+        }
+
+        QThread *thread = m_loadingThreads.at(index);
+        if (!thread->isRunning())
+            thread->start();
+        ++m_threadLoads[index];
+        ++m_activeLoads;
+
+#ifdef QT_SAMPLECACHE_DEBUG
+        qDebug() << "QSampleCache: start loading [" << sample->m_url << "] priority" << sample->m_priority
+                 << "on thread" << index;
+#endif
+        QMetaObject::invokeMethod(sample, "load", Qt::QueuedConnection);
+    }
+}
+
+// Called in both threads, when a sample is loaded, failed or deleted while
+// waiting or loading
+void QSampleCache::loadFinished(QSample *sample)
+{
+    QMutexLocker locker(&m_loadingMutex);
+    if (!m_pendingLoads.removeOne(sample)) {
+        const int index = m_loadingThreads.indexOf(sample->thread());
+        if (index >= 0)
+            --m_threadLoads[index];
+        --m_activeLoads;
+        if (!m_pendingLoads.isEmpty())
+            QMetaObject::invokeMethod(this, "startPendingLoads", Qt::QueuedConnection);
+    }
+    locker.unlock();
+
+    QMetaObject::invokeMethod(this, "loadingCountChanged", Qt::QueuedConnection);
+    loadingRelease();
 }
 
 bool QSampleCache::isCached(const QUrl &url) const
@@ -149,15 +427,57 @@ bool QSampleCache::isCached(const QUrl &url) const
     return m_samples.contains(url);
 }
 
-QSample* QSampleCache::requestSample(const QUrl& url)
+// Heap memory used by the cached samples
+qint64 QSampleCache::usage() const
 {
-    //lock and add first to make sure live loadingThread will not be killed during this function call
+    QMutexLocker locker(&m_mutex);
+    return m_usage;
+}
+
+// Memory mapped file data used by the cached samples
+qint64 QSampleCache::mappedUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_mappedUsage;
+}
+
+QSampleCache::Statistics QSampleCache::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    Statistics statistics = m_statistics;
+    statistics.heapBytes = m_usage;
+    statistics.mappedBytes = m_mappedUsage;
+    statistics.samples = m_samples.size();
+    statistics.unusedSamples = m_unusedSamples.size();
+    return statistics;
+}
+
+/*
+    Resets the counters of the statistics, the memory use is kept.
+*/
+void QSampleCache::resetStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+    m_statistics = Statistics();
+}
+
+// Called in loading thread
+void QSampleCache::sampleLoaded(qint64 loadTime)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_statistics.loads;
+    m_statistics.loadTime += loadTime;
+}
+
+QSample* QSampleCache::requestSample(const QUrl& url, Priority priority)
+{
+    //lock and add first to make sure live loading threads will not be stopped during this function call
     m_loadingMutex.lock();
-    m_loadingRefCount++;
+    const bool startLoading = m_loadingRefCount++ == 0;
     m_loadingMutex.unlock();
 
-    if (!m_loadingThread.isRunning())
-        m_loadingThread.start();
+    if (startLoading)
+        emit isLoadingChanged();
 
 #ifdef QT_SAMPLECACHE_DEBUG
     qDebug() << "QSampleCache: request sample [" << url << "]";
@@ -166,17 +486,20 @@ QSample* QSampleCache::requestSample(const QUrl& url)
     QMap<QUrl, QSample*>::iterator it = m_samples.find(url);
     QSample* sample;
     if (it == m_samples.end()) {
+        // Moved to a loading thread when its load starts
         sample = new QSample(url, this);
         m_samples.insert(url, sample);
-        sample->moveToThread(&m_loadingThread);
+        ++m_statistics.misses;
     } else {
         sample = *it;
+        m_unusedSamples.removeOne(sample);
+        ++m_statistics.hits;
     }
 
     sample->addRef();
     locker.unlock();
 
-    sample->loadIfNecessary();
+    sample->loadIfNecessary(priority);
     return sample;
 }
 
@@ -189,14 +512,12 @@ void QSampleCache::setCapacity(qint64 capacity)
     qDebug() << "QSampleCache: capacity changes from " << m_capacity << "to " << capacity;
 #endif
     if (m_capacity > 0 && capacity <= 0) { //memory management strategy changed
-        for (QMap<QUrl, QSample*>::iterator it = m_samples.begin(); it != m_samples.end();) {
-            QSample* sample = *it;
-            if (sample->m_ref == 0) {
-                unloadSample(sample);
-                it = m_samples.erase(it);
-            } else
-                it++;
+        foreach (QSample* sample, m_unusedSamples) {
+            m_samples.remove(sample->m_url);
+            unloadSample(sample);
+            ++m_statistics.evictions;
         }
+        m_unusedSamples.clear();
     }
 
     m_capacity = capacity;
@@ -206,47 +527,50 @@ void QSampleCache::setCapacity(qint64 capacity)
 // Called locked
 void QSampleCache::unloadSample(QSample *sample)
 {
-    m_usage -= sample->m_soundData.size();
+    if (sample->m_mappedFile)
+        m_mappedUsage -= sample->m_soundData.size();
+    else
+        m_usage -= sample->m_soundData.size();
     m_staleSamples.insert(sample);
     sample->deleteLater();
 }
 
 // Called in both threads
-void QSampleCache::refresh(qint64 usageChange)
+void QSampleCache::refresh(qint64 usageChange, qint64 mappedUsageChange)
 {
     QMutexLocker locker(&m_mutex);
     m_usage += usageChange;
-    if (m_capacity <= 0 || m_usage <= m_capacity)
+    m_mappedUsage += mappedUsageChange;
+    // Mapped pages are backed by their file, but still take address space
+    // and page cache, so they count towards the capacity as well
+    if (m_capacity <= 0 || m_usage + m_mappedUsage <= m_capacity)
         return;
 
 #ifdef QT_SAMPLECACHE_DEBUG
     qint64 recoveredSize = 0;
 #endif
 
-    //free unused samples to keep usage under capacity limit.
-    for (QMap<QUrl, QSample*>::iterator it = m_samples.begin(); it != m_samples.end();) {
-        QSample* sample = *it;
-        if (sample->m_ref > 0) {
-            ++it;
-            continue;
-        }
+    //free the least recently used samples to keep usage under capacity limit.
+    while (!m_unusedSamples.isEmpty()) {
+        QSample* sample = m_unusedSamples.takeFirst();
 #ifdef QT_SAMPLECACHE_DEBUG
         recoveredSize += sample->m_soundData.size();
 #endif
+        m_samples.remove(sample->m_url);
         unloadSample(sample);
-        it = m_samples.erase(it);
-        if (m_usage <= m_capacity)
+        ++m_statistics.evictions;
+        if (m_usage + m_mappedUsage <= m_capacity)
             return;
     }
 
 #ifdef QT_SAMPLECACHE_DEBUG
-    qDebug() << "QSampleCache: refresh(" << usageChange
+    qDebug() << "QSampleCache: refresh(" << usageChange << mappedUsageChange
              << ") recovered size =" << recoveredSize
-             << "new usage =" << m_usage;
+             << "new usage =" << m_usage << "mapped usage =" << m_mappedUsage;
 #endif
 
-    if (m_usage > m_capacity)
-        qWarning() << "QSampleCache: usage[" << m_usage << " out of limit[" << m_capacity << "]";
+    if (m_usage + m_mappedUsage > m_capacity)
+        qWarning() << "QSampleCache: usage[" << m_usage << "+" << m_mappedUsage << "mapped ] out of limit[" << m_capacity << "]";
 }
 
 // Called in both threads
@@ -254,6 +578,7 @@ void QSampleCache::removeUnreferencedSample(QSample *sample)
 {
     QMutexLocker m(&m_mutex);
     m_staleSamples.remove(sample);
+    m_unusedSamples.removeOne(sample);
 }
 
 // Called in loader thread (since this lives in that thread)
@@ -268,17 +593,26 @@ QSample::~QSample()
     qDebug() << "~QSample" << this << ": deleted [" << m_url << "]" << QThread::currentThread();
 #endif
     cleanup();
+    if (m_state == QSample::Loading)
+        m_parent->loadFinished(this);
+
+    // Closing the file unmaps the sample data
+    m_soundData.clear();
+    delete m_mappedFile;
 }
 
 // Called in application thread
-void QSample::loadIfNecessary()
+void QSample::loadIfNecessary(int priority)
 {
     QMutexLocker locker(&m_mutex);
     if (m_state == QSample::Error || m_state == QSample::Creating) {
         m_state = QSample::Loading;
-        QMetaObject::invokeMethod(this, "load", Qt::QueuedConnection);
+        locker.unlock();
+        m_parent->queueLoad(this, priority);
     } else {
-        qobject_cast<QSampleCache*>(m_parent)->loadingRelease();
+        if (m_state == QSample::Loading)
+            m_parent->raisePriority(this, QSampleCache::Priority(priority));
+        m_parent->loadingRelease();
     }
 }
 
@@ -286,8 +620,11 @@ void QSample::loadIfNecessary()
 bool QSampleCache::notifyUnreferencedSample(QSample* sample)
 {
     QMutexLocker locker(&m_mutex);
-    if (m_capacity > 0)
+    if (m_capacity > 0) {
+        // Kept until it is the least recently used when space is needed
+        m_unusedSamples.append(sample);
         return false;
+    }
     m_samples.remove(sample->m_url);
     unloadSample(sample);
     return true;
@@ -309,11 +646,14 @@ void QSample::release()
 // must be called locked.
 void QSample::cleanup()
 {
+    if (m_audioDecoder)
+        m_audioDecoder->deleteLater();
     if (m_waveDecoder)
         m_waveDecoder->deleteLater();
     if (m_stream)
         m_stream->deleteLater();
 
+    m_audioDecoder = 0;
     m_waveDecoder = 0;
     m_stream = 0;
 }
@@ -334,15 +674,42 @@ void QSample::readSample()
 #endif
     qint64 read = m_waveDecoder->read(m_soundData.data() + m_sampleReadLength,
                       qMin(m_waveDecoder->bytesAvailable(),
-                           qint64(m_waveDecoder->size() - m_sampleReadLength)));
+                           qint64(m_soundData.size() - m_sampleReadLength)));
     if (read > 0)
         m_sampleReadLength += read;
-    if (m_sampleReadLength < m_waveDecoder->size())
+    if (m_sampleReadLength < m_soundData.size())
         return;
     Q_ASSERT(m_sampleReadLength == qint64(m_soundData.size()));
     onReady();
 }
 
+// Called in loading thread, locked.
+// Points the sample data at the PCM data of a local file instead of copying it.
+bool QSample::mapSample()
+{
+    QFile *file = qobject_cast<QFile*>(m_stream);
+    if (!file)
+        return false;
+
+    const qint64 offset = m_waveDecoder->dataOffset();
+    const qint64 size = m_waveDecoder->size();
+    if (size <= 0 || size > std::numeric_limits<int>::max() || offset + size > file->size())
+        return false;
+
+    uchar *data = file->map(offset, size);
+    if (!data)
+        return false;
+
+    m_parent->refresh(0, size);
+    m_soundData = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(size));
+    m_sampleReadLength = size;
+
+    // The file stays open as long as the mapping is used
+    m_mappedFile = file;
+    m_stream = 0;
+    return true;
+}
+
 // Called in loading thread
 void QSample::decoderReady()
 {
@@ -351,15 +718,47 @@ void QSample::decoderReady()
 #ifdef QT_SAMPLECACHE_DEBUG
     qDebug() << "QSample: decoder ready";
 #endif
-    m_parent->refresh(m_waveDecoder->size());
+    if (mapSample()) {
+#ifdef QT_SAMPLECACHE_DEBUG
+        qDebug() << "QSample: mapped" << m_soundData.size() << "bytes";
+#endif
+        onReady();
+        return;
+    }
+
+    // Samples are held in a QByteArray, which can't be larger than this
+    const qint64 size = m_waveDecoder->size();
+    if (size > std::numeric_limits<int>::max()) {
+        m.unlock();
+        decoderError();
+        return;
+    }
+
+    m_parent->refresh(size);
 
-    m_soundData.resize(m_waveDecoder->size());
+    m_soundData.resize(int(size));
     m_sampleReadLength = 0;
-    qint64 read = m_waveDecoder->read(m_soundData.data(), m_waveDecoder->size());
-    if (read > 0)
+    while (m_sampleReadLength < m_soundData.size()) {
+        const qint64 read = m_waveDecoder->read(m_soundData.data() + m_sampleReadLength,
+                                                m_soundData.size() - m_sampleReadLength);
+        if (read <= 0)
+            break;
         m_sampleReadLength += read;
-    if (m_sampleReadLength >= m_waveDecoder->size())
+    }
+    if (m_sampleReadLength >= m_soundData.size()) {
         onReady();
+        return;
+    }
+
+    // Network replies deliver the rest through readyRead(), but files never
+    // signal it, so a file that can't be read in full is broken
+    if (!m_stream->isSequential()) {
+        m_parent->refresh(-qint64(m_soundData.size()));
+        m_soundData.clear();
+        m_sampleReadLength = 0;
+        m.unlock();
+        decoderError();
+    }
 }
 
 // Called in all threads
@@ -377,8 +776,44 @@ void QSample::load()
 #ifdef QT_SAMPLECACHE_DEBUG
     qDebug() << "QSample: load [" << m_url << "]";
 #endif
-    m_stream = m_parent->networkAccessManager().get(QNetworkRequest(m_url));
-    connect(m_stream, SIGNAL(error(QNetworkReply::NetworkError)), SLOT(decoderError()));
+    m_loadTimer.start();
+
+    // Local files are read in place so that their samples can be mapped
+    QString fileName;
+    if (m_url.isLocalFile())
+        fileName = m_url.toLocalFile();
+    else if (m_url.scheme() == QLatin1String("qrc"))
+        fileName = QLatin1Char(':') + m_url.path();
+
+    if (!fileName.isEmpty()) {
+        QFile *file = new QFile(fileName);
+        if (!file->open(QIODevice::ReadOnly)) {
+            delete file;
+            decoderError();
+            return;
+        }
+        m_stream = file;
+
+        const QByteArray id = file->peek(4);
+        if (id != "RIFF" && id != "RIFX" && id != "RF64") {
+            // Compressed, load the decoded copy or decode it once
+            m_diskCacheFile = m_parent->diskCacheFileName(m_url, fileName);
+            if (m_diskCacheFile.isEmpty() || !QFile::exists(m_diskCacheFile)) {
+                startAudioDecoder(fileName);
+                return;
+            }
+            file->close();
+            file->setFileName(m_diskCacheFile);
+            m_diskCacheFile.clear();
+            if (!file->open(QIODevice::ReadOnly)) {
+                decoderError();
+                return;
+            }
+        }
+    } else {
+        m_stream = m_parent->networkAccessManager().get(QNetworkRequest(m_url));
+        connect(m_stream, SIGNAL(error(QNetworkReply::NetworkError)), SLOT(decoderError()));
+    }
     m_waveDecoder = new QWaveDecoder(m_stream);
     connect(m_waveDecoder, SIGNAL(formatKnown()), SLOT(decoderReady()));
     connect(m_waveDecoder, SIGNAL(parsingError()), SLOT(decoderError()));
@@ -393,12 +828,136 @@ void QSample::decoderError()
 #ifdef QT_SAMPLECACHE_DEBUG
     qDebug() << "QSample: decoder error";
 #endif
+    if (m_audioDecoder) {
+        // Partly decoded data is not accounted for yet
+        m_soundData.clear();
+        m_audioFormat = QAudioFormat();
+    }
     cleanup();
     m_state = QSample::Error;
-    qobject_cast<QSampleCache*>(m_parent)->loadingRelease();
+    m_parent->loadFinished(this);
     emit error();
 }
 
+// The format compressed samples are decoded to, one that WAV files can hold
+static QAudioFormat wavePcmFormat(const QAudioFormat &format)
+{
+    QAudioFormat pcm = format;
+    pcm.setCodec(QLatin1String("audio/pcm"));
+    pcm.setByteOrder(QAudioFormat::LittleEndian);
+    if (format.sampleType() != QAudioFormat::UnSignedInt || format.sampleSize() != 8) {
+        pcm.setSampleType(QAudioFormat::SignedInt);
+        pcm.setSampleSize(16);
+    }
+    return pcm;
+}
+
+enum { WaveHeaderSize = 44 };
+
+template <typename T>
+static void appendLittleEndian(QByteArray &data, T value)
+{
+    uchar bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    data.append(reinterpret_cast<const char *>(bytes), sizeof(T));
+}
+
+static bool writeWaveFile(const QString &fileName, const QAudioFormat &format, const QByteArray &pcm)
+{
+    const QFileInfo info(fileName);
+    QDir directory = info.absoluteDir();
+    if (!directory.mkpath(QLatin1String(".")))
+        return false;
+
+    // Copies decoded from older versions of the file are of no use anymore
+    const QString urlHash = info.fileName().section(QLatin1Char('-'), 0, 0);
+    foreach (const QString &stale, directory.entryList(QStringList(urlHash + QLatin1String("-*.wav")), QDir::Files))
+        directory.remove(stale);
+
+    QByteArray header;
+    header.reserve(WaveHeaderSize);
+    header.append("RIFF", 4);
+    appendLittleEndian<quint32>(header, 36 + pcm.size());
+    header.append("WAVEfmt ", 8);
+    appendLittleEndian<quint32>(header, 16);
+    appendLittleEndian<quint16>(header, 1); // PCM
+    appendLittleEndian<quint16>(header, format.channelCount());
+    appendLittleEndian<quint32>(header, format.sampleRate());
+    appendLittleEndian<quint32>(header, format.sampleRate() * format.bytesPerFrame());
+    appendLittleEndian<quint16>(header, format.bytesPerFrame());
+    appendLittleEndian<quint16>(header, format.sampleSize());
+    header.append("data", 4);
+    appendLittleEndian<quint32>(header, pcm.size());
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(header);
+    file.write(pcm);
+    return file.commit();
+}
+
+// Called in loading thread
+void QSample::startAudioDecoder(const QString &fileName)
+{
+#ifdef QT_SAMPLECACHE_DEBUG
+    qDebug() << "QSample: decoding [" << m_url << "]";
+#endif
+    m_audioDecoder = new QAudioDecoder(this);
+    if (fileName.startsWith(QLatin1Char(':')))
+        m_audioDecoder->setSourceDevice(m_stream);
+    else
+        m_audioDecoder->setSourceFilename(fileName);
+    connect(m_audioDecoder, SIGNAL(bufferReady()), SLOT(audioDecoderBufferReady()));
+    connect(m_audioDecoder, SIGNAL(finished()), SLOT(audioDecoderFinished()));
+    connect(m_audioDecoder, SIGNAL(error(QAudioDecoder::Error)), SLOT(decoderError()));
+    m_audioDecoder->start();
+}
+
+// Called in loading thread
+void QSample::audioDecoderBufferReady()
+{
+    Q_ASSERT(QThread::currentThread()->objectName() == QLatin1String("QSampleCache::LoadingThread"));
+    QMutexLocker m(&m_mutex);
+    QAudioBuffer buffer = m_audioDecoder->read();
+    if (!buffer.isValid())
+        return;
+
+    // All the buffers are stored in the format of the first one
+    if (!m_audioFormat.isValid())
+        m_audioFormat = wavePcmFormat(buffer.format());
+    if (buffer.format() != m_audioFormat)
+        buffer = buffer.convertToFormat(m_audioFormat);
+    m_soundData.append(static_cast<const char *>(buffer.constData()), buffer.byteCount());
+}
+
+// Called in loading thread
+void QSample::audioDecoderFinished()
+{
+    Q_ASSERT(QThread::currentThread()->objectName() == QLatin1String("QSampleCache::LoadingThread"));
+    QMutexLocker m(&m_mutex);
+    if (m_soundData.isEmpty()) {
+        m.unlock();
+        decoderError();
+        return;
+    }
+
+#ifdef QT_SAMPLECACHE_DEBUG
+    qDebug() << "QSample: decoded" << m_soundData.size() << "bytes";
+#endif
+    m_parent->refresh(m_soundData.size());
+    m_sampleReadLength = m_soundData.size();
+
+    // Samples too large for the disk cache are decoded again on the next load
+    if (!m_diskCacheFile.isEmpty() && m_parent->reserveDiskCacheSpace(WaveHeaderSize + m_soundData.size())
+            && !writeWaveFile(m_diskCacheFile, m_audioFormat, m_soundData)) {
+        qWarning() << "QSampleCache: could not write" << m_diskCacheFile;
+    }
+    m_diskCacheFile.clear();
+
+    onReady();
+}
+
 // Called in loading thread from decoder when sample is done. Locked already.
 void QSample::onReady()
 {
@@ -406,10 +965,12 @@ void QSample::onReady()
 #ifdef QT_SAMPLECACHE_DEBUG
     qDebug() << "QSample: load ready";
 #endif
-    m_audioFormat = m_waveDecoder->audioFormat();
+    if (m_waveDecoder)
+        m_audioFormat = m_waveDecoder->audioFormat();
     cleanup();
     m_state = QSample::Ready;
-    qobject_cast<QSampleCache*>(m_parent)->loadingRelease();
+    m_parent->sampleLoaded(m_loadTimer.elapsed());
+    m_parent->loadFinished(this);
     emit ready();
 }
 
@@ -418,10 +979,13 @@ QSample::QSample(const QUrl& url, QSampleCache *parent)
     : m_parent(parent)
     , m_stream(0)
     , m_waveDecoder(0)
+    , m_mappedFile(0)
+    , m_audioDecoder(0)
     , m_url(url)
     , m_sampleReadLength(0)
     , m_state(Creating)
     , m_ref(0)
+    , m_priority(QSampleCache::NormalPriority)
 {
 }
 
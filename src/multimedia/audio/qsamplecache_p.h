@@ -51,12 +51,16 @@
 #include <QtCore/qmutex.h>
 #include <QtCore/qmap.h>
 #include <QtCore/qset.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qelapsedtimer.h>
 #include <qaudioformat.h>
 
 
 QT_BEGIN_NAMESPACE
 
 class QIODevice;
+class QFile;
+class QAudioDecoder;
 class QNetworkAccessManager;
 class QSampleCache;
 class QWaveDecoder;
@@ -80,6 +84,8 @@ public:
     // variables are updated to their final states
     const QByteArray& data() const { Q_ASSERT(state() == Ready); return m_soundData; }
     const QAudioFormat& format() const { Q_ASSERT(state() == Ready); return m_audioFormat; }
+    // Whether data() points into a memory mapped local file instead of the heap
+    bool isMapped() const { Q_ASSERT(state() == Ready); return m_mappedFile != 0; }
     void release();
 
 Q_SIGNALS:
@@ -94,12 +100,16 @@ private Q_SLOTS:
     void decoderError();
     void readSample();
     void decoderReady();
+    void audioDecoderBufferReady();
+    void audioDecoderFinished();
 
 private:
     void onReady();
     void cleanup();
     void addRef();
-    void loadIfNecessary();
+    void loadIfNecessary(int priority);
+    bool mapSample();
+    void startAudioDecoder(const QString &fileName);
     QSample();
     ~QSample();
 
@@ -109,10 +119,15 @@ private:
     QAudioFormat m_audioFormat;
     QIODevice    *m_stream;
     QWaveDecoder *m_waveDecoder;
+    QFile        *m_mappedFile;
+    QAudioDecoder *m_audioDecoder;
+    QString      m_diskCacheFile;
     QUrl         m_url;
+    QElapsedTimer m_loadTimer;
     qint64       m_sampleReadLength;
     State        m_state;
     int          m_ref;
+    int          m_priority;
 };
 
 class Q_MULTIMEDIA_EXPORT QSampleCache : public QObject
@@ -121,36 +136,96 @@ class Q_MULTIMEDIA_EXPORT QSampleCache : public QObject
 public:
     friend class QSample;
 
+    enum Priority
+    {
+        LowPriority,
+        NormalPriority,
+        HighPriority
+    };
+
+    struct Statistics
+    {
+        Statistics()
+            : heapBytes(0), mappedBytes(0), samples(0), unusedSamples(0)
+            , hits(0), misses(0), evictions(0), loads(0), loadTime(0) {}
+
+        qint64 heapBytes;       // sample data held on the heap
+        qint64 mappedBytes;     // sample data mapped from files
+        int samples;            // samples in the cache
+        int unusedSamples;      // of which not referenced, these can be evicted
+        int hits;               // requests for a sample already in the cache
+        int misses;             // requests for a sample that had to be loaded
+        int evictions;          // unused samples dropped to stay within the capacity
+        int loads;              // samples loaded successfully
+        qint64 loadTime;        // time spent loading them, in milliseconds
+    };
+
     QSampleCache(QObject *parent = 0);
     ~QSampleCache();
 
-    QSample* requestSample(const QUrl& url);
+    QSample* requestSample(const QUrl& url, Priority priority = NormalPriority);
+    void raisePriority(QSample *sample, Priority priority);
     void setCapacity(qint64 capacity);
 
+    QString diskCacheDirectory() const;
+    void setDiskCacheDirectory(const QString &directory);
+    qint64 diskCacheCapacity() const;
+    void setDiskCacheCapacity(qint64 capacity);
+
+    int maximumConcurrentLoads() const;
+    void setMaximumConcurrentLoads(int loads);
+
     bool isLoading() const;
+    int loadingCount() const;
     bool isCached(const QUrl& url) const;
 
+    qint64 usage() const;
+    qint64 mappedUsage() const;
+    Statistics statistics() const;
+    void resetStatistics();
+
 Q_SIGNALS:
     void isLoadingChanged();
+    void loadingCountChanged();
+
+private Q_SLOTS:
+    void startPendingLoads();
 
 private:
     QMap<QUrl, QSample*> m_samples;
+    QList<QSample*> m_unusedSamples; // least recently used first
     QSet<QSample*> m_staleSamples;
-    QNetworkAccessManager *m_networkAccessManager;
+    QMap<QThread*, QNetworkAccessManager*> m_networkAccessManagers;
     mutable QMutex m_mutex;
     qint64 m_capacity;
     qint64 m_usage;
-    QThread m_loadingThread;
+    qint64 m_mappedUsage;
+    QString m_diskCacheDirectory;
+    qint64 m_diskCacheCapacity;
+    Statistics m_statistics;
 
     QNetworkAccessManager& networkAccessManager();
-    void refresh(qint64 usageChange);
+    QString diskCacheFileName(const QUrl &url, const QString &fileName) const;
+    bool reserveDiskCacheSpace(qint64 size) const;
+    void refresh(qint64 usageChange, qint64 mappedUsageChange = 0);
     bool notifyUnreferencedSample(QSample* sample);
     void removeUnreferencedSample(QSample* sample);
     void unloadSample(QSample* sample);
+    void sampleLoaded(qint64 loadTime);
 
+    void queueLoad(QSample *sample, int priority);
+    void loadFinished(QSample *sample);
     void loadingRelease();
     int m_loadingRefCount;
-    QMutex m_loadingMutex;
+    mutable QMutex m_loadingMutex;
+
+    // Guarded by m_loadingMutex
+    QList<QSample*> m_pendingLoads;
+    QVector<QThread*> m_loadingThreads;
+    QVector<int> m_threadLoads;
+    int m_activeLoads;
+    int m_maximumLoads;
+    bool m_loadingThreadsExiting;
 };
 
 QT_END_NAMESPACE
@@ -118,6 +118,8 @@ QSoundEffect::QSoundEffect(QObject *parent) :
     connect(d, SIGNAL(playingChanged()), SIGNAL(playingChanged()));
     connect(d, SIGNAL(statusChanged()), SIGNAL(statusChanged()));
     connect(d, SIGNAL(categoryChanged()), SIGNAL(categoryChanged()));
+    connect(d, SIGNAL(lowLatencyChanged()), SIGNAL(lowLatencyChanged()));
+    connect(d, SIGNAL(latencyChanged()), SIGNAL(latencyChanged()));
 }
 
 /*!
@@ -472,6 +474,71 @@ void QSoundEffect::setCategory(const QString &category)
     d->setCategory(category);
 }
 
+/*!
+    \qmlproperty bool QtMultimedia::SoundEffect::lowLatency
+    \since 5.7
+
+    This property holds whether the sound effect keeps the audio output
+    primed, so that it starts playing as soon as possible.
+
+    By default, the output is released or suspended when no sound has been
+    played for a while, and the first sound after that waits for the output
+    to start again. In low latency mode the output keeps streaming silence
+    with short buffers as long as the sound effect is loaded, at the cost of
+    some CPU and power.
+*/
+/*!
+    \property QSoundEffect::lowLatency
+    \since 5.7
+
+    This property holds whether the sound effect keeps the audio output
+    primed, so that it starts playing as soon as possible.
+
+    By default, the output is released or suspended when no sound has been
+    played for a while, and the first sound after that waits for the output
+    to start again. In low latency mode the output keeps streaming silence
+    with short buffers as long as the sound effect is loaded, at the cost of
+    some CPU and power.
+
+    The default is false.
+*/
+bool QSoundEffect::isLowLatency() const
+{
+    return d->isLowLatency();
+}
+
+void QSoundEffect::setLowLatency(bool lowLatency)
+{
+    if (d->isLowLatency() == lowLatency)
+        return;
+
+    d->setLowLatency(lowLatency);
+}
+
+/*!
+    \qmlproperty int QtMultimedia::SoundEffect::latency
+    \since 5.7
+
+    This property holds the time in microseconds between the last call to
+    \l play() and the moment its first sample is expected to be heard, or
+    -1 if it has not been measured yet.
+*/
+/*!
+    \property QSoundEffect::latency
+    \since 5.7
+
+    This property holds the time in microseconds between the last call to
+    play() and the moment its first sample is expected to be heard, or -1 if
+    it has not been measured yet.
+
+    It includes the time to start the audio output and the audio buffered
+    ahead of the sound by the output, as far as the platform reports it.
+*/
+qint64 QSoundEffect::latency() const
+{
+    return d->latency();
+}
+
 
 /*!
   \qmlmethod QtMultimedia::SoundEffect::stop()
@@ -608,6 +675,36 @@ void QSoundEffect::stop()
     The corresponding handler is \c onCategoryChanged.
 */
 
+/*!
+    \fn void QSoundEffect::lowLatencyChanged()
+    \since 5.7
+
+    The \c lowLatencyChanged signal is emitted when the low latency mode has changed.
+*/
+/*!
+    \qmlsignal QtMultimedia::SoundEffect::lowLatencyChanged()
+    \since 5.7
+
+    The \c lowLatencyChanged signal is emitted when the low latency mode has changed.
+
+    The corresponding handler is \c onLowLatencyChanged.
+*/
+
+/*!
+    \fn void QSoundEffect::latencyChanged()
+    \since 5.7
+
+    The \c latencyChanged signal is emitted when the latency of the last play has been measured.
+*/
+/*!
+    \qmlsignal QtMultimedia::SoundEffect::latencyChanged()
+    \since 5.7
+
+    The \c latencyChanged signal is emitted when the latency of the last play has been measured.
+
+    The corresponding handler is \c onLatencyChanged.
+*/
+
 
 QT_END_NAMESPACE
 
@@ -57,6 +57,8 @@ class Q_MULTIMEDIA_EXPORT QSoundEffect : public QObject
     Q_PROPERTY(bool playing READ isPlaying NOTIFY playingChanged)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
     Q_PROPERTY(QString category READ category WRITE setCategory NOTIFY categoryChanged)
+    Q_PROPERTY(bool lowLatency READ isLowLatency WRITE setLowLatency NOTIFY lowLatencyChanged)
+    Q_PROPERTY(qint64 latency READ latency NOTIFY latencyChanged)
     Q_ENUMS(Loop)
     Q_ENUMS(Status)
 
@@ -100,6 +102,11 @@ public:
     QString category() const;
     void setCategory(const QString &category);
 
+    bool isLowLatency() const;
+    void setLowLatency(bool lowLatency);
+
+    qint64 latency() const;
+
 Q_SIGNALS:
     void sourceChanged();
     void loopCountChanged();
@@ -110,6 +117,8 @@ Q_SIGNALS:
     void playingChanged();
     void statusChanged();
     void categoryChanged();
+    void lowLatencyChanged();
+    void latencyChanged();
 
 public Q_SLOTS:
     void play();
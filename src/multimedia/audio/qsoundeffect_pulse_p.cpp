@@ -324,6 +324,8 @@ QSoundEffectPrivate::QSoundEffectPrivate(QObject* parent):
     m_loopCount(1),
     m_runningCount(0),
     m_reloadCategory(false),
+    m_lowLatency(false),
+    m_latency(-1),
     m_sample(0),
     m_position(0),
     m_resourcesAvailable(false)
@@ -362,6 +364,30 @@ void QSoundEffectPrivate::release()
     this->deleteLater();
 }
 
+bool QSoundEffectPrivate::isLowLatency() const
+{
+    return m_lowLatency;
+}
+
+void QSoundEffectPrivate::setLowLatency(bool lowLatency)
+{
+    // The stream is always prefilled and corked until played, so there is
+    // nothing more to prime here
+    m_lowLatency = lowLatency;
+    emit lowLatencyChanged();
+}
+
+qint64 QSoundEffectPrivate::latency() const
+{
+    return m_latency;
+}
+
+void QSoundEffectPrivate::setLatency(qint64 latency)
+{
+    m_latency = latency;
+    emit latencyChanged();
+}
+
 QString QSoundEffectPrivate::category() const
 {
     return m_category;
@@ -835,9 +861,16 @@ void QSoundEffectPrivate::playSample()
 #endif
     Q_ASSERT(m_pulseStream);
     Q_ASSERT(pa_stream_get_state(m_pulseStream) == PA_STREAM_READY);
+    m_playTimer.start();
     pa_operation *o = pa_stream_cork(m_pulseStream, 0, 0, 0);
     if (o)
         pa_operation_unref(o);
+    QSoundEffectRef *ref = m_ref->getRef();
+    o = pa_stream_update_timing_info(m_pulseStream, stream_latency_callback, ref);
+    if (o)
+        pa_operation_unref(o);
+    else
+        ref->release();
 }
 
 void QSoundEffectPrivate::stop()
@@ -1100,6 +1133,30 @@ void QSoundEffectPrivate::stream_flush_callback(pa_stream *s, int success, void
     QMetaObject::invokeMethod(self, "emptyComplete", Qt::QueuedConnection, Q_ARG(void*, s));
 }
 
+void QSoundEffectPrivate::stream_latency_callback(pa_stream *s, int success, void *userdata)
+{
+#ifdef QT_PA_DEBUG
+    qDebug() << "stream_latency_callback";
+#endif
+    QSoundEffectRef *ref = reinterpret_cast<QSoundEffectRef*>(userdata);
+    QSoundEffectPrivate *self = ref->soundEffect();
+    ref->release();
+    if (!self || !success)
+        return;
+
+    pa_usec_t usec = 0;
+    int negative = 0;
+    if (pa_stream_get_latency(s, &usec, &negative) != 0)
+        return;
+    if (negative)
+        usec = 0;
+
+    // The sample is already written and corked, so only the time to uncork
+    // and the sink latency stand between play() and hearing it
+    const qint64 latency = self->m_playTimer.nsecsElapsed() / 1000 + qint64(usec);
+    QMetaObject::invokeMethod(self, "setLatency", Qt::QueuedConnection, Q_ARG(qint64, latency));
+}
+
 void QSoundEffectPrivate::stream_write_done_callback(void *p)
 {
     Q_UNUSED(p);
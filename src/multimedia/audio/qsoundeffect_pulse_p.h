@@ -50,6 +50,7 @@
 
 #include <QtCore/qobject.h>
 #include <QtCore/qdatetime.h>
+#include <QtCore/qelapsedtimer.h>
 #include <QtCore/qreadwritelock.h>
 #include <qmediaplayer.h>
 #include <pulse/pulseaudio.h>
@@ -89,6 +90,10 @@ public:
     QString category() const;
     void setCategory(const QString &category);
 
+    bool isLowLatency() const;
+    void setLowLatency(bool lowLatency);
+    qint64 latency() const;
+
 public Q_SLOTS:
     void play();
     void stop();
@@ -101,6 +106,8 @@ Q_SIGNALS:
     void playingChanged();
     void statusChanged();
     void categoryChanged();
+    void lowLatencyChanged();
+    void latencyChanged();
 
 private Q_SLOTS:
     void decoderError();
@@ -114,6 +121,7 @@ private Q_SLOTS:
     void emptyComplete(void *stream);
 
     void handleAvailabilityChanged(bool available);
+    void setLatency(qint64 latency);
 
 private:
     void playAvailable();
@@ -134,6 +142,7 @@ private:
     static void stream_underrun_callback(pa_stream *s, void *userdata);
     static void stream_cork_callback(pa_stream *s, int success, void *userdata);
     static void stream_flush_callback(pa_stream *s, int success, void *userdata);
+    static void stream_latency_callback(pa_stream *s, int success, void *userdata);
     static void stream_write_done_callback(void *p);
     static void stream_adjust_prebuffer_callback(pa_stream *s, int success, void *userdata);
     static void stream_reset_buffer_callback(pa_stream *s, int success, void *userdata);
@@ -157,6 +166,9 @@ private:
     QByteArray m_name;
     QString m_category;
     bool m_reloadCategory;
+    bool m_lowLatency;
+    qint64 m_latency;
+    QElapsedTimer m_playTimer;
 
     QSample *m_sample;
     int m_position;
@@ -43,9 +43,13 @@
 //
 
 #include "qsoundeffect_qaudio_p.h"
+#include "qaudiobuffer.h"
+#include "qaudiodeviceinfo.h"
+#include "qaudioconverter_p.h"
 
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qiodevice.h>
+#include <QtCore/qvarlengtharray.h>
 
 //#include <QDebug>
 //#define QT_QAUDIO_DEBUG 1
@@ -53,6 +57,7 @@
 QT_BEGIN_NAMESPACE
 
 Q_GLOBAL_STATIC(QSampleCache, sampleCache)
+Q_GLOBAL_STATIC(QSoundEffectMixer, soundEffectMixer)
 
 QSoundEffectPrivate::QSoundEffectPrivate(QObject* parent):
     QObject(parent),
@@ -67,12 +72,13 @@ QSoundEffectPrivate::~QSoundEffectPrivate()
 void QSoundEffectPrivate::release()
 {
     stop();
-    if (d->m_audioOutput) {
-        d->m_audioOutput->stop();
-        d->m_audioOutput->deleteLater();
+    soundEffectMixer()->removeSource(d);
+    if (d->m_sample) {
+        d->releaseSampleData();
         d->m_sample->release();
     }
     delete d;
+    d = 0;
     this->deleteLater();
 }
 
@@ -106,6 +112,7 @@ void QSoundEffectPrivate::setSource(const QUrl &url)
     d->m_url = url;
 
     d->m_sampleReady = false;
+    soundEffectMixer()->setSourcePrimed(d, false);
 
     if (url.isEmpty()) {
         setStatus(QSoundEffect::Null);
@@ -122,6 +129,7 @@ void QSoundEffectPrivate::setSource(const QUrl &url)
             disconnect(d->m_sample, SIGNAL(error()), d, SLOT(decoderError()));
             disconnect(d->m_sample, SIGNAL(ready()), d, SLOT(sampleReady()));
         }
+        d->releaseSampleData();
         d->m_sample->release();
         d->m_sample = 0;
     }
@@ -161,24 +169,21 @@ void QSoundEffectPrivate::setLoopCount(int loopCount)
     if (loopCount == 0)
         loopCount = 1;
     d->m_loopCount = loopCount;
-    if (d->m_playing)
+    if (d->m_playing) {
         setLoopsRemaining(loopCount);
+        soundEffectMixer()->setVoiceLoops(d, loopCount);
+    }
 }
 
 qreal QSoundEffectPrivate::volume() const
 {
-    if (d->m_audioOutput && !d->m_muted)
-        return d->m_audioOutput->volume();
-
     return d->m_volume;
 }
 
 void QSoundEffectPrivate::setVolume(qreal volume)
 {
     d->m_volume = volume;
-
-    if (d->m_audioOutput && !d->m_muted)
-        d->m_audioOutput->setVolume(volume);
+    soundEffectMixer()->setVoiceGain(d, d->gain());
 
     emit volumeChanged();
 }
@@ -190,12 +195,9 @@ bool QSoundEffectPrivate::isMuted() const
 
 void QSoundEffectPrivate::setMuted(bool muted)
 {
-    if (muted && d->m_audioOutput)
-        d->m_audioOutput->setVolume(0);
-    else if (!muted && d->m_audioOutput && d->m_muted)
-        d->m_audioOutput->setVolume(d->m_volume);
-
     d->m_muted = muted;
+    soundEffectMixer()->setVoiceGain(d, d->gain());
+
     emit mutedChanged();
 }
 
@@ -217,7 +219,6 @@ QSoundEffect::Status QSoundEffectPrivate::status() const
 
 void QSoundEffectPrivate::play()
 {
-    d->m_offset = 0;
     setLoopsRemaining(d->m_loopCount);
 #ifdef QT_QAUDIO_DEBUG
     qDebug() << this << "play";
@@ -227,8 +228,8 @@ void QSoundEffectPrivate::play()
         return;
     }
     setPlaying(true);
-    if (d->m_audioOutput && d->m_audioOutput->state() == QAudio::StoppedState && d->m_sampleReady)
-        d->m_audioOutput->start(d);
+    if (d->m_sampleReady)
+        d->startVoice();
 }
 
 void QSoundEffectPrivate::stop()
@@ -238,12 +239,48 @@ void QSoundEffectPrivate::stop()
 #ifdef QT_QAUDIO_DEBUG
     qDebug() << "stop()";
 #endif
-    d->m_offset = 0;
-
     setPlaying(false);
+    soundEffectMixer()->stopVoice(d);
+}
+
+bool QSoundEffectPrivate::isLowLatency() const
+{
+    return d->m_lowLatency;
+}
+
+void QSoundEffectPrivate::setLowLatency(bool lowLatency)
+{
+    d->m_lowLatency = lowLatency;
+    soundEffectMixer()->setSourcePrimed(d, lowLatency && d->m_sampleReady);
+    emit lowLatencyChanged();
+}
+
+qint64 QSoundEffectPrivate::latency() const
+{
+    return d->m_latency;
+}
 
-    if (d->m_audioOutput)
-        d->m_audioOutput->stop();
+void QSoundEffectPrivate::voiceLooped(int generation, int loopsRemaining)
+{
+    // Ignore voices of previous plays
+    if (!d || generation != d->m_generation || !d->m_playing)
+        return;
+    setLoopsRemaining(loopsRemaining);
+}
+
+void QSoundEffectPrivate::voiceFinished(int generation)
+{
+    if (!d || generation != d->m_generation)
+        return;
+    stop();
+}
+
+void QSoundEffectPrivate::voiceLatency(int generation, qint64 latency)
+{
+    if (!d || generation != d->m_generation)
+        return;
+    d->m_latency = latency;
+    emit latencyChanged();
 }
 
 void QSoundEffectPrivate::setStatus(QSoundEffect::Status status)
@@ -297,21 +334,22 @@ void QSoundEffectPrivate::setCategory(const QString &category)
 }
 
 PrivateSoundSource::PrivateSoundSource(QSoundEffectPrivate* s):
-    QIODevice(s),
+    QObject(s),
     m_loopCount(1),
     m_runningCount(0),
     m_playing(false),
     m_status(QSoundEffect::Null),
-    m_audioOutput(0),
     m_sample(0),
     m_muted(false),
     m_volume(1.0),
     m_sampleReady(false),
-    m_offset(0)
+    m_lowLatency(false),
+    m_latency(-1),
+    m_generation(0)
 {
     soundeffect = s;
     m_category = QLatin1String("game");
-    open(QIODevice::ReadOnly);
+    soundEffectMixer()->addSource(this);
 }
 
 void PrivateSoundSource::sampleReady()
@@ -324,19 +362,23 @@ void PrivateSoundSource::sampleReady()
 #endif
     disconnect(m_sample, SIGNAL(error()), this, SLOT(decoderError()));
     disconnect(m_sample, SIGNAL(ready()), this, SLOT(sampleReady()));
-    if (!m_audioOutput) {
-        m_audioOutput = new QAudioOutput(m_sample->format());
-        connect(m_audioOutput,SIGNAL(stateChanged(QAudio::State)), this, SLOT(stateChanged(QAudio::State)));
-        if (!m_muted)
-            m_audioOutput->setVolume(m_volume);
-        else
-            m_audioOutput->setVolume(0);
+
+    // Shared with every sound effect playing the same sample
+    m_sampleData = soundEffectMixer()->acquireSample(m_sample);
+    if (!m_sampleData.isValid()) {
+        qWarning("QSoundEffect(qaudio): Unsupported sample format");
+        m_playing = false;
+        soundeffect->setStatus(QSoundEffect::Error);
+        return;
     }
+
     m_sampleReady = true;
+    if (m_lowLatency)
+        soundEffectMixer()->setSourcePrimed(this, true);
     soundeffect->setStatus(QSoundEffect::Ready);
 
     if (m_playing)
-        m_audioOutput->start(this);
+        startVoice();
 }
 
 void PrivateSoundSource::decoderError()
@@ -348,91 +390,455 @@ void PrivateSoundSource::decoderError()
     soundeffect->setStatus(QSoundEffect::Error);
 }
 
-void PrivateSoundSource::stateChanged(QAudio::State state)
+void PrivateSoundSource::startVoice()
 {
-#ifdef QT_QAUDIO_DEBUG
-    qDebug() << this << "stateChanged " << state;
-#endif
-    if ((state == QAudio::IdleState && m_runningCount == 0)
-         || (state == QAudio::StoppedState && m_audioOutput->error() != QAudio::NoError))
-        emit soundeffect->stop();
+    ++m_generation;
+    soundEffectMixer()->startVoice(this, soundeffect, m_generation, m_sampleData, m_loopCount, gain());
+}
+
+// The converted samples may point into the sample, so the voice playing them
+// has to stop before the sample is released
+void PrivateSoundSource::releaseSampleData()
+{
+    if (!m_sampleData.isValid())
+        return;
+    soundEffectMixer()->stopVoice(this);
+    m_sampleData = QAudioBuffer();
+    soundEffectMixer()->releaseSample(m_sample);
 }
 
-qint64 PrivateSoundSource::readData( char* data, qint64 len)
+qreal PrivateSoundSource::gain() const
 {
-    if ((m_runningCount > 0  || m_runningCount == QSoundEffect::Infinite) && m_playing) {
+    return m_muted ? 0 : m_volume;
+}
 
-        if (m_sample->state() != QSample::Ready)
-            return 0;
+QSoundEffectMixer::QSoundEffectMixer()
+    : m_voiceOrder(0)
+    , m_sourceCount(0)
+    , m_output(0)
+    , m_outputLowLatency(false)
+    , m_outputBufferBytes(0)
+{
+    // Mixing in the preferred rate of the device avoids resampling after mixing
+    const QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+    const int preferredRate = device.isNull() ? 0 : device.preferredFormat().sampleRate();
+
+    m_outputFormat.setCodec(QLatin1String("audio/pcm"));
+    m_outputFormat.setSampleRate(preferredRate > 0 ? preferredRate : 44100);
+    m_outputFormat.setChannelCount(2);
+    m_outputFormat.setSampleSize(16);
+    m_outputFormat.setSampleType(QAudioFormat::SignedInt);
+    if (!device.isNull() && !device.isFormatSupported(m_outputFormat)) {
+        const QAudioFormat nearest = device.nearestFormat(m_outputFormat);
+        if (qt_isAudioConversionSupported(nearest, nearest))
+            m_outputFormat = nearest;
+    }
 
-        qint64 bytesWritten = 0;
+    m_mixFormat = m_outputFormat;
+    m_mixFormat.setSampleSize(32);
+    m_mixFormat.setSampleType(QAudioFormat::Float);
+    m_mixFormat.setByteOrder(QAudioFormat::Endian(QSysInfo::ByteOrder));
 
-        const int   periodSize = m_audioOutput->periodSize();
-        const int   sampleSize = m_sample->data().size();
-        const char* sampleData = m_sample->data().constData();
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(IdleTimeout);
+    connect(&m_idleTimer, SIGNAL(timeout()), this, SLOT(suspendWhenIdle()));
+    m_clock.start();
 
-        // Some systems can have large buffers we only need a max of three
-        int    periodsFree = qMin(3, (int)(m_audioOutput->bytesFree()/periodSize));
-        int    dataOffset = 0;
+    open(QIODevice::ReadOnly);
+}
 
-#ifdef QT_QAUDIO_DEBUG
-        qDebug() << "bytesFree=" << m_audioOutput->bytesFree() << ", can fit " << periodsFree << " periodSize() chunks";
-#endif
+QSoundEffectMixer::~QSoundEffectMixer()
+{
+    delete m_output;
+}
 
-        while ((periodsFree > 0) && (bytesWritten + periodSize <= len)) {
+void QSoundEffectMixer::addSource(PrivateSoundSource *source)
+{
+    Q_UNUSED(source);
+    QMutexLocker locker(&m_mutex);
+    ++m_sourceCount;
+}
 
-            if (sampleSize - m_offset >= periodSize) {
-                // We can fit a whole period of data
-                memcpy(data + dataOffset, sampleData + m_offset, periodSize);
-                m_offset += periodSize;
-                dataOffset += periodSize;
-                bytesWritten += periodSize;
-#ifdef QT_QAUDIO_DEBUG
-                qDebug() << "WHOLE PERIOD: bytesWritten=" << bytesWritten << ", offset=" << m_offset
-                         << ", filesize=" << sampleSize;
-#endif
-            } else {
-                // We are at end of sound, first write what is left of current sound
-                memcpy(data + dataOffset, sampleData + m_offset, sampleSize - m_offset);
-                bytesWritten += sampleSize - m_offset;
-                int wrapLen = periodSize - (sampleSize - m_offset);
-                if (wrapLen > sampleSize)
-                    wrapLen = sampleSize;
-#ifdef QT_QAUDIO_DEBUG
-                qDebug() << "END OF SOUND: bytesWritten=" << bytesWritten << ", offset=" << m_offset
-                         << ", part1=" << (sampleSize-m_offset);
-#endif
-                dataOffset += (sampleSize - m_offset);
-                m_offset = 0;
-
-                if (m_runningCount > 0 && m_runningCount != QSoundEffect::Infinite)
-                    soundeffect->setLoopsRemaining(m_runningCount-1);
-
-                if (m_runningCount > 0 || m_runningCount == QSoundEffect::Infinite) {
-                    // There are still more loops of this sound to play, append the start of sound to make up full period
-                    memcpy(data + dataOffset, sampleData + m_offset, wrapLen);
-                    m_offset += wrapLen;
-                    dataOffset += wrapLen;
-                    bytesWritten += wrapLen;
-#ifdef QT_QAUDIO_DEBUG
-                    qDebug() << "APPEND START FOR FULL PERIOD: bytesWritten=" << bytesWritten << ", offset=" << m_offset
-                             << ", part2=" << wrapLen;
-                    qDebug() << "part1 + part2 should be a period " << periodSize;
-#endif
+void QSoundEffectMixer::removeSource(PrivateSoundSource *source)
+{
+    QMutexLocker locker(&m_mutex);
+    const int index = findVoice(source);
+    if (index >= 0)
+        m_voices.remove(index);
+    m_primedSources.removeAll(source);
+
+    // The output stays open only while there are sound effects to play
+    if (--m_sourceCount > 0)
+        return;
+    locker.unlock();
+
+    closeOutput();
+}
+
+/*
+    Keeps the output streaming with short buffers while any \a source is
+    \a primed, so that starting a voice does not wait for the output to start.
+*/
+void QSoundEffectMixer::setSourcePrimed(PrivateSoundSource *source, bool primed)
+{
+    bool lowLatency;
+    {
+        QMutexLocker locker(&m_mutex);
+        const int index = m_primedSources.indexOf(source);
+        if (primed == (index >= 0))
+            return;
+        if (primed)
+            m_primedSources.append(source);
+        else
+            m_primedSources.remove(index);
+        lowLatency = !m_primedSources.isEmpty();
+    }
+
+    // Playing voices go on with the buffer size they started with
+    if (m_output && m_outputLowLatency != lowLatency) {
+        updateOutputLatency();
+        return;
+    }
+    if (lowLatency)
+        ensureOutput();
+}
+
+/*
+    Opens the output again with the buffer size the primed sources ask for.
+    The buffer size can only be chosen when opening the output, and closing
+    it drops what it holds, so this waits until no voice is playing; the
+    mixer calls it again once the last voice ends.
+*/
+void QSoundEffectMixer::updateOutputLatency()
+{
+    bool lowLatency;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_voices.isEmpty())
+            return;
+        lowLatency = !m_primedSources.isEmpty();
+    }
+
+    if (!m_output || m_outputLowLatency == lowLatency)
+        return;
+
+    closeOutput();
+    if (lowLatency)
+        ensureOutput();
+}
+
+/*
+    Returns the format the samples of voices must be in: native float samples
+    with the rate and channels of the output.
+*/
+QAudioFormat QSoundEffectMixer::mixFormat() const
+{
+    return m_mixFormat;
+}
+
+/*
+    Returns the samples of \a sample in the mix format, converted only for
+    the first sound effect using it. Samples already in the mix format are
+    used in place. Returns an invalid buffer if the format is not supported.
+
+    Each successful call must be balanced by releaseSample().
+*/
+QAudioBuffer QSoundEffectMixer::acquireSample(QSample *sample)
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<QSample *, ConvertedSample>::iterator it = m_convertedSamples.find(sample);
+    if (it != m_convertedSamples.end()) {
+        ++it->users;
+        return it->buffer;
+    }
+    locker.unlock();
+
+    const QByteArray &data = sample->data();
+    const QAudioFormat &format = sample->format();
+    const int frameBytes = format.bytesPerFrame();
+    if (frameBytes <= 0)
+        return QAudioBuffer();
+
+    // Wrapped without copying, so that mapped samples stay in the file
+    const QAudioBuffer buffer(data.constData(), data.size() / frameBytes, format);
+    ConvertedSample converted;
+    converted.buffer = buffer.convertToFormat(m_mixFormat);
+    converted.users = 1;
+    if (!converted.buffer.isValid())
+        return QAudioBuffer();
+
+    // Another thread may have converted it in the meantime
+    locker.relock();
+    it = m_convertedSamples.find(sample);
+    if (it != m_convertedSamples.end()) {
+        ++it->users;
+        return it->buffer;
+    }
+    m_convertedSamples.insert(sample, converted);
+    return converted.buffer;
+}
+
+/*
+    Drops the converted samples of \a sample once no sound effect uses them.
+*/
+void QSoundEffectMixer::releaseSample(QSample *sample)
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<QSample *, ConvertedSample>::iterator it = m_convertedSamples.find(sample);
+    if (it != m_convertedSamples.end() && --it->users == 0)
+        m_convertedSamples.erase(it);
+}
+
+/*
+    Starts playing \a samples for \a source, \a loops times, replacing the
+    voice it was playing. When all voices are in use, the oldest one is
+    stopped.
+
+    The progress of the voice is posted to the voiceLooped() and
+    voiceFinished() slots of \a receiver, along with \a generation.
+*/
+void QSoundEffectMixer::startVoice(PrivateSoundSource *source, QSoundEffectPrivate *receiver, int generation,
+                                   const QAudioBuffer &samples, int loops, qreal gain)
+{
+    Voice voice;
+    voice.source = source;
+    voice.receiver = receiver;
+    voice.generation = generation;
+    voice.samples = samples;
+    voice.frames = samples.frameCount();
+    voice.position = 0;
+    voice.loops = loops;
+    voice.gain = float(gain);
+    voice.playTime = m_clock.nsecsElapsed();
+    voice.latencyReported = false;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        voice.order = m_voiceOrder++;
+
+        int index = findVoice(source);
+        if (index < 0 && m_voices.size() >= MaximumVoices) {
+            index = 0;
+            for (int i = 1; i < m_voices.size(); ++i) {
+                if (m_voices.at(i).order < m_voices.at(index).order)
+                    index = i;
+            }
+            finishVoice(m_voices.at(index));
+        }
+
+        if (index < 0)
+            m_voices.append(voice);
+        else
+            m_voices[index] = voice;
+    }
+
+    // Outside of the lock, some backends pull data right when starting
+    ensureOutput();
+    m_idleTimer.start();
+}
+
+void QSoundEffectMixer::stopVoice(PrivateSoundSource *source)
+{
+    QMutexLocker locker(&m_mutex);
+    const int index = findVoice(source);
+    if (index >= 0)
+        m_voices.remove(index);
+}
+
+void QSoundEffectMixer::setVoiceLoops(PrivateSoundSource *source, int loops)
+{
+    QMutexLocker locker(&m_mutex);
+    const int index = findVoice(source);
+    if (index >= 0)
+        m_voices[index].loops = loops;
+}
+
+void QSoundEffectMixer::setVoiceGain(PrivateSoundSource *source, qreal gain)
+{
+    QMutexLocker locker(&m_mutex);
+    const int index = findVoice(source);
+    if (index >= 0)
+        m_voices[index].gain = float(gain);
+}
+
+int QSoundEffectMixer::voiceCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_voices.size();
+}
+
+void QSoundEffectMixer::ensureOutput()
+{
+    if (!m_output) {
+        QMutexLocker locker(&m_mutex);
+        m_outputLowLatency = !m_primedSources.isEmpty();
+        m_outputBufferBytes = m_outputFormat.bytesForDuration(m_outputLowLatency
+                                                              ? LowLatencyBufferDuration
+                                                              : BufferDuration);
+        locker.unlock();
+
+        // A short buffer keeps the time from starting a voice to hearing it
+        // low, backends also derive shorter periods from it
+        m_output = new QAudioOutput(m_outputFormat, this);
+        m_output->setBufferSize(m_outputBufferBytes);
+        connect(m_output, SIGNAL(stateChanged(QAudio::State)), this, SLOT(outputStateChanged(QAudio::State)));
+    }
+
+    if (m_output->state() == QAudio::SuspendedState)
+        m_output->resume();
+    else if (m_output->state() == QAudio::StoppedState)
+        m_output->start(this);
+
+    // The buffer actually granted, for the latency measurements
+    const int bufferBytes = m_output->bufferSize();
+    QMutexLocker locker(&m_mutex);
+    m_outputBufferBytes = bufferBytes;
+}
+
+void QSoundEffectMixer::closeOutput()
+{
+    m_idleTimer.stop();
+    if (!m_output)
+        return;
+
+    QAudioOutput *output = m_output;
+    m_output = 0;
+    output->stop();
+    output->deleteLater();
+}
+
+void QSoundEffectMixer::suspendWhenIdle()
+{
+    if (voiceCount() > 0) {
+        m_idleTimer.start();
+        return;
+    }
+
+    // Primed outputs keep streaming silence
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_primedSources.isEmpty())
+            return;
+    }
+
+    // Stop pulling silence, resuming is faster than opening the device again
+    if (m_output && m_output->state() != QAudio::StoppedState)
+        m_output->suspend();
+}
+
+void QSoundEffectMixer::outputStateChanged(QAudio::State state)
+{
+    if (!m_output || sender() != m_output
+            || state != QAudio::StoppedState || m_output->error() == QAudio::NoError) {
+        return;
+    }
+
+    // The device went away, end all voices and open it again on the next play
+    {
+        QMutexLocker locker(&m_mutex);
+        for (int i = 0; i < m_voices.size(); ++i)
+            finishVoice(m_voices.at(i));
+        m_voices.clear();
+    }
+
+    closeOutput();
+}
+
+int QSoundEffectMixer::findVoice(PrivateSoundSource *source) const
+{
+    for (int i = 0; i < m_voices.size(); ++i) {
+        if (m_voices.at(i).source == source)
+            return i;
+    }
+    return -1;
+}
+
+void QSoundEffectMixer::finishVoice(const Voice &voice)
+{
+    QMetaObject::invokeMethod(voice.receiver, "voiceFinished", Qt::QueuedConnection,
+                              Q_ARG(int, voice.generation));
+}
+
+/*
+    Sums the voices times their gain into the output, ending them or looping
+    them back to their start as they reach their end.
+
+    In pull mode the output asks for the space freed in its buffer, so the
+    rest of the buffer is queued ahead of the data written here.
+*/
+qint64 QSoundEffectMixer::readData(char *data, qint64 len)
+{
+    enum { BlockFrames = 256 };
+
+    const int outputFrameBytes = m_outputFormat.bytesPerFrame();
+    const int channels = m_mixFormat.channelCount();
+    const int frames = int(len / outputFrameBytes);
+    QVarLengthArray<float, BlockFrames * 2> mix(BlockFrames * channels);
+
+    QMutexLocker locker(&m_mutex);
+    for (int done = 0; done < frames; done += BlockFrames) {
+        const int block = qMin(int(BlockFrames), frames - done);
+        memset(mix.data(), 0, block * channels * sizeof(float));
+
+        for (int v = 0; v < m_voices.size();) {
+            Voice &voice = m_voices[v];
+            const float *samples = voice.samples.constData<float>();
+
+            // The first frame is heard after what the output holds ahead of it
+            if (!voice.latencyReported) {
+                const qint64 queuedBytes = qMax(qint64(0), m_outputBufferBytes - len)
+                        + qint64(done) * outputFrameBytes;
+                const qint64 latency = (m_clock.nsecsElapsed() - voice.playTime) / 1000
+                        + m_outputFormat.durationForBytes(int(queuedBytes));
+                QMetaObject::invokeMethod(voice.receiver, "voiceLatency", Qt::QueuedConnection,
+                                          Q_ARG(int, voice.generation), Q_ARG(qint64, latency));
+                voice.latencyReported = true;
+            }
+
+            bool playing = voice.frames > 0;
+            int mixed = 0;
+            while (playing && mixed < block) {
+                const int count = qMin(block - mixed, voice.frames - voice.position);
+                if (voice.gain != 0) {
+                    const float *in = samples + voice.position * channels;
+                    float *out = mix.data() + mixed * channels;
+                    for (int i = 0; i < count * channels; ++i)
+                        out[i] += voice.gain * in[i];
+                }
+                mixed += count;
+                voice.position += count;
+
+                if (voice.position == voice.frames) {
+                    voice.position = 0;
+                    if (voice.loops != QSoundEffect::Infinite) {
+                        --voice.loops;
+                        QMetaObject::invokeMethod(voice.receiver, "voiceLooped", Qt::QueuedConnection,
+                                                  Q_ARG(int, voice.generation), Q_ARG(int, qMax(0, voice.loops)));
+                        playing = voice.loops > 0;
+                    }
                 }
             }
-            if (m_runningCount == 0)
-                break;
 
-            periodsFree--;
+            if (playing) {
+                ++v;
+            } else {
+                finishVoice(voice);
+                m_voices.remove(v);
+            }
         }
-        return bytesWritten;
+
+        qt_convertAudioSamples(mix.constData(), m_mixFormat,
+                               data + qint64(done) * outputFrameBytes, m_outputFormat, block);
     }
 
-    return 0;
+    // A latency change waits for the voices to end
+    if (m_voices.isEmpty() && m_outputLowLatency == m_primedSources.isEmpty())
+        QMetaObject::invokeMethod(this, "updateOutputLatency", Qt::QueuedConnection);
+
+    return qint64(frames) * outputFrameBytes;
 }
 
-qint64 PrivateSoundSource::writeData(const char* data, qint64 len)
+qint64 QSoundEffectMixer::writeData(const char *data, qint64 len)
 {
     Q_UNUSED(data)
     Q_UNUSED(len)
@@ -47,6 +47,12 @@
 
 #include <QtCore/qobject.h>
 #include <QtCore/qurl.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qvector.h>
+#include "qaudiobuffer.h"
 #include "qaudiooutput.h"
 #include "qsamplecache_p.h"
 #include "qsoundeffect.h"
@@ -55,7 +61,7 @@ QT_BEGIN_NAMESPACE
 
 class QSoundEffectPrivate;
 
-class PrivateSoundSource : public QIODevice
+class PrivateSoundSource : public QObject
 {
     friend class QSoundEffectPrivate;
     Q_OBJECT
@@ -63,31 +69,116 @@ public:
     PrivateSoundSource(QSoundEffectPrivate* s);
     ~PrivateSoundSource() {}
 
-    qint64 readData( char* data, qint64 len);
-    qint64 writeData(const char* data, qint64 len);
-
 private Q_SLOTS:
     void sampleReady();
     void decoderError();
-    void stateChanged(QAudio::State);
 
 private:
+    void startVoice();
+    void releaseSampleData();
+    qreal gain() const;
+
     QUrl           m_url;
     int            m_loopCount;
     int            m_runningCount;
     bool           m_playing;
     QSoundEffect::Status  m_status;
-    QAudioOutput   *m_audioOutput;
     QSample        *m_sample;
+    QAudioBuffer   m_sampleData;
     bool           m_muted;
     qreal          m_volume;
     bool           m_sampleReady;
-    qint64         m_offset;
+    bool           m_lowLatency;
+    qint64         m_latency;
+    int            m_generation;
     QString        m_category;
 
     QSoundEffectPrivate *soundeffect;
 };
 
+/*
+    Sums the voices of all sound effects into a single output stream, which
+    stays open while any sound effect exists. Starting a voice then only takes
+    the time to play what is already buffered.
+*/
+class QSoundEffectMixer : public QIODevice
+{
+    Q_OBJECT
+public:
+    enum {
+        MaximumVoices = 32,
+        BufferDuration = 50000,           // microseconds
+        LowLatencyBufferDuration = 20000, // microseconds
+        IdleTimeout = 3000                // milliseconds
+    };
+
+    QSoundEffectMixer();
+    ~QSoundEffectMixer();
+
+    void addSource(PrivateSoundSource *source);
+    void removeSource(PrivateSoundSource *source);
+    void setSourcePrimed(PrivateSoundSource *source, bool primed);
+
+    QAudioFormat mixFormat() const;
+    QAudioBuffer acquireSample(QSample *sample);
+    void releaseSample(QSample *sample);
+
+    void startVoice(PrivateSoundSource *source, QSoundEffectPrivate *receiver, int generation,
+                    const QAudioBuffer &samples, int loops, qreal gain);
+    void stopVoice(PrivateSoundSource *source);
+    void setVoiceLoops(PrivateSoundSource *source, int loops);
+    void setVoiceGain(PrivateSoundSource *source, qreal gain);
+    int voiceCount() const;
+
+    qint64 readData(char *data, qint64 len);
+    qint64 writeData(const char *data, qint64 len);
+
+private Q_SLOTS:
+    void suspendWhenIdle();
+    void outputStateChanged(QAudio::State state);
+    void updateOutputLatency();
+
+private:
+    struct Voice
+    {
+        PrivateSoundSource *source;
+        QSoundEffectPrivate *receiver;
+        int generation;
+        QAudioBuffer samples;
+        int frames;
+        int position;
+        int loops;
+        float gain;
+        quint64 order;
+        qint64 playTime;
+        bool latencyReported;
+    };
+
+    struct ConvertedSample
+    {
+        QAudioBuffer buffer;
+        int users;
+    };
+
+    void ensureOutput();
+    void closeOutput();
+    int findVoice(PrivateSoundSource *source) const;
+    static void finishVoice(const Voice &voice);
+
+    mutable QMutex m_mutex;
+    QVector<Voice> m_voices;
+    QHash<QSample *, ConvertedSample> m_convertedSamples;
+    quint64 m_voiceOrder;
+    int m_sourceCount;
+    QVector<PrivateSoundSource *> m_primedSources;
+    QAudioOutput *m_output;
+    bool m_outputLowLatency;
+    int m_outputBufferBytes;
+    QElapsedTimer m_clock;
+    QAudioFormat m_outputFormat;
+    QAudioFormat m_mixFormat;
+    QTimer m_idleTimer;
+};
 
 class QSoundEffectPrivate : public QObject
 {
@@ -118,6 +209,10 @@ public:
     QString category() const;
     void setCategory(const QString &);
 
+    bool isLowLatency() const;
+    void setLowLatency(bool lowLatency);
+    qint64 latency() const;
+
 public Q_SLOTS:
     void play();
     void stop();
@@ -130,6 +225,13 @@ Q_SIGNALS:
     void playingChanged();
     void statusChanged();
     void categoryChanged();
+    void lowLatencyChanged();
+    void latencyChanged();
+
+private Q_SLOTS:
+    void voiceLooped(int generation, int loopsRemaining);
+    void voiceFinished(int generation);
+    void voiceLatency(int generation, qint64 latency);
 
 private:
     void setStatus(QSoundEffect::Status status);
@@ -42,14 +42,19 @@ QWaveDecoder::QWaveDecoder(QIODevice *s, QObject *parent):
     QIODevice(parent),
     haveFormat(false),
     dataSize(0),
+    dataStart(0),
+    readPosition(0),
+    rf64DataSize(0),
     source(s),
     state(QWaveDecoder::InitialState),
     junkToSkip(0),
-    bigEndian(false)
+    bigEndian(false),
+    rf64(false)
 {
     open(QIODevice::ReadOnly | QIODevice::Unbuffered);
 
-    if (enoughDataAvailable())
+    // Random access sources hold all their data already
+    if (!source->isSequential() || enoughDataAvailable())
         QTimer::singleShot(0, this, SLOT(handleData()));
     else
         connect(source, SIGNAL(readyRead()), SLOT(handleData()));
@@ -66,7 +71,9 @@ QAudioFormat QWaveDecoder::audioFormat() const
 
 int QWaveDecoder::duration() const
 {
-    return size() * 1000 / (format.sampleSize() / 8) / format.channelCount() / format.sampleRate();
+    if (!haveFormat || format.bytesPerFrame() == 0 || format.sampleRate() == 0)
+        return 0;
+    return size() * 1000 / format.bytesPerFrame() / format.sampleRate();
 }
 
 qint64 QWaveDecoder::size() const
@@ -81,12 +88,74 @@ bool QWaveDecoder::isSequential() const
 
 qint64 QWaveDecoder::bytesAvailable() const
 {
-    return haveFormat ? source->bytesAvailable() : 0;
+    return haveFormat ? qMin(source->bytesAvailable(), dataSize - readPosition) : 0;
+}
+
+/*
+    Returns the number of sample frames in the file.
+*/
+qint64 QWaveDecoder::frameCount() const
+{
+    const int frameBytes = format.bytesPerFrame();
+    return haveFormat && frameBytes > 0 ? dataSize / frameBytes : 0;
+}
+
+/*
+    Returns the offset of the first sample frame in the source.
+*/
+qint64 QWaveDecoder::dataOffset() const
+{
+    return haveFormat ? dataStart : 0;
+}
+
+/*
+    Returns the offset of \a frame in the source, without reading anything.
+*/
+qint64 QWaveDecoder::offsetForFrame(qint64 frame) const
+{
+    return dataOffset() + frame * format.bytesPerFrame();
+}
+
+/*
+    Moves to the sample data byte at \a pos. Only random access sources can
+    seek.
+*/
+bool QWaveDecoder::seek(qint64 pos)
+{
+    if (!haveFormat || source->isSequential() || pos < 0 || pos > dataSize)
+        return false;
+    if (!source->seek(dataStart + pos))
+        return false;
+
+    readPosition = pos;
+    return QIODevice::seek(pos);
+}
+
+bool QWaveDecoder::seekToFrame(qint64 frame)
+{
+    return seek(frame * format.bytesPerFrame());
 }
 
 qint64 QWaveDecoder::readData(char *data, qint64 maxlen)
 {
-    return haveFormat ? source->read(data, maxlen) : 0;
+    if (!haveFormat)
+        return 0;
+
+    // Never past the sample data, and in whole frames so that large reads
+    // stay aligned on frames, unless less than a frame is asked for or the
+    // read reaches the end of data that stops in the middle of a frame
+    const qint64 remaining = dataSize - readPosition;
+    qint64 length = qMin(maxlen, remaining);
+    const int frameBytes = format.bytesPerFrame();
+    if (frameBytes > 0 && length >= frameBytes && length < remaining)
+        length -= length % frameBytes;
+    if (length <= 0)
+        return 0;
+
+    const qint64 read = source->read(data, length);
+    if (read > 0)
+        readPosition += read;
+    return read;
 }
 
 qint64 QWaveDecoder::writeData(const char *data, qint64 len)
@@ -120,23 +189,49 @@ void QWaveDecoder::handleData()
     }
 
     if (state == QWaveDecoder::InitialState) {
-        if (source->bytesAvailable() < qint64(sizeof(RIFFHeader)))
+        if (source->bytesAvailable() < qint64(sizeof(RIFFHeader))) {
+            if (source->atEnd())
+                parsingFailed();
             return;
+        }
 
         RIFFHeader riff;
         source->read(reinterpret_cast<char *>(&riff), sizeof(RIFFHeader));
 
-        // RIFF = little endian RIFF, RIFX = big endian RIFF
-        if (((qstrncmp(riff.descriptor.id, "RIFF", 4) != 0) && (qstrncmp(riff.descriptor.id, "RIFX", 4) != 0))
+        // RIFF = little endian RIFF, RIFX = big endian RIFF, RF64 = little endian with 64 bit sizes
+        if (((qstrncmp(riff.descriptor.id, "RIFF", 4) != 0) && (qstrncmp(riff.descriptor.id, "RIFX", 4) != 0)
+                && (qstrncmp(riff.descriptor.id, "RF64", 4) != 0))
                 || qstrncmp(riff.type, "WAVE", 4) != 0) {
             parsingFailed();
             return;
         } else {
+            bigEndian = qstrncmp(riff.descriptor.id, "RIFX", 4) == 0;
+            rf64 = qstrncmp(riff.descriptor.id, "RF64", 4) == 0;
+            state = rf64 ? QWaveDecoder::WaitingForDs64State : QWaveDecoder::WaitingForFormatState;
+        }
+    }
+
+    if (state == QWaveDecoder::WaitingForDs64State) {
+        if (findChunk("ds64")) {
+            chunk descriptor;
+            peekChunk(&descriptor);
+
+            quint32 rawChunkSize = descriptor.size + sizeof(chunk);
+            if (rawChunkSize < sizeof(DS64Header)) {
+                parsingFailed();
+                return;
+            }
+            if (source->bytesAvailable() < qint64(rawChunkSize))
+                return;
+
+            DS64Header ds64;
+            source->read(reinterpret_cast<char *>(&ds64), sizeof(DS64Header));
+            if (rawChunkSize > sizeof(DS64Header))
+                discardBytes(rawChunkSize - sizeof(DS64Header));
+
+            rf64DataSize = qint64(qFromLittleEndian<quint32>(ds64.dataSizeHigh)) << 32
+                    | qFromLittleEndian<quint32>(ds64.dataSizeLow);
             state = QWaveDecoder::WaitingForFormatState;
-            if (qstrncmp(riff.descriptor.id, "RIFX", 4) == 0)
-                bigEndian = true;
-            else
-                bigEndian = false;
         }
     }
 
@@ -151,42 +246,35 @@ void QWaveDecoder::handleData()
 
             WAVEHeader wave;
             source->read(reinterpret_cast<char *>(&wave), sizeof(WAVEHeader));
+            quint32 formatTag = fromFileEndian<quint16>(wave.audioFormat);
+
+            // Extensible formats keep the actual format tag in the extension
+            WAVEExtension extension;
+            quint32 headerSize = sizeof(WAVEHeader);
+            if (formatTag == ExtensibleFormatTag && rawChunkSize >= sizeof(WAVEHeader) + sizeof(WAVEExtension)) {
+                source->read(reinterpret_cast<char *>(&extension), sizeof(WAVEExtension));
+                headerSize += sizeof(WAVEExtension);
+                formatTag = fromFileEndian<quint32>(extension.subFormat);
+            }
 
-            if (rawChunkSize > sizeof(WAVEHeader))
-                discardBytes(rawChunkSize - sizeof(WAVEHeader));
+            if (rawChunkSize > headerSize)
+                discardBytes(rawChunkSize - headerSize);
 
-            // Swizzle this
-            if (bigEndian) {
-                wave.audioFormat = qFromBigEndian<quint16>(wave.audioFormat);
-            } else {
-                wave.audioFormat = qFromLittleEndian<quint16>(wave.audioFormat);
-            }
+            const int bps = fromFileEndian<quint16>(wave.bitsPerSample);
+            const bool isFloat = formatTag == FloatFormatTag;
 
-            if (wave.audioFormat != 0 && wave.audioFormat != 1) {
-                // 32bit wave files have format == 0xFFFE (WAVE_FORMAT_EXTENSIBLE).
-                // but don't support them at the moment.
+            if ((formatTag != 0 && formatTag != PcmFormatTag && !isFloat) || (isFloat && bps != 32)) {
+                // Compressed formats, and doubles, are not supported
                 parsingFailed();
                 return;
             } else {
                 format.setCodec(QLatin1String("audio/pcm"));
-
-                if (bigEndian) {
-                    int bps = qFromBigEndian<quint16>(wave.bitsPerSample);
-
-                    format.setSampleType(bps == 8 ? QAudioFormat::UnSignedInt : QAudioFormat::SignedInt);
-                    format.setByteOrder(QAudioFormat::BigEndian);
-                    format.setSampleRate(qFromBigEndian<quint32>(wave.sampleRate));
-                    format.setSampleSize(bps);
-                    format.setChannelCount(qFromBigEndian<quint16>(wave.numChannels));
-                } else {
-                    int bps = qFromLittleEndian<quint16>(wave.bitsPerSample);
-
-                    format.setSampleType(bps == 8 ? QAudioFormat::UnSignedInt : QAudioFormat::SignedInt);
-                    format.setByteOrder(QAudioFormat::LittleEndian);
-                    format.setSampleRate(qFromLittleEndian<quint32>(wave.sampleRate));
-                    format.setSampleSize(bps);
-                    format.setChannelCount(qFromLittleEndian<quint16>(wave.numChannels));
-                }
+                format.setSampleType(isFloat ? QAudioFormat::Float
+                                             : bps == 8 ? QAudioFormat::UnSignedInt : QAudioFormat::SignedInt);
+                format.setByteOrder(bigEndian ? QAudioFormat::BigEndian : QAudioFormat::LittleEndian);
+                format.setSampleRate(fromFileEndian<quint32>(wave.sampleRate));
+                format.setSampleSize(bps);
+                format.setChannelCount(fromFileEndian<quint16>(wave.numChannels));
 
                 state = QWaveDecoder::WaitingForDataState;
             }
@@ -199,12 +287,20 @@ void QWaveDecoder::handleData()
 
             chunk descriptor;
             source->read(reinterpret_cast<char *>(&descriptor), sizeof(chunk));
-            if (bigEndian)
-                descriptor.size = qFromBigEndian<quint32>(descriptor.size);
+            descriptor.size = fromFileEndian<quint32>(descriptor.size);
+
+            // RF64 files leave the 32 bit size at its maximum
+            if (rf64 && descriptor.size == 0xFFFFFFFF)
+                dataSize = rf64DataSize;
             else
-                descriptor.size = qFromLittleEndian<quint32>(descriptor.size);
+                dataSize = descriptor.size;
+
+            dataStart = source->pos();
+            readPosition = 0;
 
-            dataSize = descriptor.size;
+            // Files still being recorded may not hold all the data announced yet
+            if (!source->isSequential())
+                dataSize = qBound(qint64(0), dataSize, source->size() - dataStart);
 
             haveFormat = true;
             connect(source, SIGNAL(readyRead()), SIGNAL(readyRead()));
@@ -46,6 +46,7 @@
 //
 
 #include <QtCore/qiodevice.h>
+#include <QtCore/qendian.h>
 #include <qaudioformat.h>
 
 
@@ -67,6 +68,12 @@ public:
     qint64 size() const;
     bool isSequential() const;
     qint64 bytesAvailable() const;
+    bool seek(qint64 pos);
+
+    qint64 frameCount() const;
+    qint64 dataOffset() const;
+    qint64 offsetForFrame(qint64 frame) const;
+    bool seekToFrame(qint64 frame);
 
 Q_SIGNALS:
     void formatKnown();
@@ -84,12 +91,24 @@ private:
     void discardBytes(qint64 numBytes);
     void parsingFailed();
 
+    template <typename T> T fromFileEndian(T value) const
+    {
+        return bigEndian ? qFromBigEndian<T>(value) : qFromLittleEndian<T>(value);
+    }
+
     enum State {
         InitialState,
+        WaitingForDs64State,
         WaitingForFormatState,
         WaitingForDataState
     };
 
+    enum FormatTag {
+        PcmFormatTag = 0x0001,
+        FloatFormatTag = 0x0003,
+        ExtensibleFormatTag = 0xFFFE
+    };
+
     struct chunk
     {
         char        id[4];
@@ -112,14 +131,39 @@ private:
         quint16     blockAlign;
         quint16     bitsPerSample;
     };
+    // Follows the WAVEHeader when its audioFormat is ExtensibleFormatTag
+    struct WAVEExtension
+    {
+        quint16     size;
+        quint16     validBitsPerSample;
+        quint32     channelMask;
+        quint32     subFormat;      // first field of the sub format GUID, the format tag
+        char        subFormatGuid[12];
+    };
+    // RF64 files hold their 64 bit sizes in this chunk, before the format
+    struct DS64Header
+    {
+        chunk       descriptor;
+        quint32     riffSizeLow;
+        quint32     riffSizeHigh;
+        quint32     dataSizeLow;
+        quint32     dataSizeHigh;
+        quint32     sampleCountLow;
+        quint32     sampleCountHigh;
+        quint32     tableLength;
+    };
 
     bool haveFormat;
     qint64 dataSize;
+    qint64 dataStart;
+    qint64 readPosition;
+    qint64 rf64DataSize;
     QAudioFormat format;
     QIODevice *source;
     State state;
     quint32 junkToSkip;
     bool bigEndian;
+    bool rf64;
 };
 
 QT_END_NAMESPACE
@@ -40,8 +40,11 @@ PUBLIC_HEADERS += \
     controls/qaudiorolecontrol.h
 
 PRIVATE_HEADERS += \
+    controls/qmediaaudioprobecontrol_p.h \
     controls/qmediaplaylistcontrol_p.h \
-    controls/qmediaplaylistsourcecontrol_p.h
+    controls/qmediaplaylistsourcecontrol_p.h \
+    controls/qmediaprobequeue_p.h \
+    controls/qmediavideoprobecontrol_p.h
 
 SOURCES += \
     controls/qcameracapturebufferformatcontrol.cpp \
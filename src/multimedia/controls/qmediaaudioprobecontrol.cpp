@@ -32,7 +32,7 @@
 ****************************************************************************/
 
 #include "qmediaaudioprobecontrol.h"
-#include "qmediacontrol_p.h"
+#include "qmediaaudioprobecontrol_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -68,7 +68,7 @@ QT_BEGIN_NAMESPACE
   Create a new media audio probe control object with the given \a parent.
 */
 QMediaAudioProbeControl::QMediaAudioProbeControl(QObject *parent)
-    : QMediaControl(*new QMediaControlPrivate, parent)
+    : QMediaControl(*new QMediaAudioProbeControlPrivate, parent)
 {
 }
 
@@ -91,6 +91,69 @@ QMediaAudioProbeControl::~QMediaAudioProbeControl()
     This signal should be emitted when it is required to release all frames.
 */
 
+/*!
+    \class QMediaAudioProbeControlPrivate
+    \internal
+
+    Holds the settings requested by the QAudioProbe instances monitoring a
+    QMediaAudioProbeControl. Backends pass the probed buffers through \c queue,
+    which delivers them according to the requested policy.
+*/
+
+QMediaAudioProbeControlPrivate *QMediaAudioProbeControlPrivate::get(QMediaAudioProbeControl *control)
+{
+    return control ? control->d_func() : 0;
+}
+
+/*!
+    Sets the \a settings requested by \a probe.
+*/
+void QMediaAudioProbeControlPrivate::setProbeSettings(const void *probe, const QAudioProbeSettings &settings)
+{
+    QMutexLocker locker(&mutex);
+    probes.insert(probe, settings);
+    updateSettings();
+}
+
+/*!
+    Discards the settings requested by \a probe.
+*/
+void QMediaAudioProbeControlPrivate::removeProbe(const void *probe)
+{
+    QMutexLocker locker(&mutex);
+    probes.remove(probe);
+    updateSettings();
+}
+
+/*!
+    Returns the settings applied to the probed buffers, the least lossy
+    delivery policy and the largest queue capacity requested by the probes.
+*/
+QAudioProbeSettings QMediaAudioProbeControlPrivate::settings() const
+{
+    QMutexLocker locker(&mutex);
+    return current;
+}
+
+void QMediaAudioProbeControlPrivate::updateSettings()
+{
+    QAudioProbeSettings merged;
+
+    QHash<const void *, QAudioProbeSettings>::const_iterator it = probes.constBegin();
+    if (it != probes.constEnd()) {
+        merged = it.value();
+        for (++it; it != probes.constEnd(); ++it) {
+            merged.deliveryPolicy = qMax(merged.deliveryPolicy, it.value().deliveryPolicy);
+            merged.queueCapacity = qMax(merged.queueCapacity, it.value().queueCapacity);
+        }
+    }
+
+    if (merged.deliveryPolicy != current.deliveryPolicy || merged.queueCapacity != current.queueCapacity) {
+        current = merged;
+        queue.setPolicy(current.deliveryPolicy, current.queueCapacity);
+    }
+}
+
 #include "moc_qmediaaudioprobecontrol.cpp"
 
 QT_END_NAMESPACE
@@ -39,6 +39,7 @@
 QT_BEGIN_NAMESPACE
 
 class QAudioBuffer;
+class QMediaAudioProbeControlPrivate;
 class Q_MULTIMEDIA_EXPORT QMediaAudioProbeControl : public QMediaControl
 {
     Q_OBJECT
@@ -51,6 +52,9 @@ Q_SIGNALS:
 
 protected:
     explicit QMediaAudioProbeControl(QObject *parent = Q_NULLPTR);
+
+private:
+    Q_DECLARE_PRIVATE(QMediaAudioProbeControl)
 };
 
 #define QMediaAudioProbeControl_iid "org.qt-project.qt.mediaaudioprobecontrol/5.0"
@@ -0,0 +1,199 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QMEDIAPROBEQUEUE_P_H
+#define QMEDIAPROBEQUEUE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qmultimedia.h>
+
+#include <QtCore/qmutex.h>
+#include <QtCore/qqueue.h>
+#include <QtCore/qwaitcondition.h>
+
+QT_BEGIN_NAMESPACE
+
+// Hands the data captured by a media probe over to the thread of the probes,
+// following a QMultimedia::ProbeDeliveryPolicy
+template <typename T>
+class QMediaProbeQueue
+{
+public:
+    enum {
+        DefaultCapacity = 8,
+        // A blocked producer gives up after this many milliseconds, so that a
+        // pipeline stopped from the thread of the probes never deadlocks
+        MaximumBlockingTime = 1000
+    };
+
+    QMediaProbeQueue()
+        : m_policy(QMultimedia::LatestOnlyDelivery)
+        , m_capacity(DefaultCapacity)
+        , m_droppedCount(0)
+        , m_highWaterMark(0)
+        , m_flushing(false)
+    {
+    }
+
+    QMultimedia::ProbeDeliveryPolicy policy() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_policy;
+    }
+
+    int capacity() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_capacity;
+    }
+
+    void setPolicy(QMultimedia::ProbeDeliveryPolicy policy, int capacity)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_policy = policy;
+        m_capacity = qMax(1, capacity);
+        while (m_queue.size() > maximumSize()) {
+            m_queue.dequeue();
+            ++m_droppedCount;
+        }
+        m_condition.wakeAll();
+    }
+
+    // Returns true if the queue was empty, the consumer then has to be notified
+    bool enqueue(const T &item)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_policy == QMultimedia::BlockingQueueDelivery) {
+            while (!m_flushing && m_queue.size() >= maximumSize()) {
+                if (!m_condition.wait(&m_mutex, MaximumBlockingTime))
+                    break;
+            }
+        }
+
+        if (m_flushing)
+            return false;
+
+        const bool wasEmpty = m_queue.isEmpty();
+        while (m_queue.size() >= maximumSize()) {
+            m_queue.dequeue();
+            ++m_droppedCount;
+        }
+
+        m_queue.enqueue(item);
+        m_highWaterMark = qMax(m_highWaterMark, m_queue.size());
+        return wasEmpty;
+    }
+
+    // Takes the oldest item, returns false if the queue is empty
+    bool dequeue(T *item, bool *more = 0)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_queue.isEmpty())
+            return false;
+
+        *item = m_queue.dequeue();
+        if (more)
+            *more = !m_queue.isEmpty();
+        m_condition.wakeAll();
+        return true;
+    }
+
+    // Discards the queued items and releases a blocked producer, nothing is
+    // queued until flushing stops
+    void setFlushing(bool flushing)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_flushing = flushing;
+        if (flushing)
+            m_queue.clear();
+        m_condition.wakeAll();
+    }
+
+    void clear()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.clear();
+        m_condition.wakeAll();
+    }
+
+    int droppedCount() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_droppedCount;
+    }
+
+    int highWaterMark() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_highWaterMark;
+    }
+
+    void resetStatistics()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_droppedCount = 0;
+        m_highWaterMark = m_queue.size();
+    }
+
+private:
+    int maximumSize() const
+    {
+        return m_policy == QMultimedia::LatestOnlyDelivery ? 1 : m_capacity;
+    }
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    QQueue<T> m_queue;
+    QMultimedia::ProbeDeliveryPolicy m_policy;
+    int m_capacity;
+    int m_droppedCount;
+    int m_highWaterMark;
+    bool m_flushing;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMEDIAPROBEQUEUE_P_H
@@ -32,7 +32,8 @@
 ****************************************************************************/
 
 #include "qmediavideoprobecontrol.h"
-#include "qmediacontrol_p.h"
+#include "qmediavideoprobecontrol_p.h"
+#include "qvideoframe_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -68,7 +69,7 @@ QT_BEGIN_NAMESPACE
   Create a new media video probe control object with the given \a parent.
 */
 QMediaVideoProbeControl::QMediaVideoProbeControl(QObject *parent)
-    : QMediaControl(*new QMediaControlPrivate, parent)
+    : QMediaControl(*new QMediaVideoProbeControlPrivate, parent)
 {
 }
 
@@ -90,6 +91,172 @@ QMediaVideoProbeControl::~QMediaVideoProbeControl()
     This signal should be emitted when it is required to release all frames.
 */
 
+/*!
+    \class QMediaVideoProbeControlPrivate
+    \internal
+
+    Holds the settings requested by the QVideoProbe instances monitoring a
+    QMediaVideoProbeControl, and reduces the probed frames accordingly.
+
+    Backends call acceptFrame() and reduceFrame() for each frame in the
+    thread the frame is produced in, so that skipped frames never cross to the
+    thread of the probes and the remaining ones only do so at the requested
+    size and pixel format. The frames are then passed through \c queue,
+    according to the requested delivery policy.
+*/
+
+QMediaVideoProbeControlPrivate::QMediaVideoProbeControlPrivate()
+    : frameCount(0)
+    , nextTime(-1)
+{
+}
+
+QMediaVideoProbeControlPrivate *QMediaVideoProbeControlPrivate::get(QMediaVideoProbeControl *control)
+{
+    return control ? control->d_func() : 0;
+}
+
+/*!
+    Sets the \a settings requested by \a probe.
+*/
+void QMediaVideoProbeControlPrivate::setProbeSettings(const void *probe, const QVideoProbeSettings &settings)
+{
+    QMutexLocker locker(&mutex);
+    probes.insert(probe, settings);
+    updateSettings();
+}
+
+/*!
+    Discards the settings requested by \a probe.
+*/
+void QMediaVideoProbeControlPrivate::removeProbe(const void *probe)
+{
+    QMutexLocker locker(&mutex);
+    probes.remove(probe);
+    updateSettings();
+}
+
+/*!
+    Returns the settings applied to the probed frames.
+
+    The control is shared by all the probes monitoring the same media object,
+    their settings are combined so that each of them gets at least the frames
+    it asked for: the smallest stride and the highest rate apply, and the
+    frames are only resized or converted if all probes agree on the size or
+    pixel format. The least lossy delivery policy and the largest queue
+    capacity apply.
+*/
+QVideoProbeSettings QMediaVideoProbeControlPrivate::settings() const
+{
+    QMutexLocker locker(&mutex);
+    return current;
+}
+
+void QMediaVideoProbeControlPrivate::updateSettings()
+{
+    QVideoProbeSettings merged;
+
+    QHash<const void *, QVideoProbeSettings>::const_iterator it = probes.constBegin();
+    if (it != probes.constEnd()) {
+        merged = it.value();
+        for (++it; it != probes.constEnd(); ++it) {
+            const QVideoProbeSettings &settings = it.value();
+            merged.frameStride = qMin(merged.frameStride, settings.frameStride);
+            if (settings.maximumFrameRate <= 0)
+                merged.maximumFrameRate = 0;
+            else if (merged.maximumFrameRate > 0)
+                merged.maximumFrameRate = qMax(merged.maximumFrameRate, settings.maximumFrameRate);
+            if (merged.frameSize != settings.frameSize)
+                merged.frameSize = QSize();
+            if (merged.pixelFormat != settings.pixelFormat)
+                merged.pixelFormat = QVideoFrame::Format_Invalid;
+            merged.deliveryPolicy = qMax(merged.deliveryPolicy, settings.deliveryPolicy);
+            merged.queueCapacity = qMax(merged.queueCapacity, settings.queueCapacity);
+        }
+    }
+
+    if (merged.deliveryPolicy != current.deliveryPolicy || merged.queueCapacity != current.queueCapacity)
+        queue.setPolicy(merged.deliveryPolicy, merged.queueCapacity);
+
+    if (merged != current) {
+        current = merged;
+        frameCount = 0;
+        nextTime = -1;
+    }
+}
+
+/*!
+    Returns true if \a frame should be delivered to the probes, or false if it
+    is skipped to honour the requested frame stride and rate.
+
+    The rate is measured on the start time of the frames, or on the time they
+    are probed at if they have none.
+*/
+bool QMediaVideoProbeControlPrivate::acceptFrame(const QVideoFrame &frame)
+{
+    QMutexLocker locker(&mutex);
+
+    if (current.frameStride > 1) {
+        const bool skip = frameCount != 0;
+        frameCount = (frameCount + 1) % current.frameStride;
+        if (skip)
+            return false;
+    }
+
+    if (current.maximumFrameRate > 0) {
+        qint64 time = frame.startTime();
+        if (time < 0) {
+            if (!timer.isValid())
+                timer.start();
+            time = timer.nsecsElapsed() / 1000;
+        }
+
+        const qint64 interval = qRound64(1000000 / current.maximumFrameRate);
+        if (nextTime >= 0 && time < nextTime && nextTime - time <= interval)
+            return false;
+
+        // Advance from the previous deadline so the average rate stays exact,
+        // restart from this frame after a gap or when the stream went back
+        if (nextTime < 0 || time < nextTime || time - nextTime >= interval)
+            nextTime = time + interval;
+        else
+            nextTime += interval;
+    }
+
+    return true;
+}
+
+/*!
+    Returns \a frame scaled down to fit the requested frame size, keeping its
+    aspect ratio, and converted to the requested pixel format.
+
+    The frame is returned as is if no size or pixel format was requested.
+    Returns an invalid frame if the frame could not be converted.
+*/
+QVideoFrame QMediaVideoProbeControlPrivate::reduceFrame(const QVideoFrame &frame) const
+{
+    const QVideoProbeSettings settings = this->settings();
+
+    QVideoFrame result = frame;
+
+    if (settings.frameSize.isValid()
+            && (frame.width() > settings.frameSize.width()
+                || frame.height() > settings.frameSize.height())) {
+        const QImage image = qt_scaledImageFromVideoFrame(frame, settings.frameSize, Qt::KeepAspectRatio);
+        if (image.isNull())
+            return QVideoFrame();
+
+        result = QVideoFrame(image);
+        result.setStartTime(frame.startTime());
+        result.setEndTime(frame.endTime());
+    }
+
+    if (settings.pixelFormat != QVideoFrame::Format_Invalid && result.pixelFormat() != settings.pixelFormat)
+        result = qt_convertVideoFrame(result, settings.pixelFormat);
+
+    return result;
+}
+
 #include "moc_qmediavideoprobecontrol.cpp"
 
 QT_END_NAMESPACE
@@ -41,6 +41,7 @@
 QT_BEGIN_NAMESPACE
 
 class QVideoFrame;
+class QMediaVideoProbeControlPrivate;
 class Q_MULTIMEDIA_EXPORT QMediaVideoProbeControl : public QMediaControl
 {
     Q_OBJECT
@@ -53,6 +54,9 @@ Q_SIGNALS:
 
 protected:
     explicit QMediaVideoProbeControl(QObject *parent = Q_NULLPTR);
+
+private:
+    Q_DECLARE_PRIVATE(QMediaVideoProbeControl)
 };
 
 #define QMediaVideoProbeControl_iid "org.qt-project.qt.mediavideoprobecontrol/5.0"
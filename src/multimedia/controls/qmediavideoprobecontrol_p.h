@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QMEDIAVIDEOPROBECONTROL_P_H
+#define QMEDIAVIDEOPROBECONTROL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qmediavideoprobecontrol.h>
+#include <qvideoframe.h>
+#include <private/qmediacontrol_p.h>
+#include <private/qmediaprobequeue_p.h>
+
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qelapsedtimer.h>
+
+QT_BEGIN_NAMESPACE
+
+struct QVideoProbeSettings
+{
+    QVideoProbeSettings()
+        : frameStride(1)
+        , maximumFrameRate(0)
+        , pixelFormat(QVideoFrame::Format_Invalid)
+        , deliveryPolicy(QMultimedia::LatestOnlyDelivery)
+        , queueCapacity(QMediaProbeQueue<QVideoFrame>::DefaultCapacity)
+    {
+    }
+
+    bool operator==(const QVideoProbeSettings &other) const
+    {
+        return frameStride == other.frameStride
+                && qFuzzyCompare(maximumFrameRate + 1, other.maximumFrameRate + 1)
+                && frameSize == other.frameSize
+                && pixelFormat == other.pixelFormat
+                && deliveryPolicy == other.deliveryPolicy
+                && queueCapacity == other.queueCapacity;
+    }
+    bool operator!=(const QVideoProbeSettings &other) const { return !operator==(other); }
+
+    int frameStride;
+    qreal maximumFrameRate;
+    QSize frameSize;
+    QVideoFrame::PixelFormat pixelFormat;
+    QMultimedia::ProbeDeliveryPolicy deliveryPolicy;
+    int queueCapacity;
+};
+
+class Q_MULTIMEDIA_EXPORT QMediaVideoProbeControlPrivate : public QMediaControlPrivate
+{
+public:
+    QMediaVideoProbeControlPrivate();
+
+    static QMediaVideoProbeControlPrivate *get(QMediaVideoProbeControl *control);
+
+    void setProbeSettings(const void *probe, const QVideoProbeSettings &settings);
+    void removeProbe(const void *probe);
+
+    QVideoProbeSettings settings() const;
+
+    // Called by the backend for each frame, usually from the streaming thread
+    bool acceptFrame(const QVideoFrame &frame);
+    QVideoFrame reduceFrame(const QVideoFrame &frame) const;
+
+    // Frames on their way to the probes
+    QMediaProbeQueue<QVideoFrame> queue;
+
+private:
+    void updateSettings();
+
+    mutable QMutex mutex;
+    QHash<const void *, QVideoProbeSettings> probes;
+    QVideoProbeSettings current;
+    int frameCount;
+    qint64 nextTime;
+    QElapsedTimer timer;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMEDIAVIDEOPROBECONTROL_P_H
@@ -73,7 +73,6 @@ private slots:
     void bufferProbed();
 
 private:
-    QAudioBuffer m_pendingBuffer;
     QAudioFormat m_format;
     QMutex m_bufferMutex;
 };
@@ -77,7 +77,6 @@ private slots:
 
 private:
     QVideoSurfaceFormat m_format;
-    QVideoFrame m_pendingFrame;
     QMutex m_frameMutex;
 #if GST_CHECK_VERSION(1,0,0)
     GstVideoInfo m_videoInfo;
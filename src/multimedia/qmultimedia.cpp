@@ -48,6 +48,7 @@ static void qRegisterMultimediaMetaTypes()
     qRegisterMetaType<QMultimedia::SupportEstimate>();
     qRegisterMetaType<QMultimedia::EncodingMode>();
     qRegisterMetaType<QMultimedia::EncodingQuality>();
+    qRegisterMetaType<QMultimedia::ProbeDeliveryPolicy>();
 }
 
 Q_CONSTRUCTOR_FUNCTION(qRegisterMultimediaMetaTypes)
@@ -101,4 +102,19 @@ Q_CONSTRUCTOR_FUNCTION(qRegisterMultimediaMetaTypes)
     \value Busy The service must wait for access to necessary resources.
 */
 
+/*!
+    \enum QMultimedia::ProbeDeliveryPolicy
+    \since 5.7
+
+    Enumerates how a media probe delivers the data it captures when the thread
+    of the probe does not keep up with the media.
+
+    \value LatestOnlyDelivery Only the most recent buffer or frame is kept, it
+    replaces the previous one if that was not delivered yet.
+    \value DropOldestQueueDelivery Buffers or frames are queued up to the queue
+    capacity, the oldest queued one is dropped when the queue is full.
+    \value BlockingQueueDelivery Buffers or frames are queued up to the queue
+    capacity, the media pipeline waits for the probe when the queue is full.
+*/
+
 QT_END_NAMESPACE
@@ -77,6 +77,13 @@ namespace QMultimedia
         ResourceError
     };
 
+    enum ProbeDeliveryPolicy
+    {
+        LatestOnlyDelivery,
+        DropOldestQueueDelivery,
+        BlockingQueueDelivery
+    };
+
 }
 
 QT_END_NAMESPACE
@@ -85,6 +92,7 @@ Q_DECLARE_METATYPE(QMultimedia::AvailabilityStatus)
 Q_DECLARE_METATYPE(QMultimedia::SupportEstimate)
 Q_DECLARE_METATYPE(QMultimedia::EncodingMode)
 Q_DECLARE_METATYPE(QMultimedia::EncodingQuality)
+Q_DECLARE_METATYPE(QMultimedia::ProbeDeliveryPolicy)
 
 
 #endif
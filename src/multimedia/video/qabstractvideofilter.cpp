@@ -32,6 +32,11 @@
 ****************************************************************************/
 
 #include "qabstractvideofilter.h"
+#include "qabstractvideofilter_p.h"
+#include "qvideoframepool_p.h"
+
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadstorage.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -215,7 +220,11 @@ QT_BEGIN_NAMESPACE
   writing may become problematic.
 
   \note Avoid time consuming operations in this function as they block the
-  entire rendering of the application.
+  entire rendering of the application. Filters doing so should use the
+  \l{QAbstractVideoFilter::Asynchronous}{Asynchronous} execution mode, in which
+  this function is called on a worker thread instead, without an OpenGL context
+  bound. The gui thread is not blocked then, so properties of the
+  QAbstractVideoFilter must not be accessed from the function.
 
   \note The handleType() and pixelFormat() of \a input is completely up to the
   video decoding backend on the platform in use. On some platforms different
@@ -239,23 +248,81 @@ QT_BEGIN_NAMESPACE
   is the last in the corresponding VideoOutput type's filters list, meaning
   that the returned frame is the one that is going to be presented to the scene
   graph without invoking any further filters.
+
+  \value InputMapped Indicates that the input frame is already mapped in
+  \l{QAbstractVideoBuffer::ReadOnly}{ReadOnly} mode, so its data can be
+  accessed without mapping it again. The VideoOutput keeps system memory frames
+  mapped across consecutive filters which declare a
+  \l{QAbstractVideoFilter::readOnlyInput}{read only input}. This value was
+  introduced in Qt 5.7.
  */
 
-class QAbstractVideoFilterPrivate
+/*!
+  \internal
+ */
+QVideoFilterRunnable::~QVideoFilterRunnable()
+{
+}
+
+namespace {
+
+// Frame pools of the current thread, the most recently used first
+class QVideoFilterFramePools
 {
 public:
-    QAbstractVideoFilterPrivate() :
-        active(true)
-    { }
+    enum { MaximumPools = 4 };
+
+    ~QVideoFilterFramePools() { qDeleteAll(pools); }
+
+    QVideoFramePool *pool(const QSize &size, QVideoFrame::PixelFormat pixelFormat)
+    {
+        for (int i = 0; i < pools.size(); ++i) {
+            const QVideoSurfaceFormat format = pools.at(i)->format();
+            if (format.frameSize() == size && format.pixelFormat() == pixelFormat) {
+                pools.move(i, 0);
+                return pools.first();
+            }
+        }
+
+        if (pools.size() >= MaximumPools)
+            delete pools.takeLast();
+        pools.prepend(new QVideoFramePool(QVideoSurfaceFormat(size, pixelFormat)));
+        return pools.first();
+    }
 
-    bool active;
+private:
+    QList<QVideoFramePool *> pools;
 };
 
+}
+
+Q_GLOBAL_STATIC(QThreadStorage<QVideoFilterFramePools *>, filterFramePools)
+
 /*!
-  \internal
+  Returns a new system memory frame of \a size and \a pixelFormat, for example
+  to write the output of the filter into.
+
+  The memory of the frame is recycled once all copies of it are released, and
+  reused by later calls on the same thread with the same size and format.
+  Filters returning a new frame for every input frame should use this function
+  to avoid allocating memory each time. The contents of the frame are
+  undefined.
+
+  Returns an invalid frame if frames in \a pixelFormat have no known memory
+  layout.
+
+  \since 5.7
  */
-QVideoFilterRunnable::~QVideoFilterRunnable()
+QVideoFrame QVideoFilterRunnable::allocateFrame(const QSize &size, QVideoFrame::PixelFormat pixelFormat)
 {
+    QThreadStorage<QVideoFilterFramePools *> *storage = filterFramePools();
+    if (!storage)
+        return QVideoFrame();
+
+    if (!storage->hasLocalData())
+        storage->setLocalData(new QVideoFilterFramePools);
+
+    return storage->localData()->pool(size, pixelFormat)->allocate();
 }
 
 /*!
@@ -265,6 +332,7 @@ QAbstractVideoFilter::QAbstractVideoFilter(QObject *parent) :
     QObject(parent),
     d_ptr(new QAbstractVideoFilterPrivate)
 {
+    d_ptr->q_ptr = this;
 }
 
 /*!
@@ -299,6 +367,226 @@ void QAbstractVideoFilter::setActive(bool v)
     }
 }
 
+/*!
+    \enum QAbstractVideoFilter::ExecutionMode
+    \since 5.7
+
+    \value Synchronous The filter runnable is invoked on the render thread,
+    and the frame it returns is rendered.
+    \value Asynchronous Frames are queued to a worker thread on which the
+    filter runnable is invoked, while rendering continues without waiting for
+    it. The most recent frame the runnable returned, if it differs from its
+    input, is rendered in place of the incoming frames. When the worker falls
+    behind, the oldest queued frames are dropped.
+*/
+
+/*!
+    \property QAbstractVideoFilter::executionMode
+    \brief how the filter runnable is invoked.
+    \since 5.7
+
+    By default filters run \l Synchronous. Filters performing expensive
+    computations that do not need to modify the displayed image, such as
+    object detection, should be made \l Asynchronous so that they cannot lower
+    the frame rate of the VideoOutput.
+
+    Changing the mode recreates the filter runnable.
+ */
+QAbstractVideoFilter::ExecutionMode QAbstractVideoFilter::executionMode() const
+{
+    Q_D(const QAbstractVideoFilter);
+    return d->executionMode;
+}
+
+void QAbstractVideoFilter::setExecutionMode(ExecutionMode mode)
+{
+    Q_D(QAbstractVideoFilter);
+    if (d->executionMode != mode) {
+        d->executionMode = mode;
+        emit executionModeChanged();
+    }
+}
+
+/*!
+    \property QAbstractVideoFilter::droppedFrames
+    \brief the number of frames an asynchronous filter did not process.
+    \since 5.7
+
+    Frames are dropped when they arrive faster than the filter runnable
+    processes them.
+ */
+int QAbstractVideoFilter::droppedFrames() const
+{
+    Q_D(const QAbstractVideoFilter);
+    return d->droppedFrames.load();
+}
+
+/*!
+    \property QAbstractVideoFilter::readOnlyInput
+    \brief whether the filter runnable only reads its input frame.
+    \since 5.7
+
+    When true the VideoOutput maps system memory frames once for all
+    consecutive filters with a read only input, instead of each of them mapping
+    and unmapping the frame, and passes the QVideoFilterRunnable::InputMapped
+    flag. The filter runnable must then not map its input in any other mode than
+    \l{QAbstractVideoBuffer::ReadOnly}{ReadOnly}. To modify the image, it writes
+    into a new frame, for instance one returned by
+    QVideoFilterRunnable::allocateFrame(), and returns that.
+
+    The default value is false.
+ */
+bool QAbstractVideoFilter::isReadOnlyInput() const
+{
+    Q_D(const QAbstractVideoFilter);
+    return d->readOnlyInput;
+}
+
+void QAbstractVideoFilter::setReadOnlyInput(bool readOnly)
+{
+    Q_D(QAbstractVideoFilter);
+    if (d->readOnlyInput != readOnly) {
+        d->readOnlyInput = readOnly;
+        emit readOnlyInputChanged();
+    }
+}
+
+void QAbstractVideoFilterPrivate::frameDropped()
+{
+    droppedFrames.ref();
+    // Called on the render thread, notify on the thread the filter lives on
+    QMetaObject::invokeMethod(q_ptr, "droppedFramesChanged", Qt::QueuedConnection);
+}
+
+QVideoFilterInputMapping::~QVideoFilterInputMapping()
+{
+    release();
+}
+
+/*
+    Prepares \a frame for the next filter of a chain and returns the run flags
+    that describe its mapping. The mapping of the previous filter is kept when
+    \a readOnlyInput is true and the frame is still the same, otherwise it is
+    released first.
+*/
+QVideoFilterRunnable::RunFlags QVideoFilterInputMapping::update(QVideoFrame &frame, bool readOnlyInput)
+{
+    const bool shareMapping = readOnlyInput && frame.handleType() == QAbstractVideoBuffer::NoHandle;
+    if (m_frame.isValid() && (!shareMapping || m_frame != frame))
+        release();
+    if (shareMapping && !m_frame.isValid() && frame.map(QAbstractVideoBuffer::ReadOnly))
+        m_frame = frame;
+
+    return m_frame.isValid() ? QVideoFilterRunnable::InputMapped : QVideoFilterRunnable::RunFlags(0);
+}
+
+void QVideoFilterInputMapping::release()
+{
+    if (!m_frame.isValid())
+        return;
+    m_frame.unmap();
+    m_frame = QVideoFrame();
+}
+
+class QAsyncVideoFilterRunnable::Worker : public QThread
+{
+public:
+    explicit Worker(QAsyncVideoFilterRunnable *runnable) : m_runnable(runnable) { }
+
+protected:
+    void run() Q_DECL_OVERRIDE { m_runnable->process(); }
+
+private:
+    QAsyncVideoFilterRunnable *m_runnable;
+};
+
+/*!
+    \class QAsyncVideoFilterRunnable
+    \internal
+
+    Wraps the \a runnable of an asynchronous \a filter, taking ownership of
+    it. Frames passed to run() are queued to a dedicated thread invoking the
+    wrapped runnable, so that the render thread never waits for it.
+*/
+QAsyncVideoFilterRunnable::QAsyncVideoFilterRunnable(QAbstractVideoFilter *filter,
+                                                     QVideoFilterRunnable *runnable)
+    : m_filter(filter)
+    , m_runnable(runnable)
+    , m_thread(new Worker(this))
+    , m_quit(false)
+{
+    m_thread->start();
+}
+
+/*!
+    Waits for the frame being processed, discards the queued ones and destroys
+    the wrapped runnable.
+*/
+QAsyncVideoFilterRunnable::~QAsyncVideoFilterRunnable()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_queue.clear();
+        m_condition.wakeAll();
+    }
+
+    m_thread->wait();
+    delete m_thread;
+    delete m_runnable;
+}
+
+/*!
+    Queues \a input for the worker thread, dropping the oldest queued frame if
+    the queue is full, and returns the latest frame the wrapped runnable
+    produced, or \a input if it passes its frames through.
+*/
+QVideoFrame QAsyncVideoFilterRunnable::run(QVideoFrame *input,
+                                           const QVideoSurfaceFormat &surfaceFormat,
+                                           RunFlags flags)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_queue.size() >= MaximumQueuedFrames) {
+        m_queue.dequeue();
+        if (m_filter)
+            QAbstractVideoFilterPrivate::get(m_filter)->frameDropped();
+    }
+
+    Job job;
+    job.frame = *input;
+    job.surfaceFormat = surfaceFormat;
+    // The input is unmapped long before the worker gets to it
+    job.flags = flags & ~InputMapped;
+    m_queue.enqueue(job);
+    m_condition.wakeOne();
+
+    return m_result.isValid() ? m_result : *input;
+}
+
+void QAsyncVideoFilterRunnable::process()
+{
+    QMutexLocker locker(&m_mutex);
+
+    forever {
+        while (m_queue.isEmpty() && !m_quit)
+            m_condition.wait(&m_mutex);
+
+        if (m_quit)
+            return;
+
+        Job job = m_queue.dequeue();
+
+        locker.unlock();
+        QVideoFrame frame = job.frame;
+        const QVideoFrame output = m_runnable->run(&frame, job.surfaceFormat, job.flags);
+        locker.relock();
+
+        // Frames passed through must not replace the newer ones being rendered
+        m_result = output.isValid() && output != job.frame ? output : QVideoFrame();
+    }
+}
+
 /*!
   \fn QVideoFilterRunnable *QAbstractVideoFilter::createFilterRunnable()
 
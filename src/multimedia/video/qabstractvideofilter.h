@@ -46,12 +46,16 @@ class Q_MULTIMEDIA_EXPORT QVideoFilterRunnable
 {
 public:
     enum RunFlag {
-        LastInChain = 0x01
+        LastInChain = 0x01,
+        InputMapped = 0x02
     };
     Q_DECLARE_FLAGS(RunFlags, RunFlag)
 
     virtual ~QVideoFilterRunnable();
     virtual QVideoFrame run(QVideoFrame *input, const QVideoSurfaceFormat &surfaceFormat, RunFlags flags) = 0;
+
+protected:
+    QVideoFrame allocateFrame(const QSize &size, QVideoFrame::PixelFormat pixelFormat);
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QVideoFilterRunnable::RunFlags)
@@ -60,18 +64,38 @@ class Q_MULTIMEDIA_EXPORT QAbstractVideoFilter : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool active READ isActive WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(ExecutionMode executionMode READ executionMode WRITE setExecutionMode NOTIFY executionModeChanged)
+    Q_PROPERTY(int droppedFrames READ droppedFrames NOTIFY droppedFramesChanged)
+    Q_PROPERTY(bool readOnlyInput READ isReadOnlyInput WRITE setReadOnlyInput NOTIFY readOnlyInputChanged)
+    Q_ENUMS(ExecutionMode)
 
 public:
+    enum ExecutionMode {
+        Synchronous,
+        Asynchronous
+    };
+
     explicit QAbstractVideoFilter(QObject *parent = Q_NULLPTR);
     ~QAbstractVideoFilter();
 
     bool isActive() const;
     void setActive(bool v);
 
+    ExecutionMode executionMode() const;
+    void setExecutionMode(ExecutionMode mode);
+
+    int droppedFrames() const;
+
+    bool isReadOnlyInput() const;
+    void setReadOnlyInput(bool readOnly);
+
     virtual QVideoFilterRunnable *createFilterRunnable() = 0;
 
 Q_SIGNALS:
     void activeChanged();
+    void executionModeChanged();
+    void droppedFramesChanged();
+    void readOnlyInputChanged();
 
 private:
     Q_DECLARE_PRIVATE(QAbstractVideoFilter)
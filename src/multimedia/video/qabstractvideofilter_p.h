@@ -0,0 +1,133 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QABSTRACTVIDEOFILTER_P_H
+#define QABSTRACTVIDEOFILTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtMultimedia/qabstractvideofilter.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qqueue.h>
+#include <QtCore/qwaitcondition.h>
+
+QT_BEGIN_NAMESPACE
+
+class QThread;
+
+class QAbstractVideoFilterPrivate
+{
+    Q_DECLARE_PUBLIC(QAbstractVideoFilter)
+
+public:
+    QAbstractVideoFilterPrivate() :
+        q_ptr(0),
+        active(true),
+        readOnlyInput(false),
+        executionMode(QAbstractVideoFilter::Synchronous)
+    { }
+
+    static QAbstractVideoFilterPrivate *get(QAbstractVideoFilter *filter) { return filter->d_func(); }
+
+    void frameDropped();
+
+    QAbstractVideoFilter *q_ptr;
+    bool active;
+    bool readOnlyInput;
+    QAbstractVideoFilter::ExecutionMode executionMode;
+    QAtomicInt droppedFrames;
+};
+
+/*
+    Keeps a system memory frame mapped ReadOnly across consecutive filters with
+    a read only input, so that the chain maps it once instead of per filter.
+*/
+class Q_MULTIMEDIA_EXPORT QVideoFilterInputMapping
+{
+public:
+    ~QVideoFilterInputMapping();
+
+    QVideoFilterRunnable::RunFlags update(QVideoFrame &frame, bool readOnlyInput);
+    void release();
+
+private:
+    QVideoFrame m_frame;
+};
+
+class Q_MULTIMEDIA_EXPORT QAsyncVideoFilterRunnable : public QVideoFilterRunnable
+{
+public:
+    enum { MaximumQueuedFrames = 2 };
+
+    QAsyncVideoFilterRunnable(QAbstractVideoFilter *filter, QVideoFilterRunnable *runnable);
+    ~QAsyncVideoFilterRunnable();
+
+    QVideoFrame run(QVideoFrame *input, const QVideoSurfaceFormat &surfaceFormat,
+                    RunFlags flags) Q_DECL_OVERRIDE;
+
+private:
+    class Worker;
+    friend class Worker;
+
+    struct Job {
+        QVideoFrame frame;
+        QVideoSurfaceFormat surfaceFormat;
+        RunFlags flags;
+    };
+
+    void process();
+
+    QAbstractVideoFilter *m_filter;
+    QVideoFilterRunnable *m_runnable;
+    QThread *m_thread;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QQueue<Job> m_queue;
+    QVideoFrame m_result;
+    bool m_quit;
+};
+
+QT_END_NAMESPACE
+
+#endif // QABSTRACTVIDEOFILTER_P_H
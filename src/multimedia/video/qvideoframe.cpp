@@ -1005,20 +1005,24 @@ QImage::Format QVideoFrame::imageFormatFromPixelFormat(PixelFormat format)
 }
 
 
-extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_BGR24_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_BGR565_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_BGR555_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_AYUV444_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_YUV444_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_YUV420P_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_YV12_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_NV12_to_ARGB32(const QVideoFrame&, uchar*);
-extern void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame&, uchar*);
-
-static VideoFrameConvertFunc qConvertFuncs[QVideoFrame::NPixelFormats] = {
+extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_BGR24_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_BGR565_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_BGR555_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_AYUV444_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_YUV444_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_YUV420P_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_YV12_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_NV12_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_IMC2_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_IMC4_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_Y8_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+extern void QT_FASTCALL qt_convert_Y16_to_ARGB32(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+
+static const VideoFrameConvertFunc qScalarConvertFuncs[QVideoFrame::NPixelFormats] = {
     /* Format_Invalid */                Q_NULLPTR, // Not needed
     /* Format_ARGB32 */                 Q_NULLPTR, // Not needed
     /* Format_ARGB32_Premultiplied */   Q_NULLPTR, // Not needed
@@ -1043,85 +1047,569 @@ static VideoFrameConvertFunc qConvertFuncs[QVideoFrame::NPixelFormats] = {
     /* Format_YUYV */                   qt_convert_YUYV_to_ARGB32,
     /* Format_NV12 */                   qt_convert_NV12_to_ARGB32,
     /* Format_NV21 */                   qt_convert_NV21_to_ARGB32,
-    /* Format_IMC1 */                   Q_NULLPTR,
-    /* Format_IMC2 */                   Q_NULLPTR,
-    /* Format_IMC3 */                   Q_NULLPTR,
-    /* Format_IMC4 */                   Q_NULLPTR,
-    /* Format_Y8 */                     Q_NULLPTR,
-    /* Format_Y16 */                    Q_NULLPTR,
+    /* Format_IMC1 */                   qt_convert_YUV420P_to_ARGB32, // Padded chroma lines
+    /* Format_IMC2 */                   qt_convert_IMC2_to_ARGB32,
+    /* Format_IMC3 */                   qt_convert_YV12_to_ARGB32, // Padded chroma lines
+    /* Format_IMC4 */                   qt_convert_IMC4_to_ARGB32,
+    /* Format_Y8 */                     qt_convert_Y8_to_ARGB32,
+    /* Format_Y16 */                    qt_convert_Y16_to_ARGB32,
     /* Format_Jpeg */                   Q_NULLPTR, // Not needed
     /* Format_CameraRaw */              Q_NULLPTR,
     /* Format_AdobeDng */               Q_NULLPTR
 };
 
-static void qInitConvertFuncsAsm()
+/*
+    Overrides the entries of \a funcs and \a accumulate with the kernels of
+    every instruction set up to \a maxLevel which were compiled in and are
+    supported by the CPU, and returns the highest level applied.
+*/
+static QVideoFrameConvertLevel qInitConvertFuncsAsm(VideoFrameConvertFunc *funcs,
+                                                    LineAccumulateFunc *accumulate,
+                                                    QVideoFrameConvertLevel maxLevel)
 {
+    QVideoFrameConvertLevel level = QVideoFrameConvertScalar;
+
 #ifdef QT_COMPILER_SUPPORTS_SSE2
-    extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_sse2(const QVideoFrame&, uchar*);
-    if (qCpuHasFeature(SSE2)){
-        qConvertFuncs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_sse2;
-        qConvertFuncs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_sse2;
-        qConvertFuncs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_sse2;
+    extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_YV12_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_UYVY_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_YUYV_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_NV12_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_NV21_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_IMC2_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_IMC4_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_Y8_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_Y16_to_ARGB32_sse2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_accumulateLine_sse2(const uchar*, quint32*, int);
+    if (maxLevel >= QVideoFrameConvertSSE2 && qCpuHasFeature(SSE2)) {
+        level = QVideoFrameConvertSSE2;
+        funcs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_YUV420P] = qt_convert_YUV420P_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_YV12] = qt_convert_YV12_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_UYVY] = qt_convert_UYVY_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_YUYV] = qt_convert_YUYV_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_NV12] = qt_convert_NV12_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_NV21] = qt_convert_NV21_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_IMC1] = qt_convert_YUV420P_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_IMC2] = qt_convert_IMC2_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_IMC3] = qt_convert_YV12_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_IMC4] = qt_convert_IMC4_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_Y8] = qt_convert_Y8_to_ARGB32_sse2;
+        funcs[QVideoFrame::Format_Y16] = qt_convert_Y16_to_ARGB32_sse2;
+        *accumulate = qt_accumulateLine_sse2;
     }
 #endif
 #ifdef QT_COMPILER_SUPPORTS_SSSE3
-    extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_ssse3(const QVideoFrame&, uchar*);
-    if (qCpuHasFeature(SSSE3)){
-        qConvertFuncs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_ssse3;
-        qConvertFuncs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_ssse3;
-        qConvertFuncs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_ssse3;
+    extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_ssse3(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    if (maxLevel >= QVideoFrameConvertSSSE3 && qCpuHasFeature(SSSE3)) {
+        level = QVideoFrameConvertSSSE3;
+        funcs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_ssse3;
+        funcs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_ssse3;
+        funcs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_ssse3;
     }
 #endif
 #ifdef QT_COMPILER_SUPPORTS_AVX2
-    extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_avx2(const QVideoFrame&, uchar*);
-    if (qCpuHasFeature(AVX2)){
-        qConvertFuncs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_avx2;
-        qConvertFuncs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_avx2;
-        qConvertFuncs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_avx2;
+    extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_YV12_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_UYVY_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_YUYV_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_NV12_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_NV21_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_IMC2_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_IMC4_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_Y8_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_convert_Y16_to_ARGB32_avx2(const QVideoFrame&, uchar*, const QYCbCrCoefficients&);
+    extern void QT_FASTCALL qt_accumulateLine_avx2(const uchar*, quint32*, int);
+    if (maxLevel >= QVideoFrameConvertAVX2 && qCpuHasFeature(AVX2)) {
+        level = QVideoFrameConvertAVX2;
+        funcs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_YUV420P] = qt_convert_YUV420P_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_YV12] = qt_convert_YV12_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_UYVY] = qt_convert_UYVY_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_YUYV] = qt_convert_YUYV_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_NV12] = qt_convert_NV12_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_NV21] = qt_convert_NV21_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_IMC1] = qt_convert_YUV420P_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_IMC2] = qt_convert_IMC2_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_IMC3] = qt_convert_YV12_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_IMC4] = qt_convert_IMC4_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_Y8] = qt_convert_Y8_to_ARGB32_avx2;
+        funcs[QVideoFrame::Format_Y16] = qt_convert_Y16_to_ARGB32_avx2;
+        *accumulate = qt_accumulateLine_avx2;
     }
 #endif
+    return level;
 }
 
+// The fastest kernels the CPU supports, set up once in whichever thread
+// converts a frame first
+struct QVideoFrameConvertFuncs
+{
+    QVideoFrameConvertFuncs()
+        : accumulateLine(qt_accumulateLine)
+    {
+        memcpy(convert, qScalarConvertFuncs, sizeof(convert));
+        qInitConvertFuncsAsm(convert, &accumulateLine, QVideoFrameConvertAVX2);
+    }
+
+    VideoFrameConvertFunc convert[QVideoFrame::NPixelFormats];
+    LineAccumulateFunc accumulateLine;
+};
+
+Q_GLOBAL_STATIC(QVideoFrameConvertFuncs, qConvertFuncs)
+
 /*!
     \internal
+
+    Returns the function converting frames in pixel \a format to ARGB32 using
+    the kernels of instruction sets up to \a level only, or null if the format
+    can't be converted or \a level is not available on this CPU.
+
+    Conversions normally pick the fastest kernels available; this allows
+    benchmarks and tests to compare the scalar and each SIMD implementation.
 */
-QImage qt_imageFromVideoFrame(const QVideoFrame &f)
+VideoFrameConvertFunc qt_videoFrameConvertFunc(QVideoFrame::PixelFormat format,
+                                               QVideoFrameConvertLevel level)
+{
+    if (format >= QVideoFrame::NPixelFormats)
+        return Q_NULLPTR;
+
+    VideoFrameConvertFunc funcs[QVideoFrame::NPixelFormats];
+    LineAccumulateFunc accumulate = qt_accumulateLine;
+    memcpy(funcs, qScalarConvertFuncs, sizeof(funcs));
+    if (qInitConvertFuncsAsm(funcs, &accumulate, level) != level)
+        return Q_NULLPTR;
+
+    return funcs[format];
+}
+
+static VideoFrameConvertFunc qConvertFunc(QVideoFrame::PixelFormat format)
+{
+    if (format >= QVideoFrame::NPixelFormats)
+        return Q_NULLPTR;
+
+    // Null after the kernels were destroyed on exit
+    const QVideoFrameConvertFuncs *funcs = qConvertFuncs();
+    return funcs ? funcs->convert[format] : qScalarConvertFuncs[format];
+}
+
+/*!
+    \internal
+*/
+QImage qt_imageFromVideoFrame(const QVideoFrame &frame)
+{
+    return qt_imageFromVideoFrame(frame, qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_Undefined));
+}
+
+/*!
+    \internal
+
+    Returns the contents of \a frame as an image, converting YUV formats to RGB
+    with \a coefficients.
+*/
+QImage qt_imageFromVideoFrame(const QVideoFrame &frame, const QYCbCrCoefficients &coefficients)
 {
-    QVideoFrame &frame = const_cast<QVideoFrame&>(f);
     QImage result;
+    if (!qt_imageFromVideoFrame(frame, &result, coefficients))
+        return QImage();
+    return result;
+}
 
-    if (!frame.isValid() || !frame.map(QAbstractVideoBuffer::ReadOnly))
-        return result;
+/*
+    Returns the image format sharing the memory layout of frames in pixel
+    \a format. Unlike QVideoFrame::imageFormatFromPixelFormat() this maps Y8 to
+    Grayscale8, so that grey frames are copied or viewed instead of being
+    expanded to ARGB32.
+*/
+static QImage::Format qDirectImageFormat(QVideoFrame::PixelFormat format)
+{
+    if (format == QVideoFrame::Format_Y8)
+        return QImage::Format_Grayscale8;
+    return QVideoFrame::imageFormatFromPixelFormat(format);
+}
+
+/*!
+    \internal
+
+    Returns the format of the images qt_imageFromVideoFrame() produces for
+    frames in pixel \a format, or QImage::Format_Invalid if they can't be
+    converted without decoding.
+*/
+QImage::Format qt_convertedImageFormat(QVideoFrame::PixelFormat format)
+{
+    const QImage::Format imageFormat = qDirectImageFormat(format);
+    if (imageFormat != QImage::Format_Invalid)
+        return imageFormat;
+
+    return qConvertFunc(format) ? QImage::Format_ARGB32 : QImage::Format_Invalid;
+}
 
-    // Formats supported by QImage don't need conversion
-    QImage::Format imageFormat = QVideoFrame::imageFormatFromPixelFormat(frame.pixelFormat());
-    if (imageFormat != QImage::Format_Invalid) {
-        result = QImage(frame.bits(), frame.width(), frame.height(), imageFormat).copy();
+/*!
+    \internal
+*/
+bool qt_imageFromVideoFrame(const QVideoFrame &frame, uchar *output, int bytesPerLine)
+{
+    return qt_imageFromVideoFrame(frame, output, bytesPerLine,
+                                  qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_Undefined));
+}
+
+/*!
+    \internal
+
+    Writes the contents of \a f to \a output, which must hold height() lines
+    of \a bytesPerLine bytes in the format qt_convertedImageFormat()
+    returns. Formats that need conversion are written as tightly packed
+    ARGB32 lines, so \a bytesPerLine must then be width() * 4.
+
+    Returns false if the frame can't be mapped or converted.
+*/
+bool qt_imageFromVideoFrame(const QVideoFrame &f, uchar *output, int bytesPerLine,
+                            const QYCbCrCoefficients &coefficients)
+{
+    QVideoFrame &frame = const_cast<QVideoFrame&>(f);
+
+    if (!frame.isValid())
+        return false;
+
+    const QImage::Format imageFormat = qDirectImageFormat(frame.pixelFormat());
+    VideoFrameConvertFunc convert = Q_NULLPTR;
+    if (imageFormat == QImage::Format_Invalid) {
+        convert = qConvertFunc(frame.pixelFormat());
+        if (!convert) {
+            qWarning() << Q_FUNC_INFO << ": unsupported pixel format" << frame.pixelFormat();
+            return false;
+        }
+        if (bytesPerLine != frame.width() * 4) {
+            qWarning() << Q_FUNC_INFO << ": unsupported output stride" << bytesPerLine
+                       << "for" << frame.width() << "ARGB32 pixels";
+            return false;
+        }
     }
 
+    if (!frame.map(QAbstractVideoBuffer::ReadOnly))
+        return false;
+
+    if (convert) {
+        qt_runConvertFunc(convert, frame, output, bytesPerLine, coefficients);
+    } else {
+        // Formats supported by QImage only need their lines copied
+        const int lineBytes = (frame.width() * QImage::toPixelFormat(imageFormat).bitsPerPixel() + 7) / 8;
+        const int height = frame.height();
+        const uchar *src = frame.bits();
+        const int stride = frame.bytesPerLine();
+
+        if (stride == bytesPerLine) {
+            memcpy(output, src, stride * (height - 1) + lineBytes);
+        } else {
+            for (int y = 0; y < height; ++y)
+                memcpy(output + y * bytesPerLine, src + y * stride, lineBytes);
+        }
+    }
+
+    frame.unmap();
+
+    return true;
+}
+
+/*!
+    \internal
+*/
+bool qt_imageFromVideoFrame(const QVideoFrame &frame, QImage *image)
+{
+    return qt_imageFromVideoFrame(frame, image,
+                                  qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_Undefined));
+}
+
+/*!
+    \internal
+
+    Converts the contents of \a f into \a image. The storage of \a image is
+    reused when its size and format already match and it isn't shared, so
+    converting a stream of frames into the same image doesn't allocate.
+
+    Returns false if the frame can't be mapped or converted.
+*/
+bool qt_imageFromVideoFrame(const QVideoFrame &f, QImage *image,
+                            const QYCbCrCoefficients &coefficients)
+{
+    QVideoFrame &frame = const_cast<QVideoFrame&>(f);
+
+    if (!frame.isValid())
+        return false;
+
     // Load from JPG
-    else if (frame.pixelFormat() == QVideoFrame::Format_Jpeg) {
-        result.loadFromData(frame.bits(), frame.mappedBytes(), "JPG");
+    if (frame.pixelFormat() == QVideoFrame::Format_Jpeg) {
+        if (!frame.map(QAbstractVideoBuffer::ReadOnly))
+            return false;
+        const bool loaded = image->loadFromData(frame.bits(), frame.mappedBytes(), "JPG");
+        frame.unmap();
+        return loaded;
+    }
+
+    const QImage::Format imageFormat = qt_convertedImageFormat(frame.pixelFormat());
+    if (imageFormat == QImage::Format_Invalid) {
+        qWarning() << Q_FUNC_INFO << ": unsupported pixel format" << frame.pixelFormat();
+        return false;
+    }
+
+    if (image->size() != frame.size() || image->format() != imageFormat || !image->isDetached()) {
+        *image = QImage(frame.size(), imageFormat);
+        if (image->isNull())
+            return false;
+    }
+
+    return qt_imageFromVideoFrame(frame, image->bits(), image->bytesPerLine(), coefficients);
+}
+
+static void qt_cleanupVideoFrameView(void *info)
+{
+    QVideoFrame *frame = static_cast<QVideoFrame *>(info);
+    frame->unmap();
+    delete frame;
+}
+
+/*!
+    \internal
+
+    Returns an image sharing the memory of \a frame, for pixel formats QImage
+    supports natively, or a null image for any other format. The frame stays
+    mapped read only for as long as the image, or a copy of it, exists.
+    Writing to the image detaches it from the frame.
+*/
+QImage qt_imageViewFromVideoFrame(const QVideoFrame &frame)
+{
+    const QImage::Format imageFormat = qDirectImageFormat(frame.pixelFormat());
+    if (imageFormat == QImage::Format_Invalid || frame.width() <= 0 || frame.height() <= 0)
+        return QImage();
+
+    QVideoFrame *mapped = new QVideoFrame(frame);
+    if (!mapped->map(QAbstractVideoBuffer::ReadOnly)) {
+        delete mapped;
+        return QImage();
+    }
+
+    return QImage(static_cast<const uchar *>(mapped->bits()), mapped->width(), mapped->height(),
+                  mapped->bytesPerLine(), imageFormat, qt_cleanupVideoFrameView, mapped);
+}
+
+/*!
+    \internal
+*/
+QImage qt_scaledImageFromVideoFrame(const QVideoFrame &frame, const QSize &size, Qt::AspectRatioMode mode)
+{
+    return qt_scaledImageFromVideoFrame(frame, size, mode,
+                                        qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_Undefined));
+}
+
+/*!
+    \internal
+
+    Returns the contents of \a f as an ARGB32 image scaled to \a size according
+    to \a mode, converting YUV formats to RGB with \a coefficients.
+
+    Downscaling YUV frames is done in a single pass: the Y, U and V samples are
+    box filtered to the target size before the color conversion, so the full
+    resolution image is never produced. Other formats, and upscaling, fall back
+    to smoothly scaling the result of qt_imageFromVideoFrame().
+*/
+QImage qt_scaledImageFromVideoFrame(const QVideoFrame &f, const QSize &size, Qt::AspectRatioMode mode,
+                                    const QYCbCrCoefficients &coefficients)
+{
+    QVideoFrame &frame = const_cast<QVideoFrame&>(f);
+
+    if (!frame.isValid() || size.isEmpty())
+        return QImage();
+
+    const QSize targetSize = frame.size().scaled(size, mode);
+    if (targetSize == frame.size())
+        return qt_imageFromVideoFrame(frame, coefficients);
+
+    if (targetSize.width() <= frame.width() && targetSize.height() <= frame.height()
+            && frame.map(QAbstractVideoBuffer::ReadOnly)) {
+        QImage result(targetSize, QImage::Format_ARGB32);
+        const QVideoFrameConvertFuncs *funcs = qConvertFuncs();
+        const bool scaled = qt_scaleYUVFrameToARGB32(frame, targetSize,
+                                                     funcs ? funcs->accumulateLine : qt_accumulateLine,
+                                                     result.bits(), result.bytesPerLine(),
+                                                     coefficients);
+        frame.unmap();
+        if (scaled)
+            return result;
     }
 
-    // Need conversion
-    else {
-        static bool initAsmFuncsDone = false;
-        if (!initAsmFuncsDone) {
-            qInitConvertFuncsAsm();
-            initAsmFuncsDone = true;
+    return qt_imageFromVideoFrame(frame, coefficients).scaled(targetSize, Qt::IgnoreAspectRatio,
+                                                              Qt::SmoothTransformation);
+}
+
+/*
+    Returns the number of bytes a tightly packed frame of \a format and \a size
+    needs in a single buffer, with each line padded to four bytes, and stores
+    the stride of its first plane in \a bytesPerLine. Returns 0 for formats
+    without a known memory layout and subsampled formats of odd size.
+*/
+int qt_videoFrameBytes(QVideoFrame::PixelFormat format, const QSize &size, int *bytesPerLine)
+{
+    const int width = size.width();
+    const int height = size.height();
+    const bool evenSize = !(width & 1) && !(height & 1);
+    int pixelBytes = 0;
+
+    switch (format) {
+    case QVideoFrame::Format_ARGB32:
+    case QVideoFrame::Format_ARGB32_Premultiplied:
+    case QVideoFrame::Format_RGB32:
+    case QVideoFrame::Format_BGRA32:
+    case QVideoFrame::Format_BGRA32_Premultiplied:
+    case QVideoFrame::Format_BGR32:
+    case QVideoFrame::Format_AYUV444:
+    case QVideoFrame::Format_AYUV444_Premultiplied:
+        pixelBytes = 4;
+        break;
+    case QVideoFrame::Format_RGB24:
+    case QVideoFrame::Format_BGR24:
+    case QVideoFrame::Format_YUV444:
+        pixelBytes = 3;
+        break;
+    case QVideoFrame::Format_RGB565:
+    case QVideoFrame::Format_RGB555:
+    case QVideoFrame::Format_BGR565:
+    case QVideoFrame::Format_BGR555:
+    case QVideoFrame::Format_Y16:
+        pixelBytes = 2;
+        break;
+    case QVideoFrame::Format_Y8:
+        pixelBytes = 1;
+        break;
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV:
+        if (width & 1)
+            return 0;
+        pixelBytes = 2;
+        break;
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+        if (!evenSize)
+            return 0;
+        // map() derives the chroma stride from the total size
+        *bytesPerLine = (width + 3) & ~3;
+        return *bytesPerLine * height + (*bytesPerLine / 2) * height;
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_IMC2:
+    case QVideoFrame::Format_IMC4:
+        if (!evenSize)
+            return 0;
+        *bytesPerLine = (width + 3) & ~3;
+        return *bytesPerLine * height * 3 / 2;
+    case QVideoFrame::Format_IMC1:
+    case QVideoFrame::Format_IMC3:
+        if (!evenSize)
+            return 0;
+        // both chroma planes have the stride of the luma plane
+        *bytesPerLine = (width + 3) & ~3;
+        return *bytesPerLine * height * 2;
+    default:
+        return 0;
+    }
+
+    *bytesPerLine = (width * pixelBytes + 3) & ~3;
+    return *bytesPerLine * height;
+}
+
+/*!
+    \internal
+*/
+QVideoFrame qt_convertVideoFrame(const QVideoFrame &frame, QVideoFrame::PixelFormat format)
+{
+    return qt_convertVideoFrame(frame, format,
+                                qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_Undefined));
+}
+
+/*!
+    \internal
+
+    Returns a new frame with the contents of \a f converted to \a format.
+    YUV to RGB conversions use \a coefficients.
+
+    Conversions from the YUV 4:2:0 and 4:2:2 layouts to each other and to the
+    packed RGB formats are done directly, without an intermediate ARGB32 image.
+    Subsampled target formats require even frame dimensions. An invalid frame
+    is returned if the conversion is not supported.
+*/
+QVideoFrame qt_convertVideoFrame(const QVideoFrame &f, QVideoFrame::PixelFormat format,
+                                 const QYCbCrCoefficients &coefficients)
+{
+    QVideoFrame &frame = const_cast<QVideoFrame&>(f);
+
+    if (!frame.isValid())
+        return QVideoFrame();
+
+    if (frame.pixelFormat() == format)
+        return frame;
+
+    int bytesPerLine = 0;
+    const int bytes = qt_videoFrameBytes(format, frame.size(), &bytesPerLine);
+    if (bytes <= 0) {
+        qWarning() << Q_FUNC_INFO << ": unsupported target pixel format" << format << frame.size();
+        return QVideoFrame();
+    }
+
+    if (!frame.map(QAbstractVideoBuffer::ReadOnly))
+        return QVideoFrame();
+
+    QVideoFrame result;
+    const QImage::Format imageFormat = qDirectImageFormat(frame.pixelFormat());
+    const QImage::Format targetImageFormat = QVideoFrame::imageFormatFromPixelFormat(format);
+
+    if (imageFormat != QImage::Format_Invalid && targetImageFormat != QImage::Format_Invalid) {
+        // Both formats are known to QImage, let it convert straight into the new frame
+        const QImage source(frame.bits(), frame.width(), frame.height(),
+                            frame.bytesPerLine(), imageFormat);
+        result = QVideoFrame(source.convertToFormat(targetImageFormat));
+    } else {
+        result = QVideoFrame(bytes, frame.size(), bytesPerLine, format);
+        bool converted = false;
+
+        if (result.map(QAbstractVideoBuffer::WriteOnly)) {
+            const QVideoFrame::PixelFormat pf = frame.pixelFormat();
+            const bool opaque = pf != QVideoFrame::Format_BGRA32
+                    && pf != QVideoFrame::Format_BGRA32_Premultiplied
+                    && pf != QVideoFrame::Format_AYUV444;
+            VideoFrameConvertFunc convert = qConvertFunc(pf);
+
+            // The ARGB32 converters are vectorized, prefer them whenever their output fits
+            if (convert && (format == QVideoFrame::Format_ARGB32
+                            || (opaque && (format == QVideoFrame::Format_RGB32
+                                           || format == QVideoFrame::Format_ARGB32_Premultiplied)))) {
+                qt_runConvertFunc(convert, frame, result.bits(), bytesPerLine, coefficients);
+                converted = true;
+            } else {
+                converted = qt_convertYUVFrame(frame, result, coefficients);
+            }
+            result.unmap();
         }
-        VideoFrameConvertFunc convert = qConvertFuncs[frame.pixelFormat()];
-        if (!convert) {
-            qWarning() << Q_FUNC_INFO << ": unsupported pixel format" << frame.pixelFormat();
-        } else {
-            result = QImage(frame.width(), frame.height(), QImage::Format_ARGB32);
-            convert(frame, result.bits());
+
+        if (!converted) {
+            qWarning() << Q_FUNC_INFO << ": unsupported conversion from" << frame.pixelFormat()
+                       << "to" << format;
+            result = QVideoFrame();
         }
     }
 
     frame.unmap();
 
+    if (result.isValid()) {
+        result.setStartTime(frame.startTime());
+        result.setEndTime(frame.endTime());
+        result.setFieldType(frame.fieldType());
+    }
+
     return result;
 }
 
@@ -49,7 +49,29 @@
 
 QT_BEGIN_NAMESPACE
 
+struct QYCbCrCoefficients;
+
 Q_MULTIMEDIA_EXPORT QImage qt_imageFromVideoFrame(const QVideoFrame &frame);
+Q_MULTIMEDIA_EXPORT QImage qt_imageFromVideoFrame(const QVideoFrame &frame,
+                                                  const QYCbCrCoefficients &coefficients);
+Q_MULTIMEDIA_EXPORT bool qt_imageFromVideoFrame(const QVideoFrame &frame, QImage *image);
+Q_MULTIMEDIA_EXPORT bool qt_imageFromVideoFrame(const QVideoFrame &frame, QImage *image,
+                                                const QYCbCrCoefficients &coefficients);
+Q_MULTIMEDIA_EXPORT bool qt_imageFromVideoFrame(const QVideoFrame &frame, uchar *output, int bytesPerLine);
+Q_MULTIMEDIA_EXPORT bool qt_imageFromVideoFrame(const QVideoFrame &frame, uchar *output, int bytesPerLine,
+                                                const QYCbCrCoefficients &coefficients);
+Q_MULTIMEDIA_EXPORT QImage::Format qt_convertedImageFormat(QVideoFrame::PixelFormat format);
+Q_MULTIMEDIA_EXPORT QImage qt_imageViewFromVideoFrame(const QVideoFrame &frame);
+Q_MULTIMEDIA_EXPORT QImage qt_scaledImageFromVideoFrame(const QVideoFrame &frame, const QSize &size,
+                                                        Qt::AspectRatioMode mode = Qt::IgnoreAspectRatio);
+Q_MULTIMEDIA_EXPORT QImage qt_scaledImageFromVideoFrame(const QVideoFrame &frame, const QSize &size,
+                                                        Qt::AspectRatioMode mode,
+                                                        const QYCbCrCoefficients &coefficients);
+Q_MULTIMEDIA_EXPORT QVideoFrame qt_convertVideoFrame(const QVideoFrame &frame, QVideoFrame::PixelFormat format);
+Q_MULTIMEDIA_EXPORT QVideoFrame qt_convertVideoFrame(const QVideoFrame &frame, QVideoFrame::PixelFormat format,
+                                                     const QYCbCrCoefficients &coefficients);
+
+int qt_videoFrameBytes(QVideoFrame::PixelFormat format, const QSize &size, int *bytesPerLine);
 
 QT_END_NAMESPACE
 
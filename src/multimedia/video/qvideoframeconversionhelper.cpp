@@ -33,30 +33,68 @@
 
 #include "qvideoframeconversionhelper_p.h"
 
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qvarlengtharray.h>
+
 QT_BEGIN_NAMESPACE
 
-#define CLAMP(n) (n > 255 ? 255 : (n < 0 ? 0 : n))
+/*
+    Derived from Kr and Kb of each matrix, scaled by 255/219 (luma) and
+    255/224 (chroma) for limited range, then rounded to 1/256 steps. The BT.601
+    limited range entry reproduces the coefficients used before color spaces
+    were taken into account.
+*/
+static const QYCbCrCoefficients qt_yCbCrCoefficientTable[][2] = {
+    // BT.601: Kr = 0.299, Kb = 0.114
+    { { 16, 298, 409, 100, 208, 516 }, { 0, 256, 359, 88, 183, 454 } },
+    // BT.709: Kr = 0.2126, Kb = 0.0722
+    { { 16, 298, 459, 55, 136, 541 }, { 0, 256, 403, 48, 120, 475 } },
+    // BT.2020: Kr = 0.2627, Kb = 0.0593
+    { { 16, 298, 430, 48, 167, 548 }, { 0, 256, 377, 42, 146, 482 } }
+};
+
+/*!
+    \internal
+
+    Returns the fixed-point coefficients converting Y'CbCr samples encoded
+    with \a matrix and \a range to R'G'B'.
+*/
+const QYCbCrCoefficients &qt_yCbCrCoefficients(QYCbCrCoefficients::Matrix matrix,
+                                               QYCbCrCoefficients::Range range)
+{
+    return qt_yCbCrCoefficientTable[matrix][range];
+}
 
-#define EXPAND_UV(u, v) \
-    int uu = u - 128; \
-    int vv = v - 128; \
-    int rv = 409 * vv + 128; \
-    int guv = 100 * uu + 208 * vv + 128; \
-    int bu = 516 * uu + 128; \
+/*!
+    \internal
 
-static inline quint32 qYUVToARGB32(int y, int rv, int guv, int bu, int a = 0xff)
+    Returns the fixed-point coefficients for frames in \a colorSpace.
+    Undefined and custom color spaces are treated as BT.601, the xvYCC
+    variants share the coefficients of their base matrix.
+*/
+const QYCbCrCoefficients &qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCrColorSpace colorSpace)
 {
-    int yy = (y - 16) * 298;
-    return (a << 24)
-            | CLAMP((yy + rv) >> 8) << 16
-            | CLAMP((yy - guv) >> 8) << 8
-            | CLAMP((yy + bu) >> 8);
+    switch (colorSpace) {
+    case QVideoSurfaceFormat::YCbCr_BT709:
+    case QVideoSurfaceFormat::YCbCr_xvYCC709:
+        return qt_yCbCrCoefficients(QYCbCrCoefficients::BT709, QYCbCrCoefficients::LimitedRange);
+    case QVideoSurfaceFormat::YCbCr_JPEG:
+        return qt_yCbCrCoefficients(QYCbCrCoefficients::BT601, QYCbCrCoefficients::FullRange);
+    case QVideoSurfaceFormat::YCbCr_Undefined:
+    case QVideoSurfaceFormat::YCbCr_BT601:
+    case QVideoSurfaceFormat::YCbCr_xvYCC601:
+    default:
+        return qt_yCbCrCoefficients(QYCbCrCoefficients::BT601, QYCbCrCoefficients::LimitedRange);
+    }
 }
 
 static inline void planarYUV420_to_ARGB32(const uchar *y, int yStride,
                                           const uchar *u, int uStride,
                                           const uchar *v, int vStride,
                                           int uvPixelStride,
+                                          const QYCbCrCoefficients &coefficients,
                                           quint32 *rgb,
                                           int width, int height)
 {
@@ -70,14 +108,14 @@ static inline void planarYUV420_to_ARGB32(const uchar *y, int yStride,
         const uchar *lineV = v;
 
         for (int i = 0; i < width; i += 2) {
-            EXPAND_UV(*lineU, *lineV);
+            EXPAND_UV(coefficients, *lineU, *lineV);
             lineU += uvPixelStride;
             lineV += uvPixelStride;
 
-            *rgb0++ = qYUVToARGB32(*lineY0++, rv, guv, bu);
-            *rgb0++ = qYUVToARGB32(*lineY0++, rv, guv, bu);
-            *rgb1++ = qYUVToARGB32(*lineY1++, rv, guv, bu);
-            *rgb1++ = qYUVToARGB32(*lineY1++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
         }
 
         y += yStride << 1; // stride * 2
@@ -90,29 +128,32 @@ static inline void planarYUV420_to_ARGB32(const uchar *y, int yStride,
 
 
 
-void QT_FASTCALL qt_convert_YUV420P_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_YUV420P_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                              const QYCbCrCoefficients &coefficients)
 {
     FETCH_INFO_TRIPLANAR(frame)
     planarYUV420_to_ARGB32(plane1, plane1Stride,
                            plane2, plane2Stride,
                            plane3, plane3Stride,
-                           1,
+                           1, coefficients,
                            reinterpret_cast<quint32*>(output),
                            width, height);
 }
 
-void QT_FASTCALL qt_convert_YV12_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_YV12_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                           const QYCbCrCoefficients &coefficients)
 {
     FETCH_INFO_TRIPLANAR(frame)
     planarYUV420_to_ARGB32(plane1, plane1Stride,
                            plane3, plane3Stride,
                            plane2, plane2Stride,
-                           1,
+                           1, coefficients,
                            reinterpret_cast<quint32*>(output),
                            width, height);
 }
 
-void QT_FASTCALL qt_convert_AYUV444_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_AYUV444_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                              const QYCbCrCoefficients &coefficients)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 4)
@@ -128,16 +169,17 @@ void QT_FASTCALL qt_convert_AYUV444_to_ARGB32(const QVideoFrame &frame, uchar *o
             int u = *lineSrc++;
             int v = *lineSrc++;
 
-            EXPAND_UV(u, v);
+            EXPAND_UV(coefficients, u, v);
 
-            *rgb++ = qYUVToARGB32(y, rv, guv, bu, a);
+            *rgb++ = qYUVToARGB32(coefficients, y, rv, guv, bu, a);
         }
 
         src += stride;
     }
 }
 
-void QT_FASTCALL qt_convert_YUV444_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_YUV444_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                             const QYCbCrCoefficients &coefficients)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 3)
@@ -152,16 +194,17 @@ void QT_FASTCALL qt_convert_YUV444_to_ARGB32(const QVideoFrame &frame, uchar *ou
             int u = *lineSrc++;
             int v = *lineSrc++;
 
-            EXPAND_UV(u, v);
+            EXPAND_UV(coefficients, u, v);
 
-            *rgb++ = qYUVToARGB32(y, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(coefficients, y, rv, guv, bu);
         }
 
         src += stride;
     }
 }
 
-void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                           const QYCbCrCoefficients &coefficients)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 2)
@@ -177,17 +220,18 @@ void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame &frame, uchar *outp
             int v = *lineSrc++;
             int y1 = *lineSrc++;
 
-            EXPAND_UV(u, v);
+            EXPAND_UV(coefficients, u, v);
 
-            *rgb++ = qYUVToARGB32(y0, rv, guv, bu);
-            *rgb++ = qYUVToARGB32(y1, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(coefficients, y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(coefficients, y1, rv, guv, bu);
         }
 
         src += stride;
     }
 }
 
-void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                           const QYCbCrCoefficients &coefficients)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 2)
@@ -203,39 +247,106 @@ void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame &frame, uchar *outp
             int y1 = *lineSrc++;
             int v = *lineSrc++;
 
-            EXPAND_UV(u, v);
+            EXPAND_UV(coefficients, u, v);
 
-            *rgb++ = qYUVToARGB32(y0, rv, guv, bu);
-            *rgb++ = qYUVToARGB32(y1, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(coefficients, y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(coefficients, y1, rv, guv, bu);
         }
 
         src += stride;
     }
 }
 
-void QT_FASTCALL qt_convert_NV12_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_NV12_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                           const QYCbCrCoefficients &coefficients)
 {
     FETCH_INFO_BIPLANAR(frame)
     planarYUV420_to_ARGB32(plane1, plane1Stride,
                            plane2, plane2Stride,
                            plane2 + 1, plane2Stride,
-                           2,
+                           2, coefficients,
                            reinterpret_cast<quint32*>(output),
                            width, height);
 }
 
-void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                           const QYCbCrCoefficients &coefficients)
 {
     FETCH_INFO_BIPLANAR(frame)
     planarYUV420_to_ARGB32(plane1, plane1Stride,
                            plane2 + 1, plane2Stride,
                            plane2, plane2Stride,
-                           2,
+                           2, coefficients,
+                           reinterpret_cast<quint32*>(output),
+                           width, height);
+}
+
+void QT_FASTCALL qt_convert_IMC2_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                           const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    // Each chroma line holds a line of U followed by a line of V half a stride further
+    planarYUV420_to_ARGB32(plane1, plane1Stride,
+                           plane2, plane2Stride,
+                           plane2 + plane2Stride / 2, plane2Stride,
+                           1, coefficients,
+                           reinterpret_cast<quint32*>(output),
+                           width, height);
+}
+
+void QT_FASTCALL qt_convert_IMC4_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                           const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32(plane1, plane1Stride,
+                           plane2 + plane2Stride / 2, plane2Stride,
+                           plane2, plane2Stride,
+                           1, coefficients,
                            reinterpret_cast<quint32*>(output),
                            width, height);
 }
 
-void QT_FASTCALL qt_convert_BGRA32_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_Y8_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                         const QYCbCrCoefficients &)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 1)
+
+    quint32 *argb = reinterpret_cast<quint32*>(output);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *grey = src;
+
+        for (int x = 0; x < width; ++x)
+            *argb++ = qConvertY8ToARGB32(*grey++);
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_Y16_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                          const QYCbCrCoefficients &)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+
+    quint32 *argb = reinterpret_cast<quint32*>(output);
+
+    for (int y = 0; y < height; ++y) {
+        // the most significant byte of each little endian sample
+        const uchar *grey = src + 1;
+
+        for (int x = 0; x < width; ++x) {
+            *argb++ = qConvertY8ToARGB32(*grey);
+            grey += 2;
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_BGRA32_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                             const QYCbCrCoefficients &)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 4)
@@ -261,7 +372,8 @@ void QT_FASTCALL qt_convert_BGRA32_to_ARGB32(const QVideoFrame &frame, uchar *ou
     }
 }
 
-void QT_FASTCALL qt_convert_BGR24_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_BGR24_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                            const QYCbCrCoefficients &)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 3)
@@ -293,7 +405,8 @@ void QT_FASTCALL qt_convert_BGR24_to_ARGB32(const QVideoFrame &frame, uchar *out
     }
 }
 
-void QT_FASTCALL qt_convert_BGR565_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_BGR565_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                             const QYCbCrCoefficients &)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 2)
@@ -319,7 +432,8 @@ void QT_FASTCALL qt_convert_BGR565_to_ARGB32(const QVideoFrame &frame, uchar *ou
     }
 }
 
-void QT_FASTCALL qt_convert_BGR555_to_ARGB32(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_BGR555_to_ARGB32(const QVideoFrame &frame, uchar *output,
+                                             const QYCbCrCoefficients &)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 2)
@@ -345,4 +459,517 @@ void QT_FASTCALL qt_convert_BGR555_to_ARGB32(const QVideoFrame &frame, uchar *ou
     }
 }
 
+// Frames with at least this many pixels are converted on several threads
+static const int qt_parallelConversionThreshold = 1280 * 720;
+// Smallest band worth handing to another thread
+static const int qt_minimumLinesPerBand = 64;
+
+static bool isVerticallySubsampled(QVideoFrame::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_IMC1:
+    case QVideoFrame::Format_IMC2:
+    case QVideoFrame::Format_IMC3:
+    case QVideoFrame::Format_IMC4:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+    Exposes a horizontal band of an already mapped frame as a frame of its own,
+    so that the existing conversion functions can run on it unchanged.
+*/
+class QVideoFrameBandBuffer : public QAbstractPlanarVideoBuffer
+{
+public:
+    QVideoFrameBandBuffer(const QVideoFrame &frame, int firstLine)
+        : QAbstractPlanarVideoBuffer(NoHandle)
+        , m_planeCount(frame.planeCount())
+        , m_mapMode(NotMapped)
+    {
+        const bool subsampled = isVerticallySubsampled(frame.pixelFormat());
+        for (int i = 0; i < m_planeCount; ++i) {
+            const int line = (i > 0 && subsampled) ? firstLine / 2 : firstLine;
+            m_bytesPerLine[i] = frame.bytesPerLine(i);
+            m_data[i] = const_cast<uchar *>(frame.bits(i)) + line * m_bytesPerLine[i];
+        }
+    }
+
+    MapMode mapMode() const { return m_mapMode; }
+
+    int map(MapMode mode, int *numBytes, int bytesPerLine[4], uchar *data[4])
+    {
+        m_mapMode = mode;
+        if (numBytes)
+            *numBytes = 0;
+        for (int i = 0; i < m_planeCount; ++i) {
+            bytesPerLine[i] = m_bytesPerLine[i];
+            data[i] = m_data[i];
+        }
+        return m_planeCount;
+    }
+
+    void unmap() { m_mapMode = NotMapped; }
+
+private:
+    uchar *m_data[4];
+    int m_bytesPerLine[4];
+    int m_planeCount;
+    MapMode m_mapMode;
+};
+
+class QVideoFrameBandConverter : public QRunnable
+{
+public:
+    QVideoFrameBandConverter(VideoFrameConvertFunc convert, const QVideoFrame &frame,
+                             int firstLine, int lineCount, uchar *output,
+                             const QYCbCrCoefficients &coefficients, QSemaphore *done)
+        : m_convert(convert)
+        , m_band(new QVideoFrameBandBuffer(frame, firstLine),
+                 QSize(frame.width(), lineCount), frame.pixelFormat())
+        , m_output(output)
+        , m_coefficients(coefficients)
+        , m_done(done)
+    {
+    }
+
+    void run()
+    {
+        if (m_band.map(QAbstractVideoBuffer::ReadOnly)) {
+            m_convert(m_band, m_output, m_coefficients);
+            m_band.unmap();
+        }
+        m_done->release();
+    }
+
+private:
+    VideoFrameConvertFunc m_convert;
+    QVideoFrame m_band;
+    uchar *m_output;
+    const QYCbCrCoefficients m_coefficients;
+    QSemaphore *m_done;
+};
+
+/*
+    Runs \a convert over the mapped \a frame, splitting large frames into
+    horizontal bands that are converted in parallel on the global thread pool.
+    Bands always start on an even line, so 4:2:0 chroma rows are never shared.
+*/
+void qt_runConvertFunc(VideoFrameConvertFunc convert, const QVideoFrame &frame,
+                       uchar *output, int outputBytesPerLine,
+                       const QYCbCrCoefficients &coefficients)
+{
+    const int height = frame.height();
+    QThreadPool *pool = QThreadPool::globalInstance();
+
+    int bandCount = 1;
+    if (frame.width() * height >= qt_parallelConversionThreshold)
+        bandCount = qMin(pool->maxThreadCount(), height / qt_minimumLinesPerBand);
+
+    if (bandCount <= 1) {
+        convert(frame, output, coefficients);
+        return;
+    }
+
+    const int linesPerBand = (((height + bandCount - 1) / bandCount) + 1) & ~1;
+
+    QSemaphore done;
+    int pending = 0;
+    for (int firstLine = linesPerBand; firstLine < height; firstLine += linesPerBand) {
+        QVideoFrameBandConverter *band = new QVideoFrameBandConverter(
+                    convert, frame, firstLine, qMin(linesPerBand, height - firstLine),
+                    output + firstLine * outputBytesPerLine, coefficients, &done);
+        ++pending;
+        // Never wait for a busy pool, the calling thread may be one of its workers
+        if (!pool->tryStart(band)) {
+            band->run();
+            delete band;
+        }
+    }
+
+    // The calling thread takes care of the first band
+    QVideoFrameBandConverter(convert, frame, 0, linesPerBand, output, coefficients, &done).run();
+    done.acquire(pending + 1);
+}
+
+namespace {
+
+// One line of a YUV frame whose chroma is shared by two horizontally adjacent pixels
+struct QYUVLine
+{
+    uchar *y;
+    uchar *u;
+    uchar *v;
+    int yStep;  // distance between two luma samples
+    int uvStep; // distance between two chroma samples of the same plane
+};
+
+struct StoreBGRA32 {
+    static inline void store(uchar *&out, quint32 argb)
+    {
+        *reinterpret_cast<quint32*>(out) = qConvertBGRA32ToARGB32(argb);
+        out += 4;
+    }
+};
+
+struct StoreRGB24 {
+    static inline void store(uchar *&out, quint32 argb)
+    {
+        out[0] = argb >> 16;
+        out[1] = argb >> 8;
+        out[2] = argb;
+        out += 3;
+    }
+};
+
+struct StoreBGR24 {
+    static inline void store(uchar *&out, quint32 argb)
+    {
+        out[0] = argb;
+        out[1] = argb >> 8;
+        out[2] = argb >> 16;
+        out += 3;
+    }
+};
+
+struct StoreRGB565 {
+    static inline void store(uchar *&out, quint32 argb)
+    {
+        *reinterpret_cast<quint16*>(out) = ((argb >> 8) & 0xf800) | ((argb >> 5) & 0x07e0) | ((argb >> 3) & 0x001f);
+        out += 2;
+    }
+};
+
+struct StoreBGR565 {
+    static inline void store(uchar *&out, quint32 argb)
+    {
+        *reinterpret_cast<quint16*>(out) = ((argb << 8) & 0xf800) | ((argb >> 5) & 0x07e0) | ((argb >> 19) & 0x001f);
+        out += 2;
+    }
+};
+
+struct StoreRGB555 {
+    static inline void store(uchar *&out, quint32 argb)
+    {
+        *reinterpret_cast<quint16*>(out) = ((argb >> 9) & 0x7c00) | ((argb >> 6) & 0x03e0) | ((argb >> 3) & 0x001f);
+        out += 2;
+    }
+};
+
+struct StoreBGR555 {
+    static inline void store(uchar *&out, quint32 argb)
+    {
+        *reinterpret_cast<quint16*>(out) = ((argb << 7) & 0x7c00) | ((argb >> 6) & 0x03e0) | ((argb >> 19) & 0x001f);
+        out += 2;
+    }
+};
+
+}
+
+static bool yuvLine(const QVideoFrame &frame, int line, QYUVLine *l)
+{
+    // Frames are mapped with the mode the caller asked for, writing is up to the caller
+    uchar *plane1 = const_cast<uchar *>(frame.bits(0));
+    uchar *plane2 = const_cast<uchar *>(frame.bits(1));
+    uchar *plane3 = const_cast<uchar *>(frame.bits(2));
+
+    switch (frame.pixelFormat()) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12: {
+        const bool yv12 = frame.pixelFormat() == QVideoFrame::Format_YV12;
+        l->y = plane1 + line * frame.bytesPerLine(0);
+        l->u = (yv12 ? plane3 : plane2) + (line / 2) * frame.bytesPerLine(yv12 ? 2 : 1);
+        l->v = (yv12 ? plane2 : plane3) + (line / 2) * frame.bytesPerLine(yv12 ? 1 : 2);
+        l->yStep = 1;
+        l->uvStep = 1;
+        return true;
+    }
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21: {
+        uchar *uv = plane2 + (line / 2) * frame.bytesPerLine(1);
+        const bool nv21 = frame.pixelFormat() == QVideoFrame::Format_NV21;
+        l->y = plane1 + line * frame.bytesPerLine(0);
+        l->u = nv21 ? uv + 1 : uv;
+        l->v = nv21 ? uv : uv + 1;
+        l->yStep = 1;
+        l->uvStep = 2;
+        return true;
+    }
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV: {
+        uchar *src = plane1 + line * frame.bytesPerLine(0);
+        const bool yuyv = frame.pixelFormat() == QVideoFrame::Format_YUYV;
+        l->y = yuyv ? src : src + 1;
+        l->u = yuyv ? src + 1 : src;
+        l->v = yuyv ? src + 3 : src + 2;
+        l->yStep = 2;
+        l->uvStep = 4;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+static void convertYUVToYUV(const QVideoFrame &src, QVideoFrame &dst)
+{
+    const int width = src.width();
+    const int height = src.height();
+    const int chromaWidth = width / 2;
+    const bool srcSubsampled = isVerticallySubsampled(src.pixelFormat());
+    const bool dstSubsampled = isVerticallySubsampled(dst.pixelFormat());
+
+    QYUVLine s, d;
+    for (int j = 0; j < height; ++j) {
+        yuvLine(src, j, &s);
+        yuvLine(dst, j, &d);
+
+        if (s.yStep == 1 && d.yStep == 1) {
+            memcpy(d.y, s.y, width);
+        } else {
+            for (int i = 0; i < width; ++i)
+                d.y[i * d.yStep] = s.y[i * s.yStep];
+        }
+
+        // 4:2:0 destinations get their chroma line from the even source line
+        if (dstSubsampled && (j & 1))
+            continue;
+
+        if (dstSubsampled && !srcSubsampled && j + 1 < height) {
+            // 4:2:2 to 4:2:0, average the two source lines
+            QYUVLine s2;
+            yuvLine(src, j + 1, &s2);
+            for (int i = 0; i < chromaWidth; ++i) {
+                d.u[i * d.uvStep] = (s.u[i * s.uvStep] + s2.u[i * s2.uvStep] + 1) >> 1;
+                d.v[i * d.uvStep] = (s.v[i * s.uvStep] + s2.v[i * s2.uvStep] + 1) >> 1;
+            }
+        } else if (s.uvStep == 1 && d.uvStep == 1) {
+            memcpy(d.u, s.u, chromaWidth);
+            memcpy(d.v, s.v, chromaWidth);
+        } else {
+            for (int i = 0; i < chromaWidth; ++i) {
+                d.u[i * d.uvStep] = s.u[i * s.uvStep];
+                d.v[i * d.uvStep] = s.v[i * s.uvStep];
+            }
+        }
+    }
+}
+
+template <class Store>
+static void convertYUVToRGB(const QVideoFrame &src, QVideoFrame &dst,
+                            const QYCbCrCoefficients &coefficients)
+{
+    const int width = src.width();
+    const int height = src.height();
+    uchar *output = dst.bits();
+    const int outputStride = dst.bytesPerLine();
+
+    QYUVLine s;
+    for (int j = 0; j < height; ++j) {
+        yuvLine(src, j, &s);
+        uchar *out = output + j * outputStride;
+
+        for (int i = 0; i < width; i += 2) {
+            EXPAND_UV(coefficients, s.u[(i / 2) * s.uvStep], s.v[(i / 2) * s.uvStep]);
+
+            Store::store(out, qYUVToARGB32(coefficients, s.y[i * s.yStep], rv, guv, bu));
+            if (i + 1 < width)
+                Store::store(out, qYUVToARGB32(coefficients, s.y[(i + 1) * s.yStep], rv, guv, bu));
+        }
+    }
+}
+
+/*
+    Converts the mapped frame \a src into the mapped frame \a dst of the same
+    size without going through an intermediate ARGB32 image. Only sources with
+    4:2:0 or 4:2:2 chroma are handled; returns false for any other pair.
+*/
+bool qt_convertYUVFrame(const QVideoFrame &src, QVideoFrame &dst,
+                        const QYCbCrCoefficients &coefficients)
+{
+    QYUVLine l;
+    if (!yuvLine(src, 0, &l))
+        return false;
+
+    switch (dst.pixelFormat()) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV:
+        convertYUVToYUV(src, dst);
+        return true;
+    case QVideoFrame::Format_BGRA32:
+    case QVideoFrame::Format_BGRA32_Premultiplied:
+    case QVideoFrame::Format_BGR32:
+        convertYUVToRGB<StoreBGRA32>(src, dst, coefficients);
+        return true;
+    case QVideoFrame::Format_RGB24:
+        convertYUVToRGB<StoreRGB24>(src, dst, coefficients);
+        return true;
+    case QVideoFrame::Format_BGR24:
+        convertYUVToRGB<StoreBGR24>(src, dst, coefficients);
+        return true;
+    case QVideoFrame::Format_RGB565:
+        convertYUVToRGB<StoreRGB565>(src, dst, coefficients);
+        return true;
+    case QVideoFrame::Format_BGR565:
+        convertYUVToRGB<StoreBGR565>(src, dst, coefficients);
+        return true;
+    case QVideoFrame::Format_RGB555:
+        convertYUVToRGB<StoreRGB555>(src, dst, coefficients);
+        return true;
+    case QVideoFrame::Format_BGR555:
+        convertYUVToRGB<StoreBGR555>(src, dst, coefficients);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void QT_FASTCALL qt_accumulateLine(const uchar *line, quint32 *sums, int count)
+{
+    for (int x = 0; x < count; ++x)
+        sums[x] += line[x];
+}
+
+namespace {
+
+// A component whose samples are found every step bytes, starting at offset, in each source line
+struct QScaleComponent
+{
+    int step;
+    int offset;
+    int width;
+    uchar *output;
+};
+
+}
+
+/*
+    Box filters the components that share the source lines of \a src down to
+    outputWidth x outputHeight samples each. Lines are summed once into
+    column totals, which are then averaged per component.
+*/
+static void boxScaleLines(const uchar *src, int stride, int lineBytes, int height,
+                          const QScaleComponent *components, int componentCount,
+                          int outputWidth, int outputHeight,
+                          LineAccumulateFunc accumulate)
+{
+    QVarLengthArray<quint32, 4096> sums(lineBytes);
+
+    for (int dy = 0; dy < outputHeight; ++dy) {
+        const int y0 = dy * height / outputHeight;
+        const int y1 = qMax(y0 + 1, (dy + 1) * height / outputHeight);
+
+        memset(sums.data(), 0, lineBytes * sizeof(quint32));
+        for (int y = y0; y < y1; ++y)
+            accumulate(src + y * stride, sums.data(), lineBytes);
+
+        for (int c = 0; c < componentCount; ++c) {
+            const QScaleComponent &component = components[c];
+            const quint32 *column = sums.data() + component.offset;
+            uchar *out = component.output + dy * outputWidth;
+
+            for (int dx = 0; dx < outputWidth; ++dx) {
+                const int x0 = dx * component.width / outputWidth;
+                const int x1 = qMax(x0 + 1, (dx + 1) * component.width / outputWidth);
+
+                // A box may span a whole 8K frame, more than 32 bits hold
+                quint64 sum = 0;
+                for (int x = x0; x < x1; ++x)
+                    sum += column[x * component.step];
+
+                const quint64 count = quint64(x1 - x0) * (y1 - y0);
+                *out++ = (sum + count / 2) / count;
+            }
+        }
+    }
+}
+
+/*
+    Downscales the mapped YUV \a frame to \a size and converts the result to
+    ARGB32 in \a output. Filtering happens on the Y, U and V samples, so only
+    the reduced image is ever converted. Returns false if the pixel format of
+    the frame is not supported.
+*/
+bool qt_scaleYUVFrameToARGB32(const QVideoFrame &frame, const QSize &size,
+                              LineAccumulateFunc accumulate,
+                              uchar *output, int outputBytesPerLine,
+                              const QYCbCrCoefficients &coefficients)
+{
+    const int width = frame.width();
+    const int height = frame.height();
+    const int outputWidth = size.width();
+    const int outputHeight = size.height();
+    const int outputPixels = outputWidth * outputHeight;
+
+    QVarLengthArray<uchar, 3 * 4096> planes(3 * outputPixels);
+    uchar *y = planes.data();
+    uchar *u = y + outputPixels;
+    uchar *v = u + outputPixels;
+
+    switch (frame.pixelFormat()) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12: {
+        const bool yv12 = frame.pixelFormat() == QVideoFrame::Format_YV12;
+        const QScaleComponent luma = { 1, 0, width, y };
+        const QScaleComponent cb = { 1, 0, width / 2, u };
+        const QScaleComponent cr = { 1, 0, width / 2, v };
+        boxScaleLines(frame.bits(0), frame.bytesPerLine(0), width, height,
+                      &luma, 1, outputWidth, outputHeight, accumulate);
+        boxScaleLines(frame.bits(yv12 ? 2 : 1), frame.bytesPerLine(yv12 ? 2 : 1), width / 2, height / 2,
+                      &cb, 1, outputWidth, outputHeight, accumulate);
+        boxScaleLines(frame.bits(yv12 ? 1 : 2), frame.bytesPerLine(yv12 ? 1 : 2), width / 2, height / 2,
+                      &cr, 1, outputWidth, outputHeight, accumulate);
+        break;
+    }
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21: {
+        const bool nv21 = frame.pixelFormat() == QVideoFrame::Format_NV21;
+        const QScaleComponent luma = { 1, 0, width, y };
+        const QScaleComponent chroma[] = {
+            { 2, nv21 ? 1 : 0, width / 2, u },
+            { 2, nv21 ? 0 : 1, width / 2, v }
+        };
+        boxScaleLines(frame.bits(0), frame.bytesPerLine(0), width, height,
+                      &luma, 1, outputWidth, outputHeight, accumulate);
+        boxScaleLines(frame.bits(1), frame.bytesPerLine(1), (width / 2) * 2, height / 2,
+                      chroma, 2, outputWidth, outputHeight, accumulate);
+        break;
+    }
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV: {
+        const bool yuyv = frame.pixelFormat() == QVideoFrame::Format_YUYV;
+        const QScaleComponent components[] = {
+            { 2, yuyv ? 0 : 1, width, y },
+            { 4, yuyv ? 1 : 0, width / 2, u },
+            { 4, yuyv ? 3 : 2, width / 2, v }
+        };
+        boxScaleLines(frame.bits(0), frame.bytesPerLine(0), (width / 2) * 4, height,
+                      components, 3, outputWidth, outputHeight, accumulate);
+        break;
+    }
+    default:
+        return false;
+    }
+
+    for (int j = 0; j < outputHeight; ++j) {
+        quint32 *rgb = reinterpret_cast<quint32*>(output + j * outputBytesPerLine);
+        for (int i = 0; i < outputWidth; ++i) {
+            EXPAND_UV(coefficients, *u++, *v++);
+            *rgb++ = qYUVToARGB32(coefficients, *y++, rv, guv, bu);
+        }
+    }
+
+    return true;
+}
+
 QT_END_NAMESPACE
@@ -37,7 +37,8 @@
 
 QT_BEGIN_NAMESPACE
 
-void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                  const QYCbCrCoefficients &)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 4)
@@ -78,6 +79,443 @@ void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_avx2(const QVideoFrame &frame, ucha
     }
 }
 
+namespace {
+
+// QYCbCrCoefficients broadcast for the kernels below, one coefficient per 32-bit lane
+struct YCbCrCoefficients_avx2
+{
+    explicit YCbCrCoefficients_avx2(const QYCbCrCoefficients &c)
+        : yOffset(_mm256_set1_epi32(c.yOffset))
+        , yScale(_mm256_set1_epi32(c.y))
+        , rv(_mm256_set1_epi32(c.rv))
+        , guv(_mm256_set1_epi32((c.gv << 16) | c.gu))
+        , bu(_mm256_set1_epi32(c.bu))
+    {
+    }
+
+    __m256i yOffset;
+    __m256i yScale;
+    __m256i rv;
+    __m256i guv;
+    __m256i bu;
+};
+
+}
+
+// y32 holds sixteen luma samples, zero-extended to 32 bits
+static inline void yuvToARGB32_avx2(const __m256i *y32, const __m256i *rv, const __m256i *guv,
+                                    const __m256i *bu, const YCbCrCoefficients_avx2 &c,
+                                    quint32 *rgb)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi32(255);
+    const __m256i alpha = _mm256_set1_epi32(0xff000000);
+
+    for (int i = 0; i < 2; ++i) {
+        // (y - yOffset) * yScale; the high word of each sign-extended lane meets a zero coefficient
+        const __m256i yy = _mm256_madd_epi16(_mm256_sub_epi32(y32[i], c.yOffset), c.yScale);
+
+        __m256i r = _mm256_srai_epi32(_mm256_add_epi32(yy, rv[i]), 8);
+        __m256i g = _mm256_srai_epi32(_mm256_sub_epi32(yy, guv[i]), 8);
+        __m256i b = _mm256_srai_epi32(_mm256_add_epi32(yy, bu[i]), 8);
+        r = _mm256_min_epi32(_mm256_max_epi32(r, zero), max);
+        g = _mm256_min_epi32(_mm256_max_epi32(g, zero), max);
+        b = _mm256_min_epi32(_mm256_max_epi32(b, zero), max);
+
+        const __m256i argb = _mm256_or_si256(_mm256_or_si256(alpha, _mm256_slli_epi32(r, 16)),
+                                             _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb + i * 8), argb);
+    }
+}
+
+static inline void loadY_avx2(const uchar *y, __m256i *y32)
+{
+    y32[0] = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y)));
+    y32[1] = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + 8)));
+}
+
+// u32 and v32 hold eight chroma samples each, zero-extended to 32 bits
+static inline void expandUV_avx2(__m256i u32, __m256i v32, const YCbCrCoefficients_avx2 &c,
+                                 __m256i *rv, __m256i *guv, __m256i *bu)
+{
+    const __m256i uvOffset = _mm256_set1_epi32(128);
+    const __m256i round = _mm256_set1_epi32(128);
+    const __m256i dupLo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i dupHi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+    const __m256i uu = _mm256_sub_epi32(u32, uvOffset);
+    const __m256i vv = _mm256_sub_epi32(v32, uvOffset);
+    const __m256i uv = _mm256_blend_epi16(uu, _mm256_slli_epi32(vv, 16), 0xaa);
+
+    const __m256i rv8 = _mm256_add_epi32(_mm256_madd_epi16(vv, c.rv), round);
+    const __m256i guv8 = _mm256_add_epi32(_mm256_madd_epi16(uv, c.guv), round);
+    const __m256i bu8 = _mm256_add_epi32(_mm256_madd_epi16(uu, c.bu), round);
+
+    // each chroma sample covers two horizontally adjacent pixels
+    rv[0] = _mm256_permutevar8x32_epi32(rv8, dupLo);
+    rv[1] = _mm256_permutevar8x32_epi32(rv8, dupHi);
+    guv[0] = _mm256_permutevar8x32_epi32(guv8, dupLo);
+    guv[1] = _mm256_permutevar8x32_epi32(guv8, dupHi);
+    bu[0] = _mm256_permutevar8x32_epi32(bu8, dupLo);
+    bu[1] = _mm256_permutevar8x32_epi32(bu8, dupHi);
+}
+
+static inline void planarYUV420_to_ARGB32_avx2(const uchar *y, int yStride,
+                                               const uchar *u, int uStride,
+                                               const uchar *v, int vStride,
+                                               const QYCbCrCoefficients &coefficients,
+                                               quint32 *rgb,
+                                               int width, int height)
+{
+    const YCbCrCoefficients_avx2 c(coefficients);
+    quint32 *rgb0 = rgb;
+    quint32 *rgb1 = rgb + width;
+
+    for (int j = 0; j < height; j += 2) {
+        const uchar *lineY0 = y;
+        const uchar *lineY1 = y + yStride;
+        const uchar *lineU = u;
+        const uchar *lineV = v;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            __m256i rv[2], guv[2], bu[2], y32[2];
+            expandUV_avx2(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(lineU))),
+                          _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(lineV))),
+                          c, rv, guv, bu);
+            lineU += 8;
+            lineV += 8;
+
+            loadY_avx2(lineY0, y32);
+            yuvToARGB32_avx2(y32, rv, guv, bu, c, rgb0);
+            loadY_avx2(lineY1, y32);
+            yuvToARGB32_avx2(y32, rv, guv, bu, c, rgb1);
+            lineY0 += 16;
+            lineY1 += 16;
+            rgb0 += 16;
+            rgb1 += 16;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            EXPAND_UV(coefficients, *lineU, *lineV);
+            ++lineU;
+            ++lineV;
+
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+        }
+
+        y += yStride << 1; // stride * 2
+        u += uStride;
+        v += vStride;
+        rgb0 += width;
+        rgb1 += width;
+    }
+}
+
+static inline void semiPlanarYUV420_to_ARGB32_avx2(const uchar *y, int yStride,
+                                                   const uchar *uv, int uvStride,
+                                                   bool swapUV,
+                                                   const QYCbCrCoefficients &coefficients,
+                                                   quint32 *rgb,
+                                                   int width, int height)
+{
+    const YCbCrCoefficients_avx2 c(coefficients);
+    const __m256i lowWords = _mm256_set1_epi32(0xffff);
+    quint32 *rgb0 = rgb;
+    quint32 *rgb1 = rgb + width;
+    const int uOffset = swapUV ? 1 : 0;
+    const int vOffset = swapUV ? 0 : 1;
+
+    for (int j = 0; j < height; j += 2) {
+        const uchar *lineY0 = y;
+        const uchar *lineY1 = y + yStride;
+        const uchar *lineUV = uv;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            // one 32-bit lane per chroma pair, first sample in the low word
+            const __m256i pairs = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lineUV)));
+            const __m256i first = _mm256_and_si256(pairs, lowWords);
+            const __m256i second = _mm256_srli_epi32(pairs, 16);
+            __m256i rv[2], guv[2], bu[2], y32[2];
+            expandUV_avx2(swapUV ? second : first, swapUV ? first : second, c, rv, guv, bu);
+            lineUV += 16;
+
+            loadY_avx2(lineY0, y32);
+            yuvToARGB32_avx2(y32, rv, guv, bu, c, rgb0);
+            loadY_avx2(lineY1, y32);
+            yuvToARGB32_avx2(y32, rv, guv, bu, c, rgb1);
+            lineY0 += 16;
+            lineY1 += 16;
+            rgb0 += 16;
+            rgb1 += 16;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            EXPAND_UV(coefficients, lineUV[uOffset], lineUV[vOffset]);
+            lineUV += 2;
+
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+        }
+
+        y += yStride << 1; // stride * 2
+        uv += uvStride;
+        rgb0 += width;
+        rgb1 += width;
+    }
+}
+
+// Packed 4:2:2; lumaFirst selects YUYV over UYVY byte order
+static inline void packedYUV422_to_ARGB32_avx2(const uchar *src, int stride,
+                                               bool lumaFirst,
+                                               const QYCbCrCoefficients &coefficients,
+                                               quint32 *rgb,
+                                               int width, int height)
+{
+    const YCbCrCoefficients_avx2 c(coefficients);
+    const __m256i lowWords = _mm256_set1_epi32(0xffff);
+    const __m256i gatherUV = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            // one 32-bit lane per pixel: (y, u) or (y, v) for YUYV, swapped for UYVY
+            const __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc)));
+            const __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc + 16)));
+            lineSrc += 32;
+
+            __m256i y32[2], ca, cb;
+            if (lumaFirst) {
+                y32[0] = _mm256_and_si256(a, lowWords);
+                y32[1] = _mm256_and_si256(b, lowWords);
+                ca = _mm256_srli_epi32(a, 16);
+                cb = _mm256_srli_epi32(b, 16);
+            } else {
+                y32[0] = _mm256_srli_epi32(a, 16);
+                y32[1] = _mm256_srli_epi32(b, 16);
+                ca = _mm256_and_si256(a, lowWords);
+                cb = _mm256_and_si256(b, lowWords);
+            }
+
+            // u0 v0 u1 v1 ... -> u0 u1 u2 u3 v0 v1 v2 v3
+            ca = _mm256_permutevar8x32_epi32(ca, gatherUV);
+            cb = _mm256_permutevar8x32_epi32(cb, gatherUV);
+
+            __m256i rv[2], guv[2], bu[2];
+            expandUV_avx2(_mm256_permute2x128_si256(ca, cb, 0x20),
+                          _mm256_permute2x128_si256(ca, cb, 0x31),
+                          c, rv, guv, bu);
+
+            yuvToARGB32_avx2(y32, rv, guv, bu, c, rgb);
+            rgb += 16;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            int y0, y1, u, v;
+            if (lumaFirst) {
+                y0 = lineSrc[0];
+                u = lineSrc[1];
+                y1 = lineSrc[2];
+                v = lineSrc[3];
+            } else {
+                u = lineSrc[0];
+                y0 = lineSrc[1];
+                v = lineSrc[2];
+                y1 = lineSrc[3];
+            }
+            lineSrc += 4;
+
+            EXPAND_UV(coefficients, u, v);
+
+            *rgb++ = qYUVToARGB32(coefficients, y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(coefficients, y1, rv, guv, bu);
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                   const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane3, plane3Stride,
+                                coefficients,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_YV12_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                plane3, plane3Stride,
+                                plane2, plane2Stride,
+                                coefficients,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_NV12_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    semiPlanarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                    plane2, plane2Stride,
+                                    false, coefficients,
+                                    reinterpret_cast<quint32*>(output),
+                                    width, height);
+}
+
+void QT_FASTCALL qt_convert_NV21_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    semiPlanarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                    plane2, plane2Stride,
+                                    true, coefficients,
+                                    reinterpret_cast<quint32*>(output),
+                                    width, height);
+}
+
+void QT_FASTCALL qt_convert_IMC2_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane2 + plane2Stride / 2, plane2Stride,
+                                coefficients,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_IMC4_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                plane2 + plane2Stride / 2, plane2Stride,
+                                plane2, plane2Stride,
+                                coefficients,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_UYVY_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+    packedYUV422_to_ARGB32_avx2(src, stride, false, coefficients,
+                                reinterpret_cast<quint32*>(output), width, height);
+}
+
+void QT_FASTCALL qt_convert_YUYV_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+    packedYUV422_to_ARGB32_avx2(src, stride, true, coefficients,
+                                reinterpret_cast<quint32*>(output), width, height);
+}
+
+// y32 holds eight grey levels zero-extended to 32 bits, written as opaque ARGB32 pixels
+static inline void greyToARGB32_avx2(__m256i y32, quint32 *argb)
+{
+    const __m256i alpha = _mm256_set1_epi32(0xff000000);
+    const __m256i yyy = _mm256_or_si256(y32, _mm256_or_si256(_mm256_slli_epi32(y32, 8),
+                                                              _mm256_slli_epi32(y32, 16)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(argb), _mm256_or_si256(yyy, alpha));
+}
+
+void QT_FASTCALL qt_convert_Y8_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                              const QYCbCrCoefficients &)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 1)
+    quint32 *argb = reinterpret_cast<quint32*>(output);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *grey = src;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            for (int i = 0; i < 2; ++i) {
+                greyToARGB32_avx2(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(grey))), argb);
+                grey += 8;
+                argb += 8;
+            }
+        }
+
+        // leftovers
+        for (; x < width; ++x)
+            *argb++ = qConvertY8ToARGB32(*grey++);
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_Y16_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output,
+                                               const QYCbCrCoefficients &)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+    quint32 *argb = reinterpret_cast<quint32*>(output);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *grey = src;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            for (int i = 0; i < 2; ++i) {
+                const __m256i y32 = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(grey)));
+                greyToARGB32_avx2(_mm256_srli_epi32(y32, 8), argb);
+                grey += 16;
+                argb += 8;
+            }
+        }
+
+        // leftovers
+        for (; x < width; ++x) {
+            *argb++ = qConvertY8ToARGB32(grey[1]);
+            grey += 2;
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_accumulateLine_avx2(const uchar *line, quint32 *sums, int count)
+{
+    int x = 0;
+    for (; x < count - 31; x += 32) {
+        for (int i = 0; i < 4; ++i) {
+            const __m256i pixels = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(line + x + i * 8)));
+            __m256i *s = reinterpret_cast<__m256i*>(sums + x + i * 8);
+            _mm256_storeu_si256(s, _mm256_add_epi32(_mm256_loadu_si256(s), pixels));
+        }
+    }
+
+    // leftovers
+    for (; x < count; ++x)
+        sums[x] += line[x];
+}
+
 QT_END_NAMESPACE
 
 #endif
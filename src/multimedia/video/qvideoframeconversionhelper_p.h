@@ -46,9 +46,65 @@
 //
 
 #include <qvideoframe.h>
+#include <qvideosurfaceformat.h>
 #include <private/qsimd_p.h>
 
-typedef void (QT_FASTCALL *VideoFrameConvertFunc)(const QVideoFrame &frame, uchar *output);
+QT_BEGIN_NAMESPACE
+
+/*
+    Fixed-point Y'CbCr to R'G'B' coefficients, in units of 1/256.
+    Chroma terms are applied to samples centered on 128, the green ones
+    are subtracted.
+*/
+struct QYCbCrCoefficients
+{
+    enum Matrix {
+        BT601,
+        BT709,
+        BT2020
+    };
+
+    enum Range {
+        LimitedRange, // Y' in [16, 235], CbCr in [16, 240]
+        FullRange     // all components in [0, 255]
+    };
+
+    int yOffset;
+    int y;
+    int rv;
+    int gu;
+    int gv;
+    int bu;
+};
+
+Q_MULTIMEDIA_EXPORT const QYCbCrCoefficients &qt_yCbCrCoefficients(QYCbCrCoefficients::Matrix matrix,
+                                                                   QYCbCrCoefficients::Range range);
+Q_MULTIMEDIA_EXPORT const QYCbCrCoefficients &qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCrColorSpace colorSpace);
+
+typedef void (QT_FASTCALL *VideoFrameConvertFunc)(const QVideoFrame &frame, uchar *output,
+                                                  const QYCbCrCoefficients &coefficients);
+typedef void (QT_FASTCALL *LineAccumulateFunc)(const uchar *line, quint32 *sums, int count);
+
+enum QVideoFrameConvertLevel {
+    QVideoFrameConvertScalar,
+    QVideoFrameConvertSSE2,
+    QVideoFrameConvertSSSE3,
+    QVideoFrameConvertAVX2
+};
+
+Q_MULTIMEDIA_EXPORT VideoFrameConvertFunc qt_videoFrameConvertFunc(QVideoFrame::PixelFormat format,
+                                                                   QVideoFrameConvertLevel level);
+
+void qt_runConvertFunc(VideoFrameConvertFunc convert, const QVideoFrame &frame,
+                       uchar *output, int outputBytesPerLine,
+                       const QYCbCrCoefficients &coefficients);
+bool qt_convertYUVFrame(const QVideoFrame &src, QVideoFrame &dst,
+                        const QYCbCrCoefficients &coefficients);
+void QT_FASTCALL qt_accumulateLine(const uchar *line, quint32 *sums, int count);
+bool qt_scaleYUVFrameToARGB32(const QVideoFrame &frame, const QSize &size,
+                              LineAccumulateFunc accumulate,
+                              uchar *output, int outputBytesPerLine,
+                              const QYCbCrCoefficients &coefficients);
 
 inline quint32 qConvertBGRA32ToARGB32(quint32 bgra)
 {
@@ -79,6 +135,30 @@ inline quint32 qConvertBGR555ToARGB32(quint16 bgr)
             | ((((bgr) << 19) & 0xf80000) | (((bgr) << 11) & 0x70000));
 }
 
+// Grey levels are taken as full range intensities, as for QImage::Format_Grayscale8
+inline quint32 qConvertY8ToARGB32(uchar y)
+{
+    return 0xff000000 | (y * 0x010101);
+}
+
+#define CLAMP(n) (n > 255 ? 255 : (n < 0 ? 0 : n))
+
+#define EXPAND_UV(c, u, v) \
+    int uu = u - 128; \
+    int vv = v - 128; \
+    int rv = c.rv * vv + 128; \
+    int guv = c.gu * uu + c.gv * vv + 128; \
+    int bu = c.bu * uu + 128; \
+
+inline quint32 qYUVToARGB32(const QYCbCrCoefficients &c, int y, int rv, int guv, int bu, int a = 0xff)
+{
+    int yy = (y - c.yOffset) * c.y;
+    return (a << 24)
+            | CLAMP((yy + rv) >> 8) << 16
+            | CLAMP((yy - guv) >> 8) << 8
+            | CLAMP((yy + bu) >> 8);
+}
+
 #define FETCH_INFO_PACKED(frame) \
     const uchar *src = frame.bits(); \
     int stride = frame.bytesPerLine(); \
@@ -113,5 +193,7 @@ inline quint32 qConvertBGR555ToARGB32(quint16 bgr)
 #define ALIGN(boundary, ptr, x, length) \
     for (; ((reinterpret_cast<qintptr>(ptr) & (boundary - 1)) != 0) && x < length; ++x)
 
+QT_END_NAMESPACE
+
 #endif // QVIDEOFRAMECONVERSIONHELPER_P_H
 
@@ -37,7 +37,8 @@
 
 QT_BEGIN_NAMESPACE
 
-void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                  const QYCbCrCoefficients &)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 4)
@@ -78,6 +79,452 @@ void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_sse2(const QVideoFrame &frame, ucha
     }
 }
 
+namespace {
+
+// QYCbCrCoefficients broadcast for the kernels below
+struct YCbCrCoefficients_sse2
+{
+    explicit YCbCrCoefficients_sse2(const QYCbCrCoefficients &c)
+        : yOffset(_mm_set1_epi16(c.yOffset))
+        , yScale(_mm_set1_epi16(c.y))
+        // coefficient pairs for _mm_madd_epi16, low word first
+        , rv(_mm_set1_epi32((128 << 16) | c.rv))
+        , guv(_mm_set1_epi32((c.gv << 16) | c.gu))
+        , bu(_mm_set1_epi32((128 << 16) | c.bu))
+    {
+    }
+
+    __m128i yOffset;
+    __m128i yScale;
+    __m128i rv;
+    __m128i guv;
+    __m128i bu;
+};
+
+}
+
+static inline void yuvToARGB32_sse2(__m128i y8, const __m128i *rv, const __m128i *guv,
+                                    const __m128i *bu, const YCbCrCoefficients_sse2 &c,
+                                    quint32 *rgb)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi8(char(0xff));
+
+    // 16 luma samples, expanded to (y - yOffset) * yScale as 32-bit values
+    __m128i yy[4];
+    for (int i = 0; i < 2; ++i) {
+        const __m128i y16 = _mm_sub_epi16(i == 0 ? _mm_unpacklo_epi8(y8, zero)
+                                                 : _mm_unpackhi_epi8(y8, zero), c.yOffset);
+        const __m128i lo = _mm_mullo_epi16(y16, c.yScale);
+        const __m128i hi = _mm_mulhi_epi16(y16, c.yScale);
+        yy[i * 2] = _mm_unpacklo_epi16(lo, hi);
+        yy[i * 2 + 1] = _mm_unpackhi_epi16(lo, hi);
+    }
+
+    __m128i r[4], g[4], b[4];
+    for (int i = 0; i < 4; ++i) {
+        r[i] = _mm_srai_epi32(_mm_add_epi32(yy[i], rv[i]), 8);
+        g[i] = _mm_srai_epi32(_mm_sub_epi32(yy[i], guv[i]), 8);
+        b[i] = _mm_srai_epi32(_mm_add_epi32(yy[i], bu[i]), 8);
+    }
+
+    // Saturating packs clamp to [0, 255], exactly like CLAMP() does
+    const __m128i r8 = _mm_packus_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3]));
+    const __m128i g8 = _mm_packus_epi16(_mm_packs_epi32(g[0], g[1]), _mm_packs_epi32(g[2], g[3]));
+    const __m128i b8 = _mm_packus_epi16(_mm_packs_epi32(b[0], b[1]), _mm_packs_epi32(b[2], b[3]));
+
+    const __m128i bgLo = _mm_unpacklo_epi8(b8, g8);
+    const __m128i bgHi = _mm_unpackhi_epi8(b8, g8);
+    const __m128i raLo = _mm_unpacklo_epi8(r8, alpha);
+    const __m128i raHi = _mm_unpackhi_epi8(r8, alpha);
+
+    __m128i *out = reinterpret_cast<__m128i*>(rgb);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(bgLo, raLo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLo, raLo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHi, raHi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHi, raHi));
+}
+
+// u16 and v16 hold eight chroma samples each, zero-extended to 16 bits
+static inline void expandUV_sse2(__m128i u16, __m128i v16, const YCbCrCoefficients_sse2 &c,
+                                 __m128i *rv, __m128i *guv, __m128i *bu)
+{
+    const __m128i uvOffset = _mm_set1_epi16(128);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i round = _mm_set1_epi32(128);
+
+    const __m128i uu = _mm_sub_epi16(u16, uvOffset);
+    const __m128i vv = _mm_sub_epi16(v16, uvOffset);
+
+    for (int i = 0; i < 2; ++i) {
+        const __m128i v1 = i == 0 ? _mm_unpacklo_epi16(vv, one) : _mm_unpackhi_epi16(vv, one);
+        const __m128i uv = i == 0 ? _mm_unpacklo_epi16(uu, vv) : _mm_unpackhi_epi16(uu, vv);
+        const __m128i u1 = i == 0 ? _mm_unpacklo_epi16(uu, one) : _mm_unpackhi_epi16(uu, one);
+
+        const __m128i rv4 = _mm_madd_epi16(v1, c.rv);
+        const __m128i guv4 = _mm_add_epi32(_mm_madd_epi16(uv, c.guv), round);
+        const __m128i bu4 = _mm_madd_epi16(u1, c.bu);
+
+        // each chroma sample covers two horizontally adjacent pixels
+        rv[i * 2] = _mm_unpacklo_epi32(rv4, rv4);
+        rv[i * 2 + 1] = _mm_unpackhi_epi32(rv4, rv4);
+        guv[i * 2] = _mm_unpacklo_epi32(guv4, guv4);
+        guv[i * 2 + 1] = _mm_unpackhi_epi32(guv4, guv4);
+        bu[i * 2] = _mm_unpacklo_epi32(bu4, bu4);
+        bu[i * 2 + 1] = _mm_unpackhi_epi32(bu4, bu4);
+    }
+}
+
+static inline void planarYUV420_to_ARGB32_sse2(const uchar *y, int yStride,
+                                               const uchar *u, int uStride,
+                                               const uchar *v, int vStride,
+                                               const QYCbCrCoefficients &coefficients,
+                                               quint32 *rgb,
+                                               int width, int height)
+{
+    const YCbCrCoefficients_sse2 c(coefficients);
+    const __m128i zero = _mm_setzero_si128();
+    quint32 *rgb0 = rgb;
+    quint32 *rgb1 = rgb + width;
+
+    for (int j = 0; j < height; j += 2) {
+        const uchar *lineY0 = y;
+        const uchar *lineY1 = y + yStride;
+        const uchar *lineU = u;
+        const uchar *lineV = v;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            __m128i rv[4], guv[4], bu[4];
+            expandUV_sse2(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(lineU)), zero),
+                          _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(lineV)), zero),
+                          c, rv, guv, bu);
+            lineU += 8;
+            lineV += 8;
+
+            yuvToARGB32_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lineY0)), rv, guv, bu, c, rgb0);
+            yuvToARGB32_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lineY1)), rv, guv, bu, c, rgb1);
+            lineY0 += 16;
+            lineY1 += 16;
+            rgb0 += 16;
+            rgb1 += 16;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            EXPAND_UV(coefficients, *lineU, *lineV);
+            ++lineU;
+            ++lineV;
+
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+        }
+
+        y += yStride << 1; // stride * 2
+        u += uStride;
+        v += vStride;
+        rgb0 += width;
+        rgb1 += width;
+    }
+}
+
+static inline void semiPlanarYUV420_to_ARGB32_sse2(const uchar *y, int yStride,
+                                                   const uchar *uv, int uvStride,
+                                                   bool swapUV,
+                                                   const QYCbCrCoefficients &coefficients,
+                                                   quint32 *rgb,
+                                                   int width, int height)
+{
+    const YCbCrCoefficients_sse2 c(coefficients);
+    const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+    quint32 *rgb0 = rgb;
+    quint32 *rgb1 = rgb + width;
+    const int uOffset = swapUV ? 1 : 0;
+    const int vOffset = swapUV ? 0 : 1;
+
+    for (int j = 0; j < height; j += 2) {
+        const uchar *lineY0 = y;
+        const uchar *lineY1 = y + yStride;
+        const uchar *lineUV = uv;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            const __m128i uv8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineUV));
+            const __m128i even = _mm_and_si128(uv8, lowBytes);
+            const __m128i odd = _mm_srli_epi16(uv8, 8);
+            __m128i rv[4], guv[4], bu[4];
+            expandUV_sse2(swapUV ? odd : even, swapUV ? even : odd, c, rv, guv, bu);
+            lineUV += 16;
+
+            yuvToARGB32_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lineY0)), rv, guv, bu, c, rgb0);
+            yuvToARGB32_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lineY1)), rv, guv, bu, c, rgb1);
+            lineY0 += 16;
+            lineY1 += 16;
+            rgb0 += 16;
+            rgb1 += 16;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            EXPAND_UV(coefficients, lineUV[uOffset], lineUV[vOffset]);
+            lineUV += 2;
+
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(coefficients, *lineY0++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(coefficients, *lineY1++, rv, guv, bu);
+        }
+
+        y += yStride << 1; // stride * 2
+        uv += uvStride;
+        rgb0 += width;
+        rgb1 += width;
+    }
+}
+
+// Packed 4:2:2; lumaFirst selects YUYV over UYVY byte order
+static inline void packedYUV422_to_ARGB32_sse2(const uchar *src, int stride,
+                                               bool lumaFirst,
+                                               const QYCbCrCoefficients &coefficients,
+                                               quint32 *rgb,
+                                               int width, int height)
+{
+    const YCbCrCoefficients_sse2 c(coefficients);
+    const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc + 16));
+            lineSrc += 32;
+
+            __m128i y8, c8;
+            if (lumaFirst) {
+                y8 = _mm_packus_epi16(_mm_and_si128(a, lowBytes), _mm_and_si128(b, lowBytes));
+                c8 = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+            } else {
+                y8 = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+                c8 = _mm_packus_epi16(_mm_and_si128(a, lowBytes), _mm_and_si128(b, lowBytes));
+            }
+
+            // c8 now holds u0 v0 u1 v1 ... u7 v7
+            __m128i rv[4], guv[4], bu[4];
+            expandUV_sse2(_mm_and_si128(c8, lowBytes), _mm_srli_epi16(c8, 8), c, rv, guv, bu);
+
+            yuvToARGB32_sse2(y8, rv, guv, bu, c, rgb);
+            rgb += 16;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            int y0, y1, u, v;
+            if (lumaFirst) {
+                y0 = lineSrc[0];
+                u = lineSrc[1];
+                y1 = lineSrc[2];
+                v = lineSrc[3];
+            } else {
+                u = lineSrc[0];
+                y0 = lineSrc[1];
+                v = lineSrc[2];
+                y1 = lineSrc[3];
+            }
+            lineSrc += 4;
+
+            EXPAND_UV(coefficients, u, v);
+
+            *rgb++ = qYUVToARGB32(coefficients, y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(coefficients, y1, rv, guv, bu);
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                   const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane3, plane3Stride,
+                                coefficients,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_YV12_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                plane3, plane3Stride,
+                                plane2, plane2Stride,
+                                coefficients,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_NV12_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    semiPlanarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                    plane2, plane2Stride,
+                                    false, coefficients,
+                                    reinterpret_cast<quint32*>(output),
+                                    width, height);
+}
+
+void QT_FASTCALL qt_convert_NV21_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    semiPlanarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                    plane2, plane2Stride,
+                                    true, coefficients,
+                                    reinterpret_cast<quint32*>(output),
+                                    width, height);
+}
+
+void QT_FASTCALL qt_convert_IMC2_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane2 + plane2Stride / 2, plane2Stride,
+                                coefficients,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_IMC4_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                plane2 + plane2Stride / 2, plane2Stride,
+                                plane2, plane2Stride,
+                                coefficients,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_UYVY_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+    packedYUV422_to_ARGB32_sse2(src, stride, false, coefficients,
+                                reinterpret_cast<quint32*>(output), width, height);
+}
+
+void QT_FASTCALL qt_convert_YUYV_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                                const QYCbCrCoefficients &coefficients)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+    packedYUV422_to_ARGB32_sse2(src, stride, true, coefficients,
+                                reinterpret_cast<quint32*>(output), width, height);
+}
+
+// Writes sixteen grey levels as opaque ARGB32 pixels
+static inline void greyToARGB32_sse2(__m128i y8, quint32 *argb)
+{
+    const __m128i alpha = _mm_set1_epi8(char(0xff));
+    const __m128i yyLo = _mm_unpacklo_epi8(y8, y8);
+    const __m128i yyHi = _mm_unpackhi_epi8(y8, y8);
+    const __m128i yaLo = _mm_unpacklo_epi8(y8, alpha);
+    const __m128i yaHi = _mm_unpackhi_epi8(y8, alpha);
+
+    __m128i *out = reinterpret_cast<__m128i*>(argb);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(yyLo, yaLo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(yyLo, yaLo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(yyHi, yaHi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(yyHi, yaHi));
+}
+
+void QT_FASTCALL qt_convert_Y8_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                              const QYCbCrCoefficients &)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 1)
+    quint32 *argb = reinterpret_cast<quint32*>(output);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *grey = src;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            greyToARGB32_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(grey)), argb);
+            grey += 16;
+            argb += 16;
+        }
+
+        // leftovers
+        for (; x < width; ++x)
+            *argb++ = qConvertY8ToARGB32(*grey++);
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_Y16_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output,
+                                               const QYCbCrCoefficients &)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+    quint32 *argb = reinterpret_cast<quint32*>(output);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *grey = src;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(grey));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(grey + 16));
+            greyToARGB32_sse2(_mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)), argb);
+            grey += 32;
+            argb += 16;
+        }
+
+        // leftovers
+        for (; x < width; ++x) {
+            *argb++ = qConvertY8ToARGB32(grey[1]);
+            grey += 2;
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_accumulateLine_sse2(const uchar *line, quint32 *sums, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x < count - 15; x += 16) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line + x));
+        const __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+        const __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+        __m128i *s = reinterpret_cast<__m128i*>(sums + x);
+        _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+
+    // leftovers
+    for (; x < count; ++x)
+        sums[x] += line[x];
+}
+
 QT_END_NAMESPACE
 
 #endif
@@ -0,0 +1,312 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qvideoframepool_p.h"
+#include "qvideoframe_p.h"
+
+#include <QtMultimedia/qabstractvideobuffer.h>
+
+#include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+
+QT_BEGIN_NAMESPACE
+
+class QVideoFramePoolPrivate
+{
+public:
+    QVideoFramePoolPrivate(int capacity)
+        : bytes(0)
+        , bytesPerLine(0)
+        , capacity(qMax(0, capacity))
+        , hits(0)
+        , misses(0)
+        , closed(false)
+    {
+    }
+
+    void setFormat(const QVideoSurfaceFormat &newFormat)
+    {
+        format = newFormat;
+        bytesPerLine = 0;
+        bytes = qt_videoFrameBytes(format.pixelFormat(), format.frameSize(), &bytesPerLine);
+
+        // Buffers of the previous format are only useful if they have the same size
+        for (int i = idle.size() - 1; i >= 0; --i) {
+            if (idle.at(i).size() != bytes)
+                idle.removeAt(i);
+        }
+    }
+
+    void recycle(const QByteArray &data)
+    {
+        QMutexLocker locker(&mutex);
+
+        if (!closed && data.size() == bytes && idle.size() < capacity)
+            idle.append(data);
+    }
+
+    mutable QMutex mutex;
+    QVideoSurfaceFormat format;
+    int bytes;
+    int bytesPerLine;
+    int capacity;
+    int hits;
+    int misses;
+    bool closed;
+    QList<QByteArray> idle;
+};
+
+/*
+    A system memory video buffer which hands its data back to the pool that
+    allocated it once the last frame referencing it is released.
+*/
+class QVideoFramePoolBuffer : public QAbstractVideoBuffer
+{
+public:
+    QVideoFramePoolBuffer(const QSharedPointer<QVideoFramePoolPrivate> &pool,
+                          const QByteArray &data, int bytesPerLine)
+        : QAbstractVideoBuffer(NoHandle)
+        , m_pool(pool)
+        , m_data(data)
+        , m_bytesPerLine(bytesPerLine)
+        , m_mapMode(NotMapped)
+    {
+    }
+
+    ~QVideoFramePoolBuffer()
+    {
+        m_pool->recycle(m_data);
+    }
+
+    MapMode mapMode() const { return m_mapMode; }
+
+    uchar *map(MapMode mode, int *numBytes, int *bytesPerLine)
+    {
+        if (m_mapMode != NotMapped || mode == NotMapped || m_data.isEmpty())
+            return 0;
+
+        m_mapMode = mode;
+
+        if (numBytes)
+            *numBytes = m_data.size();
+
+        if (bytesPerLine)
+            *bytesPerLine = m_bytesPerLine;
+
+        return reinterpret_cast<uchar *>(m_data.data());
+    }
+
+    void unmap() { m_mapMode = NotMapped; }
+
+private:
+    QSharedPointer<QVideoFramePoolPrivate> m_pool;
+    QByteArray m_data;
+    int m_bytesPerLine;
+    MapMode m_mapMode;
+};
+
+/*!
+    \class QVideoFramePool
+    \internal
+
+    \brief The QVideoFramePool class recycles the memory of system memory video frames.
+
+    Frames returned by allocate() are backed by a plain memory buffer sized for
+    the pool's format().  When the last QVideoFrame referring to such a buffer
+    is destroyed its memory is returned to the pool, and handed out again by
+    the next call to allocate() instead of being freed and reallocated.  At most
+    capacity() idle buffers are kept; frames may outlive the pool, in which case
+    their memory is simply freed.
+
+    The pool may be used from several threads.
+*/
+
+/*!
+    Constructs a pool without a format keeping up to \a capacity idle buffers.
+*/
+QVideoFramePool::QVideoFramePool(int capacity)
+    : d(new QVideoFramePoolPrivate(capacity))
+{
+}
+
+/*!
+    Constructs a pool allocating frames of \a format and keeping up to
+    \a capacity idle buffers.
+*/
+QVideoFramePool::QVideoFramePool(const QVideoSurfaceFormat &format, int capacity)
+    : d(new QVideoFramePoolPrivate(capacity))
+{
+    d->setFormat(format);
+}
+
+/*!
+    Destroys the pool.  Frames allocated from it remain valid.
+*/
+QVideoFramePool::~QVideoFramePool()
+{
+    QMutexLocker locker(&d->mutex);
+
+    d->closed = true;
+    d->idle.clear();
+}
+
+/*!
+    Returns the format of the frames allocated by the pool.
+*/
+QVideoSurfaceFormat QVideoFramePool::format() const
+{
+    QMutexLocker locker(&d->mutex);
+
+    return d->format;
+}
+
+/*!
+    Sets the \a format of the frames allocated by the pool.
+
+    Idle buffers which do not have the size required by \a format are released.
+*/
+void QVideoFramePool::setFormat(const QVideoSurfaceFormat &format)
+{
+    QMutexLocker locker(&d->mutex);
+
+    d->setFormat(format);
+}
+
+/*!
+    Returns the maximum number of idle buffers kept by the pool.
+*/
+int QVideoFramePool::capacity() const
+{
+    QMutexLocker locker(&d->mutex);
+
+    return d->capacity;
+}
+
+/*!
+    Sets the maximum number of idle buffers kept by the pool to \a capacity.
+*/
+void QVideoFramePool::setCapacity(int capacity)
+{
+    QMutexLocker locker(&d->mutex);
+
+    d->capacity = qMax(0, capacity);
+
+    while (d->idle.size() > d->capacity)
+        d->idle.removeLast();
+}
+
+/*!
+    Returns a frame of the pool's format, reusing the memory of a released
+    frame if one is available.
+
+    The contents of the frame are undefined.  Returns an invalid frame if the
+    format has no known memory layout.
+*/
+QVideoFrame QVideoFramePool::allocate()
+{
+    QMutexLocker locker(&d->mutex);
+
+    if (d->bytes <= 0)
+        return QVideoFrame();
+
+    QByteArray data;
+    if (!d->idle.isEmpty()) {
+        data = d->idle.takeLast();
+        ++d->hits;
+    } else {
+        data = QByteArray(d->bytes, Qt::Uninitialized);
+        ++d->misses;
+    }
+
+    const QVideoSurfaceFormat format = d->format;
+    const int bytesPerLine = d->bytesPerLine;
+
+    locker.unlock();
+
+    return QVideoFrame(new QVideoFramePoolBuffer(d, data, bytesPerLine),
+                       format.frameSize(), format.pixelFormat());
+}
+
+/*!
+    Releases all idle buffers.
+*/
+void QVideoFramePool::clear()
+{
+    QMutexLocker locker(&d->mutex);
+
+    d->idle.clear();
+}
+
+/*!
+    Returns the number of released buffers waiting to be reused.
+*/
+int QVideoFramePool::idleCount() const
+{
+    QMutexLocker locker(&d->mutex);
+
+    return d->idle.size();
+}
+
+/*!
+    Returns the number of frames allocated from a recycled buffer.
+*/
+int QVideoFramePool::hitCount() const
+{
+    QMutexLocker locker(&d->mutex);
+
+    return d->hits;
+}
+
+/*!
+    Returns the number of frames for which new memory had to be allocated.
+*/
+int QVideoFramePool::missCount() const
+{
+    QMutexLocker locker(&d->mutex);
+
+    return d->misses;
+}
+
+/*!
+    Resets the hit and miss counters.
+*/
+void QVideoFramePool::resetStatistics()
+{
+    QMutexLocker locker(&d->mutex);
+
+    d->hits = 0;
+    d->misses = 0;
+}
+
+QT_END_NAMESPACE
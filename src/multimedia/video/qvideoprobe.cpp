@@ -57,11 +57,27 @@
     This same approach works with the QCamera object as well, to receive viewfinder or video
     frames as they are captured.
 
+    Consumers which do not need every frame at full size can reduce the cost of
+    probing with setFrameStride(), setMaximumFrameRate(), setFrameSize() and
+    setPixelFormat(). Backends supporting it skip, scale and convert the frames
+    in the thread producing them, before they are delivered to the probe. When
+    several probes monitor the same media object, each of them receives at
+    least the frames it asked for: the smallest stride and highest rate apply,
+    and frames are only scaled or converted if all probes request the same
+    size or pixel format.
+
+    \code
+        probe->setMaximumFrameRate(2);
+        probe->setFrameSize(QSize(320, 240));
+        probe->setPixelFormat(QVideoFrame::Format_RGB32);
+    \endcode
+
     \sa QAudioProbe, QMediaPlayer, QCamera
 */
 
 #include "qvideoprobe.h"
 #include "qmediavideoprobecontrol.h"
+#include "qmediavideoprobecontrol_p.h"
 #include "qmediaservice.h"
 #include "qmediarecorder.h"
 #include "qsharedpointer.h"
@@ -71,8 +87,21 @@ QT_BEGIN_NAMESPACE
 
 class QVideoProbePrivate {
 public:
+    void applySettings()
+    {
+        if (QMediaVideoProbeControlPrivate *control = QMediaVideoProbeControlPrivate::get(probee.data()))
+            control->setProbeSettings(this, settings);
+    }
+
+    void removeSettings()
+    {
+        if (QMediaVideoProbeControlPrivate *control = QMediaVideoProbeControlPrivate::get(probee.data()))
+            control->removeProbe(this);
+    }
+
     QPointer<QMediaObject> source;
     QPointer<QMediaVideoProbeControl> probee;
+    QVideoProbeSettings settings;
 };
 
 /*!
@@ -99,6 +128,7 @@ QVideoProbe::~QVideoProbe()
         if (d->probee) {
             disconnect(d->probee.data(), SIGNAL(videoFrameProbed(QVideoFrame)), this, SIGNAL(videoFrameProbed(QVideoFrame)));
             disconnect(d->probee.data(), SIGNAL(flush()), this, SIGNAL(flush()));
+            d->removeSettings();
         }
         d->source.data()->service()->releaseControl(d->probee.data());
     }
@@ -128,6 +158,7 @@ bool QVideoProbe::setSource(QMediaObject *source)
     if (!d->source && d->probee) {
         disconnect(d->probee.data(), SIGNAL(videoFrameProbed(QVideoFrame)), this, SIGNAL(videoFrameProbed(QVideoFrame)));
         disconnect(d->probee.data(), SIGNAL(flush()), this, SIGNAL(flush()));
+        d->removeSettings();
         d->probee.clear();
     }
 
@@ -136,6 +167,7 @@ bool QVideoProbe::setSource(QMediaObject *source)
             Q_ASSERT(d->probee);
             disconnect(d->probee.data(), SIGNAL(videoFrameProbed(QVideoFrame)), this, SIGNAL(videoFrameProbed(QVideoFrame)));
             disconnect(d->probee.data(), SIGNAL(flush()), this, SIGNAL(flush()));
+            d->removeSettings();
             d->source.data()->service()->releaseControl(d->probee.data());
             d->source.clear();
             d->probee.clear();
@@ -150,6 +182,7 @@ bool QVideoProbe::setSource(QMediaObject *source)
             if (d->probee) {
                 connect(d->probee.data(), SIGNAL(videoFrameProbed(QVideoFrame)), this, SIGNAL(videoFrameProbed(QVideoFrame)));
                 connect(d->probee.data(), SIGNAL(flush()), this, SIGNAL(flush()));
+                d->applySettings();
                 d->source = source;
             }
         }
@@ -195,6 +228,200 @@ bool QVideoProbe::isActive() const
     return d->probee != 0;
 }
 
+/*!
+    Returns the stride between the probed frames.
+
+    \since 5.7
+    \sa setFrameStride()
+*/
+int QVideoProbe::frameStride() const
+{
+    return d->settings.frameStride;
+}
+
+/*!
+    Sets the \a stride between the probed frames, only one frame out of every
+    \a stride frames is delivered.
+
+    The default value of 1 delivers every frame.
+
+    \since 5.7
+*/
+void QVideoProbe::setFrameStride(int stride)
+{
+    d->settings.frameStride = qMax(1, stride);
+    d->applySettings();
+}
+
+/*!
+    Returns the maximum rate, in frames per second, at which frames are
+    probed.
+
+    \since 5.7
+    \sa setMaximumFrameRate()
+*/
+qreal QVideoProbe::maximumFrameRate() const
+{
+    return d->settings.maximumFrameRate;
+}
+
+/*!
+    Limits the delivery of frames to at most \a rate frames per second of
+    media time, the frames in between are skipped.
+
+    The default value of 0 does not limit the rate.
+
+    \since 5.7
+*/
+void QVideoProbe::setMaximumFrameRate(qreal rate)
+{
+    d->settings.maximumFrameRate = qMax(qreal(0), rate);
+    d->applySettings();
+}
+
+/*!
+    Returns the size the probed frames are scaled down to fit in.
+
+    \since 5.7
+    \sa setFrameSize()
+*/
+QSize QVideoProbe::frameSize() const
+{
+    return d->settings.frameSize;
+}
+
+/*!
+    Scales the probed frames down to fit in \a size, keeping their aspect
+    ratio. Frames which already fit are delivered as they are.
+
+    The default, invalid, size delivers the frames at their original size.
+
+    \since 5.7
+*/
+void QVideoProbe::setFrameSize(const QSize &size)
+{
+    d->settings.frameSize = size;
+    d->applySettings();
+}
+
+/*!
+    Returns the pixel format the probed frames are converted to.
+
+    \since 5.7
+    \sa setPixelFormat()
+*/
+QVideoFrame::PixelFormat QVideoProbe::pixelFormat() const
+{
+    return d->settings.pixelFormat;
+}
+
+/*!
+    Converts the probed frames to \a format.
+
+    The default value of QVideoFrame::Format_Invalid delivers the frames in
+    their original format.
+
+    \since 5.7
+*/
+void QVideoProbe::setPixelFormat(QVideoFrame::PixelFormat format)
+{
+    d->settings.pixelFormat = format;
+    d->applySettings();
+}
+
+/*!
+    Returns the policy followed to deliver the probed frames.
+
+    \since 5.7
+    \sa setDeliveryPolicy()
+*/
+QMultimedia::ProbeDeliveryPolicy QVideoProbe::deliveryPolicy() const
+{
+    return d->settings.deliveryPolicy;
+}
+
+/*!
+    Sets the \a policy followed when the probed frames arrive faster than
+    they are handled.
+
+    The default QMultimedia::LatestOnlyDelivery policy suits previews, only the
+    most recent frame is delivered. Analysis needing every frame should
+    use QMultimedia::BlockingQueueDelivery, which makes the media wait while
+    the queue is full. The media is only ever held for a second, after which
+    the oldest frame is dropped, so the queue must be drained from a thread
+    running an event loop.
+
+    \since 5.7
+    \sa setQueueCapacity(), droppedCount()
+*/
+void QVideoProbe::setDeliveryPolicy(QMultimedia::ProbeDeliveryPolicy policy)
+{
+    d->settings.deliveryPolicy = policy;
+    d->applySettings();
+}
+
+/*!
+    Returns the maximum number of frames queued for delivery.
+
+    \since 5.7
+    \sa setQueueCapacity()
+*/
+int QVideoProbe::queueCapacity() const
+{
+    return d->settings.queueCapacity;
+}
+
+/*!
+    Sets the maximum number of frames queued for delivery to \a capacity.
+    It has no effect with the QMultimedia::LatestOnlyDelivery policy.
+
+    \since 5.7
+*/
+void QVideoProbe::setQueueCapacity(int capacity)
+{
+    d->settings.queueCapacity = qMax(1, capacity);
+    d->applySettings();
+}
+
+/*!
+    Returns the number of frames dropped, since the statistics were last
+    reset, because they could not be delivered in time.
+
+    The count covers all the probes monitoring the same media object.
+
+    \since 5.7
+    \sa resetStatistics()
+*/
+int QVideoProbe::droppedCount() const
+{
+    QMediaVideoProbeControlPrivate *control = QMediaVideoProbeControlPrivate::get(d->probee.data());
+    return control ? control->queue.droppedCount() : 0;
+}
+
+/*!
+    Returns the largest number of frames that were waiting for delivery at
+    the same time, since the statistics were last reset.
+
+    \since 5.7
+    \sa resetStatistics()
+*/
+int QVideoProbe::queueHighWaterMark() const
+{
+    QMediaVideoProbeControlPrivate *control = QMediaVideoProbeControlPrivate::get(d->probee.data());
+    return control ? control->queue.highWaterMark() : 0;
+}
+
+/*!
+    Resets the dropped count and the queue high-water mark.
+
+    \since 5.7
+*/
+void QVideoProbe::resetStatistics()
+{
+    if (QMediaVideoProbeControlPrivate *control = QMediaVideoProbeControlPrivate::get(d->probee.data()))
+        control->queue.resetStatistics();
+}
+
 /*!
     \fn QVideoProbe::videoFrameProbed(const QVideoFrame &frame)
 
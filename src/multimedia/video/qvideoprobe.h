@@ -36,6 +36,7 @@
 
 #include <QtCore/QObject>
 #include <QtMultimedia/qvideoframe.h>
+#include <QtMultimedia/qmultimedia.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -55,6 +56,28 @@ public:
 
     bool isActive() const;
 
+    int frameStride() const;
+    void setFrameStride(int stride);
+
+    qreal maximumFrameRate() const;
+    void setMaximumFrameRate(qreal rate);
+
+    QSize frameSize() const;
+    void setFrameSize(const QSize &size);
+
+    QVideoFrame::PixelFormat pixelFormat() const;
+    void setPixelFormat(QVideoFrame::PixelFormat format);
+
+    QMultimedia::ProbeDeliveryPolicy deliveryPolicy() const;
+    void setDeliveryPolicy(QMultimedia::ProbeDeliveryPolicy policy);
+
+    int queueCapacity() const;
+    void setQueueCapacity(int capacity);
+
+    int droppedCount() const;
+    int queueHighWaterMark() const;
+    void resetStatistics();
+
 Q_SIGNALS:
     void videoFrameProbed(const QVideoFrame &videoFrame);
     void flush();
@@ -10,12 +10,14 @@ PUBLIC_HEADERS += \
     video/qabstractvideofilter.h
 
 PRIVATE_HEADERS += \
+    video/qabstractvideofilter_p.h \
     video/qabstractvideobuffer_p.h \
     video/qimagevideobuffer_p.h \
     video/qmemoryvideobuffer_p.h \
     video/qvideooutputorientationhandler_p.h \
     video/qvideosurfaceoutput_p.h \
     video/qvideoframe_p.h \
+    video/qvideoframepool_p.h \
     video/qvideoframeconversionhelper_p.h
 
 SOURCES += \
@@ -24,6 +26,7 @@ SOURCES += \
     video/qimagevideobuffer.cpp \
     video/qmemoryvideobuffer.cpp \
     video/qvideoframe.cpp \
+    video/qvideoframepool.cpp \
     video/qvideooutputorientationhandler.cpp \
     video/qvideosurfaceformat.cpp \
     video/qvideosurfaceoutput.cpp \
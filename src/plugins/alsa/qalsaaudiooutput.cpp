@@ -74,6 +74,7 @@ QAlsaAudioOutput::QAlsaAudioOutput(const QByteArray &device)
     opened = false;
 
     m_volume = 1.0f;
+    m_appliedVolume = 1.0f;
 
     m_device = device;
 
@@ -501,6 +502,7 @@ bool QAlsaAudioOutput::open()
     clockStamp.restart();
     timeStamp.restart();
     elapsedTimeOffset = 0;
+    m_appliedVolume = m_volume;
     errorState  = QAudio::NoError;
     totalTimeValue = 0;
     opened = true;
@@ -572,9 +574,11 @@ qint64 QAlsaAudioOutput::write( const char *data, qint64 len )
 
     frames = snd_pcm_bytes_to_frames(handle, space);
 
-    if (m_volume < 1.0f) {
+    if (m_volume < 1.0f || m_appliedVolume < 1.0f) {
         char out[space];
-        QAudioHelperInternal::qMultiplySamples(m_volume, settings, data, out, space);
+        // Ramp from the volume of the previous write so that changes don't click
+        QAudioHelperInternal::qMultiplySamples(m_appliedVolume, m_volume, settings, data, out, space);
+        m_appliedVolume = m_volume;
         err = snd_pcm_writei(handle, out, frames);
     } else {
         err = snd_pcm_writei(handle, data, frames);
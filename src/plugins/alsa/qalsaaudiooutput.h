@@ -135,6 +135,7 @@ private:
     snd_pcm_format_t pcmformat;
     snd_pcm_hw_params_t *hwparams;
     qreal m_volume;
+    qreal m_appliedVolume;
 };
 
 class AlsaOutputPrivate : public QIODevice
@@ -65,6 +65,29 @@ typedef enum {
     GST_PLAY_FLAG_BUFFERING     = 0x000000100
 } GstPlayFlags;
 
+#if GST_CHECK_VERSION(1,0,0)
+// Keeps a pulled sample mapped for as long as an audio buffer refers to its data
+struct QGstMappedSample
+{
+    GstSample *sample;
+    GstBuffer *buffer;
+    GstMapInfo mapInfo;
+};
+
+static void releaseMappedSample(void *cleanupInfo)
+{
+    QGstMappedSample *mapped = static_cast<QGstMappedSample *>(cleanupInfo);
+    gst_buffer_unmap(mapped->buffer, &mapped->mapInfo);
+    gst_sample_unref(mapped->sample);
+    delete mapped;
+}
+#else
+static void releaseBuffer(void *cleanupInfo)
+{
+    gst_buffer_unref(static_cast<GstBuffer *>(cleanupInfo));
+}
+#endif
+
 QGstreamerAudioDecoderSession::QGstreamerAudioDecoderSession(QObject *parent)
     : QObject(parent),
      m_state(QAudioDecoder::StoppedState),
@@ -446,36 +469,39 @@ QAudioBuffer QGstreamerAudioDecoderSession::read()
         int bufferSize = 0;
 
 #if GST_CHECK_VERSION(1,0,0)
-        GstSample *sample = gst_app_sink_pull_sample(m_appSink);
-        GstBuffer *buffer = gst_sample_get_buffer(sample);
-        GstMapInfo mapInfo;
-        gst_buffer_map(buffer, &mapInfo, GST_MAP_READ);
-        bufferData = (const char*)mapInfo.data;
-        bufferSize = mapInfo.size;
-        QAudioFormat format = QGstUtils::audioFormatForSample(sample);
+        QGstMappedSample *mapped = new QGstMappedSample;
+        mapped->sample = gst_app_sink_pull_sample(m_appSink);
+        mapped->buffer = gst_sample_get_buffer(mapped->sample);
+        gst_buffer_map(mapped->buffer, &mapped->mapInfo, GST_MAP_READ);
+        GstBuffer *buffer = mapped->buffer;
+        bufferData = (const char*)mapped->mapInfo.data;
+        bufferSize = mapped->mapInfo.size;
+        QAudioFormat format = QGstUtils::audioFormatForSample(mapped->sample);
+        QAudioBuffer::CleanupFunction cleanupFunction = releaseMappedSample;
+        void *cleanupInfo = mapped;
 #else
         GstBuffer *buffer = gst_app_sink_pull_buffer(m_appSink);
         bufferData = (const char*)buffer->data;
         bufferSize = buffer->size;
         QAudioFormat format = QGstUtils::audioFormatForBuffer(buffer);
+        QAudioBuffer::CleanupFunction cleanupFunction = releaseBuffer;
+        void *cleanupInfo = buffer;
 #endif
 
         if (format.isValid()) {
-            // XXX At the moment we have to copy data from GstBuffer into QAudioBuffer.
-            // We could improve performance by implementing QAbstractAudioBuffer for GstBuffer.
+            // The audio buffer wraps the GStreamer buffer, which it releases when it is destroyed
             qint64 position = getPositionFromBuffer(buffer);
-            audioBuffer = QAudioBuffer(QByteArray((const char*)bufferData, bufferSize), format, position);
+            audioBuffer = QAudioBuffer(static_cast<const void *>(bufferData), format.framesForBytes(bufferSize),
+                                       format, QAudioBuffer::InterleavedLayout, position,
+                                       cleanupFunction, cleanupInfo);
             position /= 1000; // convert to milliseconds
             if (position != m_position) {
                 m_position = position;
                 emit positionChanged(m_position);
             }
+        } else {
+            cleanupFunction(cleanupInfo);
         }
-#if GST_CHECK_VERSION(1,0,0)
-        gst_sample_unref(sample);
-#else
-        gst_buffer_unref(buffer);
-#endif
     }
 
     return audioBuffer;
@@ -163,6 +163,7 @@ QPulseAudioOutput::QPulseAudioOutput(const QByteArray &device)
     , m_audioBuffer(0)
     , m_resuming(false)
     , m_volume(1.0)
+    , m_appliedVolume(1.0)
 {
     connect(m_tickTimer, SIGNAL(timeout()), SLOT(userFeed()));
 }
@@ -373,6 +374,7 @@ bool QPulseAudioOutput::open()
     m_elapsedTimeOffset = 0;
     m_timeStamp.restart();
     m_clockStamp.restart();
+    m_appliedVolume = m_volume;
 
     return true;
 }
@@ -473,7 +475,7 @@ qint64 QPulseAudioOutput::write(const char *data, qint64 len)
 
     len = qMin(len, static_cast<qint64>(pa_stream_writable_size(m_stream)));
 
-    if (m_volume < 1.0f) {
+    if (m_volume < 1.0f || m_appliedVolume < 1.0f) {
         // Don't use PulseAudio volume, as it might affect all other streams of the same category
         // or even affect the system volume if flat volumes are enabled
         void *dest = NULL;
@@ -486,7 +488,9 @@ qint64 QPulseAudioOutput::write(const char *data, qint64 len)
         }
 
         len = int(nbytes);
-        QAudioHelperInternal::qMultiplySamples(m_volume, m_format, data, dest, len);
+        // Ramp from the volume of the previous write so that changes don't click
+        QAudioHelperInternal::qMultiplySamples(m_appliedVolume, m_volume, m_format, data, dest, len);
+        m_appliedVolume = m_volume;
         data = reinterpret_cast<char *>(dest);
     }
 
@@ -135,6 +135,7 @@ private:
     QString m_category;
 
     qreal m_volume;
+    qreal m_appliedVolume;
     pa_sample_spec m_spec;
 };
 
@@ -38,6 +38,7 @@
 #include <QtMultimedia/qvideorenderercontrol.h>
 #include <QtMultimedia/qmediaservice.h>
 #include <QtCore/qloggingcategory.h>
+#include <private/qabstractvideofilter_p.h>
 #include <private/qmediapluginloader_p.h>
 #include <private/qsgvideonode_p.h>
 
@@ -288,13 +289,26 @@ QSGNode *QDeclarativeVideoRendererBackend::updatePaintNode(QSGNode *oldNode,
         // Run the VideoFilter if there is one. This must be done before potentially changing the videonode below.
         if (m_frame.isValid() && !m_filters.isEmpty()) {
             const QVideoSurfaceFormat surfaceFormat = videoSurface()->surfaceFormat();
+            // System memory frame kept mapped for consecutive filters with a read only input
+            QVideoFilterInputMapping inputMapping;
             for (int i = 0; i < m_filters.count(); ++i) {
                 QAbstractVideoFilter *filter = m_filters[i].filter;
                 QVideoFilterRunnable *&runnable = m_filters[i].runnable;
                 if (filter && filter->isActive()) {
+                    const bool async = filter->executionMode() == QAbstractVideoFilter::Asynchronous;
+                    if (runnable && m_filters[i].async != async) {
+                        delete runnable;
+                        runnable = 0;
+                    }
+
                     // Create the filter runnable if not yet done. Ownership is taken and is tied to this thread, on which rendering happens.
-                    if (!runnable)
+                    if (!runnable) {
                         runnable = filter->createFilterRunnable();
+                        // Asynchronous runnables are invoked on a worker thread, rendering never waits for them
+                        if (runnable && async)
+                            runnable = new QAsyncVideoFilterRunnable(filter, runnable);
+                        m_filters[i].async = async;
+                    }
                     if (!runnable)
                         continue;
 
@@ -302,6 +316,8 @@ QSGNode *QDeclarativeVideoRendererBackend::updatePaintNode(QSGNode *oldNode,
                     if (i == m_filters.count() - 1)
                         flags |= QVideoFilterRunnable::LastInChain;
 
+                    flags |= inputMapping.update(m_frame, filter->isReadOnlyInput() && !async);
+
                     QVideoFrame newFrame = runnable->run(&m_frame, surfaceFormat, flags);
 
                     if (newFrame.isValid() && newFrame != m_frame) {
@@ -310,6 +326,8 @@ QSGNode *QDeclarativeVideoRendererBackend::updatePaintNode(QSGNode *oldNode,
                     }
                 }
             }
+
+            inputMapping.release();
         }
 
         if (videoNode && (videoNode->pixelFormat() != m_frame.pixelFormat() || videoNode->handleType() != m_frame.handleType())) {
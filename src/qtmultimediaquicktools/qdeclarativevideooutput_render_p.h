@@ -105,10 +105,11 @@ private:
     QRectF m_sourceTextureRect;    // Source texture coordinates
 
     struct Filter {
-        Filter() : filter(0), runnable(0) { }
-        Filter(QAbstractVideoFilter *filter) : filter(filter), runnable(0) { }
+        Filter() : filter(0), runnable(0), async(false) { }
+        Filter(QAbstractVideoFilter *filter) : filter(filter), runnable(0), async(false) { }
         QAbstractVideoFilter *filter;
         QVideoFilterRunnable *runnable;
+        bool async; // runnable is wrapped for asynchronous execution
     };
     QList<Filter> m_filters;
 };
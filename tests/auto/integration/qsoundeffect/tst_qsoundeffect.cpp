@@ -62,6 +62,8 @@ private slots:
 
     void testDestroyWhilePlaying();
     void testDestroyWhileRestartPlaying();
+    void testManyEffects();
+    void testLowLatency();
 
     void testSetSourceWhileLoading();
     void testSetSourceWhilePlaying();
@@ -325,6 +327,63 @@ void tst_QSoundEffect::testDestroyWhileRestartPlaying()
     QTestEventLoop::instance().enterLoop(1);
 }
 
+void tst_QSoundEffect::testManyEffects()
+{
+    // More effects than voices mixed at once
+    QList<QSoundEffect *> effects;
+    for (int i = 0; i < 40; ++i) {
+        QSoundEffect *effect = new QSoundEffect(this);
+        effect->setSource(i % 2 ? url : url2);
+        effect->setVolume(0.02f);
+        effects.append(effect);
+    }
+    for (int i = 0; i < effects.size(); ++i)
+        QTRY_COMPARE(effects.at(i)->status(), QSoundEffect::Ready);
+
+    for (int i = 0; i < effects.size(); ++i)
+        effects.at(i)->play();
+    QTRY_VERIFY(effects.last()->isPlaying());
+
+    // They all finish, whether they played to their end or were cut short
+    for (int i = 0; i < effects.size(); ++i)
+        QTRY_VERIFY_WITH_TIMEOUT(!effects.at(i)->isPlaying(), 10000);
+
+    // And they can play again afterwards
+    effects.first()->play();
+    QTRY_VERIFY(effects.first()->isPlaying());
+    effects.first()->stop();
+    QVERIFY(!effects.first()->isPlaying());
+
+    qDeleteAll(effects);
+}
+
+void tst_QSoundEffect::testLowLatency()
+{
+    QSoundEffect effect;
+    QCOMPARE(effect.isLowLatency(), false);
+    QCOMPARE(effect.latency(), qint64(-1));
+
+    QSignalSpy lowLatencySpy(&effect, SIGNAL(lowLatencyChanged()));
+    effect.setLowLatency(true);
+    QCOMPARE(effect.isLowLatency(), true);
+    QCOMPARE(lowLatencySpy.count(), 1);
+    effect.setLowLatency(true);
+    QCOMPARE(lowLatencySpy.count(), 1);
+
+    effect.setSource(url);
+    QTRY_COMPARE(effect.status(), QSoundEffect::Ready);
+
+    QSignalSpy latencySpy(&effect, SIGNAL(latencyChanged()));
+    effect.play();
+    QTRY_VERIFY(latencySpy.count() > 0);
+    QVERIFY(effect.latency() >= 0);
+
+    effect.stop();
+    effect.setLowLatency(false);
+    QCOMPARE(effect.isLowLatency(), false);
+    QCOMPARE(lowLatencySpy.count(), 2);
+}
+
 void tst_QSoundEffect::testSetSourceWhileLoading()
 {
     for (int i = 0; i < 10; i++) {
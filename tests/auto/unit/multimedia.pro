@@ -28,6 +28,11 @@ SUBDIRS += \
     qradiotuner \
     qvideoencodersettingscontrol \
     qvideoframe \
+    qvideoframepool \
+    qabstractvideofilter \
+    qmediaprobequeue \
+    qaudiohelpers \
+    qaudioresampler \
     qvideosurfaceformat \
     qwavedecoder \
     qaudiobuffer \
@@ -0,0 +1,8 @@
+CONFIG += testcase
+TARGET = tst_qabstractvideofilter
+
+QT += core multimedia-private testlib
+
+SOURCES += tst_qabstractvideofilter.cpp
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,350 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+
+#include <qabstractvideofilter.h>
+#include <private/qabstractvideofilter_p.h>
+
+class TestFilterRunnable : public QVideoFilterRunnable
+{
+public:
+    TestFilterRunnable(bool *deleted = 0)
+        : thread(0)
+        , runs(0)
+        , block(false)
+        , deleted(deleted)
+    {
+    }
+
+    ~TestFilterRunnable()
+    {
+        if (deleted)
+            *deleted = true;
+    }
+
+    QVideoFrame run(QVideoFrame *input, const QVideoSurfaceFormat &, RunFlags)
+    {
+        thread = QThread::currentThread();
+        started.release();
+        if (block)
+            proceed.acquire();
+        runs.ref();
+        return output.isValid() ? output : *input;
+    }
+
+    QThread *thread;
+    QAtomicInt runs;
+    bool block;
+    bool *deleted;
+    QVideoFrame output;
+    QSemaphore started;
+    QSemaphore proceed;
+};
+
+class AllocatingFilterRunnable : public QVideoFilterRunnable
+{
+public:
+    QVideoFrame run(QVideoFrame *input, const QVideoSurfaceFormat &, RunFlags)
+    {
+        return *input;
+    }
+
+    using QVideoFilterRunnable::allocateFrame;
+};
+
+// Reads its input in place, the way filters with a read only input may
+class ReadingFilterRunnable : public QVideoFilterRunnable
+{
+public:
+    ReadingFilterRunnable()
+        : bits(0)
+        , flags(0)
+        , mapped(false)
+    {
+    }
+
+    QVideoFrame run(QVideoFrame *input, const QVideoSurfaceFormat &, RunFlags runFlags)
+    {
+        flags = runFlags;
+        mapped = input->isMapped();
+        bits = input->bits();
+        return *input;
+    }
+
+    const uchar *bits;
+    RunFlags flags;
+    bool mapped;
+};
+
+class CountingVideoBuffer : public QAbstractVideoBuffer
+{
+public:
+    CountingVideoBuffer()
+        : QAbstractVideoBuffer(NoHandle)
+        , data(16 * 4, 0)
+        , mode(NotMapped)
+        , maps(0)
+    {
+    }
+
+    MapMode mapMode() const { return mode; }
+
+    uchar *map(MapMode mapMode, int *numBytes, int *bytesPerLine)
+    {
+        ++maps;
+        mode = mapMode;
+        if (numBytes)
+            *numBytes = data.size();
+        if (bytesPerLine)
+            *bytesPerLine = 16;
+        return reinterpret_cast<uchar *>(data.data());
+    }
+
+    void unmap() { mode = NotMapped; }
+
+    QByteArray data;
+    MapMode mode;
+    int maps;
+};
+
+class TestFilter : public QAbstractVideoFilter
+{
+public:
+    QVideoFilterRunnable *createFilterRunnable() { return new TestFilterRunnable; }
+};
+
+class tst_QAbstractVideoFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void executionMode();
+    void asyncRun();
+    void asyncResult();
+    void asyncDropFrames();
+    void readOnlyInput();
+    void allocateFrame();
+    void sharedInputMapping();
+};
+
+static const int MaximumRuns = 16;
+
+static QVideoFrame createFrame()
+{
+    return QVideoFrame(16 * 4 * 4, QSize(4, 4), 16, QVideoFrame::Format_RGB32);
+}
+
+void tst_QAbstractVideoFilter::executionMode()
+{
+    TestFilter filter;
+    QCOMPARE(filter.executionMode(), QAbstractVideoFilter::Synchronous);
+    QCOMPARE(filter.droppedFrames(), 0);
+
+    QSignalSpy spy(&filter, SIGNAL(executionModeChanged()));
+    filter.setExecutionMode(QAbstractVideoFilter::Asynchronous);
+    QCOMPARE(filter.executionMode(), QAbstractVideoFilter::Asynchronous);
+    QCOMPARE(spy.count(), 1);
+
+    filter.setExecutionMode(QAbstractVideoFilter::Asynchronous);
+    QCOMPARE(spy.count(), 1);
+
+    QCOMPARE(filter.property("executionMode").toInt(), int(QAbstractVideoFilter::Asynchronous));
+}
+
+void tst_QAbstractVideoFilter::asyncRun()
+{
+    TestFilter filter;
+    bool deleted = false;
+    TestFilterRunnable *runnable = new TestFilterRunnable(&deleted);
+
+    {
+        QAsyncVideoFilterRunnable async(&filter, runnable);
+
+        QVideoFrame frame = createFrame();
+        QCOMPARE(async.run(&frame, QVideoSurfaceFormat(), 0), frame);
+
+        QVERIFY(runnable->started.tryAcquire(1, 5000));
+        QVERIFY(runnable->thread != QThread::currentThread());
+        QTRY_COMPARE(runnable->runs.load(), 1);
+    }
+
+    QVERIFY(deleted);
+    QCOMPARE(filter.droppedFrames(), 0);
+}
+
+void tst_QAbstractVideoFilter::asyncResult()
+{
+    TestFilter filter;
+    TestFilterRunnable *runnable = new TestFilterRunnable;
+    QAsyncVideoFilterRunnable async(&filter, runnable);
+
+    // Frames passed through by the filter are rendered as they arrive
+    QVideoFrame first = createFrame();
+    QCOMPARE(async.run(&first, QVideoSurfaceFormat(), 0), first);
+    QTRY_COMPARE(runnable->runs.load(), 1);
+
+    QVideoFrame second = createFrame();
+    QCOMPARE(async.run(&second, QVideoSurfaceFormat(), 0), second);
+    QTRY_COMPARE(runnable->runs.load(), 2);
+
+    // Once the filter produced a frame of its own it replaces the incoming ones
+    const QVideoFrame output = createFrame();
+    runnable->output = output;
+    QVideoFrame third = createFrame();
+    async.run(&third, QVideoSurfaceFormat(), 0);
+    QTRY_COMPARE(async.run(&third, QVideoSurfaceFormat(), 0), output);
+}
+
+void tst_QAbstractVideoFilter::asyncDropFrames()
+{
+    TestFilter filter;
+    QSignalSpy spy(&filter, SIGNAL(droppedFramesChanged()));
+
+    TestFilterRunnable *runnable = new TestFilterRunnable;
+    runnable->block = true;
+
+    {
+        QAsyncVideoFilterRunnable async(&filter, runnable);
+
+        // The first frame keeps the worker busy
+        QVideoFrame frame = createFrame();
+        async.run(&frame, QVideoSurfaceFormat(), 0);
+        QVERIFY(runnable->started.tryAcquire(1, 5000));
+
+        for (int i = 0; i < QAsyncVideoFilterRunnable::MaximumQueuedFrames; ++i)
+            async.run(&frame, QVideoSurfaceFormat(), 0);
+        QCOMPARE(filter.droppedFrames(), 0);
+
+        // Rendering never waits, the oldest queued frames are dropped instead
+        async.run(&frame, QVideoSurfaceFormat(), 0);
+        async.run(&frame, QVideoSurfaceFormat(), 0);
+        QCOMPARE(filter.droppedFrames(), 2);
+        QTRY_COMPARE(spy.count(), 2);
+
+        // Let the worker finish whatever it picks up before it is stopped
+        runnable->proceed.release(MaximumRuns);
+    }
+
+    // The queued frames are discarded when the runnable is destroyed
+    QCOMPARE(filter.droppedFrames(), 2);
+}
+
+void tst_QAbstractVideoFilter::readOnlyInput()
+{
+    TestFilter filter;
+    QCOMPARE(filter.isReadOnlyInput(), false);
+
+    QSignalSpy spy(&filter, SIGNAL(readOnlyInputChanged()));
+    filter.setReadOnlyInput(true);
+    QCOMPARE(filter.isReadOnlyInput(), true);
+    QCOMPARE(spy.count(), 1);
+
+    filter.setReadOnlyInput(true);
+    QCOMPARE(spy.count(), 1);
+
+    QCOMPARE(filter.property("readOnlyInput").toBool(), true);
+}
+
+void tst_QAbstractVideoFilter::allocateFrame()
+{
+    AllocatingFilterRunnable runnable;
+
+    QVideoFrame frame = runnable.allocateFrame(QSize(64, 32), QVideoFrame::Format_ARGB32);
+    QVERIFY(frame.isValid());
+    QCOMPARE(frame.size(), QSize(64, 32));
+    QCOMPARE(frame.pixelFormat(), QVideoFrame::Format_ARGB32);
+    QCOMPARE(frame.handleType(), QAbstractVideoBuffer::NoHandle);
+
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+    const uchar *bits = frame.bits();
+    frame.unmap();
+
+    // Frames of another format are served alongside
+    QVideoFrame other = runnable.allocateFrame(QSize(64, 32), QVideoFrame::Format_YUV420P);
+    QVERIFY(other.isValid());
+    QCOMPARE(other.pixelFormat(), QVideoFrame::Format_YUV420P);
+
+    // The memory of released frames is reused
+    frame = QVideoFrame();
+    frame = runnable.allocateFrame(QSize(64, 32), QVideoFrame::Format_ARGB32);
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+    QCOMPARE(frame.bits(), bits);
+    frame.unmap();
+
+    QVERIFY(!runnable.allocateFrame(QSize(64, 32), QVideoFrame::Format_Jpeg).isValid());
+}
+
+void tst_QAbstractVideoFilter::sharedInputMapping()
+{
+    // Owned by the frame
+    CountingVideoBuffer *buffer = new CountingVideoBuffer;
+    QVideoFrame frame(buffer, QSize(4, 4), QVideoFrame::Format_RGB32);
+
+    ReadingFilterRunnable first;
+    ReadingFilterRunnable second;
+    QVideoFilterRunnable *chain[] = { &first, &second };
+
+    // Run like the VideoOutput runs consecutive filters with a read only input
+    QVideoFilterInputMapping mapping;
+    for (int i = 0; i < 2; ++i) {
+        const QVideoFilterRunnable::RunFlags flags = mapping.update(frame, true);
+        frame = chain[i]->run(&frame, QVideoSurfaceFormat(), flags);
+    }
+
+    QCOMPARE(buffer->maps, 1);
+    QCOMPARE(buffer->mapMode(), QAbstractVideoBuffer::ReadOnly);
+    QVERIFY(first.mapped);
+    QVERIFY(second.mapped);
+    QVERIFY(first.flags & QVideoFilterRunnable::InputMapped);
+    QVERIFY(second.flags & QVideoFilterRunnable::InputMapped);
+    QCOMPARE(first.bits, reinterpret_cast<const uchar *>(buffer->data.constData()));
+    QCOMPARE(second.bits, first.bits);
+
+    mapping.release();
+    QVERIFY(!frame.isMapped());
+    QCOMPARE(buffer->mapMode(), QAbstractVideoBuffer::NotMapped);
+
+    // A filter which may write to its input gets it unmapped
+    QVERIFY(mapping.update(frame, true) & QVideoFilterRunnable::InputMapped);
+    QCOMPARE(buffer->maps, 2);
+    QVERIFY(!(mapping.update(frame, false) & QVideoFilterRunnable::InputMapped));
+    QVERIFY(!frame.isMapped());
+}
+
+QTEST_MAIN(tst_QAbstractVideoFilter)
+
+#include "tst_qabstractvideofilter.moc"
@@ -1,4 +1,4 @@
-QT       += multimedia testlib
+QT       += multimedia-private testlib
 QT       -= gui
 
 TARGET = tst_qaudiobuffer
@@ -35,6 +35,7 @@
 #include <QtTest/QtTest>
 
 #include <qaudiobuffer.h>
+#include <private/qaudioconverter_p.h>
 
 class tst_QAudioBuffer : public QObject
 {
@@ -53,6 +54,17 @@ private Q_SLOTS:
     void durations();
     void durations_data();
     void stereoSample();
+    void convertSampleType_data();
+    void convertSampleType();
+    void convertChannels();
+    void convertByteOrder();
+    void convertUnsupported();
+    void convertSampleRate();
+    void convertKernels_data();
+    void convertKernels();
+    void externalData();
+    void externalWritableData();
+    void planarLayout();
 
 private:
     QAudioFormat mFormat;
@@ -396,6 +408,420 @@ void tst_QAudioBuffer::stereoSample()
     QCOMPARE(s32f.average(), 0.0f);
 }
 
+static QAudioFormat pcmFormat(int sampleSize, QAudioFormat::SampleType sampleType, int channels,
+                              QAudioFormat::Endian byteOrder = QAudioFormat::LittleEndian)
+{
+    QAudioFormat format;
+    format.setCodec("audio/pcm");
+    format.setSampleRate(8000);
+    format.setSampleSize(sampleSize);
+    format.setSampleType(sampleType);
+    format.setChannelCount(channels);
+    format.setByteOrder(byteOrder);
+    return format;
+}
+
+// Reads sample \a index of \a buffer scaled to [-1, 1]
+static qreal sampleAt(const QAudioBuffer &buffer, int index)
+{
+    const QAudioFormat format = buffer.format();
+    const uchar *data = buffer.constData<uchar>() + index * format.sampleSize() / 8;
+    const bool little = format.byteOrder() == QAudioFormat::LittleEndian;
+
+    switch (format.sampleSize()) {
+    case 8:
+        return format.sampleType() == QAudioFormat::UnSignedInt
+                ? (data[0] - 128) / 128.0
+                : qint8(data[0]) / 128.0;
+    case 16: {
+        const quint16 value = little ? qFromLittleEndian<quint16>(data) : qFromBigEndian<quint16>(data);
+        return format.sampleType() == QAudioFormat::UnSignedInt
+                ? (value - 32768) / 32768.0
+                : qint16(value) / 32768.0;
+    }
+    case 32: {
+        const quint32 value = little ? qFromLittleEndian<quint32>(data) : qFromBigEndian<quint32>(data);
+        if (format.sampleType() == QAudioFormat::Float) {
+            float f;
+            memcpy(&f, &value, sizeof(f));
+            return f;
+        }
+        return format.sampleType() == QAudioFormat::UnSignedInt
+                ? (qint64(value) - 2147483648LL) / 2147483648.0
+                : qint32(value) / 2147483648.0;
+    }
+    default:
+        return 0;
+    }
+}
+
+void tst_QAudioBuffer::convertSampleType_data()
+{
+    QTest::addColumn<QAudioFormat>("from");
+    QTest::addColumn<QAudioFormat>("to");
+
+    const QAudioFormat formats[] = {
+        pcmFormat(8, QAudioFormat::UnSignedInt, 2),
+        pcmFormat(8, QAudioFormat::SignedInt, 2),
+        pcmFormat(16, QAudioFormat::SignedInt, 2),
+        pcmFormat(16, QAudioFormat::UnSignedInt, 2),
+        pcmFormat(32, QAudioFormat::SignedInt, 2),
+        pcmFormat(32, QAudioFormat::UnSignedInt, 2),
+        pcmFormat(32, QAudioFormat::Float, 2)
+    };
+    const char *names[] = { "u8", "s8", "s16", "u16", "s32", "u32", "f32" };
+
+    for (int i = 0; i < 7; ++i) {
+        for (int j = 0; j < 7; ++j) {
+            if (i != j) {
+                QTest::newRow(QByteArray(names[i]).append(" to ").append(names[j]).constData())
+                        << formats[i] << formats[j];
+            }
+        }
+    }
+}
+
+void tst_QAudioBuffer::convertSampleType()
+{
+    QFETCH(QAudioFormat, from);
+    QFETCH(QAudioFormat, to);
+
+    // A ramp over the whole range, long enough for the vectorized kernels
+    const int frames = 100;
+    QAudioBuffer source(frames, from, 1234);
+    for (int i = 0; i < frames * 2; ++i) {
+        const qreal value = -1.0 + 2.0 * i / (frames * 2);
+        uchar *data = source.data<uchar>() + i * from.sampleSize() / 8;
+        switch (from.sampleSize()) {
+        case 8:
+            data[0] = from.sampleType() == QAudioFormat::UnSignedInt
+                    ? uchar(qRound(value * 128) + 128) : uchar(qint8(qRound(value * 128)));
+            break;
+        case 16: {
+            const qint16 v = qint16(qRound(value * 32768));
+            qToLittleEndian<quint16>(from.sampleType() == QAudioFormat::UnSignedInt ? quint16(v + 32768) : quint16(v), data);
+            break;
+        }
+        default:
+            if (from.sampleType() == QAudioFormat::Float) {
+                const float f = value;
+                memcpy(data, &f, sizeof(f));
+            } else {
+                const qint32 v = qint32(qRound64(value * 2147483648.0));
+                qToLittleEndian<quint32>(from.sampleType() == QAudioFormat::UnSignedInt ? quint32(v) ^ 0x80000000 : quint32(v), data);
+            }
+            break;
+        }
+    }
+
+    const QAudioBuffer result = source.convertToFormat(to);
+    QVERIFY(result.isValid());
+    QCOMPARE(result.format(), to);
+    QCOMPARE(result.frameCount(), frames);
+    QCOMPARE(result.startTime(), qint64(1234));
+
+    // Within one step of the coarser of both formats
+    const qreal tolerance = 1.0 / (1 << (qMin(from.sampleSize(), to.sampleSize()) == 8 ? 6 : 14));
+    for (int i = 0; i < frames * 2; ++i)
+        QVERIFY2(qAbs(sampleAt(result, i) - sampleAt(source, i)) <= tolerance, QByteArray::number(i));
+}
+
+void tst_QAudioBuffer::convertChannels()
+{
+    const int frames = 50;
+    QAudioBuffer stereo(frames, pcmFormat(16, QAudioFormat::SignedInt, 2));
+    qint16 *samples = stereo.data<qint16>();
+    for (int i = 0; i < frames; ++i) {
+        samples[2 * i] = qint16(i * 100);
+        samples[2 * i + 1] = qint16(-i * 50);
+    }
+
+    // Stereo to mono averages both channels
+    QAudioBuffer mono = stereo.convertToFormat(pcmFormat(16, QAudioFormat::SignedInt, 1));
+    QCOMPARE(mono.frameCount(), frames);
+    for (int i = 0; i < frames; ++i)
+        QCOMPARE(mono.constData<qint16>()[i], qint16(i * 25));
+
+    // Mono to stereo copies the sample to both channels
+    QAudioBuffer upmixed = mono.convertToFormat(pcmFormat(32, QAudioFormat::Float, 2));
+    for (int i = 0; i < frames; ++i) {
+        QCOMPARE(upmixed.constData<float>()[2 * i], i * 25 / 32768.0f);
+        QCOMPARE(upmixed.constData<float>()[2 * i + 1], i * 25 / 32768.0f);
+    }
+
+    // Stereo to four channels adds silent ones, and back drops them
+    QAudioBuffer quad = stereo.convertToFormat(pcmFormat(16, QAudioFormat::SignedInt, 4));
+    for (int i = 0; i < frames; ++i) {
+        QCOMPARE(quad.constData<qint16>()[4 * i], samples[2 * i]);
+        QCOMPARE(quad.constData<qint16>()[4 * i + 1], samples[2 * i + 1]);
+        QCOMPARE(quad.constData<qint16>()[4 * i + 2], qint16(0));
+        QCOMPARE(quad.constData<qint16>()[4 * i + 3], qint16(0));
+    }
+    QAudioBuffer back = quad.convertToFormat(stereo.format());
+    QCOMPARE(memcmp(back.constData(), stereo.constData(), stereo.byteCount()), 0);
+
+    // Six channels to mono averages all of them
+    QAudioBuffer six(frames, pcmFormat(8, QAudioFormat::UnSignedInt, 6));
+    uchar *bytes = six.data<uchar>();
+    for (int i = 0; i < frames * 6; ++i)
+        bytes[i] = uchar(128 + (i % 6) * 10);
+    mono = six.convertToFormat(pcmFormat(16, QAudioFormat::SignedInt, 1));
+    for (int i = 0; i < frames; ++i)
+        QCOMPARE(mono.constData<qint16>()[i], qint16(25 * 256));
+}
+
+void tst_QAudioBuffer::convertByteOrder()
+{
+    const int frames = 40;
+    QAudioBuffer little(frames, pcmFormat(16, QAudioFormat::SignedInt, 2, QAudioFormat::LittleEndian));
+    for (int i = 0; i < frames * 2; ++i)
+        qToLittleEndian<quint16>(quint16(i * 321), little.data<uchar>() + 2 * i);
+
+    QAudioBuffer big = little.convertToFormat(pcmFormat(16, QAudioFormat::SignedInt, 2, QAudioFormat::BigEndian));
+    QVERIFY(big.isValid());
+    for (int i = 0; i < frames * 2; ++i)
+        QCOMPARE(qFromBigEndian<quint16>(big.constData<uchar>() + 2 * i), quint16(i * 321));
+
+    // Swapping and converting at once
+    QAudioBuffer floats = big.convertToFormat(pcmFormat(32, QAudioFormat::Float, 2, QAudioFormat::BigEndian));
+    for (int i = 0; i < frames * 2; ++i) {
+        const quint32 bits = qFromBigEndian<quint32>(floats.constData<uchar>() + 4 * i);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        QCOMPARE(value, qint16(i * 321) / 32768.0f);
+    }
+}
+
+void tst_QAudioBuffer::convertUnsupported()
+{
+    const QAudioFormat format = pcmFormat(16, QAudioFormat::SignedInt, 2);
+    QAudioBuffer buffer(10, format);
+
+    QVERIFY(!QAudioBuffer().convertToFormat(format).isValid());
+    QVERIFY(!buffer.convertToFormat(QAudioFormat()).isValid());
+
+    QAudioFormat compressed = format;
+    compressed.setCodec("audio/mpeg");
+    QVERIFY(!buffer.convertToFormat(compressed).isValid());
+
+    QAudioFormat wide = format;
+    wide.setSampleSize(24);
+    QVERIFY(!buffer.convertToFormat(wide).isValid());
+
+    // The same format shares the data
+    QCOMPARE(buffer.convertToFormat(format).constData(), buffer.constData());
+}
+
+void tst_QAudioBuffer::convertSampleRate()
+{
+    // A 500 Hz sine at 8 kHz
+    const int frames = 800;
+    QAudioBuffer source(frames, pcmFormat(16, QAudioFormat::SignedInt, 1), 5000);
+    for (int i = 0; i < frames; ++i)
+        source.data<qint16>()[i] = qint16(qRound(16384 * qSin(2 * M_PI * 500 * i / 8000)));
+
+    QAudioFormat format = pcmFormat(32, QAudioFormat::Float, 2);
+    format.setSampleRate(48000);
+    const QAudioBuffer result = source.convertToFormat(format);
+    QVERIFY(result.isValid());
+    QCOMPARE(result.format(), format);
+    QCOMPARE(result.frameCount(), frames * 6);
+    QCOMPARE(result.startTime(), qint64(5000));
+    QCOMPARE(result.duration(), source.duration());
+
+    // Away from the edges, where the resampler sees silence around the buffer
+    const float *samples = result.constData<float>();
+    for (int i = 100; i < frames * 6 - 100; ++i) {
+        const float expected = 0.5f * qSin(2 * M_PI * 500 * i / 48000);
+        QVERIFY2(qAbs(samples[2 * i] - expected) < 2e-3, QByteArray::number(i));
+        QCOMPARE(samples[2 * i + 1], samples[2 * i]);
+    }
+}
+
+void tst_QAudioBuffer::convertKernels_data()
+{
+    QTest::addColumn<int>("kernel");
+
+    QTest::newRow("s16 to f32") << int(QAudioConvertS16ToF32);
+    QTest::newRow("f32 to s16") << int(QAudioConvertF32ToS16);
+    QTest::newRow("u8 to s16") << int(QAudioConvertU8ToS16);
+    QTest::newRow("s16 to u8") << int(QAudioConvertS16ToU8);
+    QTest::newRow("s32 to s16") << int(QAudioConvertS32ToS16);
+    QTest::newRow("s16 to s32") << int(QAudioConvertS16ToS32);
+    QTest::newRow("s32 to f32") << int(QAudioConvertS32ToF32);
+    QTest::newRow("f32 to s32") << int(QAudioConvertF32ToS32);
+    QTest::newRow("s16 stereo to mono") << int(QAudioConvertS16StereoToMono);
+    QTest::newRow("f32 stereo to mono") << int(QAudioConvertF32StereoToMono);
+    QTest::newRow("8 bit mono to stereo") << int(QAudioConvert8MonoToStereo);
+    QTest::newRow("16 bit mono to stereo") << int(QAudioConvert16MonoToStereo);
+    QTest::newRow("32 bit mono to stereo") << int(QAudioConvert32MonoToStereo);
+}
+
+void tst_QAudioBuffer::convertKernels()
+{
+    QFETCH(int, kernel);
+
+    AudioConvertFunc scalar = qt_audioConvertFunc(QAudioConvertKernel(kernel), QAudioConvertScalar);
+    QVERIFY(scalar);
+
+    AudioConvertFunc sse2 = qt_audioConvertFunc(QAudioConvertKernel(kernel), QAudioConvertSSE2);
+    if (!sse2)
+        QSKIP("SSE2 kernels are not available");
+
+    const bool floatInput = kernel == QAudioConvertF32ToS16 || kernel == QAudioConvertF32ToS32
+            || kernel == QAudioConvertF32StereoToMono;
+
+    // Every count up to a few vectors, to cover the leftover samples
+    for (int count = 0; count < 70; ++count) {
+        QByteArray input(count * 8, Qt::Uninitialized);
+        if (floatInput) {
+            float *samples = reinterpret_cast<float *>(input.data());
+            for (int i = 0; i < count * 2; ++i)
+                samples[i] = float((qrand() % 5001) - 2500) / 1000.0f;
+        } else {
+            for (int i = 0; i < input.size(); ++i)
+                input[i] = char(qrand());
+        }
+
+        QByteArray expected(count * 8, '\0');
+        QByteArray actual(count * 8, '\0');
+        scalar(input.constData(), expected.data(), count);
+        sse2(input.constData(), actual.data(), count);
+        QCOMPARE(actual, expected);
+    }
+}
+
+static void countCleanup(void *cleanupInfo)
+{
+    ++*static_cast<int *>(cleanupInfo);
+}
+
+void tst_QAudioBuffer::externalData()
+{
+    const QAudioFormat format = pcmFormat(16, QAudioFormat::SignedInt, 2);
+    qint16 samples[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    int cleanups = 0;
+
+    {
+        QAudioBuffer buffer(static_cast<const void *>(samples), 4, format,
+                            QAudioBuffer::InterleavedLayout, 1000, countCleanup, &cleanups);
+        QVERIFY(buffer.isValid());
+        QCOMPARE(buffer.frameCount(), 4);
+        QCOMPARE(buffer.byteCount(), 16);
+        QCOMPARE(buffer.startTime(), qint64(1000));
+        QCOMPARE(buffer.constData(), static_cast<const void *>(samples));
+
+        // Copies share the memory
+        QAudioBuffer copy(buffer);
+        QCOMPARE(copy.constData(), static_cast<const void *>(samples));
+        QAudioBuffer assigned;
+        assigned = copy;
+        QCOMPARE(assigned.constData(), static_cast<const void *>(samples));
+
+        // Writing to read-only memory makes a copy
+        qint16 *data = copy.data<qint16>();
+        QVERIFY(data != samples);
+        QCOMPARE(data[7], qint16(8));
+        data[0] = 10;
+        QCOMPARE(samples[0], qint16(1));
+        QCOMPARE(cleanups, 0);
+    }
+    QCOMPARE(cleanups, 1);
+
+    // Invalid buffers hand the memory straight back
+    QAudioBuffer noData(static_cast<const void *>(0), 4, format,
+                        QAudioBuffer::InterleavedLayout, -1, countCleanup, &cleanups);
+    QVERIFY(!noData.isValid());
+    QCOMPARE(cleanups, 2);
+
+    QAudioBuffer noFormat(static_cast<const void *>(samples), 4, QAudioFormat(),
+                          QAudioBuffer::InterleavedLayout, -1, countCleanup, &cleanups);
+    QVERIFY(!noFormat.isValid());
+    QCOMPARE(cleanups, 3);
+}
+
+void tst_QAudioBuffer::externalWritableData()
+{
+    const QAudioFormat format = pcmFormat(16, QAudioFormat::SignedInt, 2);
+    qint16 samples[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    int cleanups = 0;
+
+    {
+        QAudioBuffer buffer(static_cast<void *>(samples), 4, format,
+                            QAudioBuffer::InterleavedLayout, -1, countCleanup, &cleanups);
+
+        // The only copy writes to the memory directly
+        QCOMPARE(buffer.data(), static_cast<void *>(samples));
+        buffer.data<qint16>()[0] = 10;
+        QCOMPARE(samples[0], qint16(10));
+
+        // A shared copy detaches, the other one keeps the memory
+        QAudioBuffer copy(buffer);
+        QVERIFY(copy.data() != static_cast<void *>(samples));
+        QCOMPARE(copy.constData<qint16>()[0], qint16(10));
+        QCOMPARE(buffer.data(), static_cast<void *>(samples));
+        QCOMPARE(cleanups, 0);
+
+        // Detaching the last copy releases the memory
+        buffer = copy;
+        QCOMPARE(cleanups, 1);
+    }
+    QCOMPARE(cleanups, 1);
+}
+
+void tst_QAudioBuffer::planarLayout()
+{
+    const QAudioFormat format = pcmFormat(16, QAudioFormat::SignedInt, 2);
+    const qint16 planar[8] = {1, 2, 3, 4, -1, -2, -3, -4};
+
+    QAudioBuffer buffer(static_cast<const void *>(planar), 4, format, QAudioBuffer::PlanarLayout, 500);
+    QVERIFY(buffer.isValid());
+    QCOMPARE(buffer.channelLayout(), QAudioBuffer::PlanarLayout);
+    QCOMPARE(buffer.sampleCount(), 8);
+    QCOMPARE(buffer.sampleStride(), 2);
+    QCOMPARE(buffer.constChannelData<qint16>(0), planar);
+    QCOMPARE(buffer.constChannelData<qint16>(1), planar + 4);
+    QVERIFY(!buffer.constChannelData(2));
+    QVERIFY(!buffer.constChannelData(-1));
+
+    // Interleave and back
+    const QAudioBuffer interleaved = buffer.convertToLayout(QAudioBuffer::InterleavedLayout);
+    QCOMPARE(interleaved.channelLayout(), QAudioBuffer::InterleavedLayout);
+    QCOMPARE(interleaved.format(), format);
+    QCOMPARE(interleaved.startTime(), qint64(500));
+    QCOMPARE(interleaved.sampleStride(), 4);
+    const qint16 *samples = interleaved.constData<qint16>();
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE(samples[2 * i], qint16(i + 1));
+        QCOMPARE(samples[2 * i + 1], qint16(-i - 1));
+    }
+    QCOMPARE(interleaved.constChannelData<qint16>(1), samples + 1);
+
+    const QAudioBuffer planarAgain = interleaved.convertToLayout(QAudioBuffer::PlanarLayout);
+    QCOMPARE(QByteArray(planarAgain.constData<char>(), planarAgain.byteCount()),
+             QByteArray(reinterpret_cast<const char *>(planar), sizeof(planar)));
+    QCOMPARE(buffer.convertToLayout(QAudioBuffer::PlanarLayout).constData(), buffer.constData());
+
+    // Format conversion always gives interleaved samples
+    const QAudioBuffer converted = buffer.convertToFormat(format);
+    QCOMPARE(converted.channelLayout(), QAudioBuffer::InterleavedLayout);
+    QCOMPARE(QByteArray(converted.constData<char>(), converted.byteCount()),
+             QByteArray(interleaved.constData<char>(), interleaved.byteCount()));
+
+    const QAudioBuffer floats = buffer.convertToFormat(pcmFormat(32, QAudioFormat::Float, 2));
+    QVERIFY(floats.isValid());
+    QCOMPARE(floats.constData<float>()[1], -1.0f / 32768);
+
+    // Owned planar buffers, written per channel
+    QAudioBuffer owned(4, format, QAudioBuffer::PlanarLayout);
+    QCOMPARE(owned.channelLayout(), QAudioBuffer::PlanarLayout);
+    QCOMPARE(owned.byteCount(), 16);
+    qint16 *right = owned.channelData<qint16>(1);
+    QVERIFY(right);
+    right[3] = 7;
+    QCOMPARE(owned.constData<qint16>()[7], qint16(7));
+    QCOMPARE(owned.convertToLayout(QAudioBuffer::InterleavedLayout).constData<qint16>()[7], qint16(7));
+}
 
 QTEST_APPLESS_MAIN(tst_QAudioBuffer);
 
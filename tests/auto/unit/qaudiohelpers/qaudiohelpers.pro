@@ -0,0 +1,8 @@
+CONFIG += testcase
+TARGET = tst_qaudiohelpers
+
+QT += core multimedia-private testlib
+
+SOURCES += tst_qaudiohelpers.cpp
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
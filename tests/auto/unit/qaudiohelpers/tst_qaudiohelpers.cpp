@@ -0,0 +1,236 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+
+#include <private/qaudiohelpers_p.h>
+
+#include <limits>
+
+using namespace QAudioHelperInternal;
+
+class tst_QAudioHelpers : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void unityGain();
+    void constantGain();
+    void gainRamp();
+    void unsignedGainRamp();
+    void gainLevels_data();
+    void gainLevels();
+};
+
+static QAudioFormat audioFormat(int sampleSize, QAudioFormat::SampleType sampleType, int channels)
+{
+    QAudioFormat format;
+    format.setSampleRate(48000);
+    format.setChannelCount(channels);
+    format.setSampleSize(sampleSize);
+    format.setSampleType(sampleType);
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setCodec(QStringLiteral("audio/pcm"));
+    return format;
+}
+
+void tst_QAudioHelpers::unityGain()
+{
+    const QAudioFormat format = audioFormat(16, QAudioFormat::SignedInt, 2);
+    const qint16 samples[] = { 1000, -1000, 32767, -32768, 5, -5 };
+
+    qint16 output[6] = { 0 };
+    qMultiplySamples(1.0, format, samples, output, sizeof(samples));
+    QCOMPARE(memcmp(output, samples, sizeof(samples)), 0);
+
+    qint16 inPlace[6];
+    memcpy(inPlace, samples, sizeof(samples));
+    qMultiplySamples(1.0, 1.0, format, inPlace, inPlace, sizeof(samples));
+    QCOMPARE(memcmp(inPlace, samples, sizeof(samples)), 0);
+}
+
+void tst_QAudioHelpers::constantGain()
+{
+    const QAudioFormat format = audioFormat(16, QAudioFormat::SignedInt, 1);
+
+    QVector<qint16> samples(100);
+    for (int i = 0; i < samples.size(); ++i)
+        samples[i] = (i - 50) * 100;
+
+    QVector<qint16> output(samples.size());
+    qMultiplySamples(0.5, format, samples.constData(), output.data(), samples.size() * 2);
+    for (int i = 0; i < samples.size(); ++i)
+        QCOMPARE(output.at(i), qint16(samples.at(i) / 2));
+
+    const QAudioFormat floatFormat = audioFormat(32, QAudioFormat::Float, 2);
+    QVector<float> floatSamples(66, 0.5f);
+    qMultiplySamples(0.25, floatFormat, floatSamples.constData(), floatSamples.data(), floatSamples.size() * 4);
+    for (int i = 0; i < floatSamples.size(); ++i)
+        QCOMPARE(floatSamples.at(i), 0.125f);
+}
+
+void tst_QAudioHelpers::gainRamp()
+{
+    // The ramp goes from the start factor on the first frame towards the end
+    // factor, reached right after the last frame
+    const QAudioFormat format = audioFormat(16, QAudioFormat::SignedInt, 2);
+    const qint16 samples[] = { 1000, -1000, 1000, -1000, 1000, -1000, 1000, -1000 };
+
+    qint16 output[8];
+    qMultiplySamples(1.0, 0.0, format, samples, output, sizeof(samples));
+    const qint16 expected[] = { 1000, -1000, 750, -750, 500, -500, 250, -250 };
+    QCOMPARE(memcmp(output, expected, sizeof(expected)), 0);
+
+    // Channel counts that don't fit in SIMD registers are ramped as well
+    const QAudioFormat surround = audioFormat(32, QAudioFormat::Float, 6);
+    QVector<float> frames(6 * 100, 1.0f);
+    qMultiplySamples(0.0, 1.0, surround, frames.constData(), frames.data(), frames.size() * 4);
+    for (int frame = 0; frame < 100; ++frame) {
+        for (int channel = 0; channel < 6; ++channel)
+            QVERIFY(qAbs(frames.at(frame * 6 + channel) - frame / 100.0f) < 1e-6f);
+    }
+}
+
+void tst_QAudioHelpers::unsignedGainRamp()
+{
+    const QAudioFormat format = audioFormat(8, QAudioFormat::UnSignedInt, 1);
+    const quint8 samples[] = { 0x80 + 100, 0x80 - 100, 0x80 + 100, 0x80 - 100 };
+
+    quint8 output[4];
+    qMultiplySamples(0.0, 1.0, format, samples, output, sizeof(samples));
+    const quint8 expected[] = { 0x80, 0x80 - 25, 0x80 + 50, 0x80 - 75 };
+    QCOMPARE(memcmp(output, expected, sizeof(expected)), 0);
+}
+
+void tst_QAudioHelpers::gainLevels_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<int>("channels");
+    QTest::addColumn<qreal>("startFactor");
+    QTest::addColumn<qreal>("endFactor");
+
+    static const char *formatNames[] = { "int16", "int32", "float" };
+    const int channelCounts[] = { 1, 2, 6, 8 };
+
+    for (int format = 0; format < NGainFormats; ++format) {
+        for (int c = 0; c < 4; ++c) {
+            const int channels = channelCounts[c];
+            QTest::newRow(QByteArray(formatNames[format]) + ' ' + QByteArray::number(channels) + "ch constant")
+                    << format << channels << qreal(0.7) << qreal(0.7);
+            QTest::newRow(QByteArray(formatNames[format]) + ' ' + QByteArray::number(channels) + "ch ramp")
+                    << format << channels << qreal(0.9) << qreal(0.1);
+        }
+    }
+}
+
+// Inputs spanning the whole range of each sample type
+template <typename T> static T gainInput(int i);
+
+template <> qint16 gainInput<qint16>(int i)
+{
+    return qint16((i * 7919) % 65536 - 32768);
+}
+
+template <> qint32 gainInput<qint32>(int i)
+{
+    // Full scale samples, where a float mantissa is not enough
+    if (i < 2)
+        return i == 0 ? std::numeric_limits<qint32>::min() : std::numeric_limits<qint32>::max();
+    return qint32(quint32(i) * 2654435761u);
+}
+
+template <> float gainInput<float>(int i)
+{
+    return gainInput<qint16>(i) / 32768.0f;
+}
+
+template <typename T>
+static void compareLevels(SampleGainFormat format, int channels, qreal factor, qreal step, double tolerance)
+{
+    // An odd length exercises the leftovers of every kernel
+    const int samples = channels * 301 + 1;
+    QVector<T> input(samples);
+    QVector<double> expected(samples);
+    for (int i = 0; i < samples; ++i) {
+        input[i] = gainInput<T>(i);
+        expected[i] = double(input.at(i)) * (factor + step * (i / channels));
+    }
+
+    for (int level = GainScalar; level <= GainAVX2; ++level) {
+        SampleGainFunc func = qSampleGainFunc(format, SampleGainLevel(level));
+        if (!func)
+            continue;
+
+        QVector<T> output(samples);
+        func(input.constData(), output.data(), samples, channels, factor, step);
+        for (int i = 0; i < samples; ++i) {
+            if (qAbs(double(output.at(i)) - expected.at(i)) > tolerance)
+                QFAIL(qPrintable(QString::fromLatin1("level %1 differs at sample %2: %3 instead of %4")
+                                 .arg(level).arg(i).arg(double(output.at(i)), 0, 'g', 12)
+                                 .arg(expected.at(i), 0, 'g', 12)));
+        }
+    }
+}
+
+void tst_QAudioHelpers::gainLevels()
+{
+    QFETCH(int, format);
+    QFETCH(int, channels);
+    QFETCH(qreal, startFactor);
+    QFETCH(qreal, endFactor);
+
+    const qreal step = (endFactor - startFactor) / 301;
+
+    // Every kernel is held to a double precision reference; integer samples
+    // are truncated, float ones are multiplied in single precision
+    switch (format) {
+    case GainInt16:
+        compareLevels<qint16>(GainInt16, channels, startFactor, step, 1);
+        break;
+    case GainInt32:
+        // Ramp gains stepped per block may round an ulp apart across an
+        // integer, while single precision would be off by about 128
+        compareLevels<qint32>(GainInt32, channels, startFactor, step, 1.001);
+        break;
+    case GainFloat:
+        compareLevels<float>(GainFloat, channels, startFactor, step, 1e-6);
+        break;
+    }
+}
+
+QTEST_GUILESS_MAIN(tst_QAudioHelpers)
+
+#include "tst_qaudiohelpers.moc"
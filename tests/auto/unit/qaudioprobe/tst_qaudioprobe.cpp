@@ -36,6 +36,7 @@
 
 #include <qaudioprobe.h>
 #include <qaudiorecorder.h>
+#include <private/qmediaaudioprobecontrol_p.h>
 
 //TESTED_COMPONENT=src/multimedia
 
@@ -60,6 +61,7 @@ private slots:
     void testRecorderDeleteRecorder();
     void testRecorderDeleteProbe();
     void testMediaObject();
+    void testDeliveryPolicy();
 
 private:
     QAudioRecorder *recorder;
@@ -183,6 +185,48 @@ void tst_QAudioProbe::testMediaObject()
     delete object;
 }
 
+void tst_QAudioProbe::testDeliveryPolicy()
+{
+    recorder = new QAudioRecorder;
+    QMediaAudioProbeControlPrivate *control =
+            QMediaAudioProbeControlPrivate::get(mockMediaRecorderService->mockAudioProbeControl);
+
+    QAudioProbe probe;
+    QCOMPARE(probe.deliveryPolicy(), QMultimedia::LatestOnlyDelivery);
+    QVERIFY(probe.queueCapacity() > 0);
+    QCOMPARE(probe.droppedCount(), 0);
+    QCOMPARE(probe.queueHighWaterMark(), 0);
+
+    probe.setDeliveryPolicy(QMultimedia::DropOldestQueueDelivery);
+    probe.setQueueCapacity(2);
+    QVERIFY(probe.setSource(recorder));
+    QCOMPARE(control->queue.policy(), QMultimedia::DropOldestQueueDelivery);
+    QCOMPARE(control->queue.capacity(), 2);
+
+    // The least lossy policy requested by the probes applies
+    QAudioProbe *other = new QAudioProbe;
+    other->setDeliveryPolicy(QMultimedia::BlockingQueueDelivery);
+    other->setQueueCapacity(1);
+    QVERIFY(other->setSource(recorder));
+    QCOMPARE(control->queue.policy(), QMultimedia::BlockingQueueDelivery);
+    QCOMPARE(control->queue.capacity(), 2);
+    delete other;
+    QCOMPARE(control->queue.policy(), QMultimedia::DropOldestQueueDelivery);
+
+    const QAudioBuffer buffer(QByteArray(64, 0), QAudioFormat());
+    for (int i = 0; i < 3; ++i)
+        control->queue.enqueue(buffer);
+    QCOMPARE(probe.droppedCount(), 1);
+    QCOMPARE(probe.queueHighWaterMark(), 2);
+
+    probe.resetStatistics();
+    QCOMPARE(probe.droppedCount(), 0);
+
+    probe.setSource((QMediaRecorder*)0);
+    QCOMPARE(control->queue.policy(), QMultimedia::LatestOnlyDelivery);
+    QCOMPARE(probe.droppedCount(), 0);
+}
+
 QTEST_GUILESS_MAIN(tst_QAudioProbe)
 
 #include "tst_qaudioprobe.moc"
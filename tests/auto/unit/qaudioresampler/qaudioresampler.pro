@@ -0,0 +1,8 @@
+CONFIG += testcase
+TARGET = tst_qaudioresampler
+
+QT += core multimedia-private testlib
+
+SOURCES += tst_qaudioresampler.cpp
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,274 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+
+#include <private/qaudioresampler_p.h>
+
+Q_DECLARE_METATYPE(QAudioResampler::Quality)
+
+class tst_QAudioResampler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void invalid();
+    void sine_data();
+    void sine();
+    void streaming();
+    void equalRates();
+    void flush();
+    void latency();
+    void dotLevels();
+};
+
+// A sine of amplitude 0.5 with a different phase on each channel
+static QVector<float> sineWave(int frames, int channels, int rate, qreal frequency)
+{
+    QVector<float> samples(frames * channels);
+    for (int i = 0; i < frames; ++i) {
+        for (int c = 0; c < channels; ++c)
+            samples[i * channels + c] = 0.5 * qSin(2 * M_PI * frequency * i / rate + c);
+    }
+    return samples;
+}
+
+// Resamples all of input, passing it in chunks of chunkFrames frames
+static QVector<float> resample(QAudioResampler &resampler, const QVector<float> &input, int chunkFrames)
+{
+    const int channels = resampler.channelCount();
+    const int frames = input.size() / channels;
+
+    QVector<float> output;
+    for (int done = 0; done < frames; done += chunkFrames) {
+        const int chunk = qMin(chunkFrames, frames - done);
+        QVector<float> block(resampler.maximumOutputFrames(chunk) * channels);
+        const int written = resampler.process(input.constData() + done * channels, chunk,
+                                              block.data(), resampler.maximumOutputFrames(chunk));
+        output += block.mid(0, written * channels);
+    }
+
+    const int pending = resampler.maximumOutputFrames(resampler.latencyFrames());
+    QVector<float> block(pending * channels);
+    const int written = resampler.flush(block.data(), pending);
+    output += block.mid(0, written * channels);
+    return output;
+}
+
+void tst_QAudioResampler::invalid()
+{
+    QAudioResampler resampler;
+    QVERIFY(!resampler.isValid());
+
+    resampler.setup(0, 48000, 2);
+    QVERIFY(!resampler.isValid());
+    resampler.setup(44100, 48000, 0);
+    QVERIFY(!resampler.isValid());
+
+    float samples[4] = { 0 };
+    QCOMPARE(resampler.process(samples, 2, samples, 2), 0);
+    QCOMPARE(resampler.flush(samples, 2), 0);
+
+    resampler.setup(44100, 48000, 2);
+    QVERIFY(resampler.isValid());
+}
+
+void tst_QAudioResampler::sine_data()
+{
+    QTest::addColumn<int>("inputRate");
+    QTest::addColumn<int>("outputRate");
+    QTest::addColumn<QAudioResampler::Quality>("quality");
+    QTest::addColumn<qreal>("tolerance");
+
+    const int rates[][2] = {
+        { 44100, 48000 },
+        { 48000, 44100 },
+        { 8000, 48000 },
+        { 48000, 8000 },
+        { 22050, 44100 },
+        { 44100, 48001 }
+    };
+    for (unsigned i = 0; i < sizeof(rates) / sizeof(rates[0]); ++i) {
+        const QByteArray name = QByteArray::number(rates[i][0]) + " to " + QByteArray::number(rates[i][1]);
+        QTest::newRow((name + ", fast").constData())
+                << rates[i][0] << rates[i][1] << QAudioResampler::FastQuality << 5e-3;
+        QTest::newRow((name + ", medium").constData())
+                << rates[i][0] << rates[i][1] << QAudioResampler::MediumQuality << 1e-3;
+        QTest::newRow((name + ", high").constData())
+                << rates[i][0] << rates[i][1] << QAudioResampler::HighQuality << 2e-4;
+    }
+}
+
+void tst_QAudioResampler::sine()
+{
+    QFETCH(int, inputRate);
+    QFETCH(int, outputRate);
+    QFETCH(QAudioResampler::Quality, quality);
+    QFETCH(qreal, tolerance);
+
+    const int channels = 2;
+    const int frames = 10000;
+    const qreal frequency = 1000;
+
+    QAudioResampler resampler(inputRate, outputRate, channels, quality);
+    QVERIFY(resampler.isValid());
+
+    const QVector<float> output = resample(resampler, sineWave(frames, channels, inputRate, frequency), 333);
+    const int outputFrames = output.size() / channels;
+    QCOMPARE(qint64(outputFrames), QAudioResampler::outputFrameCount(frames, inputRate, outputRate));
+
+    // The output is aligned with the input, away from the silence around it
+    const QVector<float> expected = sineWave(outputFrames, channels, outputRate, frequency);
+    const int margin = resampler.filterLength() * outputRate / inputRate + 1;
+    qreal error = 0;
+    for (int i = margin * channels; i < (outputFrames - margin) * channels; ++i)
+        error = qMax(error, qreal(qAbs(output[i] - expected[i])));
+    QVERIFY2(error < tolerance, QByteArray::number(error));
+}
+
+void tst_QAudioResampler::streaming()
+{
+    // The output does not depend on how the input is split
+    const QVector<float> input = sineWave(5000, 2, 44100, 440);
+
+    QAudioResampler resampler(44100, 48000, 2);
+    const QVector<float> whole = resample(resampler, input, 5000);
+
+    const int chunks[] = { 1, 7, 128, 1023, 4999 };
+    for (unsigned i = 0; i < sizeof(chunks) / sizeof(chunks[0]); ++i) {
+        resampler.reset();
+        QCOMPARE(resample(resampler, input, chunks[i]), whole);
+    }
+
+    // Output which does not fit comes with the next calls
+    resampler.reset();
+    QVector<float> output(whole.size());
+    int written = resampler.process(input.constData(), 5000, output.data(), 100);
+    QCOMPARE(written, 100);
+    written += resampler.process(input.constData(), 0, output.data() + written * 2, 5000);
+    written += resampler.flush(output.data() + written * 2, 5000);
+    QCOMPARE(output, whole);
+}
+
+void tst_QAudioResampler::equalRates()
+{
+    const QVector<float> input = sineWave(1000, 1, 48000, 440);
+
+    QAudioResampler resampler(48000, 48000, 1, QAudioResampler::HighQuality);
+    const QVector<float> output = resample(resampler, input, 100);
+    QCOMPARE(output.size(), input.size());
+    for (int i = 0; i < input.size(); ++i)
+        QVERIFY(qAbs(output[i] - input[i]) < 1e-6);
+}
+
+void tst_QAudioResampler::flush()
+{
+    QAudioResampler resampler(8000, 48000, 1);
+    const QVector<float> input(100, 0.25f);
+
+    QVector<float> output(600);
+    const int written = resampler.process(input.constData(), 100, output.data(), 600);
+    QVERIFY(written < 600);
+
+    // Draining in small pieces
+    int flushed = 0;
+    int count;
+    while ((count = resampler.flush(output.data() + written + flushed, 7)) > 0) {
+        QVERIFY(count <= 7);
+        flushed += count;
+    }
+    QCOMPARE(written + flushed, 600);
+
+    // Nothing more until it is reset
+    QCOMPARE(resampler.process(input.constData(), 100, output.data(), 600), 0);
+    resampler.reset();
+    QVERIFY(resampler.process(input.constData(), 100, output.data(), 600) > 0);
+}
+
+void tst_QAudioResampler::latency()
+{
+    for (int quality = QAudioResampler::FastQuality; quality <= QAudioResampler::HighQuality; ++quality) {
+        QAudioResampler resampler(44100, 48000, 2, QAudioResampler::Quality(quality));
+        QCOMPARE(resampler.latencyFrames(), resampler.filterLength() / 2);
+        QCOMPARE(resampler.latency(), qint64(resampler.latencyFrames()) * 1000000 / 44100);
+
+        // Longer filters for better quality
+        if (quality > QAudioResampler::FastQuality) {
+            QAudioResampler lower(44100, 48000, 2, QAudioResampler::Quality(quality - 1));
+            QVERIFY(resampler.filterLength() > lower.filterLength());
+        }
+
+        // The first frame comes once the latency is covered, and not later
+        const QVector<float> input(2 * 200, 0.0f);
+        QVector<float> output(2 * 300);
+        const int held = resampler.latencyFrames();
+        QCOMPARE(resampler.process(input.constData(), held, output.data(), 300), 0);
+        QVERIFY(resampler.process(input.constData(), 1, output.data(), 300) > 0);
+
+        // And it stays the same while streaming
+        for (int i = 0; i < 10; ++i) {
+            resampler.process(input.constData(), 200, output.data(), 300);
+            QCOMPARE(resampler.latencyFrames(), resampler.filterLength() / 2);
+        }
+    }
+}
+
+void tst_QAudioResampler::dotLevels()
+{
+    AudioResampleDotFunc scalar = qt_audioResampleDotFunc(QAudioResampleScalar);
+    QVERIFY(scalar);
+
+    QVector<float> samples(64);
+    QVector<float> coefficients(64);
+    for (int i = 0; i < 64; ++i) {
+        samples[i] = qSin(i);
+        coefficients[i] = qCos(i * 0.3) / 16;
+    }
+
+    const QAudioResampleLevel levels[] = { QAudioResampleSSE2, QAudioResampleAVX2 };
+    for (unsigned i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+        AudioResampleDotFunc dot = qt_audioResampleDotFunc(levels[i]);
+        if (!dot)
+            continue;
+        for (int count = 8; count <= 64; count += 8)
+            QVERIFY(qAbs(dot(samples.constData(), coefficients.constData(), count)
+                         - scalar(samples.constData(), coefficients.constData(), count)) < 1e-5);
+    }
+}
+
+QTEST_GUILESS_MAIN(tst_QAudioResampler)
+
+#include "tst_qaudioresampler.moc"
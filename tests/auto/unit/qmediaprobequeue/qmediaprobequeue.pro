@@ -0,0 +1,8 @@
+CONFIG += testcase
+TARGET = tst_qmediaprobequeue
+
+QT += core multimedia-private testlib
+
+SOURCES += tst_qmediaprobequeue.cpp
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,206 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+
+#include <private/qmediaprobequeue_p.h>
+
+class Producer : public QThread
+{
+public:
+    Producer(QMediaProbeQueue<int> *queue, int count)
+        : queue(queue)
+        , count(count)
+    {
+    }
+
+    void run()
+    {
+        for (int i = 0; i < count; ++i) {
+            queue->enqueue(i);
+            produced.ref();
+        }
+    }
+
+    QMediaProbeQueue<int> *queue;
+    int count;
+    QAtomicInt produced;
+};
+
+class tst_QMediaProbeQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void latestOnly();
+    void dropOldest();
+    void blocking();
+    void flushing();
+    void statistics();
+};
+
+void tst_QMediaProbeQueue::latestOnly()
+{
+    QMediaProbeQueue<int> queue;
+    QCOMPARE(queue.policy(), QMultimedia::LatestOnlyDelivery);
+
+    // Only the first item needs the consumer to be notified
+    QVERIFY(queue.enqueue(1));
+    QVERIFY(!queue.enqueue(2));
+    QVERIFY(!queue.enqueue(3));
+
+    int item = 0;
+    bool more = true;
+    QVERIFY(queue.dequeue(&item, &more));
+    QCOMPARE(item, 3);
+    QVERIFY(!more);
+    QVERIFY(!queue.dequeue(&item));
+
+    QCOMPARE(queue.droppedCount(), 2);
+    QCOMPARE(queue.highWaterMark(), 1);
+}
+
+void tst_QMediaProbeQueue::dropOldest()
+{
+    QMediaProbeQueue<int> queue;
+    queue.setPolicy(QMultimedia::DropOldestQueueDelivery, 3);
+
+    for (int i = 0; i < 5; ++i)
+        queue.enqueue(i);
+
+    QCOMPARE(queue.droppedCount(), 2);
+    QCOMPARE(queue.highWaterMark(), 3);
+
+    int item = 0;
+    bool more = false;
+    QVERIFY(queue.dequeue(&item, &more));
+    QCOMPARE(item, 2);
+    QVERIFY(more);
+    QVERIFY(queue.dequeue(&item, &more));
+    QCOMPARE(item, 3);
+    QVERIFY(queue.dequeue(&item, &more));
+    QCOMPARE(item, 4);
+    QVERIFY(!more);
+
+    // Shrinking the queue drops the oldest items beyond the new capacity
+    for (int i = 0; i < 3; ++i)
+        queue.enqueue(i);
+    queue.setPolicy(QMultimedia::DropOldestQueueDelivery, 1);
+    QCOMPARE(queue.droppedCount(), 4);
+    QVERIFY(queue.dequeue(&item));
+    QCOMPARE(item, 2);
+}
+
+void tst_QMediaProbeQueue::blocking()
+{
+    QMediaProbeQueue<int> queue;
+    queue.setPolicy(QMultimedia::BlockingQueueDelivery, 2);
+
+    Producer producer(&queue, 10);
+    producer.start();
+
+    // The producer waits for room in the queue, nothing is lost
+    QTRY_COMPARE(producer.produced.load(), 2);
+    QTest::qWait(50);
+    QCOMPARE(producer.produced.load(), 2);
+
+    QList<int> items;
+    while (items.size() < 10) {
+        int item = 0;
+        if (queue.dequeue(&item))
+            items.append(item);
+        else
+            QThread::yieldCurrentThread();
+    }
+    QVERIFY(producer.wait(5000));
+
+    QList<int> expected;
+    for (int i = 0; i < 10; ++i)
+        expected.append(i);
+    QCOMPARE(items, expected);
+    QCOMPARE(queue.droppedCount(), 0);
+    QCOMPARE(queue.highWaterMark(), 2);
+}
+
+void tst_QMediaProbeQueue::flushing()
+{
+    QMediaProbeQueue<int> queue;
+    queue.setPolicy(QMultimedia::BlockingQueueDelivery, 1);
+    queue.enqueue(0);
+
+    Producer producer(&queue, 1);
+    producer.start();
+    QTest::qWait(50);
+    QCOMPARE(producer.produced.load(), 0);
+
+    // Flushing discards the queue and releases the producer
+    queue.setFlushing(true);
+    QVERIFY(producer.wait(5000));
+
+    int item = 0;
+    QVERIFY(!queue.dequeue(&item));
+    QVERIFY(!queue.enqueue(1));
+    QCOMPARE(queue.droppedCount(), 0);
+
+    queue.setFlushing(false);
+    QVERIFY(queue.enqueue(2));
+    QVERIFY(queue.dequeue(&item));
+    QCOMPARE(item, 2);
+}
+
+void tst_QMediaProbeQueue::statistics()
+{
+    QMediaProbeQueue<int> queue;
+    queue.setPolicy(QMultimedia::DropOldestQueueDelivery, 4);
+
+    for (int i = 0; i < 6; ++i)
+        queue.enqueue(i);
+    QCOMPARE(queue.droppedCount(), 2);
+    QCOMPARE(queue.highWaterMark(), 4);
+
+    int item = 0;
+    queue.dequeue(&item);
+    queue.dequeue(&item);
+
+    // The high-water mark restarts from the items still queued
+    queue.resetStatistics();
+    QCOMPARE(queue.droppedCount(), 0);
+    QCOMPARE(queue.highWaterMark(), 2);
+}
+
+QTEST_GUILESS_MAIN(tst_QMediaProbeQueue)
+
+#include "tst_qmediaprobequeue.moc"
@@ -5,5 +5,6 @@ QT += multimedia-private testlib
 
 SOURCES += tst_qsamplecache.cpp
 
-TESTDATA += testdata/*
+TESTDATA += testdata/* \
+            ../qmediaplayer/testdata/nokia-tune.mp3
 DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
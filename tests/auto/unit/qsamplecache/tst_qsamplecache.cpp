@@ -35,6 +35,7 @@
 
 #include <QtTest/QtTest>
 #include <private/qsamplecache_p.h>
+#include <qaudiodecoder.h>
 
 class tst_QSampleCache : public QObject
 {
@@ -42,6 +43,7 @@ class tst_QSampleCache : public QObject
 public:
 
 public slots:
+    void sampleFinished();
 
 private slots:
     void testCachedSample();
@@ -49,11 +51,23 @@ private slots:
     void testEnoughCapacity();
     void testNotEnoughCapacity();
     void testInvalidFile();
+    void testMappedSample();
+    void testMappedRf64Sample();
+    void testConcurrentLoads();
+    void testLoadPriority();
+    void testCompressedSample();
+    void testDiskCacheCapacity();
+    void testLeastRecentlyUsed();
 
 private:
-
+    QList<QSample*> m_finishedSamples;
 };
 
+void tst_QSampleCache::sampleFinished()
+{
+    m_finishedSamples.append(qobject_cast<QSample*>(sender()));
+}
+
 void tst_QSampleCache::testCachedSample()
 {
     QSampleCache cache;
@@ -186,6 +200,316 @@ void tst_QSampleCache::testInvalidFile()
     QVERIFY(!cache.isCached(QUrl::fromLocalFile("invalid")));
 }
 
+void tst_QSampleCache::testMappedSample()
+{
+    QSampleCache cache;
+    cache.setCapacity(1024 * 1024);
+
+    QSample* sample = cache.requestSample(QUrl::fromLocalFile(QFINDTESTDATA("testdata/test.wav")));
+    QVERIFY(sample);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+
+    // The PCM data is read in place from the file
+    QVERIFY(sample->isMapped());
+    QVERIFY(sample->data().size() > 0);
+    QCOMPARE(cache.mappedUsage(), qint64(sample->data().size()));
+    QCOMPARE(cache.usage(), qint64(0));
+
+    QFile file(QFINDTESTDATA("testdata/test.wav"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll().contains(sample->data()));
+
+    sample->release();
+    QVERIFY(cache.isCached(QUrl::fromLocalFile(QFINDTESTDATA("testdata/test.wav"))));
+
+    // Unloading gives the mapping back
+    cache.setCapacity(0);
+    QVERIFY(!cache.isCached(QUrl::fromLocalFile(QFINDTESTDATA("testdata/test.wav"))));
+    QCOMPARE(cache.mappedUsage(), qint64(0));
+}
+
+template <typename T>
+static void appendLittleEndian(QByteArray &data, T value)
+{
+    uchar bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    data.append(reinterpret_cast<const char *>(bytes), sizeof(T));
+}
+
+void tst_QSampleCache::testMappedRf64Sample()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    // Mono 16 bit PCM, the sizes are only given by the ds64 chunk
+    QByteArray pcm;
+    for (int i = 0; i < 4000; ++i)
+        appendLittleEndian<qint16>(pcm, qint16(i));
+
+    QByteArray wave;
+    wave.append("RF64", 4);
+    appendLittleEndian<quint32>(wave, 0xFFFFFFFF);
+    wave.append("WAVE", 4);
+    wave.append("ds64", 4);
+    appendLittleEndian<quint32>(wave, 28);
+    appendLittleEndian<quint64>(wave, 0);
+    appendLittleEndian<quint64>(wave, pcm.size());
+    appendLittleEndian<quint64>(wave, pcm.size() / 2);
+    appendLittleEndian<quint32>(wave, 0);
+    wave.append("fmt ", 4);
+    appendLittleEndian<quint32>(wave, 16);
+    appendLittleEndian<quint16>(wave, 1);
+    appendLittleEndian<quint16>(wave, 1);
+    appendLittleEndian<quint32>(wave, 8000);
+    appendLittleEndian<quint32>(wave, 16000);
+    appendLittleEndian<quint16>(wave, 2);
+    appendLittleEndian<quint16>(wave, 16);
+    wave.append("data", 4);
+    appendLittleEndian<quint32>(wave, 0xFFFFFFFF);
+    wave.append(pcm);
+
+    const QString fileName = directory.path() + QLatin1String("/rf64.wav");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(wave), qint64(wave.size()));
+    file.close();
+
+    QSampleCache cache;
+    cache.setCapacity(1024 * 1024);
+
+    // RF64 is read by the wave decoder in place, not decoded into a copy
+    QSample* sample = cache.requestSample(QUrl::fromLocalFile(fileName));
+    QVERIFY(sample);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+    QVERIFY(sample->isMapped());
+    QCOMPARE(sample->data(), pcm);
+    QCOMPARE(sample->format().sampleSize(), 16);
+    QCOMPARE(cache.mappedUsage(), qint64(pcm.size()));
+    QCOMPARE(cache.usage(), qint64(0));
+
+    sample->release();
+}
+
+void tst_QSampleCache::testConcurrentLoads()
+{
+    QSampleCache cache;
+    cache.setMaximumConcurrentLoads(2);
+    QCOMPARE(cache.maximumConcurrentLoads(), 2);
+    QSignalSpy loadingSpy(&cache, SIGNAL(isLoadingChanged()));
+
+    QSample* sample = cache.requestSample(QUrl::fromLocalFile(QFINDTESTDATA("testdata/test.wav")));
+    QSample* sampleOther = cache.requestSample(QUrl::fromLocalFile(QFINDTESTDATA("testdata/test2.wav")));
+    QVERIFY(cache.isLoading());
+    QVERIFY(cache.loadingCount() > 0);
+
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+    QTRY_COMPARE(sampleOther->state(), QSample::Ready);
+    QTRY_VERIFY(!cache.isLoading());
+    QCOMPARE(cache.loadingCount(), 0);
+    QTRY_COMPARE(loadingSpy.count(), 2);
+
+    sample->release();
+    sampleOther->release();
+}
+
+void tst_QSampleCache::testLoadPriority()
+{
+    QSampleCache cache;
+    cache.setMaximumConcurrentLoads(1);
+    m_finishedSamples.clear();
+
+    // The first request starts right away, the others wait for it in the
+    // queue, until the application thread starts the next load
+    QSample* first = cache.requestSample(QUrl::fromLocalFile(QFINDTESTDATA("testdata/test.wav")));
+    QSample* background = cache.requestSample(QUrl::fromLocalFile("invalid"), QSampleCache::LowPriority);
+    QSample* urgent = cache.requestSample(QUrl::fromLocalFile(QFINDTESTDATA("testdata/test2.wav")),
+                                          QSampleCache::HighPriority);
+    QCOMPARE(cache.loadingCount(), 3);
+
+    connect(background, SIGNAL(error()), SLOT(sampleFinished()));
+    connect(urgent, SIGNAL(ready()), SLOT(sampleFinished()));
+
+    QTRY_COMPARE(m_finishedSamples.size(), 2);
+    QCOMPARE(m_finishedSamples, QList<QSample*>() << urgent << background);
+    QCOMPARE(first->state(), QSample::Ready);
+    QTRY_COMPARE(cache.loadingCount(), 0);
+
+    first->release();
+    background->release();
+    urgent->release();
+}
+
+// The compressed sample is shared with the media player tests
+static QString compressedTestFile()
+{
+    return QFINDTESTDATA("../qmediaplayer/testdata/nokia-tune.mp3");
+}
+
+void tst_QSampleCache::testCompressedSample()
+{
+    QAudioDecoder decoder;
+    if (decoder.error() == QAudioDecoder::ServiceMissingError)
+        QSKIP("There is no audio decoding support on this platform.");
+    if (compressedTestFile().isEmpty())
+        QSKIP("The compressed test file is not available.");
+
+    QTemporaryDir cacheDirectory;
+    QVERIFY(cacheDirectory.isValid());
+    const QUrl url = QUrl::fromLocalFile(compressedTestFile());
+
+    QByteArray decoded;
+    QAudioFormat format;
+    {
+        QSampleCache cache;
+        cache.setDiskCacheDirectory(cacheDirectory.path());
+        QCOMPARE(cache.diskCacheDirectory(), cacheDirectory.path());
+
+        QSample* sample = cache.requestSample(url);
+        QTRY_VERIFY_WITH_TIMEOUT(sample->state() == QSample::Ready, 10000);
+        QVERIFY(!sample->isMapped());
+        QVERIFY(sample->data().size() > 0);
+        QVERIFY(sample->format().isValid());
+        QCOMPARE(cache.usage(), qint64(sample->data().size()));
+        decoded = sample->data();
+        format = sample->format();
+        sample->release();
+    }
+
+    // The decoded samples are kept on disk
+    QCOMPARE(QDir(cacheDirectory.path()).entryList(QDir::Files).size(), 1);
+
+    // and mapped from there by the next cache
+    QSampleCache cache;
+    cache.setDiskCacheDirectory(cacheDirectory.path());
+    QSample* sample = cache.requestSample(url);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+    QVERIFY(sample->isMapped());
+    QCOMPARE(sample->format(), format);
+    QVERIFY(sample->data() == decoded);
+    sample->release();
+}
+
+void tst_QSampleCache::testDiskCacheCapacity()
+{
+    QAudioDecoder decoder;
+    if (decoder.error() == QAudioDecoder::ServiceMissingError)
+        QSKIP("There is no audio decoding support on this platform.");
+    if (compressedTestFile().isEmpty())
+        QSKIP("The compressed test file is not available.");
+
+    QTemporaryDir cacheDirectory;
+    QVERIFY(cacheDirectory.isValid());
+    QDir directory(cacheDirectory.path());
+    const QUrl url = QUrl::fromLocalFile(compressedTestFile());
+
+    // Nothing is kept on disk without room for it
+    {
+        QSampleCache cache;
+        QCOMPARE(cache.diskCacheCapacity(), qint64(64 * 1024 * 1024));
+        cache.setDiskCacheDirectory(cacheDirectory.path());
+        cache.setDiskCacheCapacity(1024);
+        QCOMPARE(cache.diskCacheCapacity(), qint64(1024));
+
+        QSample* sample = cache.requestSample(url);
+        QTRY_VERIFY_WITH_TIMEOUT(sample->state() == QSample::Ready, 10000);
+        sample->release();
+    }
+    QVERIFY(directory.entryList(QDir::Files).isEmpty());
+
+    // Stands for the decoded samples of a file that is gone
+    QFile old(directory.filePath(QLatin1String("old.wav")));
+    QVERIFY(old.open(QIODevice::WriteOnly));
+    QVERIFY(old.write(QByteArray(4096, '\0')) == 4096);
+    old.close();
+
+    qint64 decodedSize;
+    {
+        QSampleCache cache;
+        cache.setDiskCacheDirectory(cacheDirectory.path());
+        QSample* sample = cache.requestSample(url);
+        QTRY_VERIFY_WITH_TIMEOUT(sample->state() == QSample::Ready, 10000);
+        decodedSize = sample->data().size() + 44;
+        sample->release();
+    }
+    QCOMPARE(directory.entryList(QDir::Files).size(), 2);
+
+    // A copy of the file is another sample for the disk cache
+    QTemporaryDir otherDirectory;
+    QVERIFY(otherDirectory.isValid());
+    const QString otherFile = otherDirectory.path() + QLatin1String("/other.mp3");
+    QVERIFY(QFile::copy(compressedTestFile(), otherFile));
+    {
+        QSampleCache cache;
+        cache.setDiskCacheDirectory(cacheDirectory.path());
+        cache.setDiskCacheCapacity(2 * decodedSize);
+
+        QSample* sample = cache.requestSample(QUrl::fromLocalFile(otherFile));
+        QTRY_VERIFY_WITH_TIMEOUT(sample->state() == QSample::Ready, 10000);
+        sample->release();
+    }
+
+    // Only two of the three files fit
+    qint64 used = 0;
+    const QFileInfoList files = directory.entryInfoList(QDir::Files);
+    foreach (const QFileInfo &file, files)
+        used += file.size();
+    QCOMPARE(files.size(), 2);
+    QVERIFY(used <= 2 * decodedSize);
+}
+
+void tst_QSampleCache::testLeastRecentlyUsed()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString thirdFile = directory.path() + QLatin1String("/test3.wav");
+    QVERIFY(QFile::copy(QFINDTESTDATA("testdata/test.wav"), thirdFile));
+
+    const QUrl first = QUrl::fromLocalFile(QFINDTESTDATA("testdata/test.wav"));
+    const QUrl second = QUrl::fromLocalFile(QFINDTESTDATA("testdata/test2.wav"));
+    const QUrl third = QUrl::fromLocalFile(thirdFile);
+
+    QSampleCache cache;
+    QSample* sample = cache.requestSample(first);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+    const qint64 sampleSize = sample->data().size();
+    sample->release();
+
+    // Room for two samples and a half
+    cache.setCapacity(sampleSize * 5 / 2);
+    cache.resetStatistics();
+
+    sample = cache.requestSample(first);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+    sample->release();
+    sample = cache.requestSample(second);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+    sample->release();
+
+    // Using the first one again makes the second one the least recently used
+    sample = cache.requestSample(first);
+    QCOMPARE(sample->state(), QSample::Ready);
+    sample->release();
+
+    sample = cache.requestSample(third);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+
+    QVERIFY(cache.isCached(first));
+    QVERIFY(!cache.isCached(second));
+    QVERIFY(cache.isCached(third));
+
+    const QSampleCache::Statistics statistics = cache.statistics();
+    QCOMPARE(statistics.heapBytes + statistics.mappedBytes, sampleSize * 2);
+    QCOMPARE(statistics.samples, 2);
+    QCOMPARE(statistics.unusedSamples, 1);
+    QCOMPARE(statistics.hits, 1);
+    QCOMPARE(statistics.misses, 3);
+    QCOMPARE(statistics.evictions, 1);
+    QCOMPARE(statistics.loads, 3);
+    QVERIFY(statistics.loadTime >= 0);
+
+    sample->release();
+}
+
 QTEST_MAIN(tst_QSampleCache)
 
 #include "tst_qsamplecache.moc"
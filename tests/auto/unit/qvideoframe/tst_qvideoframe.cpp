@@ -36,6 +36,8 @@
 #include <QtTest/QtTest>
 
 #include <qvideoframe.h>
+#include <private/qvideoframe_p.h>
+#include <private/qvideoframeconversionhelper_p.h>
 #include <QtGui/QImage>
 #include <QtCore/QPointer>
 
@@ -84,6 +86,29 @@ private slots:
     void imageDetach();
     void formatConversion_data();
     void formatConversion();
+    void imageFromYUV_data();
+    void imageFromYUV();
+    void convertYUVRoundTrip_data();
+    void convertYUVRoundTrip();
+    void convertYUVToRGB_data();
+    void convertYUVToRGB();
+    void convertUnsupported();
+    void scaledImageFromYUV_data();
+    void scaledImageFromYUV();
+    void scaledImageFromHugeYUV();
+    void scaledImageFromYUVPattern_data();
+    void scaledImageFromYUVPattern();
+    void imageFromYUVColorSpace_data();
+    void imageFromYUVColorSpace();
+    void colorSpaceCoefficients();
+    void imageIntoExistingImage();
+    void imageIntoBuffer();
+    void imageView();
+    void convertLevels_data();
+    void convertLevels();
+    void imageFromIMC_data();
+    void imageFromIMC();
+    void imageFromGrey();
 
     void metadata();
 
@@ -1010,6 +1035,752 @@ void tst_QVideoFrame::formatConversion()
              pixelFormat != QVideoFrame::Format_Invalid);
 }
 
+static QRgb referenceYUVToRgb(int y, int u, int v)
+{
+    const int yy = (y - 16) * 298;
+    const int uu = u - 128;
+    const int vv = v - 128;
+    return qRgb(qBound(0, (yy + 409 * vv + 128) >> 8, 255),
+                qBound(0, (yy - 100 * uu - 208 * vv - 128) >> 8, 255),
+                qBound(0, (yy + 516 * uu + 128) >> 8, 255));
+}
+
+void tst_QVideoFrame::imageFromYUV_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+
+    const struct {
+        QVideoFrame::PixelFormat format;
+        const char *name;
+    } formats[] = {
+        { QVideoFrame::Format_YUV420P, "YUV420P" },
+        { QVideoFrame::Format_YV12, "YV12" },
+        { QVideoFrame::Format_NV12, "NV12" },
+        { QVideoFrame::Format_NV21, "NV21" },
+        { QVideoFrame::Format_UYVY, "UYVY" },
+        { QVideoFrame::Format_YUYV, "YUYV" }
+    };
+
+    // Widths are chosen to exercise both the vectorized and the leftover code paths,
+    // the largest size is converted in parallel bands
+    const QSize sizes[] = { QSize(8, 4), QSize(30, 6), QSize(64, 8), QSize(100, 10), QSize(1280, 720) };
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            QTest::newRow(qPrintable(QString::fromLatin1("%1 %2x%3").arg(QLatin1String(formats[f].name))
+                                     .arg(sizes[i].width()).arg(sizes[i].height())))
+                    << formats[f].format << sizes[i];
+        }
+    }
+}
+
+void tst_QVideoFrame::imageFromYUV()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    const bool packed = pixelFormat == QVideoFrame::Format_UYVY
+            || pixelFormat == QVideoFrame::Format_YUYV;
+    const int yStride = packed ? size.width() * 2 : size.width();
+    const int bytes = packed ? yStride * size.height() : yStride * size.height() * 3 / 2;
+
+    QVideoFrame frame(bytes, size, yStride, pixelFormat);
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    uchar *bits = frame.bits();
+    for (int i = 0; i < bytes; ++i)
+        bits[i] = uchar((i * 37) ^ (i >> 3));
+    frame.unmap();
+
+    const QImage image = qt_imageFromVideoFrame(frame);
+    QCOMPARE(image.size(), size);
+    QCOMPARE(image.format(), QImage::Format_ARGB32);
+
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+    for (int j = 0; j < size.height(); ++j) {
+        for (int i = 0; i < size.width(); ++i) {
+            int y = 0, u = 0, v = 0;
+            switch (pixelFormat) {
+            case QVideoFrame::Format_YUV420P:
+            case QVideoFrame::Format_YV12: {
+                const int uvOffset = (j / 2) * frame.bytesPerLine(1) + i / 2;
+                const int uPlane = pixelFormat == QVideoFrame::Format_YUV420P ? 1 : 2;
+                y = frame.bits(0)[j * yStride + i];
+                u = frame.bits(uPlane)[uvOffset];
+                v = frame.bits(3 - uPlane)[uvOffset];
+                break;
+            }
+            case QVideoFrame::Format_NV12:
+            case QVideoFrame::Format_NV21: {
+                const uchar *uv = frame.bits(1) + (j / 2) * frame.bytesPerLine(1) + (i & ~1);
+                const bool nv12 = pixelFormat == QVideoFrame::Format_NV12;
+                y = frame.bits(0)[j * yStride + i];
+                u = uv[nv12 ? 0 : 1];
+                v = uv[nv12 ? 1 : 0];
+                break;
+            }
+            default: {
+                const uchar *macroPixel = frame.bits() + j * yStride + (i & ~1) * 2;
+                const bool yuyv = pixelFormat == QVideoFrame::Format_YUYV;
+                y = macroPixel[(yuyv ? 0 : 1) + (i & 1) * 2];
+                u = macroPixel[yuyv ? 1 : 0];
+                v = macroPixel[yuyv ? 3 : 2];
+                break;
+            }
+            }
+
+            const QRgb expected = referenceYUVToRgb(y, u, v);
+            if (image.pixel(i, j) != expected)
+                QFAIL(qPrintable(QString::fromLatin1("Mismatch at (%1, %2)").arg(i).arg(j)));
+        }
+    }
+    frame.unmap();
+}
+
+static QVideoFrame createYUV420PFrame(const QSize &size)
+{
+    const int bytes = size.width() * size.height() * 3 / 2;
+    QVideoFrame frame(bytes, size, size.width(), QVideoFrame::Format_YUV420P);
+    if (frame.map(QAbstractVideoBuffer::WriteOnly)) {
+        for (int i = 0; i < bytes; ++i)
+            frame.bits()[i] = uchar((i * 37) ^ (i >> 3));
+        frame.unmap();
+    }
+    return frame;
+}
+
+void tst_QVideoFrame::convertYUVRoundTrip_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+
+    QTest::newRow("YV12") << QVideoFrame::Format_YV12;
+    QTest::newRow("NV12") << QVideoFrame::Format_NV12;
+    QTest::newRow("NV21") << QVideoFrame::Format_NV21;
+    QTest::newRow("UYVY") << QVideoFrame::Format_UYVY;
+    QTest::newRow("YUYV") << QVideoFrame::Format_YUYV;
+}
+
+void tst_QVideoFrame::convertYUVRoundTrip()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+
+    const QSize size(38, 10);
+    QVideoFrame source = createYUV420PFrame(size);
+    source.setStartTime(100);
+    source.setEndTime(200);
+
+    QVideoFrame converted = qt_convertVideoFrame(source, pixelFormat);
+    QVERIFY(converted.isValid());
+    QCOMPARE(converted.pixelFormat(), pixelFormat);
+    QCOMPARE(converted.size(), size);
+    QCOMPARE(converted.startTime(), qint64(100));
+    QCOMPARE(converted.endTime(), qint64(200));
+
+    // 4:2:0 to 4:2:2 duplicates chroma lines and the way back averages them,
+    // so every round trip is lossless
+    QVideoFrame roundTrip = qt_convertVideoFrame(converted, QVideoFrame::Format_YUV420P);
+    QVERIFY(roundTrip.isValid());
+    QCOMPARE(roundTrip.pixelFormat(), QVideoFrame::Format_YUV420P);
+    QCOMPARE(qt_imageFromVideoFrame(roundTrip), qt_imageFromVideoFrame(source));
+}
+
+void tst_QVideoFrame::convertYUVToRGB_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QImage::Format>("imageFormat");
+
+    QTest::newRow("ARGB32") << QVideoFrame::Format_ARGB32 << QImage::Format_ARGB32;
+    QTest::newRow("RGB32") << QVideoFrame::Format_RGB32 << QImage::Format_RGB32;
+    QTest::newRow("RGB24") << QVideoFrame::Format_RGB24 << QImage::Format_RGB888;
+    QTest::newRow("RGB565") << QVideoFrame::Format_RGB565 << QImage::Format_RGB16;
+    QTest::newRow("RGB555") << QVideoFrame::Format_RGB555 << QImage::Format_RGB555;
+}
+
+void tst_QVideoFrame::convertYUVToRGB()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QImage::Format, imageFormat);
+
+    const QSize size(38, 10);
+    const QVideoFrame source = createYUV420PFrame(size);
+
+    QVideoFrame converted = qt_convertVideoFrame(source, pixelFormat);
+    QVERIFY(converted.isValid());
+    QCOMPARE(converted.pixelFormat(), pixelFormat);
+
+    const QImage expected = qt_imageFromVideoFrame(source).convertToFormat(imageFormat);
+    QCOMPARE(qt_imageFromVideoFrame(converted), expected);
+}
+
+void tst_QVideoFrame::convertUnsupported()
+{
+    const QVideoFrame source = createYUV420PFrame(QSize(16, 16));
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("unsupported")));
+    QVERIFY(!qt_convertVideoFrame(source, QVideoFrame::Format_Jpeg).isValid());
+
+    // Subsampled targets need even dimensions
+    QVideoFrame odd(16 * 15, QSize(15, 15), 16, QVideoFrame::Format_ARGB32);
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("unsupported")));
+    QVERIFY(!qt_convertVideoFrame(odd, QVideoFrame::Format_NV12).isValid());
+
+    QVERIFY(!qt_convertVideoFrame(QVideoFrame(), QVideoFrame::Format_NV12).isValid());
+}
+
+void tst_QVideoFrame::scaledImageFromYUV_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<QSize>("expectedSize");
+
+    QTest::newRow("YUV420P quarter") << QVideoFrame::Format_YUV420P << QSize(160, 90) << QSize(160, 90);
+    QTest::newRow("YUV420P odd") << QVideoFrame::Format_YUV420P << QSize(201, 77) << QSize(136, 77);
+    QTest::newRow("NV12 quarter") << QVideoFrame::Format_NV12 << QSize(160, 90) << QSize(160, 90);
+    QTest::newRow("NV12 odd") << QVideoFrame::Format_NV12 << QSize(201, 77) << QSize(136, 77);
+    QTest::newRow("YUYV quarter") << QVideoFrame::Format_YUYV << QSize(160, 90) << QSize(160, 90);
+    QTest::newRow("YUYV upscale") << QVideoFrame::Format_YUYV << QSize(1280, 720) << QSize(1280, 720);
+}
+
+void tst_QVideoFrame::scaledImageFromYUV()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+    QFETCH(QSize, expectedSize);
+
+    // A uniformly colored frame must keep its color whatever the filter does
+    const QSize frameSize(640, 360);
+    QVideoFrame frame = qt_convertVideoFrame(createYUV420PFrame(frameSize), pixelFormat);
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    for (int j = 0; j < frameSize.height(); ++j) {
+        for (int i = 0; i < frameSize.width(); ++i) {
+            switch (pixelFormat) {
+            case QVideoFrame::Format_YUV420P:
+                frame.bits(0)[j * frame.bytesPerLine(0) + i] = 100;
+                frame.bits(1)[(j / 2) * frame.bytesPerLine(1) + i / 2] = 60;
+                frame.bits(2)[(j / 2) * frame.bytesPerLine(2) + i / 2] = 200;
+                break;
+            case QVideoFrame::Format_NV12:
+                frame.bits(0)[j * frame.bytesPerLine(0) + i] = 100;
+                frame.bits(1)[(j / 2) * frame.bytesPerLine(1) + (i & ~1)] = 60;
+                frame.bits(1)[(j / 2) * frame.bytesPerLine(1) + (i & ~1) + 1] = 200;
+                break;
+            default: {
+                uchar *macroPixel = frame.bits() + j * frame.bytesPerLine() + (i & ~1) * 2;
+                macroPixel[0] = 100;
+                macroPixel[1] = 60;
+                macroPixel[2] = 100;
+                macroPixel[3] = 200;
+                break;
+            }
+            }
+        }
+    }
+    frame.unmap();
+
+    const QRgb expected = referenceYUVToRgb(100, 60, 200);
+    const QImage image = qt_scaledImageFromVideoFrame(frame, size, Qt::KeepAspectRatio);
+    QCOMPARE(image.size(), expectedSize);
+    for (int j = 0; j < image.height(); ++j) {
+        for (int i = 0; i < image.width(); ++i) {
+            if (image.pixel(i, j) != expected)
+                QFAIL(qPrintable(QString::fromLatin1("Mismatch at (%1, %2)").arg(i).arg(j)));
+        }
+    }
+}
+
+void tst_QVideoFrame::scaledImageFromHugeYUV()
+{
+    // The luma of a whole 8K frame lands in a single box, whose sum does not
+    // fit in 32 bits
+    const QSize frameSize(7680, 4320);
+    const int lumaBytes = frameSize.width() * frameSize.height();
+    QVideoFrame frame(lumaBytes * 3 / 2, frameSize, frameSize.width(), QVideoFrame::Format_YUV420P);
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    memset(frame.bits(0), 235, lumaBytes);
+    memset(frame.bits(1), 60, lumaBytes / 4);
+    memset(frame.bits(2), 200, lumaBytes / 4);
+    frame.unmap();
+
+    const QImage image = qt_scaledImageFromVideoFrame(frame, QSize(1, 1), Qt::IgnoreAspectRatio);
+    QCOMPARE(image.size(), QSize(1, 1));
+    QCOMPARE(image.pixel(0, 0), referenceYUVToRgb(235, 60, 200));
+}
+
+// Per-component patterns that differ along each axis, so that swapped
+// components, offset samples and transposed coordinates all show
+static int patternY(int x, int y) { return (x * 5 + y * 3) % 220 + 16; }
+static int patternU(int x, int y) { return (x * 7 + y) % 224 + 16; }
+static int patternV(int x, int y) { return (x + y * 9) % 224 + 16; }
+
+// Box averages a width x height plane down to outputWidth x outputHeight,
+// a reference for the filter of qt_scaledImageFromVideoFrame()
+static QVector<int> referenceBoxScale(int (*pattern)(int, int), int width, int height,
+                                      int outputWidth, int outputHeight)
+{
+    QVector<int> output(outputWidth * outputHeight);
+    for (int dy = 0; dy < outputHeight; ++dy) {
+        const int y0 = dy * height / outputHeight;
+        const int y1 = qMax(y0 + 1, (dy + 1) * height / outputHeight);
+        for (int dx = 0; dx < outputWidth; ++dx) {
+            const int x0 = dx * width / outputWidth;
+            const int x1 = qMax(x0 + 1, (dx + 1) * width / outputWidth);
+            int sum = 0;
+            for (int y = y0; y < y1; ++y) {
+                for (int x = x0; x < x1; ++x)
+                    sum += pattern(x, y);
+            }
+            const int count = (x1 - x0) * (y1 - y0);
+            output[dy * outputWidth + dx] = (sum + count / 2) / count;
+        }
+    }
+    return output;
+}
+
+void tst_QVideoFrame::scaledImageFromYUVPattern_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("YUV420P quarter") << QVideoFrame::Format_YUV420P << QSize(160, 90);
+    QTest::newRow("YUV420P odd") << QVideoFrame::Format_YUV420P << QSize(136, 77);
+    QTest::newRow("NV12 quarter") << QVideoFrame::Format_NV12 << QSize(160, 90);
+    QTest::newRow("NV12 odd") << QVideoFrame::Format_NV12 << QSize(136, 77);
+    QTest::newRow("YUYV quarter") << QVideoFrame::Format_YUYV << QSize(160, 90);
+    QTest::newRow("YUYV odd") << QVideoFrame::Format_YUYV << QSize(136, 77);
+}
+
+void tst_QVideoFrame::scaledImageFromYUVPattern()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    const QSize frameSize(640, 360);
+    const bool packed = pixelFormat == QVideoFrame::Format_YUYV;
+    const int chromaWidth = frameSize.width() / 2;
+    const int chromaHeight = packed ? frameSize.height() : frameSize.height() / 2;
+
+    QVideoFrame frame = qt_convertVideoFrame(createYUV420PFrame(frameSize), pixelFormat);
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    for (int j = 0; j < frameSize.height(); ++j) {
+        for (int i = 0; i < frameSize.width(); ++i) {
+            const int cx = i / 2;
+            const int cy = packed ? j : j / 2;
+            switch (pixelFormat) {
+            case QVideoFrame::Format_YUV420P:
+                frame.bits(0)[j * frame.bytesPerLine(0) + i] = patternY(i, j);
+                frame.bits(1)[cy * frame.bytesPerLine(1) + cx] = patternU(cx, cy);
+                frame.bits(2)[cy * frame.bytesPerLine(2) + cx] = patternV(cx, cy);
+                break;
+            case QVideoFrame::Format_NV12:
+                frame.bits(0)[j * frame.bytesPerLine(0) + i] = patternY(i, j);
+                frame.bits(1)[cy * frame.bytesPerLine(1) + cx * 2] = patternU(cx, cy);
+                frame.bits(1)[cy * frame.bytesPerLine(1) + cx * 2 + 1] = patternV(cx, cy);
+                break;
+            default: {
+                uchar *macroPixel = frame.bits() + j * frame.bytesPerLine() + cx * 4;
+                macroPixel[(i & 1) * 2] = patternY(i, j);
+                macroPixel[1] = patternU(cx, cy);
+                macroPixel[3] = patternV(cx, cy);
+                break;
+            }
+            }
+        }
+    }
+    frame.unmap();
+
+    const QVector<int> y = referenceBoxScale(patternY, frameSize.width(), frameSize.height(),
+                                             size.width(), size.height());
+    const QVector<int> u = referenceBoxScale(patternU, chromaWidth, chromaHeight,
+                                             size.width(), size.height());
+    const QVector<int> v = referenceBoxScale(patternV, chromaWidth, chromaHeight,
+                                             size.width(), size.height());
+
+    const QImage image = qt_scaledImageFromVideoFrame(frame, size, Qt::IgnoreAspectRatio);
+    QCOMPARE(image.size(), size);
+    for (int j = 0; j < image.height(); ++j) {
+        for (int i = 0; i < image.width(); ++i) {
+            const int index = j * size.width() + i;
+            const QRgb expected = referenceYUVToRgb(y.at(index), u.at(index), v.at(index));
+            const QRgb actual = image.pixel(i, j);
+            if (qAbs(qRed(actual) - qRed(expected)) > 1
+                    || qAbs(qGreen(actual) - qGreen(expected)) > 1
+                    || qAbs(qBlue(actual) - qBlue(expected)) > 1) {
+                QFAIL(qPrintable(QString::fromLatin1("Mismatch at (%1, %2): %3, expected %4")
+                                 .arg(i).arg(j).arg(actual, 8, 16).arg(expected, 8, 16)));
+            }
+        }
+    }
+}
+
+void tst_QVideoFrame::imageFromYUVColorSpace_data()
+{
+    QTest::addColumn<int>("matrix");
+    QTest::addColumn<int>("range");
+    QTest::addColumn<double>("kr");
+    QTest::addColumn<double>("kb");
+
+    const struct {
+        QYCbCrCoefficients::Matrix matrix;
+        double kr;
+        double kb;
+        const char *name;
+    } matrices[] = {
+        { QYCbCrCoefficients::BT601, 0.299, 0.114, "BT.601" },
+        { QYCbCrCoefficients::BT709, 0.2126, 0.0722, "BT.709" },
+        { QYCbCrCoefficients::BT2020, 0.2627, 0.0593, "BT.2020" }
+    };
+
+    for (size_t m = 0; m < sizeof(matrices) / sizeof(matrices[0]); ++m) {
+        QTest::newRow(qPrintable(QString::fromLatin1("%1 limited").arg(QLatin1String(matrices[m].name))))
+                << int(matrices[m].matrix) << int(QYCbCrCoefficients::LimitedRange)
+                << matrices[m].kr << matrices[m].kb;
+        QTest::newRow(qPrintable(QString::fromLatin1("%1 full").arg(QLatin1String(matrices[m].name))))
+                << int(matrices[m].matrix) << int(QYCbCrCoefficients::FullRange)
+                << matrices[m].kr << matrices[m].kb;
+    }
+}
+
+void tst_QVideoFrame::imageFromYUVColorSpace()
+{
+    QFETCH(int, matrix);
+    QFETCH(int, range);
+    QFETCH(double, kr);
+    QFETCH(double, kb);
+
+    const bool fullRange = range == QYCbCrCoefficients::FullRange;
+    const QYCbCrCoefficients &coefficients = qt_yCbCrCoefficients(
+                QYCbCrCoefficients::Matrix(matrix), QYCbCrCoefficients::Range(range));
+
+    // 32 pixels wide, so that both the vectorized and the leftover code paths run
+    const QSize size(34, 2);
+    const int samples[][3] = {
+        { 16, 128, 128 }, { 235, 128, 128 }, { 0, 128, 128 }, { 255, 128, 128 },
+        { 81, 90, 240 }, { 145, 54, 34 }, { 41, 240, 110 }, { 170, 166, 16 }
+    };
+
+    for (size_t s = 0; s < sizeof(samples) / sizeof(samples[0]); ++s) {
+        const int y = samples[s][0];
+        const int u = samples[s][1];
+        const int v = samples[s][2];
+
+        QVideoFrame frame(size.width() * size.height() * 3 / 2, size, size.width(),
+                          QVideoFrame::Format_NV12);
+        QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+        memset(frame.bits(0), y, size.width() * size.height());
+        for (int i = 0; i < size.width(); i += 2) {
+            frame.bits(1)[i] = u;
+            frame.bits(1)[i + 1] = v;
+        }
+        frame.unmap();
+
+        const double yy = fullRange ? y : (y - 16) * 255.0 / 219.0;
+        const double cb = (u - 128) * (fullRange ? 1.0 : 255.0 / 224.0);
+        const double cr = (v - 128) * (fullRange ? 1.0 : 255.0 / 224.0);
+        const double r = yy + 2 * (1 - kr) * cr;
+        const double b = yy + 2 * (1 - kb) * cb;
+        const double g = (yy - kr * r - kb * b) / (1 - kr - kb);
+        const int expected[] = {
+            qBound(0, qRound(r), 255), qBound(0, qRound(g), 255), qBound(0, qRound(b), 255)
+        };
+
+        const QImage image = qt_imageFromVideoFrame(frame, coefficients);
+        QCOMPARE(image.size(), size);
+        for (int i = 0; i < size.width(); ++i) {
+            const QRgb pixel = image.pixel(i, 1);
+            const int actual[] = { qRed(pixel), qGreen(pixel), qBlue(pixel) };
+            for (int c = 0; c < 3; ++c) {
+                if (qAbs(actual[c] - expected[c]) > 2) {
+                    QFAIL(qPrintable(QString::fromLatin1("(%1, %2, %3) at %4: got %5, expected %6")
+                                     .arg(y).arg(u).arg(v).arg(i)
+                                     .arg(actual[c]).arg(expected[c])));
+                }
+            }
+        }
+    }
+}
+
+void tst_QVideoFrame::colorSpaceCoefficients()
+{
+    const QYCbCrCoefficients &bt601 = qt_yCbCrCoefficients(QYCbCrCoefficients::BT601,
+                                                           QYCbCrCoefficients::LimitedRange);
+    const QYCbCrCoefficients &bt709 = qt_yCbCrCoefficients(QYCbCrCoefficients::BT709,
+                                                           QYCbCrCoefficients::LimitedRange);
+    const QYCbCrCoefficients &jpeg = qt_yCbCrCoefficients(QYCbCrCoefficients::BT601,
+                                                          QYCbCrCoefficients::FullRange);
+
+    QCOMPARE(&qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_Undefined), &bt601);
+    QCOMPARE(&qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_BT601), &bt601);
+    QCOMPARE(&qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_xvYCC601), &bt601);
+    QCOMPARE(&qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_BT709), &bt709);
+    QCOMPARE(&qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_xvYCC709), &bt709);
+    QCOMPARE(&qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_JPEG), &jpeg);
+
+    // The default conversion is unchanged
+    QCOMPARE(bt601.yOffset, 16);
+    QCOMPARE(bt601.y, 298);
+    QCOMPARE(bt601.rv, 409);
+    QCOMPARE(bt601.gu, 100);
+    QCOMPARE(bt601.gv, 208);
+    QCOMPARE(bt601.bu, 516);
+}
+
+void tst_QVideoFrame::imageIntoExistingImage()
+{
+    const QSize size(38, 10);
+    const QVideoFrame source = createYUV420PFrame(size);
+    const QImage expected = qt_imageFromVideoFrame(source);
+
+    QImage image;
+    QVERIFY(qt_imageFromVideoFrame(source, &image));
+    QCOMPARE(image, expected);
+
+    // Matching storage is reused
+    const uchar *bits = image.constBits();
+    image.fill(0);
+    QVERIFY(qt_imageFromVideoFrame(source, &image));
+    QCOMPARE(image.constBits(), bits);
+    QCOMPARE(image, expected);
+
+    // Shared storage is never written to
+    QImage copy = image;
+    copy.fill(0);
+    image = copy;
+    QVERIFY(qt_imageFromVideoFrame(source, &image));
+    QVERIFY(image.constBits() != copy.constBits());
+    QCOMPARE(image, expected);
+    QCOMPARE(copy.pixel(0, 0), 0u);
+
+    // So is storage of the wrong size
+    QImage small(8, 8, QImage::Format_ARGB32);
+    QVERIFY(qt_imageFromVideoFrame(source, &small));
+    QCOMPARE(small, expected);
+
+    QImage untouched(8, 8, QImage::Format_ARGB32);
+    QVERIFY(!qt_imageFromVideoFrame(QVideoFrame(), &untouched));
+    QCOMPARE(untouched.size(), QSize(8, 8));
+}
+
+void tst_QVideoFrame::imageIntoBuffer()
+{
+    const QSize size(10, 4);
+    QImage rgb(size, QImage::Format_RGB32);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x)
+            rgb.setPixel(x, y, qRgb(x * 20, y * 50, 7));
+    }
+    const QVideoFrame rgbFrame(rgb);
+    QCOMPARE(qt_convertedImageFormat(rgbFrame.pixelFormat()), QImage::Format_RGB32);
+
+    // Lines are copied into any stride wide enough for them
+    const int stride = size.width() * 4 + 24;
+    QByteArray buffer(stride * size.height(), '\0');
+    QVERIFY(qt_imageFromVideoFrame(rgbFrame, reinterpret_cast<uchar *>(buffer.data()), stride));
+    QCOMPARE(QImage(reinterpret_cast<const uchar *>(buffer.constData()), size.width(), size.height(),
+                    stride, QImage::Format_RGB32), rgb);
+
+    // Converted formats are written as packed ARGB32 lines
+    const QVideoFrame yuvFrame = createYUV420PFrame(QSize(38, 10));
+    QCOMPARE(qt_convertedImageFormat(yuvFrame.pixelFormat()), QImage::Format_ARGB32);
+    QByteArray argb(38 * 4 * 10, '\0');
+    QVERIFY(qt_imageFromVideoFrame(yuvFrame, reinterpret_cast<uchar *>(argb.data()), 38 * 4));
+    QCOMPARE(QImage(reinterpret_cast<const uchar *>(argb.constData()), 38, 10, QImage::Format_ARGB32),
+             qt_imageFromVideoFrame(yuvFrame));
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("unsupported output stride")));
+    QVERIFY(!qt_imageFromVideoFrame(yuvFrame, reinterpret_cast<uchar *>(argb.data()), 38 * 4 + 8));
+}
+
+void tst_QVideoFrame::imageView()
+{
+    const QSize size(10, 4);
+    QVideoFrame frame(size.width() * 4 * size.height(), size, size.width() * 4,
+                      QVideoFrame::Format_RGB32);
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    memset(frame.bits(), 0x80, frame.mappedBytes());
+    const uchar *bits = frame.bits();
+    frame.unmap();
+
+    {
+        const QImage view = qt_imageViewFromVideoFrame(frame);
+        QCOMPARE(view.size(), size);
+        QCOMPARE(view.format(), QImage::Format_RGB32);
+        QCOMPARE(view.constBits(), bits);
+        QCOMPARE(view.pixel(3, 2), qRgb(0x80, 0x80, 0x80));
+        QVERIFY(frame.isMapped());
+
+        // Writing detaches from the frame
+        QImage copy = view;
+        copy.setPixel(0, 0, qRgb(0, 0, 0));
+        QVERIFY(copy.constBits() != bits);
+        QCOMPARE(view.pixel(0, 0), qRgb(0x80, 0x80, 0x80));
+    }
+    QVERIFY(!frame.isMapped());
+
+    QVERIFY(qt_imageViewFromVideoFrame(createYUV420PFrame(QSize(16, 16))).isNull());
+    QVERIFY(qt_imageViewFromVideoFrame(QVideoFrame()).isNull());
+}
+
+void tst_QVideoFrame::convertLevels_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<int>("bytesPerLine");
+    QTest::addColumn<int>("mappedBytes");
+
+    // 100x10 frames, wide enough for every kernel to run its vector and leftover loops
+    QTest::newRow("BGRA32") << QVideoFrame::Format_BGRA32 << 400 << 400 * 10;
+    QTest::newRow("YUV420P") << QVideoFrame::Format_YUV420P << 100 << 100 * 10 * 3 / 2;
+    QTest::newRow("YV12") << QVideoFrame::Format_YV12 << 100 << 100 * 10 * 3 / 2;
+    QTest::newRow("NV12") << QVideoFrame::Format_NV12 << 100 << 100 * 10 * 3 / 2;
+    QTest::newRow("NV21") << QVideoFrame::Format_NV21 << 100 << 100 * 10 * 3 / 2;
+    QTest::newRow("UYVY") << QVideoFrame::Format_UYVY << 200 << 200 * 10;
+    QTest::newRow("YUYV") << QVideoFrame::Format_YUYV << 200 << 200 * 10;
+    QTest::newRow("IMC1") << QVideoFrame::Format_IMC1 << 100 << 100 * 10 * 2;
+    QTest::newRow("IMC2") << QVideoFrame::Format_IMC2 << 100 << 100 * 10 * 3 / 2;
+    QTest::newRow("IMC4") << QVideoFrame::Format_IMC4 << 100 << 100 * 10 * 3 / 2;
+    QTest::newRow("Y8") << QVideoFrame::Format_Y8 << 100 << 100 * 10;
+    QTest::newRow("Y16") << QVideoFrame::Format_Y16 << 200 << 200 * 10;
+}
+
+void tst_QVideoFrame::convertLevels()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(int, bytesPerLine);
+    QFETCH(int, mappedBytes);
+
+    const QSize size(100, 10);
+    QVideoFrame frame(mappedBytes, size, bytesPerLine, pixelFormat);
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    for (int i = 0; i < mappedBytes; ++i)
+        frame.bits()[i] = uchar(i * 37 + (i >> 3));
+    frame.unmap();
+
+    const QYCbCrCoefficients &coefficients =
+            qt_yCbCrCoefficients(QYCbCrCoefficients::BT709, QYCbCrCoefficients::LimitedRange);
+
+    const VideoFrameConvertFunc scalar = qt_videoFrameConvertFunc(pixelFormat, QVideoFrameConvertScalar);
+    QVERIFY(scalar);
+    QVERIFY(!qt_videoFrameConvertFunc(QVideoFrame::Format_Jpeg, QVideoFrameConvertScalar));
+
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+    QByteArray expected(size.width() * size.height() * 4, '\0');
+    scalar(frame, reinterpret_cast<uchar *>(expected.data()), coefficients);
+
+    // Every SIMD tier available on this CPU must produce the scalar results
+    const QVideoFrameConvertLevel levels[] = {
+        QVideoFrameConvertSSE2, QVideoFrameConvertSSSE3, QVideoFrameConvertAVX2
+    };
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+        const VideoFrameConvertFunc convert = qt_videoFrameConvertFunc(pixelFormat, levels[i]);
+        if (!convert)
+            continue;
+        QByteArray output(expected.size(), '\0');
+        convert(frame, reinterpret_cast<uchar *>(output.data()), coefficients);
+        QCOMPARE(output, expected);
+    }
+
+    frame.unmap();
+}
+
+void tst_QVideoFrame::imageFromIMC_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+
+    QTest::newRow("IMC1") << QVideoFrame::Format_IMC1;
+    QTest::newRow("IMC2") << QVideoFrame::Format_IMC2;
+    QTest::newRow("IMC3") << QVideoFrame::Format_IMC3;
+    QTest::newRow("IMC4") << QVideoFrame::Format_IMC4;
+}
+
+void tst_QVideoFrame::imageFromIMC()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+
+    const QSize size(38, 10);
+    const int stride = 40;
+    const int chromaWidth = size.width() / 2;
+    const int chromaHeight = size.height() / 2;
+    const bool interleaved = pixelFormat == QVideoFrame::Format_IMC2
+            || pixelFormat == QVideoFrame::Format_IMC4;
+    const bool uFirst = pixelFormat == QVideoFrame::Format_IMC1
+            || pixelFormat == QVideoFrame::Format_IMC2;
+
+    QVideoFrame reference = createYUV420PFrame(size);
+    QVERIFY(reference.map(QAbstractVideoBuffer::ReadOnly));
+
+    const int bytes = stride * size.height() + stride * chromaHeight * (interleaved ? 1 : 2);
+    QVideoFrame frame(bytes, size, stride, pixelFormat);
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    memset(frame.bits(), 0, bytes);
+
+    uchar *y = frame.bits();
+    uchar *chroma = y + stride * size.height();
+    // Offsets of the first and the second chroma line from the start of a chroma row
+    const int second = interleaved ? stride / 2 : stride * chromaHeight;
+    uchar *u = chroma + (uFirst ? 0 : second);
+    uchar *v = chroma + (uFirst ? second : 0);
+
+    for (int line = 0; line < size.height(); ++line)
+        memcpy(y + line * stride, reference.bits(0) + line * reference.bytesPerLine(0), size.width());
+    for (int line = 0; line < chromaHeight; ++line) {
+        memcpy(u + line * stride, reference.bits(1) + line * reference.bytesPerLine(1), chromaWidth);
+        memcpy(v + line * stride, reference.bits(2) + line * reference.bytesPerLine(2), chromaWidth);
+    }
+
+    frame.unmap();
+    reference.unmap();
+
+    const QImage image = qt_imageFromVideoFrame(frame);
+    QCOMPARE(image.format(), QImage::Format_ARGB32);
+    QCOMPARE(image, qt_imageFromVideoFrame(reference));
+}
+
+void tst_QVideoFrame::imageFromGrey()
+{
+    const QSize size(35, 3);
+
+    // Y8 frames are copied, or viewed, as Grayscale8 images
+    QVideoFrame y8(36 * size.height(), size, 36, QVideoFrame::Format_Y8);
+    QVERIFY(y8.map(QAbstractVideoBuffer::WriteOnly));
+    for (int i = 0; i < y8.mappedBytes(); ++i)
+        y8.bits()[i] = uchar(i * 7);
+    const uchar *bits = y8.bits();
+    y8.unmap();
+
+    QCOMPARE(qt_convertedImageFormat(QVideoFrame::Format_Y8), QImage::Format_Grayscale8);
+
+    const QImage grey = qt_imageFromVideoFrame(y8);
+    QCOMPARE(grey.format(), QImage::Format_Grayscale8);
+    QCOMPARE(grey.size(), size);
+    QCOMPARE(grey.constScanLine(2)[34], uchar((2 * 36 + 34) * 7));
+
+    const QImage view = qt_imageViewFromVideoFrame(y8);
+    QCOMPARE(view.constBits(), bits);
+    QCOMPARE(view, grey);
+
+    // Expanding to ARGB32 repeats the grey level in each color channel
+    const QVideoFrame argb = qt_convertVideoFrame(y8, QVideoFrame::Format_ARGB32);
+    QCOMPARE(qt_imageFromVideoFrame(argb), grey.convertToFormat(QImage::Format_ARGB32));
+
+    // Y16 frames keep the most significant byte of each sample
+    QVideoFrame y16(72 * size.height(), size, 72, QVideoFrame::Format_Y16);
+    QVERIFY(y16.map(QAbstractVideoBuffer::WriteOnly));
+    for (int i = 0; i < y16.mappedBytes(); i += 2) {
+        y16.bits()[i] = 0xaa;
+        y16.bits()[i + 1] = uchar(i * 3);
+    }
+    y16.unmap();
+
+    QCOMPARE(qt_convertedImageFormat(QVideoFrame::Format_Y16), QImage::Format_ARGB32);
+    const QImage expanded = qt_imageFromVideoFrame(y16);
+    QCOMPARE(expanded.format(), QImage::Format_ARGB32);
+    for (int line = 0; line < size.height(); ++line) {
+        for (int x = 0; x < size.width(); ++x) {
+            const int level = uchar((line * 72 + x * 2) * 3);
+            QCOMPARE(expanded.pixel(x, line), qRgb(level, level, level));
+        }
+    }
+}
+
 void tst_QVideoFrame::metadata()
 {
     // Simple metadata test
@@ -0,0 +1,8 @@
+CONFIG += testcase
+TARGET = tst_qvideoframepool
+
+QT += core multimedia-private testlib
+
+SOURCES += tst_qvideoframepool.cpp
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
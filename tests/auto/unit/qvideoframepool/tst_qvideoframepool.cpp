@@ -0,0 +1,225 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+
+#include <qvideoframe.h>
+#include <qvideosurfaceformat.h>
+#include <private/qvideoframepool_p.h>
+
+class tst_QVideoFramePool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void allocate_data();
+    void allocate();
+    void unsupportedFormat();
+    void recycle();
+    void sharedFrame();
+    void capacity();
+    void changeFormat();
+    void outliveThePool();
+};
+
+void tst_QVideoFramePool::allocate_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("bytesPerLine");
+    QTest::addColumn<int>("mappedBytes");
+
+    QTest::newRow("ARGB32 64x64")
+            << QVideoFrame::Format_ARGB32 << QSize(64, 64) << 256 << 256 * 64;
+    QTest::newRow("RGB24 63x5")
+            << QVideoFrame::Format_RGB24 << QSize(63, 5) << 192 << 192 * 5;
+    QTest::newRow("YUV420P 64x48")
+            << QVideoFrame::Format_YUV420P << QSize(64, 48) << 64 << 64 * 48 * 3 / 2;
+    QTest::newRow("NV12 62x48")
+            << QVideoFrame::Format_NV12 << QSize(62, 48) << 64 << 64 * 48 * 3 / 2;
+}
+
+void tst_QVideoFramePool::allocate()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+    QFETCH(int, bytesPerLine);
+    QFETCH(int, mappedBytes);
+
+    QVideoFramePool pool(QVideoSurfaceFormat(size, pixelFormat));
+
+    QVideoFrame frame = pool.allocate();
+    QVERIFY(frame.isValid());
+    QCOMPARE(frame.handleType(), QAbstractVideoBuffer::NoHandle);
+    QCOMPARE(frame.pixelFormat(), pixelFormat);
+    QCOMPARE(frame.size(), size);
+
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    QVERIFY(frame.bits());
+    QCOMPARE(frame.bytesPerLine(), bytesPerLine);
+    QCOMPARE(frame.mappedBytes(), mappedBytes);
+    frame.unmap();
+
+    QCOMPARE(pool.hitCount(), 0);
+    QCOMPARE(pool.missCount(), 1);
+}
+
+void tst_QVideoFramePool::unsupportedFormat()
+{
+    QVideoFramePool pool;
+    QVERIFY(!pool.allocate().isValid());
+
+    pool.setFormat(QVideoSurfaceFormat(QSize(63, 63), QVideoFrame::Format_YUV420P));
+    QVERIFY(!pool.allocate().isValid());
+
+    pool.setFormat(QVideoSurfaceFormat(QSize(64, 64), QVideoFrame::Format_Jpeg));
+    QVERIFY(!pool.allocate().isValid());
+
+    QCOMPARE(pool.missCount(), 0);
+}
+
+void tst_QVideoFramePool::recycle()
+{
+    QVideoFramePool pool(QVideoSurfaceFormat(QSize(64, 64), QVideoFrame::Format_RGB32));
+
+    uchar *bits = 0;
+    {
+        QVideoFrame frame = pool.allocate();
+        QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+        bits = frame.bits();
+        frame.unmap();
+        QCOMPARE(pool.idleCount(), 0);
+    }
+    QCOMPARE(pool.idleCount(), 1);
+
+    QVideoFrame frame = pool.allocate();
+    QCOMPARE(pool.idleCount(), 0);
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+    QCOMPARE(frame.bits(), bits);
+    frame.unmap();
+
+    QCOMPARE(pool.hitCount(), 1);
+    QCOMPARE(pool.missCount(), 1);
+
+    pool.resetStatistics();
+    QCOMPARE(pool.hitCount(), 0);
+    QCOMPARE(pool.missCount(), 0);
+}
+
+void tst_QVideoFramePool::sharedFrame()
+{
+    QVideoFramePool pool(QVideoSurfaceFormat(QSize(16, 16), QVideoFrame::Format_RGB32));
+
+    QVideoFrame frame = pool.allocate();
+    QVideoFrame copy = frame;
+
+    frame = QVideoFrame();
+    QCOMPARE(pool.idleCount(), 0);
+
+    copy = QVideoFrame();
+    QCOMPARE(pool.idleCount(), 1);
+}
+
+void tst_QVideoFramePool::capacity()
+{
+    QVideoFramePool pool(QVideoSurfaceFormat(QSize(16, 16), QVideoFrame::Format_RGB32), 2);
+    QCOMPARE(pool.capacity(), 2);
+
+    {
+        QVideoFrame frame1 = pool.allocate();
+        QVideoFrame frame2 = pool.allocate();
+        QVideoFrame frame3 = pool.allocate();
+        QCOMPARE(pool.missCount(), 3);
+    }
+    QCOMPARE(pool.idleCount(), 2);
+
+    pool.setCapacity(1);
+    QCOMPARE(pool.capacity(), 1);
+    QCOMPARE(pool.idleCount(), 1);
+
+    pool.clear();
+    QCOMPARE(pool.idleCount(), 0);
+
+    pool.setCapacity(0);
+    pool.allocate();
+    QCOMPARE(pool.idleCount(), 0);
+}
+
+void tst_QVideoFramePool::changeFormat()
+{
+    QVideoFramePool pool(QVideoSurfaceFormat(QSize(16, 16), QVideoFrame::Format_RGB32));
+
+    pool.allocate();
+    QCOMPARE(pool.idleCount(), 1);
+
+    // Same number of bytes, the idle buffer remains usable
+    pool.setFormat(QVideoSurfaceFormat(QSize(16, 16), QVideoFrame::Format_BGRA32));
+    QCOMPARE(pool.idleCount(), 1);
+
+    QVideoFrame frame = pool.allocate();
+    QCOMPARE(frame.pixelFormat(), QVideoFrame::Format_BGRA32);
+    QCOMPARE(pool.hitCount(), 1);
+    frame = QVideoFrame();
+
+    pool.setFormat(QVideoSurfaceFormat(QSize(32, 32), QVideoFrame::Format_RGB32));
+    QCOMPARE(pool.format().frameSize(), QSize(32, 32));
+    QCOMPARE(pool.idleCount(), 0);
+
+    // Frames of the old size are not taken back
+    QVideoFramePool other(QVideoSurfaceFormat(QSize(16, 16), QVideoFrame::Format_RGB32));
+    frame = other.allocate();
+    other.setFormat(QVideoSurfaceFormat(QSize(8, 8), QVideoFrame::Format_RGB32));
+    frame = QVideoFrame();
+    QCOMPARE(other.idleCount(), 0);
+}
+
+void tst_QVideoFramePool::outliveThePool()
+{
+    QVideoFrame frame;
+    {
+        QVideoFramePool pool(QVideoSurfaceFormat(QSize(16, 16), QVideoFrame::Format_RGB32));
+        frame = pool.allocate();
+    }
+
+    QVERIFY(frame.isValid());
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadWrite));
+    frame.bits()[0] = 0xff;
+    frame.unmap();
+}
+
+QTEST_MAIN(tst_QVideoFramePool)
+
+#include "tst_qvideoframepool.moc"
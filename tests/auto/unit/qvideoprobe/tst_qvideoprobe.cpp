@@ -35,6 +35,7 @@
 #include <QDebug>
 
 #include <qvideoprobe.h>
+#include <private/qmediavideoprobecontrol_p.h>
 #include <qaudiorecorder.h>
 #include <qmediaplayer.h>
 
@@ -61,6 +62,12 @@ private slots:
     void testPlayerDeleteRecorder();
     void testPlayerDeleteProbe();
     void testRecorder();
+    void testSettings();
+    void testMergedSettings();
+    void testFrameStride();
+    void testFrameRate();
+    void testFrameReduction();
+    void testDeliveryPolicy();
 
 private:
     QMediaPlayer *player;
@@ -176,6 +183,194 @@ void tst_QVideoProbe::testRecorder()
     QVERIFY(!probe.isActive());
 }
 
+void tst_QVideoProbe::testSettings()
+{
+    player = new QMediaPlayer;
+
+    QVideoProbe probe;
+    QCOMPARE(probe.frameStride(), 1);
+    QCOMPARE(probe.maximumFrameRate(), qreal(0));
+    QCOMPARE(probe.frameSize(), QSize());
+    QCOMPARE(probe.pixelFormat(), QVideoFrame::Format_Invalid);
+
+    probe.setFrameStride(0);
+    QCOMPARE(probe.frameStride(), 1);
+    probe.setMaximumFrameRate(-1);
+    QCOMPARE(probe.maximumFrameRate(), qreal(0));
+
+    // Settings made before the source is set are applied once it is
+    probe.setFrameStride(4);
+    probe.setFrameSize(QSize(320, 240));
+    QVERIFY(probe.setSource(player));
+
+    QMediaVideoProbeControlPrivate *control =
+            QMediaVideoProbeControlPrivate::get(mockMediaPlayerService->mockVideoProbeControl);
+    QCOMPARE(control->settings().frameStride, 4);
+    QCOMPARE(control->settings().frameSize, QSize(320, 240));
+
+    probe.setMaximumFrameRate(2);
+    probe.setPixelFormat(QVideoFrame::Format_RGB32);
+    QCOMPARE(control->settings().maximumFrameRate, qreal(2));
+    QCOMPARE(control->settings().pixelFormat, QVideoFrame::Format_RGB32);
+
+    probe.setSource((QMediaPlayer*)0);
+    QCOMPARE(control->settings().frameStride, 1);
+    QCOMPARE(control->settings().maximumFrameRate, qreal(0));
+    QCOMPARE(control->settings().frameSize, QSize());
+    QCOMPARE(control->settings().pixelFormat, QVideoFrame::Format_Invalid);
+}
+
+void tst_QVideoProbe::testMergedSettings()
+{
+    player = new QMediaPlayer;
+    QMediaVideoProbeControlPrivate *control =
+            QMediaVideoProbeControlPrivate::get(mockMediaPlayerService->mockVideoProbeControl);
+
+    QVideoProbe first;
+    first.setFrameStride(4);
+    first.setMaximumFrameRate(2);
+    first.setFrameSize(QSize(320, 240));
+    first.setPixelFormat(QVideoFrame::Format_RGB32);
+    QVERIFY(first.setSource(player));
+
+    QVideoProbe *second = new QVideoProbe;
+    second->setFrameStride(2);
+    second->setMaximumFrameRate(5);
+    second->setFrameSize(QSize(320, 240));
+    QVERIFY(second->setSource(player));
+
+    // Each probe gets at least the frames it asked for
+    QCOMPARE(control->settings().frameStride, 2);
+    QCOMPARE(control->settings().maximumFrameRate, qreal(5));
+    QCOMPARE(control->settings().frameSize, QSize(320, 240));
+    QCOMPARE(control->settings().pixelFormat, QVideoFrame::Format_Invalid);
+
+    second->setMaximumFrameRate(0);
+    QCOMPARE(control->settings().maximumFrameRate, qreal(0));
+
+    delete second;
+    QCOMPARE(control->settings().frameStride, 4);
+    QCOMPARE(control->settings().maximumFrameRate, qreal(2));
+    QCOMPARE(control->settings().pixelFormat, QVideoFrame::Format_RGB32);
+}
+
+static QVideoFrame createFrame(qint64 startTime, const QSize &size = QSize(4, 4))
+{
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    QVideoFrame frame(image);
+    frame.setStartTime(startTime);
+    return frame;
+}
+
+void tst_QVideoProbe::testFrameStride()
+{
+    player = new QMediaPlayer;
+    QMediaVideoProbeControlPrivate *control =
+            QMediaVideoProbeControlPrivate::get(mockMediaPlayerService->mockVideoProbeControl);
+
+    QVideoProbe probe;
+    probe.setFrameStride(3);
+    QVERIFY(probe.setSource(player));
+
+    QList<int> accepted;
+    for (int i = 0; i < 10; ++i) {
+        if (control->acceptFrame(createFrame(-1)))
+            accepted.append(i);
+    }
+    QCOMPARE(accepted, QList<int>() << 0 << 3 << 6 << 9);
+}
+
+void tst_QVideoProbe::testFrameRate()
+{
+    player = new QMediaPlayer;
+    QMediaVideoProbeControlPrivate *control =
+            QMediaVideoProbeControlPrivate::get(mockMediaPlayerService->mockVideoProbeControl);
+
+    QVideoProbe probe;
+    probe.setMaximumFrameRate(2);
+    QVERIFY(probe.setSource(player));
+
+    // Three seconds of a 30 fps stream
+    QList<int> accepted;
+    for (int i = 0; i < 90; ++i) {
+        if (control->acceptFrame(createFrame(i * qint64(33333))))
+            accepted.append(i);
+    }
+    QCOMPARE(accepted, QList<int>() << 0 << 16 << 31 << 46 << 61 << 76);
+
+    // Going back in the stream restarts the measure
+    QVERIFY(control->acceptFrame(createFrame(0)));
+    QVERIFY(!control->acceptFrame(createFrame(33333)));
+}
+
+void tst_QVideoProbe::testFrameReduction()
+{
+    player = new QMediaPlayer;
+    QMediaVideoProbeControlPrivate *control =
+            QMediaVideoProbeControlPrivate::get(mockMediaPlayerService->mockVideoProbeControl);
+
+    QVideoProbe probe;
+    QVERIFY(probe.setSource(player));
+
+    const QVideoFrame frame = createFrame(1000, QSize(640, 360));
+    QCOMPARE(control->reduceFrame(frame), frame);
+
+    probe.setFrameSize(QSize(320, 240));
+    QVideoFrame reduced = control->reduceFrame(frame);
+    QCOMPARE(reduced.size(), QSize(320, 180));
+    QCOMPARE(reduced.startTime(), qint64(1000));
+
+    // Frames which already fit are not scaled up
+    const QVideoFrame small = createFrame(2000, QSize(160, 90));
+    QCOMPARE(control->reduceFrame(small), small);
+
+    probe.setPixelFormat(QVideoFrame::Format_ARGB32);
+    reduced = control->reduceFrame(small);
+    QCOMPARE(reduced.size(), QSize(160, 90));
+    QCOMPARE(reduced.pixelFormat(), QVideoFrame::Format_ARGB32);
+    QCOMPARE(reduced.startTime(), qint64(2000));
+}
+
+void tst_QVideoProbe::testDeliveryPolicy()
+{
+    player = new QMediaPlayer;
+    QMediaVideoProbeControlPrivate *control =
+            QMediaVideoProbeControlPrivate::get(mockMediaPlayerService->mockVideoProbeControl);
+
+    QVideoProbe probe;
+    QCOMPARE(probe.deliveryPolicy(), QMultimedia::LatestOnlyDelivery);
+    QCOMPARE(probe.droppedCount(), 0);
+
+    QVERIFY(probe.setSource(player));
+    QCOMPARE(control->queue.policy(), QMultimedia::LatestOnlyDelivery);
+
+    // Only the latest frame is kept by default
+    control->queue.enqueue(createFrame(0));
+    control->queue.enqueue(createFrame(1));
+    QCOMPARE(probe.droppedCount(), 1);
+
+    QVideoFrame frame;
+    QVERIFY(control->queue.dequeue(&frame));
+    QCOMPARE(frame.startTime(), qint64(1));
+
+    probe.setDeliveryPolicy(QMultimedia::BlockingQueueDelivery);
+    probe.setQueueCapacity(4);
+    QCOMPARE(control->queue.policy(), QMultimedia::BlockingQueueDelivery);
+    QCOMPARE(control->queue.capacity(), 4);
+    QCOMPARE(control->settings().deliveryPolicy, QMultimedia::BlockingQueueDelivery);
+
+    for (int i = 0; i < 4; ++i)
+        control->queue.enqueue(createFrame(i));
+    QCOMPARE(probe.queueHighWaterMark(), 4);
+    QCOMPARE(probe.droppedCount(), 1);
+
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(control->queue.dequeue(&frame));
+        QCOMPARE(frame.startTime(), qint64(i));
+    }
+}
+
 QTEST_GUILESS_MAIN(tst_QVideoProbe)
 
 #include "tst_qvideoprobe.moc"
@@ -70,6 +70,11 @@ private slots:
 
     void readAllAtOnce();
     void readPerByte();
+
+    void generated_data();
+    void generated();
+    void seekToFrame();
+    void truncatedData();
 };
 
 Q_DECLARE_METATYPE(tst_QWaveDecoder::Corruption)
@@ -96,6 +101,56 @@ static QString testFilePath(const char *filename)
     return QFINDTESTDATA(path);
 }
 
+template <typename T>
+static void appendLittleEndian(QByteArray &data, T value)
+{
+    uchar bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    data.append(reinterpret_cast<const char *>(bytes), sizeof(T));
+}
+
+// A little endian wave file holding frames counting up from 0, one byte each
+static QByteArray generateWave(int formatTag, int subFormatTag, int channels, int sampleSize,
+                               bool rf64, int frames)
+{
+    const int frameBytes = channels * sampleSize / 8;
+    const quint32 dataSize = frames * frameBytes;
+    const bool extensible = formatTag == 0xFFFE;
+
+    QByteArray wave;
+    wave.append(rf64 ? "RF64" : "RIFF", 4);
+    appendLittleEndian<quint32>(wave, rf64 ? 0xFFFFFFFF : 0);
+    wave.append("WAVE", 4);
+    if (rf64) {
+        wave.append("ds64", 4);
+        appendLittleEndian<quint32>(wave, 28);
+        appendLittleEndian<quint64>(wave, 0);
+        appendLittleEndian<quint64>(wave, dataSize);
+        appendLittleEndian<quint64>(wave, frames);
+        appendLittleEndian<quint32>(wave, 0);
+    }
+    wave.append("fmt ", 4);
+    appendLittleEndian<quint32>(wave, extensible ? 40 : 16);
+    appendLittleEndian<quint16>(wave, formatTag);
+    appendLittleEndian<quint16>(wave, channels);
+    appendLittleEndian<quint32>(wave, 8000);
+    appendLittleEndian<quint32>(wave, 8000 * frameBytes);
+    appendLittleEndian<quint16>(wave, frameBytes);
+    appendLittleEndian<quint16>(wave, sampleSize);
+    if (extensible) {
+        appendLittleEndian<quint16>(wave, 22);
+        appendLittleEndian<quint16>(wave, sampleSize);
+        appendLittleEndian<quint32>(wave, 0);
+        appendLittleEndian<quint32>(wave, subFormatTag);
+        wave.append("\x00\x00\x10\x00\x80\x00\x00\xaa\x00\x38\x9b\x71", 12);
+    }
+    wave.append("data", 4);
+    appendLittleEndian<quint32>(wave, rf64 ? 0xFFFFFFFF : dataSize);
+    for (quint32 i = 0; i < dataSize; ++i)
+        wave.append(char(i / frameBytes));
+    return wave;
+}
+
 void tst_QWaveDecoder::file_data()
 {
     QTest::addColumn<QString>("file");
@@ -125,11 +180,11 @@ void tst_QWaveDecoder::file_data()
     // The next file has extra data in the wave header.
     QTest::newRow("File isawav_1_16_44100_le_2.wav") << testFilePath("isawav_1_16_44100_le_2.wav")  << tst_QWaveDecoder::None << 1 << 16 << 44100 << QAudioFormat::LittleEndian;
 
-    // 32 bit waves are not supported
-    QTest::newRow("File isawav_1_32_8000_le.wav") << testFilePath("isawav_1_32_8000_le.wav")  << tst_QWaveDecoder::FormatDescriptor << 1 << 32 << 8000 << QAudioFormat::LittleEndian;
-    QTest::newRow("File isawav_1_32_44100_le.wav") << testFilePath("isawav_1_32_44100_le.wav")  << tst_QWaveDecoder::FormatDescriptor << 1 << 32 << 44100 << QAudioFormat::LittleEndian;
-    QTest::newRow("File isawav_2_32_8000_be.wav") << testFilePath("isawav_2_32_8000_be.wav")  << tst_QWaveDecoder::FormatDescriptor << 2 << 32 << 8000 << QAudioFormat::BigEndian;
-    QTest::newRow("File isawav_2_32_44100_be.wav") << testFilePath("isawav_2_32_44100_be.wav")  << tst_QWaveDecoder::FormatDescriptor << 2 << 32 << 44100 << QAudioFormat::BigEndian;
+    // 32 bit waves use the extensible format
+    QTest::newRow("File isawav_1_32_8000_le.wav") << testFilePath("isawav_1_32_8000_le.wav")  << tst_QWaveDecoder::None << 1 << 32 << 8000 << QAudioFormat::LittleEndian;
+    QTest::newRow("File isawav_1_32_44100_le.wav") << testFilePath("isawav_1_32_44100_le.wav")  << tst_QWaveDecoder::None << 1 << 32 << 44100 << QAudioFormat::LittleEndian;
+    QTest::newRow("File isawav_2_32_8000_be.wav") << testFilePath("isawav_2_32_8000_be.wav")  << tst_QWaveDecoder::None << 2 << 32 << 8000 << QAudioFormat::BigEndian;
+    QTest::newRow("File isawav_2_32_44100_be.wav") << testFilePath("isawav_2_32_44100_be.wav")  << tst_QWaveDecoder::None << 2 << 32 << 44100 << QAudioFormat::BigEndian;
 }
 
 void tst_QWaveDecoder::file()
@@ -304,6 +359,122 @@ void tst_QWaveDecoder::readPerByte()
     stream.close();
 }
 
+void tst_QWaveDecoder::generated_data()
+{
+    QTest::addColumn<QByteArray>("wave");
+    QTest::addColumn<int>("channels");
+    QTest::addColumn<int>("samplesize");
+    QTest::addColumn<QAudioFormat::SampleType>("sampletype");
+
+    QTest::newRow("float") << generateWave(3, 0, 2, 32, false, 100)
+                           << 2 << 32 << QAudioFormat::Float;
+    QTest::newRow("extensible 24 bit") << generateWave(0xFFFE, 1, 6, 24, false, 100)
+                                       << 6 << 24 << QAudioFormat::SignedInt;
+    QTest::newRow("extensible float") << generateWave(0xFFFE, 3, 8, 32, false, 100)
+                                      << 8 << 32 << QAudioFormat::Float;
+    QTest::newRow("rf64") << generateWave(1, 0, 2, 16, true, 100)
+                          << 2 << 16 << QAudioFormat::SignedInt;
+    QTest::newRow("rf64 extensible float") << generateWave(0xFFFE, 3, 2, 32, true, 100)
+                                           << 2 << 32 << QAudioFormat::Float;
+}
+
+void tst_QWaveDecoder::generated()
+{
+    QFETCH(QByteArray, wave);
+    QFETCH(int, channels);
+    QFETCH(int, samplesize);
+    QFETCH(QAudioFormat::SampleType, sampletype);
+
+    QBuffer stream(&wave);
+    QVERIFY(stream.open(QIODevice::ReadOnly));
+
+    QWaveDecoder waveDecoder(&stream);
+    QSignalSpy validFormatSpy(&waveDecoder, SIGNAL(formatKnown()));
+    QSignalSpy parsingErrorSpy(&waveDecoder, SIGNAL(parsingError()));
+
+    QTRY_COMPARE(validFormatSpy.count(), 1);
+    QCOMPARE(parsingErrorSpy.count(), 0);
+
+    const QAudioFormat format = waveDecoder.audioFormat();
+    QVERIFY(format.isValid());
+    QCOMPARE(format.channelCount(), channels);
+    QCOMPARE(format.sampleSize(), samplesize);
+    QCOMPARE(format.sampleType(), sampletype);
+    QCOMPARE(format.sampleRate(), 8000);
+    QCOMPARE(waveDecoder.frameCount(), qint64(100));
+    QCOMPARE(waveDecoder.size(), qint64(100 * format.bytesPerFrame()));
+
+    // Reads never go past the sample data
+    const QByteArray data = waveDecoder.readAll();
+    QCOMPARE(qint64(data.size()), waveDecoder.size());
+    QCOMPARE(wave.right(data.size()), data);
+}
+
+void tst_QWaveDecoder::seekToFrame()
+{
+    QByteArray wave = generateWave(1, 0, 2, 16, false, 100);
+    wave.append("LIST", 4); // trailing chunks are not sample data
+    appendLittleEndian<quint32>(wave, 0);
+
+    QBuffer stream(&wave);
+    QVERIFY(stream.open(QIODevice::ReadOnly));
+
+    QWaveDecoder waveDecoder(&stream);
+    QSignalSpy validFormatSpy(&waveDecoder, SIGNAL(formatKnown()));
+    QTRY_COMPARE(validFormatSpy.count(), 1);
+
+    QCOMPARE(waveDecoder.frameCount(), qint64(100));
+    QCOMPARE(waveDecoder.dataOffset(), qint64(44));
+    QCOMPARE(waveDecoder.offsetForFrame(10), qint64(44 + 10 * 4));
+
+    QVERIFY(waveDecoder.seekToFrame(42));
+    QCOMPARE(waveDecoder.pos(), qint64(42 * 4));
+    QCOMPARE(waveDecoder.bytesAvailable(), qint64(58 * 4));
+
+    // Reads are rounded down to whole frames
+    char frames[10];
+    QCOMPARE(waveDecoder.read(frames, sizeof(frames)), qint64(8));
+    QCOMPARE(int(frames[0]), 42);
+    QCOMPARE(int(frames[4]), 43);
+
+    QVERIFY(waveDecoder.seekToFrame(99));
+    QCOMPARE(waveDecoder.readAll().size(), 4);
+    QVERIFY(waveDecoder.atEnd());
+
+    QVERIFY(waveDecoder.seekToFrame(0));
+    QCOMPARE(waveDecoder.readAll().size(), 400);
+    QVERIFY(!waveDecoder.seekToFrame(101));
+}
+
+void tst_QWaveDecoder::truncatedData()
+{
+    // Two frames and a half, where the header announces a hundred
+    QByteArray wave = generateWave(1, 0, 2, 16, false, 100);
+    wave.chop(400 - 9);
+
+    QBuffer stream(&wave);
+    QVERIFY(stream.open(QIODevice::ReadOnly));
+
+    QWaveDecoder waveDecoder(&stream);
+    QSignalSpy validFormatSpy(&waveDecoder, SIGNAL(formatKnown()));
+    QTRY_COMPARE(validFormatSpy.count(), 1);
+
+    QCOMPARE(waveDecoder.size(), qint64(9));
+    QCOMPARE(waveDecoder.frameCount(), qint64(2));
+
+    // A single read reaches the end of the data, partial frame included
+    char data[16];
+    QCOMPARE(waveDecoder.read(data, sizeof(data)), qint64(9));
+    QCOMPARE(int(data[8]), 2);
+    QVERIFY(waveDecoder.atEnd());
+
+    // Reads that stop short of the end are still whole frames
+    QVERIFY(waveDecoder.seek(0));
+    QCOMPARE(waveDecoder.read(data, 7), qint64(4));
+    QCOMPARE(waveDecoder.read(data, 5), qint64(5));
+    QVERIFY(waveDecoder.atEnd());
+}
+
 QTEST_MAIN(tst_QWaveDecoder)
 
 #include "tst_qwavedecoder.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = tst_bench_qvideoframeconversion
+
+QT += core multimedia-private testlib
+
+SOURCES += tst_bench_qvideoframeconversion.cpp
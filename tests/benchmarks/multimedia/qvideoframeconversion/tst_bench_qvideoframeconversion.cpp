@@ -0,0 +1,231 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+
+#include <qvideoframe.h>
+#include <qvideosurfaceformat.h>
+#include <private/qvideoframe_p.h>
+#include <private/qvideoframeconversionhelper_p.h>
+#include <private/qvideoframepool_p.h>
+
+static const struct {
+    QVideoFrame::PixelFormat format;
+    const char *name;
+} convertedFormats[] = {
+    { QVideoFrame::Format_BGRA32, "BGRA32" },
+    { QVideoFrame::Format_BGRA32_Premultiplied, "BGRA32_Premultiplied" },
+    { QVideoFrame::Format_BGR32, "BGR32" },
+    { QVideoFrame::Format_BGR24, "BGR24" },
+    { QVideoFrame::Format_BGR565, "BGR565" },
+    { QVideoFrame::Format_BGR555, "BGR555" },
+    { QVideoFrame::Format_AYUV444, "AYUV444" },
+    { QVideoFrame::Format_YUV444, "YUV444" },
+    { QVideoFrame::Format_YUV420P, "YUV420P" },
+    { QVideoFrame::Format_YV12, "YV12" },
+    { QVideoFrame::Format_UYVY, "UYVY" },
+    { QVideoFrame::Format_YUYV, "YUYV" },
+    { QVideoFrame::Format_NV12, "NV12" },
+    { QVideoFrame::Format_NV21, "NV21" },
+    { QVideoFrame::Format_IMC1, "IMC1" },
+    { QVideoFrame::Format_IMC2, "IMC2" },
+    { QVideoFrame::Format_IMC3, "IMC3" },
+    { QVideoFrame::Format_IMC4, "IMC4" },
+    { QVideoFrame::Format_Y8, "Y8" },
+    { QVideoFrame::Format_Y16, "Y16" }
+};
+
+static const struct {
+    QSize size;
+    const char *name;
+} frameSizes[] = {
+    { QSize(640, 480), "480p" },
+    { QSize(1920, 1080), "1080p" },
+    { QSize(3840, 2160), "4K" }
+};
+
+static const struct {
+    QVideoFrameConvertLevel level;
+    const char *name;
+} convertLevels[] = {
+    { QVideoFrameConvertScalar, "scalar" },
+    { QVideoFrameConvertSSE2, "sse2" },
+    { QVideoFrameConvertSSSE3, "ssse3" },
+    { QVideoFrameConvertAVX2, "avx2" }
+};
+
+class tst_QVideoFrameConversion : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void convert_data();
+    void convert();
+    void imageFromVideoFrame_data();
+    void imageFromVideoFrame();
+    void map_data();
+    void map();
+
+private:
+    void addFormatRows();
+    QVideoFrame createFrame(QVideoFrame::PixelFormat format, const QSize &size);
+
+    QVideoFramePool m_pool;
+};
+
+void tst_QVideoFrameConversion::addFormatRows()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+
+    for (size_t i = 0; i < sizeof(convertedFormats) / sizeof(convertedFormats[0]); ++i) {
+        for (size_t j = 0; j < sizeof(frameSizes) / sizeof(frameSizes[0]); ++j) {
+            QTest::newRow(QByteArray(convertedFormats[i].name) + ' ' + frameSizes[j].name)
+                    << convertedFormats[i].format << frameSizes[j].size;
+        }
+    }
+}
+
+/*
+    Returns a frame filled with a gradient, so that the YUV kernels see
+    varying chroma and the conversion can't be short-circuited.
+*/
+QVideoFrame tst_QVideoFrameConversion::createFrame(QVideoFrame::PixelFormat format,
+                                                   const QSize &size)
+{
+    m_pool.setFormat(QVideoSurfaceFormat(size, format));
+
+    QVideoFrame frame = m_pool.allocate();
+    if (!frame.map(QAbstractVideoBuffer::WriteOnly))
+        return QVideoFrame();
+
+    uchar *bits = frame.bits();
+    for (int i = 0; i < frame.mappedBytes(); ++i)
+        bits[i] = uchar(i * 7 + (i >> 11));
+
+    frame.unmap();
+    return frame;
+}
+
+void tst_QVideoFrameConversion::convert_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("level");
+
+    for (size_t i = 0; i < sizeof(convertedFormats) / sizeof(convertedFormats[0]); ++i) {
+        for (size_t j = 0; j < sizeof(frameSizes) / sizeof(frameSizes[0]); ++j) {
+            for (size_t k = 0; k < sizeof(convertLevels) / sizeof(convertLevels[0]); ++k) {
+                QTest::newRow(QByteArray(convertedFormats[i].name) + ' ' + frameSizes[j].name
+                              + ' ' + convertLevels[k].name)
+                        << convertedFormats[i].format << frameSizes[j].size
+                        << int(convertLevels[k].level);
+            }
+        }
+    }
+}
+
+/*
+    Measures a single conversion kernel on one thread, bypassing the band
+    splitting done by qt_imageFromVideoFrame().
+*/
+void tst_QVideoFrameConversion::convert()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+    QFETCH(int, level);
+
+    const VideoFrameConvertFunc convert =
+            qt_videoFrameConvertFunc(pixelFormat, QVideoFrameConvertLevel(level));
+    if (!convert)
+        QSKIP("Instruction set not available");
+
+    QVideoFrame frame = createFrame(pixelFormat, size);
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+
+    const QYCbCrCoefficients &coefficients =
+            qt_yCbCrCoefficients(QVideoSurfaceFormat::YCbCr_BT601);
+    QByteArray output(size.width() * size.height() * 4, Qt::Uninitialized);
+    uchar *bits = reinterpret_cast<uchar *>(output.data());
+
+    QBENCHMARK {
+        convert(frame, bits, coefficients);
+    }
+
+    frame.unmap();
+}
+
+void tst_QVideoFrameConversion::imageFromVideoFrame_data()
+{
+    addFormatRows();
+}
+
+void tst_QVideoFrameConversion::imageFromVideoFrame()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    QVideoFrame frame = createFrame(pixelFormat, size);
+    QVERIFY(frame.isValid());
+
+    QImage image;
+    QVERIFY(qt_imageFromVideoFrame(frame, &image));
+
+    QBENCHMARK {
+        qt_imageFromVideoFrame(frame, &image);
+    }
+}
+
+void tst_QVideoFrameConversion::map_data()
+{
+    addFormatRows();
+}
+
+void tst_QVideoFrameConversion::map()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    QVideoFrame frame = createFrame(pixelFormat, size);
+    QVERIFY(frame.isValid());
+
+    QBENCHMARK {
+        frame.map(QAbstractVideoBuffer::ReadOnly);
+        frame.unmap();
+    }
+}
+
+QTEST_MAIN(tst_QVideoFrameConversion)
+
+#include "tst_bench_qvideoframeconversion.moc"